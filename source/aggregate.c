@@ -0,0 +1,137 @@
+#include "aggregate.h"
+
+#include <SDL3/SDL.h>
+
+#include "git_status.h"
+
+//=============================================================================
+// PROPAGATION
+//=============================================================================
+
+void aggregate_add (Directory *directory, DirectoryStats delta) {
+	for (Directory *ancestor = directory; ancestor; ancestor = ancestor->parent) {
+		ancestor->stats.total_size += delta.total_size;
+		ancestor->stats.num_files += delta.num_files;
+		ancestor->stats.newest_modified_time = xtd_max(ancestor->stats.newest_modified_time, delta.newest_modified_time);
+		ancestor->stats.num_modified += delta.num_modified;
+		ancestor->stats.num_untracked += delta.num_untracked;
+		ancestor->stats_label_dirty = true;
+	}
+}
+
+void aggregate_subtract (Directory *directory, DirectoryStats delta) {
+	for (Directory *ancestor = directory; ancestor; ancestor = ancestor->parent) {
+		ancestor->stats.total_size -= xtd_min(delta.total_size, ancestor->stats.total_size);
+		ancestor->stats.num_files -= xtd_min(delta.num_files, ancestor->stats.num_files);
+		ancestor->stats.num_modified -= xtd_min(delta.num_modified, ancestor->stats.num_modified);
+		ancestor->stats.num_untracked -= xtd_min(delta.num_untracked, ancestor->stats.num_untracked);
+		ancestor->stats_label_dirty = true;
+	}
+}
+
+void aggregate_add_file (Directory *parent, File *file) {
+	aggregate_add(parent, (DirectoryStats) { file->size, 1, file->modified_time,
+		file->vcs_status == VCS_STATUS_MODIFIED, file->vcs_status == VCS_STATUS_UNTRACKED });
+}
+
+void aggregate_remove_file (Directory *parent, File *file) {
+	aggregate_subtract(parent, (DirectoryStats) { file->size, 1, 0,
+		file->vcs_status == VCS_STATUS_MODIFIED, file->vcs_status == VCS_STATUS_UNTRACKED });
+}
+
+void aggregate_update_file (File *file, u64 new_size, i64 new_modified_time) {
+	if (file->parent) {
+		if (new_size >= file->size) {
+			aggregate_add(file->parent, (DirectoryStats) { new_size - file->size, 0, new_modified_time });
+		} else {
+			aggregate_subtract(file->parent, (DirectoryStats) { file->size - new_size, 0, 0 });
+			aggregate_add(file->parent, (DirectoryStats) { 0, 0, new_modified_time });
+		}
+	}
+	file->size = new_size;
+	file->modified_time = new_modified_time;
+}
+
+void aggregate_recompute (Directory *directory) {
+	DirectoryStats stats = { .num_modified = directory->num_git_deleted };
+	for (u32 i = 0; i < directory->num_child_files; i++) {
+		File *file = directory->child_files[i];
+		stats.total_size += file->size;
+		stats.num_files++;
+		stats.newest_modified_time = xtd_max(stats.newest_modified_time, file->modified_time);
+		stats.num_modified += file->vcs_status == VCS_STATUS_MODIFIED;
+		stats.num_untracked += file->vcs_status == VCS_STATUS_UNTRACKED;
+	}
+	for (u32 i = 0; i < directory->num_child_directories; i++) {
+		DirectoryStats *child = &directory->child_directories[i]->stats;
+		stats.total_size += child->total_size;
+		stats.num_files += child->num_files;
+		stats.newest_modified_time = xtd_max(stats.newest_modified_time, child->newest_modified_time);
+		stats.num_modified += child->num_modified;
+		stats.num_untracked += child->num_untracked;
+	}
+
+	DirectoryStats old = directory->stats;
+	directory->stats = stats;
+	directory->stats_label_dirty = true;
+
+	if (directory->parent) {
+		aggregate_subtract(directory->parent, (DirectoryStats) { old.total_size, old.num_files, 0, old.num_modified, old.num_untracked });
+		aggregate_add(directory->parent, stats);
+	}
+}
+
+//=============================================================================
+// DISPLAY
+//=============================================================================
+
+static void format_size (char *buffer, size_t capacity, u64 bytes) {
+	static const char *units[] = { "B", "KB", "MB", "GB", "TB", "PB" };
+	f64 size = (f64) bytes;
+	u32 unit = 0;
+	while (size >= 1024.0 && unit < SDL_arraysize(units) - 1) {
+		size /= 1024.0;
+		unit++;
+	}
+
+	if (unit == 0) {
+		SDL_snprintf(buffer, capacity, "%u %s", (u32) size, units[unit]);
+	} else {
+		SDL_snprintf(buffer, capacity, "%.1f %s", size, units[unit]);
+	}
+}
+
+// 950, 12.4k, 3.1M
+static void format_count (char *buffer, size_t capacity, u64 count) {
+	if (count < 1000) {
+		SDL_snprintf(buffer, capacity, "%u", (u32) count);
+	} else if (count < 1000000) {
+		SDL_snprintf(buffer, capacity, "%.1fk", (f64) count / 1000.0);
+	} else {
+		SDL_snprintf(buffer, capacity, "%.1fM", (f64) count / 1000000.0);
+	}
+}
+
+// "12.3 MB, 4.2k files, 2025-03-14": size, file count and the local date of
+// the newest change below the directory
+const char *aggregate_label (Directory *directory) {
+	if (!directory->stats_label_dirty) {
+		return directory->stats_label;
+	}
+
+	DirectoryStats *stats = &directory->stats;
+	char size[16], count[16];
+	format_size(size, sizeof(size), stats->total_size);
+	format_count(count, sizeof(count), stats->num_files);
+	const char *files = stats->num_files == 1 ? "file" : "files";
+
+	SDL_DateTime newest;
+	if (stats->num_files && SDL_TimeToDateTime(stats->newest_modified_time, &newest, true)) {
+		SDL_snprintf(directory->stats_label, sizeof(directory->stats_label), "%s, %s %s, %04d-%02d-%02d",
+			size, count, files, newest.year, newest.month, newest.day);
+	} else {
+		SDL_snprintf(directory->stats_label, sizeof(directory->stats_label), "%s, %s %s", size, count, files);
+	}
+	directory->stats_label_dirty = false;
+	return directory->stats_label;
+}
@@ -0,0 +1,37 @@
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include "xtdlib.h"
+
+#include "ui.h"
+
+//=============================================================================
+// DIRECTORY AGGREGATES
+//=============================================================================
+
+// Directory::stats holds recursive size, file count, newest modification
+// time and git status counts (see git_status.h). Totals are never
+// recomputed from scratch: a change to any node is expressed as a delta and
+// added to every ancestor, which is O(depth).
+// The newest modification time is a max, which has no inverse, so removing
+// the newest file leaves it as an upper bound until aggregate_recompute runs
+// on that directory.
+//
+// All functions here run on the UI thread; workers hand their results over
+// through the scanner instead of touching the tree.
+
+void aggregate_add (Directory *directory, DirectoryStats delta);
+void aggregate_subtract (Directory *directory, DirectoryStats delta);
+
+void aggregate_add_file (Directory *parent, File *file);
+void aggregate_remove_file (Directory *parent, File *file);
+void aggregate_update_file (File *file, u64 new_size, i64 new_modified_time);
+
+// rebuilds one directory's stats from its direct children and propagates the difference
+void aggregate_recompute (Directory *directory);
+
+// the size, file count and newest change for display; refreshes
+// Directory::stats_label if the stats changed since the last call
+const char *aggregate_label (Directory *directory);
+
+#endif // AGGREGATE_H
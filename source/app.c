@@ -14,6 +14,17 @@
 #include "app.h"
 #include "render.h"
 #include "ui.h"
+#include "job.h"
+#include "sort.h"
+#include "scroll.h"
+#include "scan.h"
+#include "preview.h"
+#include "search.h"
+#include "thumbnail.h"
+#include "filetype.h"
+#include "workspace.h"
+#include "file_ops.h"
+#include "hit_test.h"
 
 //=============================================================================
 // APPLICATION STATE
@@ -36,11 +47,29 @@ static const ResizeRule resize_rules[] = {
 };
 
 //=============================================================================
-// UPDATE AND RENDER
+// CLAY CONTEXT
 //=============================================================================
 
+// Clay lays out into an arena sized for fixed element and measured-word
+// counts. A layout that gets within a quarter of either count raises it
+// before the next frame. One that runs out of room drops its frame, which is
+// neither drawn nor hit tested, and the count it ran out of doubles before
+// the next frame; at the maximum count the layout is drawn as it is. Once a
+// stretch of frames has used under a quarter of a count it comes down again.
+
 void clay_error_handler (Clay_ErrorData errorData) {
-    printf("%s\n", errorData.errorText.chars);
+	ClayCapacity *capacity = errorData.userData;
+	switch (errorData.errorType) {
+	case CLAY_ERROR_TYPE_ELEMENTS_CAPACITY_EXCEEDED:
+		capacity->elements_exceeded = true;
+		break;
+	case CLAY_ERROR_TYPE_TEXT_MEASUREMENT_CAPACITY_EXCEEDED:
+		capacity->words_exceeded = true;
+		break;
+	default:
+		printf("%s\n", errorData.errorText.chars);
+		break;
+	}
 }
 
 static inline Clay_Dimensions measure_text (Clay_StringSlice text, Clay_TextElementConfig *config, void *userData)
@@ -57,6 +86,121 @@ static inline Clay_Dimensions measure_text (Clay_StringSlice text, Clay_TextElem
     return (Clay_Dimensions) { (float) width, (float) height };
 }
 
+// the smallest power of two from minimum holding twice the usage
+static i32 clay_capacity_for (i32 usage, i32 minimum, i32 maximum) {
+	i32 capacity = minimum;
+	while (capacity < usage * 2 && capacity < maximum) {
+		capacity *= 2;
+	}
+	return capacity;
+}
+
+// Counts can only change in a new context, so the arena is replaced whole.
+// What the pointer was over carries across, so hover state does not drop for
+// a frame; this file holds the Clay implementation, whose context it reads.
+// --frame-stats logs the new counts
+static void resize_clay_context (ApplicationState *app) {
+	ClayCapacity *capacity = &app->clay_capacity;
+	Clay_Context *old_context = Clay_GetCurrentContext();
+	Clay_Arena old_arena = app->clay_arena;
+
+	Clay_SetMaxElementCount(capacity->wanted_elements);
+	Clay_SetMaxMeasureTextCacheWordCount(capacity->wanted_words);
+	size_t clay_mem_size = Clay_MinMemorySize();
+	app->clay_arena = Clay_CreateArenaWithCapacityAndMemory(clay_mem_size, SDL_malloc(clay_mem_size));
+	Clay_Dimensions dimensions = old_context ? old_context->layoutDimensions : (Clay_Dimensions){960, 540};
+	Clay_Context *context = Clay_Initialize(app->clay_arena, dimensions, (Clay_ErrorHandler){ clay_error_handler, capacity });
+	Clay_SetMeasureTextFunction(measure_text, app->render_context.fonts);
+
+	if (old_context) {
+		i32 num_over = xtd_min(old_context->pointerOverIds.length, context->pointerOverIds.capacity);
+		SDL_memcpy(context->pointerOverIds.internalArray, old_context->pointerOverIds.internalArray, num_over * sizeof(Clay_ElementId));
+		context->pointerOverIds.length = num_over;
+		context->pointerInfo = old_context->pointerInfo;
+	}
+	if (old_context && app->frame_stats.log_enabled) {
+		SDL_Log("clay capacity: %d elements, %d measured words (%.1f MiB)",
+			capacity->wanted_elements, capacity->wanted_words, (f64) clay_mem_size / (1024 * 1024));
+	}
+	SDL_free(old_arena.memory);
+
+	capacity->max_elements = capacity->wanted_elements;
+	capacity->max_words = capacity->wanted_words;
+	capacity->window_start_ns = SDL_GetTicksNS();
+	capacity->peak_elements = 0;
+	capacity->peak_words = 0;
+}
+
+static void init_clay_context (ApplicationState *app) {
+	ClayCapacity *capacity = &app->clay_capacity;
+	capacity->wanted_elements = CLAY_MIN_ELEMENTS;
+	capacity->wanted_words = CLAY_MIN_MEASURED_WORDS;
+	resize_clay_context(app);
+}
+
+// after a layout ran out of room: whether there is more to give it
+static bool grow_clay_capacity (ClayCapacity *capacity) {
+	if (capacity->elements_exceeded) {
+		capacity->wanted_elements = xtd_min(capacity->max_elements * 2, CLAY_MAX_ELEMENTS);
+	}
+	if (capacity->words_exceeded) {
+		capacity->wanted_words = xtd_min(capacity->max_words * 2, CLAY_MAX_MEASURED_WORDS);
+	}
+	return capacity->wanted_elements != capacity->max_elements || capacity->wanted_words != capacity->max_words;
+}
+
+// what the layout just used decides the counts for the next one
+static void plan_clay_capacity (ClayCapacity *capacity) {
+	Clay_Context *context = Clay_GetCurrentContext();
+	i32 elements = context->layoutElements.length;
+	i32 words = context->measuredWords.length - context->measuredWordsFreeList.length;
+	capacity->peak_elements = xtd_max(capacity->peak_elements, elements);
+	capacity->peak_words = xtd_max(capacity->peak_words, words);
+
+	if (elements * 4 > capacity->max_elements * 3 || words * 4 > capacity->max_words * 3) {
+		capacity->wanted_elements = xtd_max(capacity->max_elements, clay_capacity_for(elements, CLAY_MIN_ELEMENTS, CLAY_MAX_ELEMENTS));
+		capacity->wanted_words = xtd_max(capacity->max_words, clay_capacity_for(words, CLAY_MIN_MEASURED_WORDS, CLAY_MAX_MEASURED_WORDS));
+		return;
+	}
+
+	// a count comes down only when the peak fits in a quarter of it, so the
+	// next frame near the old peak does not bring it straight back up
+	u64 now = SDL_GetTicksNS();
+	if (now - capacity->window_start_ns < CLAY_SHRINK_DELAY_NS) {
+		return;
+	}
+	capacity->wanted_elements = xtd_min(capacity->max_elements, clay_capacity_for(capacity->peak_elements, CLAY_MIN_ELEMENTS, CLAY_MAX_ELEMENTS));
+	capacity->wanted_words = xtd_min(capacity->max_words, clay_capacity_for(capacity->peak_words, CLAY_MIN_MEASURED_WORDS, CLAY_MAX_MEASURED_WORDS));
+	capacity->window_start_ns = now;
+	capacity->peak_elements = 0;
+	capacity->peak_words = 0;
+}
+
+// A layout that ran out of room is never drawn. Nor is it laid out again
+// within the frame, since its hover callbacks have already acted on this
+// pointer state; the context grows before the next frame, which is drawn
+// whatever its hash. Returns false for a dropped frame
+static bool lay_out (ApplicationState *app, Clay_RenderCommandArray *cmds) {
+	ClayCapacity *capacity = &app->clay_capacity;
+	if (capacity->wanted_elements != capacity->max_elements || capacity->wanted_words != capacity->max_words) {
+		resize_clay_context(app);
+	}
+	text_truncator_begin_frame(&app->truncator);
+	capacity->elements_exceeded = false;
+	capacity->words_exceeded = false;
+	*cmds = application_layout(app);
+	if (grow_clay_capacity(capacity)) {
+		app->frame_stats.force_redraw = true;
+		return false;
+	}
+	plan_clay_capacity(capacity);
+	return true;
+}
+
+//=============================================================================
+// UPDATE AND RENDER
+//=============================================================================
+
 static void update_clay_dimensions_and_mouse_state (ApplicationState *app) {
     i32 screen_width, screen_height;
     SDL_GetWindowSize(app->window, &screen_width, &screen_height);
@@ -67,15 +211,142 @@ static void update_clay_dimensions_and_mouse_state (ApplicationState *app) {
     );
 }
 
-static void render (ApplicationState *app) {
-    Clay_RenderCommandArray cmds = application_layout(app);
+// samples only frames that were presented; input handled in a frame skipped
+// as unchanged put nothing new on screen, so it is only counted
+static void record_input_latency (ApplicationState *app, bool presented) {
+	PendingInput *input = &app->pending_input;
+	LatencyStats *stats = &app->input_latency;
+	u64 now = SDL_GetTicksNS();
+
+	if (input->oldest_event_ns != 0) {
+		if (presented) {
+			u64 latency = now - input->oldest_event_ns;
+			stats->total_ns += latency;
+			stats->max_ns = xtd_max(stats->max_ns, latency);
+			stats->num_samples++;
+			stats->num_events += input->num_events;
+			stats->session_total_ns += latency;
+			stats->session_max_ns = xtd_max(stats->session_max_ns, latency);
+			stats->session_samples++;
+			stats->session_events += input->num_events;
+		} else {
+			stats->num_unpresented += input->num_events;
+			stats->session_unpresented += input->num_events;
+		}
+		input->oldest_event_ns = 0;
+		input->num_events = 0;
+	}
 
-    SDL_SetRenderDrawColor(app->render_context.renderer, 0, 0, 0, 0);
-    SDL_RenderClear(app->render_context.renderer);
+	if (now - stats->window_start_ns < SDL_NS_PER_SECOND) {
+		return;
+	}
 
-    render_clay_commands(&app->render_context, &cmds);
+	if (stats->log_enabled && stats->num_samples > 0) {
+		SDL_Log("input-to-present latency: avg %.2f ms, max %.2f ms, %u events in %u frames (%s)",
+			(f64) stats->total_ns / stats->num_samples / SDL_NS_PER_MS,
+			(f64) stats->max_ns / SDL_NS_PER_MS,
+			stats->num_events, stats->num_samples,
+			app->coalesce_input ? "coalesced" : "per-event");
+	}
+	if (stats->log_enabled && stats->num_unpresented > 0) {
+		SDL_Log("input in frames skipped as unchanged: %u events", stats->num_unpresented);
+	}
+
+	stats->window_start_ns = now;
+	stats->total_ns = 0;
+	stats->max_ns = 0;
+	stats->num_samples = 0;
+	stats->num_events = 0;
+	stats->num_unpresented = 0;
+}
+
+// --input-latency also sums up the run at exit; replaying one --record with
+// and without --no-input-coalescing gives the before and after
+static void log_input_latency_summary (ApplicationState *app) {
+	LatencyStats *stats = &app->input_latency;
+	if (!stats->log_enabled || stats->session_samples == 0) {
+		return;
+	}
+	SDL_Log("input-to-present latency over the run: avg %.2f ms, max %.2f ms, %llu events in %llu frames, %llu more in frames skipped as unchanged, %llu window geometry calls (%s)",
+		(f64) stats->session_total_ns / stats->session_samples / SDL_NS_PER_MS,
+		(f64) stats->session_max_ns / SDL_NS_PER_MS,
+		(unsigned long long) stats->session_events, (unsigned long long) stats->session_samples,
+		(unsigned long long) stats->session_unpresented,
+		(unsigned long long) stats->num_geometry_calls,
+		app->coalesce_input ? "coalesced" : "per-event");
+}
+
+// pointer queries between frames go against what this frame put on screen
+static void build_hit_index (ApplicationState *app, Clay_RenderCommandArray *commands) {
+	Clay_BoundingBox window = Clay_GetElementData(ui_ids.top_level_container).boundingBox;
+	hit_index_build(&app->hit_index, commands, window.width, window.height);
+	hit_index_set_rows(&app->hit_index, ui_ids.file_explorer_search_results_list.id,
+		app->explorer_scroll.offset, EXPLORER_ROW_HEIGHT, app->explorer_laid_out_rows);
+}
+
+// --frame-stats: the share of frames skipped as identical, logged once a
+// second. Frames dropped for want of Clay room are counted apart, so they do
+// not pass for skips
+static void record_frame (ApplicationState *app, bool skipped, bool dropped) {
+	FrameStats *stats = &app->frame_stats;
+	if (dropped) {
+		stats->num_dropped++;
+	} else {
+		stats->num_frames++;
+		stats->num_skipped += skipped;
+	}
+
+	u64 now = SDL_GetTicksNS();
+	if (now - stats->window_start_ns < SDL_NS_PER_SECOND) {
+		return;
+	}
+	if (stats->log_enabled && stats->num_frames > 0) {
+		SDL_Log("frames: %u of %u skipped as unchanged (%.1f%%)",
+			stats->num_skipped, stats->num_frames, 100.0 * stats->num_skipped / stats->num_frames);
+	}
+	if (stats->log_enabled && stats->num_dropped > 0) {
+		SDL_Log("frames: %u dropped when Clay ran out of room", stats->num_dropped);
+	}
+	stats->window_start_ns = now;
+	stats->num_frames = 0;
+	stats->num_skipped = 0;
+	stats->num_dropped = 0;
+}
 
-    SDL_RenderPresent(app->render_context.renderer);
+// a frame whose commands hash the same as the last one presented would draw
+// the same pixels, so it is neither drawn nor presented
+static void render (ApplicationState *app) {
+	FrameStats *frame = &app->frame_stats;
+	u64 layout_start = SDL_GetTicksNS();
+	Clay_RenderCommandArray cmds;
+	bool laid_out = lay_out(app, &cmds);
+	u64 layout_ns = SDL_GetTicksNS() - layout_start;
+
+	// the screen, the hit index and the pending input all stay as they were
+	if (!laid_out) {
+		record_frame(app, false, true);
+		frame->layout_ns = layout_ns;
+		frame->num_commands = 0;
+		frame->skipped = true;
+		return;
+	}
+	build_hit_index(app, &cmds);
+
+	u64 hash = render_commands_hash(&cmds);
+	bool skip = hash == frame->last_hash && !frame->force_redraw;
+	record_frame(app, skip, false);
+	frame->layout_ns = layout_ns;
+	frame->num_commands = (u32) cmds.length;
+	frame->skipped = skip;
+	if (!skip) {
+		frame->last_hash = hash;
+		frame->force_redraw = false;
+
+		render_clear(&app->render_context);
+		render_clay_commands(&app->render_context, &cmds);
+		render_present(&app->render_context);
+	}
+	record_input_latency(app, !skip);
 }
 
 //=============================================================================
@@ -89,8 +360,8 @@ bool check_resizing (ApplicationState *app) {
 		return false;
 	}
 	
-	f32 cursor_x, cursor_y;
-	SDL_GetGlobalMouseState(&cursor_x, &cursor_y);
+	i32 cursor_x = app->mouse_state.global_position_x;
+	i32 cursor_y = app->mouse_state.global_position_y;
 
 	SDL_Window *window = app->window;
 
@@ -117,11 +388,30 @@ bool check_resizing (ApplicationState *app) {
         }
     }
 
-	SDL_SetCursor(cursor);
+	if (cursor != app->applied_cursor) {
+		SDL_SetCursor(cursor);
+		app->applied_cursor = cursor;
+	}
 	app->resize_mode = mask;
 	return (mask == 0);
 }
 
+// only forwards coordinates that actually changed to the window system
+static void set_window_geometry (ApplicationState *app, i32 x, i32 y, i32 w, i32 h) {
+	if (x != app->window_applied_x || y != app->window_applied_y) {
+		SDL_SetWindowPosition(app->window, x, y);
+		app->input_latency.num_geometry_calls++;
+		app->window_applied_x = x;
+		app->window_applied_y = y;
+	}
+	if (w != app->window_applied_w || h != app->window_applied_h) {
+		SDL_SetWindowSize(app->window, w, h);
+		app->input_latency.num_geometry_calls++;
+		app->window_applied_w = w;
+		app->window_applied_h = h;
+	}
+}
+
 void handle_resizing (ApplicationState *app) {
     if (!app->mouse_state.is_down || !app->resize_started_from_hit_test || app->drag_started_from_hit_test) {
 		return;
@@ -163,34 +453,21 @@ void handle_resizing (ApplicationState *app) {
         new_h = min_h;
     }
 
-    SDL_SetWindowPosition(app->window, new_x, new_y);
-    SDL_SetWindowSize(app->window, new_w, new_h);
+    set_window_geometry(app, new_x, new_y, new_w, new_h);
 }
 
+// the header drags the window everywhere but on its buttons
 bool check_dragging (ApplicationState *app) {
 	
 	if (app->drag_started_from_hit_test || app->resize_mode != EDGE_NONE) {
 		return false;
 	}
-	
-	i32 cursor_x = app->mouse_state.position_x;
-	i32 cursor_y = app->mouse_state.position_y;
-
-	Clay_ElementData header_data = Clay_GetElementData(CLAY_ID("ApplicationHeader"));
-	xtd_assert(header_data.found == true);
-	
-	Clay_BoundingBox header_bounding_box = header_data.boundingBox;
-
-	i32 drag_area_left_x = header_bounding_box.x;
-	i32 drag_area_top_y = header_bounding_box.y;
-	i32 drag_area_right_x = header_bounding_box.x + header_bounding_box.width - (35 * 3);
-	i32 drag_area_bottom_y = header_bounding_box.y + header_bounding_box.height;
 
-	bool cursor_within_drag_area = 
-		xtd_is_between(cursor_x, drag_area_left_x, drag_area_right_x) && 
-		xtd_is_between(cursor_y, drag_area_top_y, drag_area_bottom_y);
-	
-	return cursor_within_drag_area;
+	HitIndex *index = &app->hit_index;
+	return hit_index_pointer_over(index, ui_ids.application_header.id) &&
+		!hit_index_pointer_over(index, ui_ids.application_minimize_button.id) &&
+		!hit_index_pointer_over(index, ui_ids.application_maximize_button.id) &&
+		!hit_index_pointer_over(index, ui_ids.application_close_button.id);
 }
 
 void handle_dragging(ApplicationState *app) {
@@ -210,43 +487,1264 @@ void handle_dragging(ApplicationState *app) {
 	i32 new_x = window_x + dx;
 	i32 new_y = window_y + dy;
 
-    SDL_SetWindowPosition(app->window, new_x, new_y);
+	set_window_geometry(app, new_x, new_y, app->window_applied_w, app->window_applied_h);
+}
+
+//=============================================================================
+// SEARCH
+//=============================================================================
+
+// a leading '/' makes the rest a regex; an all-lowercase query ignores case
+static SearchFlags search_flags_for_query (const char *query) {
+	SearchFlags flags = SEARCH_FLAG_IGNORE_CASE;
+	if (query[0] == '/') {
+		flags |= SEARCH_FLAG_REGEX;
+	}
+	for (const char *c = query; *c; c++) {
+		if (*c >= 'A' && *c <= 'Z') {
+			flags &= ~SEARCH_FLAG_IGNORE_CASE;
+			break;
+		}
+	}
+	return flags;
+}
+
+static void submit_search (ApplicationState *app) {
+	SearchFlags flags = search_flags_for_query(app->search_query);
+	const char *pattern = app->search_query + ((flags & SEARCH_FLAG_REGEX) ? 1 : 0);
+	app->search_first_hit = 0;
+	search_start(&app->search_engine, app->workspace.roots, app->workspace.num_roots, pattern, flags);
+}
+
+static void clear_search (ApplicationState *app) {
+	search_cancel(&app->search_engine);
+	app->search_query_length = 0;
+	app->search_query[0] = '\0';
+}
+
+static void update_search (ApplicationState *app) {
+	SearchEngine *engine = &app->search_engine;
+	search_update(engine);
+
+	app->search_visible_rows = SEARCH_RESULT_MAX_ROWS;
+	Clay_ElementData list_data = Clay_GetElementData(ui_ids.search_results_list);
+	if (list_data.found) {
+		app->search_visible_rows = xtd_min((u32) (list_data.boundingBox.height / SEARCH_RESULT_ROW_HEIGHT) + 1, (u32) SEARCH_RESULT_MAX_ROWS);
+	}
+	app->search_first_hit = xtd_min(app->search_first_hit, engine->num_hits ? engine->num_hits - 1 : 0);
+
+	SearchStats *stats = &engine->stats;
+	u64 end_ns = search_is_busy(engine) ? SDL_GetTicksNS() : stats->end_ns;
+	f64 seconds = (f64) (end_ns - stats->start_ns) / SDL_NS_PER_SECOND;
+	SDL_snprintf(app->search_status, sizeof(app->search_status), "%u matches, %llu / %llu files%s  %.2f GB/s",
+		engine->num_hits,
+		(unsigned long long) stats->num_files_searched, (unsigned long long) stats->num_files,
+		search_is_busy(engine) ? "..." : "",
+		seconds > 0 ? (f64) stats->bytes_searched / 1e9 / seconds : 0.0);
+}
+
+static void scroll_search_results (ApplicationState *app, f32 wheel_delta) {
+	i32 lines = (i32) (-wheel_delta * PREVIEW_WHEEL_LINES);
+	i64 first = (i64) app->search_first_hit + lines;
+	app->search_first_hit = (u32) xtd_max(first, 0ll);
+}
+
+static void append_search_text (ApplicationState *app, const char *text) {
+	size_t length = SDL_strlen(text);
+	if (app->search_query_length + length >= sizeof(app->search_query)) {
+		return;
+	}
+	SDL_memcpy(app->search_query + app->search_query_length, text, length + 1);
+	app->search_query_length += (u32) length;
+}
+
+// returns true if the key was consumed by the query box
+static bool handle_search_key (ApplicationState *app, SDL_Keycode key) {
+	switch (key) {
+	case SDLK_BACKSPACE:
+		// drop the whole trailing UTF-8 sequence
+		while (app->search_query_length > 0) {
+			u8 c = (u8) app->search_query[--app->search_query_length];
+			if ((c & 0xC0) != 0x80) break;
+		}
+		app->search_query[app->search_query_length] = '\0';
+		return true;
+	case SDLK_RETURN:
+	case SDLK_KP_ENTER:
+		if (app->search_query_length > 0) {
+			submit_search(app);
+		}
+		return true;
+	case SDLK_ESCAPE:
+		if (app->search_query_length > 0 || search_is_busy(&app->search_engine)) {
+			clear_search(app);
+			return true;
+		}
+		return false;
+	}
+	return false;
+}
+
+//=============================================================================
+// FILE OPERATIONS
+//=============================================================================
+
+static const char *operation_verbs[][2] = {
+	[FILE_OPERATION_COPY]   = { "Copying", "Copied" },
+	[FILE_OPERATION_MOVE]   = { "Moving", "Moved" },
+	[FILE_OPERATION_DELETE] = { "Deleting", "Deleted" },
+};
+
+static void format_bytes (char *buffer, size_t size, u64 bytes) {
+	if (bytes >= (1ull << 30)) SDL_snprintf(buffer, size, "%.2f GB", (f64) bytes / (1ull << 30));
+	else if (bytes >= (1ull << 20)) SDL_snprintf(buffer, size, "%.1f MB", (f64) bytes / (1ull << 20));
+	else SDL_snprintf(buffer, size, "%.0f KB", (f64) bytes / (1ull << 10));
+}
+
+// the clicked row, or failing that the first root
+static const char *current_directory_path (ApplicationState *app, char *buffer, size_t size) {
+	if (!app->current_path) {
+		return app->workspace.num_roots ? app->workspace.roots[0].path : NULL;
+	}
+	if (app->current_is_directory) {
+		return app->current_path;
+	}
+	SDL_strlcpy(buffer, app->current_path, size);
+	char *separator = SDL_strrchr(buffer, PATH_SEPARATOR);
+	if (separator) *separator = '\0';
+	return buffer;
+}
+
+static bool has_ancestor (Directory *directory, Directory *ancestor) {
+	for (; directory; directory = directory->parent) {
+		if (directory == ancestor) return true;
+	}
+	return false;
+}
+
+// The paths file operations act on: the selected rows, or the clicked row
+// when nothing is selected. Rows below a selected directory go with it and
+// are left out; rows are in tree order, so such a directory always comes
+// first. Returns the count, *sources is freed by the caller
+static u32 operation_sources (ApplicationState *app, const char ***sources) {
+	Selection *selection = &app->selection;
+	if (!selection->num_selected) {
+		*sources = SDL_malloc(sizeof(char *));
+		(*sources)[0] = app->current_path;
+		return app->current_path ? 1 : 0;
+	}
+	*sources = SDL_malloc(selection->num_selected * sizeof(char *));
+	u32 num_sources = 0;
+	Directory *enclosing = NULL;
+	for (u32 i = 0; i < selection->num_ranges; i++) {
+		RowRange range = selection->ranges[i];
+		for (u32 index = range.first; index < xtd_min(range.end, app->num_explorer_rows); index++) {
+			ExplorerRow *row = &app->explorer_rows[index];
+			Directory *parent = row->directory ? row->directory->parent : row->file->parent;
+			if (enclosing && has_ancestor(parent, enclosing)) {
+				continue;
+			}
+			if (row->directory) {
+				enclosing = row->directory;
+			}
+			(*sources)[num_sources++] = row->directory ? row->directory->path : row->file->path;
+		}
+	}
+	return num_sources;
+}
+
+static void free_clipboard (ApplicationState *app) {
+	for (u32 i = 0; i < app->num_clipboard_paths; i++) {
+		SDL_free(app->clipboard_paths[i]);
+	}
+	SDL_free(app->clipboard_paths);
+	app->clipboard_paths = NULL;
+	app->num_clipboard_paths = 0;
+}
+
+// the clipboard keeps copies, the rows may be gone by the time it is pasted
+static void set_clipboard (ApplicationState *app, bool cut) {
+	const char **sources;
+	u32 num_sources = operation_sources(app, &sources);
+	if (num_sources) {
+		free_clipboard(app);
+		app->clipboard_paths = SDL_malloc(num_sources * sizeof(char *));
+		for (u32 i = 0; i < num_sources; i++) {
+			app->clipboard_paths[i] = SDL_strdup(sources[i]);
+		}
+		app->num_clipboard_paths = num_sources;
+		app->clipboard_cut = cut;
+		if (num_sources == 1) {
+			SDL_snprintf(app->file_ops_status, sizeof(app->file_ops_status), "%s %s",
+				cut ? "Cut" : "Copied", app->clipboard_paths[0]);
+		} else {
+			SDL_snprintf(app->file_ops_status, sizeof(app->file_ops_status), "%s %u items",
+				cut ? "Cut" : "Copied", num_sources);
+		}
+	}
+	SDL_free(sources);
+}
+
+static void paste_clipboard (ApplicationState *app) {
+	char buffer[1024];
+	const char *destination = current_directory_path(app, buffer, sizeof(buffer));
+	if (!app->num_clipboard_paths || !destination) {
+		return;
+	}
+	file_ops_start(&app->file_ops, app->clipboard_cut ? FILE_OPERATION_MOVE : FILE_OPERATION_COPY,
+		(const char **) app->clipboard_paths, app->num_clipboard_paths, destination);
+
+	// a cut pastes once
+	if (app->clipboard_cut) {
+		free_clipboard(app);
+	}
+	app->file_ops_status[0] = '\0';
+}
+
+// deleting is permanent, so the first press only arms it
+static void delete_current (ApplicationState *app) {
+	const char **sources;
+	u32 num_sources = operation_sources(app, &sources);
+	u64 now = SDL_GetTicksNS();
+	if (num_sources && now - app->delete_armed_ns > FILE_DELETE_CONFIRM_NS) {
+		app->delete_armed_ns = now;
+		if (num_sources == 1) {
+			SDL_snprintf(app->file_ops_status, sizeof(app->file_ops_status),
+				"Press Shift+Delete again to delete %s", sources[0]);
+		} else {
+			SDL_snprintf(app->file_ops_status, sizeof(app->file_ops_status),
+				"Press Shift+Delete again to delete %u items", num_sources);
+		}
+	} else if (num_sources) {
+		app->delete_armed_ns = 0;
+		file_ops_start(&app->file_ops, FILE_OPERATION_DELETE, sources, num_sources, NULL);
+		app->file_ops_status[0] = '\0';
+	}
+	SDL_free(sources);
+}
+
+static bool preview_is_inside (ApplicationState *app, Directory *directory) {
+	for (Directory *ancestor = app->preview.file ? app->preview.file->parent : NULL; ancestor; ancestor = ancestor->parent) {
+		if (ancestor == directory) return true;
+	}
+	return false;
+}
+
+// brings the loaded trees in line with what the operation did on disk
+static void apply_file_operation (ApplicationState *app, FileOperation *operation) {
+	Workspace *workspace = &app->workspace;
+	Directory *destination = operation->destination ? workspace_find_directory(workspace, operation->destination) : NULL;
+
+	for (u32 i = 0; i < operation->num_items; i++) {
+		FileOperationItem *item = &operation->items[i];
+		bool failed = SDL_GetAtomicInt(&item->failed) != 0;
+
+		// a failed file copy leaves nothing behind, a failed directory copy whatever it got to
+		if (destination && item->created && (item->is_directory || !failed)) {
+			if (item->is_directory) {
+				workspace_insert_directory(workspace, destination, item->target, item->modified_time);
+			} else {
+				workspace_insert_file(workspace, destination, item->target, item->size, item->modified_time);
+			}
+		}
+
+		if (operation->kind == FILE_OPERATION_COPY || failed) {
+			continue;
+		}
+		File *file = workspace_find_file(workspace, item->source);
+		Directory *directory = file ? NULL : workspace_find_directory(workspace, item->source);
+		if ((file && app->preview.file == file) || (directory && preview_is_inside(app, directory))) {
+			preview_close(&app->preview);
+		}
+		if (file) {
+			workspace_remove_file(workspace, file);
+			git_status_reclassify(&app->git_status, file->parent);
+		}
+		if (directory) {
+			workspace_remove_directory(workspace, directory);
+			if (directory->parent) git_status_reclassify(&app->git_status, directory->parent);
+		}
+	}
+
+	if (destination) {
+		git_status_reclassify(&app->git_status, destination);
+	}
+	if (destination && destination->expanded) {
+		sort_directory_children(&app->sort_engine, destination, app->sort_column, app->sort_descending);
+	}
+	app->explorer_rows_dirty = true;
+
+	char bytes[32];
+	format_bytes(bytes, sizeof(bytes), atomic_u64_get(&operation->progress.bytes_done));
+	f64 seconds = (f64) (operation->end_ns - operation->start_ns) / SDL_NS_PER_SECOND;
+	i32 num_errors = SDL_GetAtomicInt(&operation->progress.num_errors);
+	SDL_snprintf(app->file_ops_status, sizeof(app->file_ops_status), "%s %d files (%s) in %.1f s%s%s%s",
+		SDL_GetAtomicInt(&operation->cancelled) ? "Cancelled after" : operation_verbs[operation->kind][1],
+		SDL_GetAtomicInt(&operation->progress.num_files_done), bytes, seconds,
+		num_errors ? ", failed: " : "",
+		SDL_GetAtomicInt(&operation->error_ready) ? operation->error : "",
+		num_errors > 1 ? " (and more)" : "");
+}
+
+static void update_file_operations (ApplicationState *app) {
+	u64 now = SDL_GetTicksNS();
+	for (FileOperation *operation = app->file_ops.operations; operation; operation = operation->next) {
+		FileOperationProgress *progress = &operation->progress;
+		const char *verb = operation_verbs[operation->kind][0];
+		i32 num_files = SDL_GetAtomicInt(&progress->num_files);
+
+		if (SDL_GetAtomicInt(&progress->phase) == FILE_OPERATION_PHASE_PLANNING) {
+			SDL_snprintf(operation->label, sizeof(operation->label), "%s: found %d files...", verb, num_files);
+			continue;
+		}
+		char done[32], total[32];
+		u64 bytes_done = atomic_u64_get(&progress->bytes_done);
+		format_bytes(done, sizeof(done), bytes_done);
+		format_bytes(total, sizeof(total), atomic_u64_get(&progress->total_bytes));
+		f64 seconds = (f64) (now - operation->start_ns) / SDL_NS_PER_SECOND;
+		SDL_snprintf(operation->label, sizeof(operation->label), "%s %d / %d files, %s / %s, %.0f MB/s (Esc cancels)",
+			verb, SDL_GetAtomicInt(&progress->num_files_done), num_files, done, total,
+			seconds > 0 ? (f64) bytes_done / (1 << 20) / seconds : 0.0);
+	}
+
+	// inserting children under a directory that is being sorted would be undone by the sort
+	if (sort_engine_is_busy(&app->sort_engine)) {
+		return;
+	}
+	FileOperation *operation;
+	while ((operation = file_ops_take_finished(&app->file_ops))) {
+		apply_file_operation(app, operation);
+		file_operation_free(operation);
+	}
+}
+
+static bool handle_file_operation_key (ApplicationState *app, SDL_Keycode key, SDL_Keymod modifiers) {
+	bool command = (modifiers & (SDL_KMOD_CTRL | SDL_KMOD_GUI)) != 0;
+	switch (key) {
+	case SDLK_C:
+		if (command) set_clipboard(app, false);
+		return command;
+	case SDLK_X:
+		if (command) set_clipboard(app, true);
+		return command;
+	case SDLK_V:
+		if (command) paste_clipboard(app);
+		return command;
+	case SDLK_DELETE:
+		if (modifiers & SDL_KMOD_SHIFT) delete_current(app);
+		return (modifiers & SDL_KMOD_SHIFT) != 0;
+	case SDLK_ESCAPE:
+		if (file_ops_is_busy(&app->file_ops)) {
+			file_ops_cancel_all(&app->file_ops);
+			return true;
+		}
+		return false;
+	}
+	return false;
+}
+
+//=============================================================================
+// SELECTION
+//=============================================================================
+
+// Ctrl+A selects every row, Ctrl+I inverts the selection and Escape clears
+// it once nothing running is left to cancel
+static bool handle_selection_key (ApplicationState *app, SDL_Keycode key, SDL_Keymod modifiers) {
+	Selection *selection = &app->selection;
+	bool command = (modifiers & (SDL_KMOD_CTRL | SDL_KMOD_GUI)) != 0;
+	switch (key) {
+	case SDLK_A:
+		if (!command) return false;
+		selection_add(selection, (RowRange) { 0, app->num_explorer_rows });
+		break;
+	case SDLK_I:
+		if (!command) return false;
+		selection_invert(selection, app->num_explorer_rows);
+		break;
+	case SDLK_ESCAPE:
+		if (!selection->num_selected) return false;
+		selection_clear(selection);
+		break;
+	default:
+		return false;
+	}
+	app->delete_armed_ns = 0;
+	return true;
+}
+
+//=============================================================================
+// SORTING
+//=============================================================================
+
+// Ctrl+1 to Ctrl+4 sort the explorer by name, extension, size or modified
+// time; picking the column it is already sorted by reverses the order
+static void sort_expanded_directories (ApplicationState *app, Directory *directory) {
+	if (directory->unloaded) {
+		return;
+	}
+	sort_directory_children(&app->sort_engine, directory, app->sort_column, app->sort_descending);
+	for (u32 i = 0; i < directory->num_child_directories; i++) {
+		// collapsed directories are sorted when they are expanded
+		if (directory->child_directories[i]->expanded) {
+			sort_expanded_directories(app, directory->child_directories[i]);
+		}
+	}
+}
+
+static bool handle_sort_key (ApplicationState *app, SDL_Keycode key, SDL_Keymod modifiers) {
+	if (!(modifiers & (SDL_KMOD_CTRL | SDL_KMOD_GUI)) || key < SDLK_1 || key >= SDLK_1 + NUM_SORT_COLUMNS) {
+		return false;
+	}
+	SortColumn column = (SortColumn) (key - SDLK_1);
+	app->sort_descending = column == app->sort_column ? !app->sort_descending : false;
+	app->sort_column = column;
+	for (u32 i = 0; i < app->workspace.num_roots; i++) {
+		sort_expanded_directories(app, &app->workspace.roots[i]);
+	}
+	return true;
+}
+
+//=============================================================================
+// DUPLICATES
+//=============================================================================
+
+// Ctrl+D looks for duplicates below the workspace roots. Escape stops a
+// running search, then closes the list
+static void start_duplicate_search (ApplicationState *app) {
+	app->duplicates_visible = true;
+	app->duplicates_first_row = 0;
+	app->duplicates_labeled = 0;
+	duplicate_finder_start(&app->duplicates, app->workspace.roots, app->workspace.num_roots);
+}
+
+static void update_duplicates (ApplicationState *app) {
+	DuplicateFinder *finder = &app->duplicates;
+	duplicate_finder_update(finder);
+
+	for (; app->duplicates_labeled < finder->num_sets; app->duplicates_labeled++) {
+		DuplicateSet *set = &finder->sets[app->duplicates_labeled];
+		char size[16], reclaimable[16];
+		format_bytes(size, sizeof(size), set->size);
+		format_bytes(reclaimable, sizeof(reclaimable), set->size * (set->num_files - 1));
+		SDL_snprintf(set->label, sizeof(set->label), "%u copies of %s, %s reclaimable", set->num_files, size, reclaimable);
+	}
+
+	app->duplicates_visible_rows = DUPLICATE_MAX_ROWS;
+	Clay_ElementData list_data = Clay_GetElementData(ui_ids.duplicates_list);
+	if (list_data.found) {
+		app->duplicates_visible_rows = xtd_min((u32) (list_data.boundingBox.height / DUPLICATE_ROW_HEIGHT) + 1, (u32) DUPLICATE_MAX_ROWS);
+	}
+	app->duplicates_first_row = xtd_min(app->duplicates_first_row, finder->num_rows ? finder->num_rows - 1 : 0);
+
+	DuplicateStats *stats = &finder->stats;
+	u64 end_ns = duplicate_finder_is_busy(finder) ? SDL_GetTicksNS() : stats->end_ns;
+	f64 seconds = (f64) (end_ns - stats->start_ns) / SDL_NS_PER_SECOND;
+	char reclaimable[16];
+	format_bytes(reclaimable, sizeof(reclaimable), stats->reclaimable_bytes);
+	SDL_snprintf(app->duplicates_status, sizeof(app->duplicates_status), "%u duplicate sets, %s reclaimable  %llu files, %llu same size, %llu same ends%s  %.2f GB/s",
+		finder->num_sets, reclaimable,
+		(unsigned long long) stats->num_files, (unsigned long long) stats->num_size_candidates,
+		(unsigned long long) stats->num_content_candidates,
+		duplicate_finder_is_busy(finder) ? "..." : "",
+		seconds > 0 ? (f64) stats->bytes_read / 1e9 / seconds : 0.0);
+}
+
+static void scroll_duplicates (ApplicationState *app, f32 wheel_delta) {
+	i32 lines = (i32) (-wheel_delta * PREVIEW_WHEEL_LINES);
+	i64 first = (i64) app->duplicates_first_row + lines;
+	app->duplicates_first_row = (u32) xtd_max(first, 0ll);
 }
+
+static bool handle_duplicates_key (ApplicationState *app, SDL_Keycode key, SDL_Keymod modifiers) {
+	bool command = (modifiers & (SDL_KMOD_CTRL | SDL_KMOD_GUI)) != 0;
+	switch (key) {
+	case SDLK_D:
+		if (command) start_duplicate_search(app);
+		return command;
+	case SDLK_ESCAPE:
+		if (duplicate_finder_is_busy(&app->duplicates)) {
+			duplicate_finder_cancel(&app->duplicates);
+			return true;
+		}
+		if (app->duplicates_visible) {
+			app->duplicates_visible = false;
+			return true;
+		}
+		return false;
+	}
+	return false;
+}
+
+//=============================================================================
+// INPUT
+//=============================================================================
+
+static void note_input_event (ApplicationState *app, u64 timestamp_ns) {
+	PendingInput *input = &app->pending_input;
+	if (input->oldest_event_ns == 0 || timestamp_ns < input->oldest_event_ns) {
+		input->oldest_event_ns = timestamp_ns;
+	}
+	input->num_events++;
+}
+
+// a replay moves the pointer only through its events, so it reports where
+// they put it rather than where the real cursor is
+static void update_global_mouse_position (ApplicationState *app) {
+	f32 global_x, global_y;
+	if (app->replay_started) {
+		global_x = app->replay.pointer_x;
+		global_y = app->replay.pointer_y;
+	} else {
+		SDL_GetGlobalMouseState(&global_x, &global_y);
+	}
+	app->mouse_state.global_position_x = (i32) global_x;
+	app->mouse_state.global_position_y = (i32) global_y;
+}
+
+static void remember_window_geometry (ApplicationState *app) {
+	SDL_GetWindowPosition(app->window, &app->window_resize_start_x, &app->window_resize_start_y);
+	SDL_GetWindowSize(app->window, &app->window_resize_start_w, &app->window_resize_start_h);
+	app->window_applied_x = app->window_resize_start_x;
+	app->window_applied_y = app->window_resize_start_y;
+	app->window_applied_w = app->window_resize_start_w;
+	app->window_applied_h = app->window_resize_start_h;
+}
+
+static void press_mouse (ApplicationState *app) {
+	app->mouse_state.is_down = true;
+
+	app->mouse_state.position_x = app->pending_input.position_x;
+	app->mouse_state.position_y = app->pending_input.position_y;
+	update_global_mouse_position(app);
+
+	app->mouse_state.global_drag_start_x = app->mouse_state.global_position_x;
+	app->mouse_state.global_drag_start_y = app->mouse_state.global_position_y;
+	app->mouse_state.drag_start_x = app->mouse_state.position_x;
+	app->mouse_state.drag_start_y = app->mouse_state.position_y;
+	hit_index_set_pointer(&app->hit_index, app->pending_input.position_x, app->pending_input.position_y);
+	
+	if (!app->resize_started_from_hit_test && app->resize_mode != EDGE_NONE) {
+		remember_window_geometry(app);
+		app->resize_started_from_hit_test = true;
+	}
 	
+	if (!app->drag_started_from_hit_test && check_dragging(app)) {
+		remember_window_geometry(app);
+		app->drag_started_from_hit_test = true;
+	}	
+	handle_explorer_row_press(app);
+}
+
+static void release_mouse (ApplicationState *app) {
+	app->mouse_state.is_down = false;
+	hit_index_set_pointer(&app->hit_index, app->pending_input.position_x, app->pending_input.position_y);
+	handle_explorer_row_release(app);
+	scroll_end_thumb_drag(&app->explorer_scroll);
+	app->resize_started_from_hit_test = false;
+	app->drag_started_from_hit_test = false;
+}
+
+// applies everything SDL_AppEvent gathered since the last frame: one global
+// mouse query, at most one window geometry change and one scroll update
+static void apply_pending_input (ApplicationState *app) {
+	PendingInput *input = &app->pending_input;
+
+	// a press and release inside one frame would otherwise never be seen as a click
+	if (input->release_deferred && !input->pressed_this_frame) {
+		release_mouse(app);
+		input->release_deferred = false;
+	}
+
+	update_global_mouse_position(app);
+
+	if (input->motion) {
+		app->mouse_state.position_x = input->position_x;
+		app->mouse_state.position_y = input->position_y;
+		hit_index_set_pointer(&app->hit_index, input->position_x, input->position_y);
+		handle_resizing(app);
+		handle_dragging(app);
+		input->motion = false;
+	}
+
+	if (input->wheel_x != 0 || input->wheel_y != 0) {
+		app->mouse_state.wheel_x = input->wheel_x;
+		app->mouse_state.wheel_y = input->wheel_y;
+		HitIndex *index = &app->hit_index;
+		if (hit_index_pointer_over(index, ui_ids.file_explorer_search_results_list.id)) {
+			scroll_add_wheel(&app->explorer_scroll, input->wheel_y);
+		} else if (hit_index_pointer_over(index, ui_ids.search_results_list.id)) {
+			scroll_search_results(app, input->wheel_y);
+		} else if (hit_index_pointer_over(index, ui_ids.duplicates_list.id)) {
+			scroll_duplicates(app, input->wheel_y);
+		} else if (hit_index_pointer_over(index, ui_ids.file_preview_lines.id)) {
+			preview_scroll_wheel(&app->preview, input->wheel_y);
+		}
+		input->wheel_x = 0;
+		input->wheel_y = 0;
+	}
+}
+
+//=============================================================================
+// SCROLLING
+//=============================================================================
+
+static void update_frame_time (ApplicationState *app) {
+	u64 now = SDL_GetTicksNS();
+	if (app->last_frame_ns == 0) {
+		app->last_frame_ns = now;
+	}
+	// clamp so a stalled frame doesn't launch the scroll position
+	app->delta_time = xtd_min((f32) (now - app->last_frame_ns) / SDL_NS_PER_SECOND, 0.1f);
+	app->last_frame_ns = now;
+}
+
+static void update_explorer_scroll (ApplicationState *app) {
+	ScrollState *scroll = &app->explorer_scroll;
+
+	// geometry comes from the previous layout, which is what is on screen
+	Clay_ElementData list_data = Clay_GetElementData(ui_ids.file_explorer_search_results_list);
+	if (list_data.found) {
+		scroll->viewport_height = list_data.boundingBox.height;
+	}
+	scroll->content_height = (f32) app->num_explorer_rows * EXPLORER_ROW_HEIGHT;
+
+	scroll_update_thumb_drag(scroll, app->mouse_state.position_y, scroll->viewport_height);
+	scroll_update(scroll, app->delta_time);
+}
+
+// the rows the last layout produced, prefetch included, clamped to the current list
+static RowRange laid_out_explorer_rows (ApplicationState *app) {
+	RowRange rows = app->explorer_laid_out_rows;
+	rows.end = xtd_min(rows.end, app->num_explorer_rows);
+	rows.first = xtd_min(rows.first, rows.end);
+	return rows;
+}
+
+// files the extension table could not place are sniffed once they are laid out
+static void update_file_types (ApplicationState *app) {
+	file_type_sniffer_update(&app->file_type_sniffer, app->explorer_rows, laid_out_explorer_rows(app));
+}
+
+static void update_thumbnails (ApplicationState *app) {
+	thumbnail_update(&app->thumbnails, app->explorer_rows, laid_out_explorer_rows(app));
+}
+
+// runs after the thumbnail and type updates, which let go of files that are no
+// longer laid out, so nothing in flight points into a collapsed subtree
+static void update_workspace (ApplicationState *app) {
+	workspace_mark_viewed(&app->workspace, app->explorer_rows, laid_out_explorer_rows(app));
+
+	// sort tasks and git status refreshes hold directory pointers, so nothing is freed while one is in flight
+	if (!sort_engine_is_busy(&app->sort_engine) && !git_status_is_refreshing(&app->git_status)) {
+		workspace_free_removed(&app->workspace);
+		workspace_enforce_budget(&app->workspace, app->explorer_rows, app->num_explorer_rows, app->preview.file);
+	}
+}
+
+//=============================================================================
+// PREVIEW
+//=============================================================================
+
+static void update_preview (ApplicationState *app) {
+	// the line area size comes from the previous layout, like the explorer viewport
+	u32 max_visible_lines = PREVIEW_MAX_LINES;
+	Clay_ElementData lines_data = Clay_GetElementData(ui_ids.file_preview_lines);
+	if (lines_data.found) {
+		max_visible_lines = (u32) (lines_data.boundingBox.height / PREVIEW_LINE_HEIGHT) + 1;
+	}
+	preview_update(&app->preview, max_visible_lines);
+}
+
+static void handle_preview_key (ApplicationState *app, SDL_Keycode key) {
+	Preview *preview = &app->preview;
+	i32 page = (i32) xtd_max(preview->max_visible_lines, 2u) - 1;
+
+	switch (key) {
+	case SDLK_HOME:     preview_jump_to_start(preview);       break;
+	case SDLK_END:      preview_jump_to_end(preview);         break;
+	case SDLK_PAGEUP:   preview_scroll_lines(preview, -page); break;
+	case SDLK_PAGEDOWN: preview_scroll_lines(preview, page);  break;
+	case SDLK_UP:       preview_scroll_lines(preview, -1);    break;
+	case SDLK_DOWN:     preview_scroll_lines(preview, 1);     break;
+	}
+}
+
+//=============================================================================
+// INPUT RECORDING
+//=============================================================================
+
+static SDL_AppResult handle_event (ApplicationState *app, SDL_Event *event);
+
+// feeds the frame's share of the replay through the same handler as live
+// input; at max speed the frame also takes the recorded frame's time step
+static SDL_AppResult replay_input (ApplicationState *app) {
+	InputReplay *replay = &app->replay;
+	if (input_replay_finished(replay)) {
+		input_replay_report(replay);
+		return SDL_APP_SUCCESS;
+	}
+
+	if (!replay->start_ns) {
+		SDL_GetWindowPosition(app->window, &replay->window_x, &replay->window_y);
+	}
+	SDL_Event event;
+	while (input_replay_next_event(replay, &event)) {
+		if (event.type == SDL_EVENT_WINDOW_RESIZED) {
+			SDL_SetWindowSize(app->window, event.window.data1, event.window.data2);
+		}
+		SDL_AppResult result = handle_event(app, &event);
+		if (result != SDL_APP_CONTINUE) {
+			input_replay_report(replay);
+			return result;
+		}
+	}
+	if (app->replay_speed == REPLAY_SPEED_MAX) {
+		app->delta_time = xtd_min((f32) replay->frame_delta_ns / SDL_NS_PER_SECOND, 0.1f);
+	}
+	return SDL_APP_CONTINUE;
+}
+
+static SDL_AppResult update_input_log (ApplicationState *app) {
+	bool ready = !scanner_is_busy(&app->scanner);
+	if (app->record_path && !app->recorder.stream && ready) {
+		if (input_recorder_open(&app->recorder, app->window, app->record_path)) {
+			SDL_Log("recording input to %s", app->record_path);
+		}
+		app->record_path = NULL;
+	}
+	input_recorder_frame(&app->recorder);
+
+	if (app->replay_path && (app->replay_started || ready)) {
+		app->replay_started = true;
+		return replay_input(app);
+	}
+	return SDL_APP_CONTINUE;
+}
+
 //=============================================================================
 // SDL CALLBACKS
 //=============================================================================
 
-SDL_AppResult SDL_AppInit (void **out_state, int argc, char **argv) {
-	xtd_ignore_unused(argc);
-	xtd_ignore_unused(argv);
+static void parse_arguments (ApplicationState *app, int argc, char **argv) {
+	for (i32 i = 1; i < argc; i++) {
+		if (SDL_strcmp(argv[i], "--no-input-coalescing") == 0) {
+			app->coalesce_input = false;
+		}
+		else if (SDL_strcmp(argv[i], "--input-latency") == 0) {
+			app->input_latency.log_enabled = true;
+		}
+		else if (SDL_strcmp(argv[i], "--frame-stats") == 0) {
+			app->frame_stats.log_enabled = true;
+		}
+		else if (SDL_strcmp(argv[i], "--bench-search") == 0 && i + 1 < argc) {
+			app->bench_search_pattern = argv[++i];
+		}
+		else if (SDL_strcmp(argv[i], "--bench-duplicates") == 0) {
+			app->bench_duplicates = true;
+		}
+		else if (SDL_strcmp(argv[i], "--bench-git-status") == 0) {
+			app->bench_git_status = true;
+		}
+		else if (SDL_strcmp(argv[i], "--scan-backend") == 0 && i + 1 < argc) {
+			app->scan_backend_name = argv[++i];
+		}
+		else if (SDL_strcmp(argv[i], "--bench-stat") == 0 && i + 1 < argc) {
+			app->bench_stat_directory = argv[++i];
+		}
+		else if (SDL_strcmp(argv[i], "--renderer") == 0 && i + 1 < argc) {
+			app->render_backend_name = argv[++i];
+		}
+		else if (SDL_strcmp(argv[i], "--bench-render") == 0 && i + 1 < argc) {
+			app->bench_render_frames = (u32) SDL_strtoul(argv[++i], NULL, 10);
+		}
+		else if (SDL_strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+			app->record_path = argv[++i];
+		}
+		else if (SDL_strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+			app->replay_path = argv[++i];
+		}
+		else if (SDL_strcmp(argv[i], "--replay-speed") == 0 && i + 1 < argc) {
+			app->replay_speed = SDL_strcmp(argv[++i], "max") == 0 ? REPLAY_SPEED_MAX : REPLAY_SPEED_ORIGINAL;
+		}
+		else if (SDL_strcmp(argv[i], "--memory-budget") == 0 && i + 1 < argc) {
+			app->memory_budget = (u64) SDL_strtoull(argv[++i], NULL, 10) << 20;
+		}
+		else if (argv[i][0] != '-' && app->num_root_paths < WORKSPACE_MAX_ROOTS) {
+			app->root_paths[app->num_root_paths++] = argv[i];
+		}
+	}
+}
 
+// newly listed children of an expanded directory are sorted and shown right away
+static void on_directory_scanned (Directory *directory, void *user_data) {
+	ApplicationState *app = (ApplicationState *) user_data;
+	workspace_on_listed(&app->workspace, directory);
+	git_status_on_listed(&app->git_status, directory);
+	if (!directory->expanded) {
+		return;
+	}
+	sort_directory_children(&app->sort_engine, directory, app->sort_column, app->sort_descending);
+
+	for (Directory *ancestor = directory->parent; ancestor; ancestor = ancestor->parent) {
+		if (!ancestor->expanded) return;
+	}
+	app->explorer_rows_dirty = true;
+}
+
+// --scan-backend: overrides the backend scan_io_init picked
+static void select_scan_backend (Scanner *scanner, const char *name) {
+	for (ScanIoBackend backend = 0; backend < NUM_SCAN_IO_BACKENDS; backend++) {
+		if (SDL_strcmp(name, scan_io_backend_name(backend)) == 0) {
+			if (scan_io_backend_is_supported(backend)) {
+				scanner->io.backend = backend;
+			} else {
+				SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Scan backend %s is not supported here", name);
+			}
+			return;
+		}
+	}
+	SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Unknown scan backend %s", name);
+}
+
+// --renderer: the OpenGL backend samples the SDL_Renderer's textures, so
+// the renderer has to be the OpenGL one too
+static void select_render_backend (RenderContext *render_context, const char *name) {
+	for (RenderBackend backend = 0; backend < NUM_RENDER_BACKENDS; backend++) {
+		if (SDL_strcmp(name, render_backend_name(backend)) == 0) {
+			render_context->backend = backend;
+			if (backend == RENDER_BACKEND_GL) {
+				SDL_SetHint(SDL_HINT_RENDER_DRIVER, "opengl");
+			}
+			return;
+		}
+	}
+	SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Unknown renderer %s", name);
+}
+
+// the OpenGL backend gets a 3.3 core context sharing objects with the
+// renderer's, which is current after the icons were loaded
+static void create_gl_context (ApplicationState *app) {
+	RenderContext *render_context = &app->render_context;
+	if (render_context->backend == RENDER_BACKEND_GL) {
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+		SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+	}
+	render_context->gl_context = SDL_GL_CreateContext(app->window);
+	if (render_context->backend != RENDER_BACKEND_GL) {
+		return;
+	}
+
+	render_context->gl = gl_renderer_create(app->window, render_context->gl_context, render_context->renderer);
+	if (!render_context->gl) {
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "OpenGL renderer unavailable, falling back to SDL_Renderer: %s", SDL_GetError());
+		render_context->backend = RENDER_BACKEND_SDL;
+	}
+}
+
+static bool start_workers (ApplicationState *app) {
+	u32 num_workers = xtd_max(SDL_GetNumLogicalCPUCores() - 1, 1);
+	if (!job_queue_create(&app->job_queue, num_workers, SDL_THREAD_PRIORITY_NORMAL, "IQWorker")) {
+		return false;
+	}
+	sort_engine_init(&app->sort_engine, &app->job_queue);
+	search_engine_init(&app->search_engine, &app->job_queue);
+	duplicate_finder_init(&app->duplicates, &app->job_queue);
+	app->sort_column = SORT_COLUMN_NAME;
+	app->explorer_rows_dirty = true;
+
+	// the indexer gets few threads at low CPU and I/O priority so it never competes with the UI
+	u32 num_background_workers = xtd_min(num_workers, 2u);
+	if (!job_queue_create(&app->background_queue, num_background_workers, SDL_THREAD_PRIORITY_LOW, "IQIndexer") ||
+		!scanner_init(&app->scanner, &app->background_queue, on_directory_scanned, app) ||
+		!git_status_init(&app->git_status, &app->background_queue)) {
+		return false;
+	}
+	app->scanner.git_status = &app->git_status;
+	if (app->scan_backend_name) {
+		select_scan_backend(&app->scanner, app->scan_backend_name);
+	}
+	workspace_init(&app->workspace, &app->scanner, &app->thumbnails, app->memory_budget ? app->memory_budget : WORKSPACE_DEFAULT_MEMORY_BUDGET);
+	preview_init(&app->preview, &app->background_queue);
+	file_type_sniffer_init(&app->file_type_sniffer, &app->background_queue);
+
+	// decoding is CPU bound and only ever for visible rows, so a few threads suffice
+	u32 num_thumbnail_workers = xtd_max(num_workers / 2, 1u);
+	if (!job_queue_create(&app->thumbnail_queue, num_thumbnail_workers, SDL_THREAD_PRIORITY_NORMAL, "IQThumbnail")) {
+		return false;
+	}
+	thumbnail_service_init(&app->thumbnails, &app->thumbnail_queue, app->render_context.renderer);
+
+	// transfers spend their time blocked in the kernel, one thread per in-flight job
+	if (!job_queue_create(&app->file_ops_queue, FILE_OPS_MAX_IN_FLIGHT, SDL_THREAD_PRIORITY_NORMAL, "IQFileOps")) {
+		return false;
+	}
+	file_ops_init(&app->file_ops, &app->file_ops_queue);
+	return true;
+}
+
+// every path given on the command line becomes a root, the working directory if there are none
+static void open_workspace (ApplicationState *app) {
+	for (u32 i = 0; i < app->num_root_paths; i++) {
+		workspace_add_root(&app->workspace, app->root_paths[i]);
+	}
+	if (app->workspace.num_roots == 0) {
+		char *current_directory = SDL_GetCurrentDirectory();
+		if (current_directory) {
+			workspace_add_root(&app->workspace, current_directory);
+			SDL_free(current_directory);
+		}
+	}
+}
+
+static bool open_workspace_and_wait (ApplicationState *app) {
+	if (!start_workers(app)) {
+		return false;
+	}
+	open_workspace(app);
+	while (scanner_is_busy(&app->scanner)) {
+		scanner_update(&app->scanner);
+		SDL_Delay(1);
+	}
+	scanner_update(&app->scanner);
+	return true;
+}
+
+// --bench-search: indexes the root, then times two searches; the first warms
+// the page cache, the second is reported
+static SDL_AppResult run_search_benchmark (ApplicationState *app) {
+	if (!open_workspace_and_wait(app)) {
+		return SDL_APP_FAILURE;
+	}
+
+	SearchFlags flags = search_flags_for_query(app->bench_search_pattern);
+	const char *pattern = app->bench_search_pattern + ((flags & SEARCH_FLAG_REGEX) ? 1 : 0);
+
+	for (u32 pass = 0; pass < 2; pass++) {
+		if (!search_start(&app->search_engine, app->workspace.roots, app->workspace.num_roots, pattern, flags)) {
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Invalid search pattern");
+			return SDL_APP_FAILURE;
+		}
+		while (search_is_busy(&app->search_engine)) {
+			search_update(&app->search_engine);
+			SDL_Delay(1);
+		}
+		search_update(&app->search_engine);
+	}
+
+	SearchStats *stats = &app->search_engine.stats;
+	f64 seconds = (f64) (stats->end_ns - stats->start_ns) / SDL_NS_PER_SECOND;
+	SDL_Log("search \"%s\": %llu hits, %llu files (%llu binary skipped), %.1f MB in %.3f s, %.2f GB/s",
+		app->bench_search_pattern,
+		(unsigned long long) app->search_engine.num_hits,
+		(unsigned long long) stats->num_files_searched,
+		(unsigned long long) stats->num_binary_files,
+		(f64) stats->bytes_searched / 1e6, seconds,
+		seconds > 0 ? (f64) stats->bytes_searched / 1e9 / seconds : 0.0);
+	return SDL_APP_SUCCESS;
+}
+
+// --bench-duplicates: indexes the roots, then times two duplicate searches
+// the way --bench-search does, reporting how far each stage narrowed the
+// candidates and the read throughput
+static SDL_AppResult run_duplicates_benchmark (ApplicationState *app) {
+	if (!open_workspace_and_wait(app)) {
+		return SDL_APP_FAILURE;
+	}
+
+	for (u32 pass = 0; pass < 2; pass++) {
+		duplicate_finder_start(&app->duplicates, app->workspace.roots, app->workspace.num_roots);
+		while (duplicate_finder_is_busy(&app->duplicates)) {
+			duplicate_finder_update(&app->duplicates);
+			SDL_Delay(1);
+		}
+		duplicate_finder_update(&app->duplicates);
+	}
+
+	DuplicateStats *stats = &app->duplicates.stats;
+	f64 seconds = (f64) (stats->end_ns - stats->start_ns) / SDL_NS_PER_SECOND;
+	SDL_Log("duplicates: %u sets, %.1f MB reclaimable; %llu files, %llu same size, %llu same ends, %llu hashed whole, %llu unreadable",
+		app->duplicates.num_sets, (f64) stats->reclaimable_bytes / 1e6,
+		(unsigned long long) stats->num_files,
+		(unsigned long long) stats->num_size_candidates,
+		(unsigned long long) stats->num_content_candidates,
+		(unsigned long long) stats->num_files_hashed,
+		(unsigned long long) stats->num_unreadable);
+	SDL_Log("duplicates: %.1f MB read in %.3f s, %.2f GB/s",
+		(f64) stats->bytes_read / 1e6, seconds,
+		seconds > 0 ? (f64) stats->bytes_read / 1e9 / seconds : 0.0);
+	return SDL_APP_SUCCESS;
+}
+
+// --bench-git-status: indexes the roots, which compares every listing inside
+// a work tree with its index on the way, and reports how long status took
+// to be complete along with the roots' totals
+static SDL_AppResult run_git_status_benchmark (ApplicationState *app) {
+	u64 start_ns = SDL_GetTicksNS();
+	if (!open_workspace_and_wait(app)) {
+		return SDL_APP_FAILURE;
+	}
+	f64 seconds = (f64) (SDL_GetTicksNS() - start_ns) / SDL_NS_PER_SECOND;
+
+	GitStatusStats *stats = &app->git_status.stats;
+	SDL_Log("git status: %u repositories, %llu index entries parsed in %.1f ms, %llu files compared; scan and status in %.3f s",
+		stats->num_repos, (unsigned long long) stats->num_entries_parsed,
+		(f64) stats->parse_ns / SDL_NS_PER_MS,
+		(unsigned long long) atomic_u64_get(&stats->num_files_compared), seconds);
+	for (u32 i = 0; i < app->workspace.num_roots; i++) {
+		Directory *root = &app->workspace.roots[i];
+		SDL_Log("git status: %s: %llu modified or deleted, %llu untracked of %llu files",
+			root->path,
+			(unsigned long long) root->stats.num_modified,
+			(unsigned long long) root->stats.num_untracked,
+			(unsigned long long) root->stats.num_files);
+	}
+	return SDL_APP_SUCCESS;
+}
+
+// --bench-render: draws a fixed scene for the given number of frames with the
+// selected backend, waiting for each to finish, and reports the average
+static SDL_AppResult run_render_benchmark (ApplicationState *app) {
+	RenderContext *render_context = &app->render_context;
+	u32 num_cells = BENCH_RENDER_COLUMNS * BENCH_RENDER_ROWS;
+	Clay_RenderCommand *commands = SDL_calloc(num_cells * 3, sizeof(Clay_RenderCommand));
+	char (*labels)[16] = SDL_calloc(num_cells, sizeof(*labels));
+	i32 num_commands = 0;
+
+	i32 width, height;
+	SDL_GetWindowSizeInPixels(app->window, &width, &height);
+	f32 cell_width = (f32) width / BENCH_RENDER_COLUMNS;
+	f32 cell_height = (f32) height / BENCH_RENDER_ROWS;
+	for (u32 i = 0; i < num_cells; i++) {
+		Clay_BoundingBox box = {
+			(i % BENCH_RENDER_COLUMNS) * cell_width + 1, (i / BENCH_RENDER_COLUMNS) * cell_height + 1,
+			cell_width - 2, cell_height - 2
+		};
+		Clay_CornerRadius radius = { 6, 6, 6, 6 };
+		commands[num_commands++] = (Clay_RenderCommand) {
+			.boundingBox = box,
+			.commandType = CLAY_RENDER_COMMAND_TYPE_RECTANGLE,
+			.renderData.rectangle = { { 40, 44, 52, 255 }, radius },
+		};
+		commands[num_commands++] = (Clay_RenderCommand) {
+			.boundingBox = box,
+			.commandType = CLAY_RENDER_COMMAND_TYPE_BORDER,
+			.renderData.border = { { 90, 96, 110, 255 }, radius, { 1, 1, 1, 1, 0 } },
+		};
+		if (i % 4 == 0) {
+			i32 length = SDL_snprintf(labels[i], sizeof(labels[i]), "%u", i);
+			commands[num_commands++] = (Clay_RenderCommand) {
+				.boundingBox = { box.x + 3, box.y + 2, box.width - 6, box.height - 4 },
+				.commandType = CLAY_RENDER_COMMAND_TYPE_TEXT,
+				.renderData.text = {
+					.stringContents = { length, labels[i], labels[i] },
+					.textColor = { 220, 220, 220, 255 },
+					.fontId = FONT_ID_ROBOTO_REGULAR,
+					.fontSize = 12,
+				},
+			};
+		}
+	}
+	Clay_RenderCommandArray array = { num_commands, num_commands, commands };
+
+	// presenting must not wait for the display
+	if (render_context->backend == RENDER_BACKEND_GL) {
+		SDL_GL_SetSwapInterval(0);
+	}
+
+	// the first frames fill caches and compile shaders
+	u64 start = 0;
+	for (u32 frame = 0; frame < app->bench_render_frames + 10; frame++) {
+		if (frame == 10) {
+			start = SDL_GetTicksNS();
+		}
+		render_clear(render_context);
+		render_clay_commands(render_context, &array);
+		render_finish(render_context);
+		render_present(render_context);
+	}
+	f64 milliseconds = (f64) (SDL_GetTicksNS() - start) / SDL_NS_PER_MS;
+	SDL_Log("render %s (%s): %d commands, %u frames, %.3f ms per frame",
+		render_backend_name(render_context->backend), SDL_GetRendererName(render_context->renderer),
+		num_commands, app->bench_render_frames,
+		app->bench_render_frames ? milliseconds / app->bench_render_frames : 0.0);
+
+	SDL_free(commands);
+	SDL_free(labels);
+	return SDL_APP_SUCCESS;
+}
+
+// paths of the --bench-stat tree, created on first use
+static char **bench_stat_tree (const char *root) {
+	char **paths = SDL_malloc(BENCH_STAT_DIRECTORIES * BENCH_STAT_FILES_PER_DIRECTORY * sizeof(char *));
+	char name[32];
+	SDL_snprintf(name, sizeof(name), "d%04u", BENCH_STAT_DIRECTORIES - 1);
+	char *last_directory = join_path(root, name);
+	bool create = !SDL_GetPathInfo(last_directory, NULL);
+	SDL_free(last_directory);
+	if (create) {
+		SDL_Log("creating %u files under %s", BENCH_STAT_DIRECTORIES * BENCH_STAT_FILES_PER_DIRECTORY, root);
+	}
+
+	for (u32 d = 0; d < BENCH_STAT_DIRECTORIES; d++) {
+		SDL_snprintf(name, sizeof(name), "d%04u", d);
+		char *directory = join_path(root, name);
+		if (create) {
+			SDL_CreateDirectory(directory);
+		}
+		for (u32 f = 0; f < BENCH_STAT_FILES_PER_DIRECTORY; f++) {
+			SDL_snprintf(name, sizeof(name), "f%04u.txt", f);
+			char *path = join_path(directory, name);
+			if (create) {
+				SDL_SaveFile(path, name, f % 10);
+			}
+			paths[d * BENCH_STAT_FILES_PER_DIRECTORY + f] = path;
+		}
+		SDL_free(directory);
+	}
+	return paths;
+}
+
+static void log_stat_rate (const char *label, u32 num_lookups, u64 start_ns) {
+	f64 seconds = (f64) (SDL_GetTicksNS() - start_ns) / SDL_NS_PER_SECOND;
+	SDL_Log("%-24s %u lookups in %.3f s, %.0f k/s", label, num_lookups, seconds,
+		seconds > 0 ? num_lookups / seconds / 1000 : 0.0);
+}
+
+// --bench-stat: times metadata lookups over a synthetic tree, first one
+// SDL_GetPathInfo at a time, then batched on one thread with each backend, then
+// as a full scan with each backend. Every measurement runs twice and the
+// second, warm run is reported
+static SDL_AppResult run_stat_benchmark (ApplicationState *app) {
+	const char *root = app->bench_stat_directory;
+	SDL_CreateDirectory(root);
+	char **paths = bench_stat_tree(root);
+	u32 num_paths = BENCH_STAT_DIRECTORIES * BENCH_STAT_FILES_PER_DIRECTORY;
+	ScanStat *stats = SDL_calloc(num_paths, sizeof(ScanStat));
+	for (u32 i = 0; i < num_paths; i++) {
+		stats[i].path = paths[i];
+	}
+
+	u64 start = 0;
+	for (u32 pass = 0; pass < 2; pass++) {
+		start = SDL_GetTicksNS();
+		for (u32 i = 0; i < num_paths; i++) {
+			SDL_PathInfo info;
+			SDL_GetPathInfo(paths[i], &info);
+		}
+	}
+	log_stat_rate("sequential stat", num_paths, start);
+
+	for (ScanIoBackend backend = 0; backend < NUM_SCAN_IO_BACKENDS; backend++) {
+		if (!scan_io_backend_is_supported(backend)) {
+			SDL_Log("%s: not supported here", scan_io_backend_name(backend));
+			continue;
+		}
+		ScanIo io = { backend };
+		for (u32 pass = 0; pass < 2; pass++) {
+			start = SDL_GetTicksNS();
+			for (u32 first = 0; first < num_paths; first += SCAN_STAT_CHUNK) {
+				scan_io_stat(&io, stats + first, xtd_min(num_paths - first, (u32) SCAN_STAT_CHUNK));
+			}
+		}
+		char label[64];
+		SDL_snprintf(label, sizeof(label), "batched %s", scan_io_backend_name(backend));
+		log_stat_rate(label, num_paths, start);
+
+		// the same thread count the indexer gets
+		for (u32 pass = 0; pass < 2; pass++) {
+			JobQueue queue;
+			Scanner scanner;
+			Workspace workspace;
+			u32 num_workers = xtd_min(xtd_max(SDL_GetNumLogicalCPUCores() - 1, 1), 2);
+			if (!job_queue_create(&queue, num_workers, SDL_THREAD_PRIORITY_NORMAL, "IQBench") ||
+				!scanner_init(&scanner, &queue, NULL, NULL)) {
+				return SDL_APP_FAILURE;
+			}
+			scanner.io.backend = backend;
+			workspace_init(&workspace, &scanner, NULL, UINT64_MAX);
+
+			start = SDL_GetTicksNS();
+			workspace_add_root(&workspace, root);
+			while (scanner_is_busy(&scanner)) {
+				scanner_update(&scanner);
+				SDL_Delay(1);
+			}
+			scanner_update(&scanner);
+			u64 num_entries = scanner.num_files_attached + scanner.num_directories_attached;
+
+			job_queue_destroy(&queue);
+			workspace_shutdown(&workspace);
+			scanner_shutdown(&scanner);
+			if (pass == 1) {
+				SDL_snprintf(label, sizeof(label), "scan %s x%u", scan_io_backend_name(backend), num_workers);
+				log_stat_rate(label, (u32) num_entries, start);
+			}
+		}
+	}
+
+	for (u32 i = 0; i < num_paths; i++) {
+		SDL_free(paths[i]);
+	}
+	SDL_free(paths);
+	SDL_free(stats);
+	return SDL_APP_SUCCESS;
+}
+
+SDL_AppResult SDL_AppInit (void **out_state, int argc, char **argv) {
     ApplicationState *app = SDL_malloc(sizeof(ApplicationState));
     if (!app) return SDL_APP_FAILURE;
     SDL_memset(app, 0, sizeof(*app));
     *out_state = app;
 
-	app->directories = SDL_malloc(sizeof(Directory) * 99);
-	app->num_directories += 99;
+	app->coalesce_input = true;
+	selection_init(&app->selection);
+	parse_arguments(app, argc, argv);
+	file_types_init();
+	if (app->bench_search_pattern) {
+		return run_search_benchmark(app);
+	}
+	if (app->bench_duplicates) {
+		return run_duplicates_benchmark(app);
+	}
+	if (app->bench_git_status) {
+		return run_git_status_benchmark(app);
+	}
+	if (app->bench_stat_directory) {
+		return run_stat_benchmark(app);
+	}
 
-	for (i32 i = 0; i < 99; i++) {
-		app->directories[i].name = SDL_malloc(sizeof(char) * 24);
-		char buf[24];
-		sprintf(buf, "Test Directory %d", i);
-		strncpy_s(app->directories[i].name, 24, buf, 24);
+	if (app->render_backend_name) {
+		select_render_backend(&app->render_context, app->render_backend_name);
+	}
+
+	// replays run headless unless SDL_VIDEO_DRIVER says otherwise
+	if (app->replay_path) {
+		if (!input_replay_open(&app->replay, app->replay_path, app->replay_speed)) {
+			return SDL_APP_FAILURE;
+		}
+		SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "dummy");
 	}
 
 	if (!TTF_Init()) {
         return SDL_APP_FAILURE;
     }
 
-    if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_EVENTS))
+    if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_EVENTS)) {
         return SDL_APP_FAILURE;
+	}
+
+	// the dummy driver has no OpenGL and draws with the software renderer
+	SDL_WindowFlags window_flags = SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_BORDERLESS | SDL_WINDOW_TRANSPARENT;
+	if (SDL_strcmp(SDL_GetCurrentVideoDriver(), "dummy") == 0) {
+		window_flags &= ~SDL_WINDOW_OPENGL;
+	}
 
     if (!SDL_CreateWindowAndRenderer(
 			"IQ",
             960, 540,
-            SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_BORDERLESS | SDL_WINDOW_TRANSPARENT,
+            window_flags,
             &app->window,
             &app->render_context.renderer)) {
         return SDL_APP_FAILURE;
@@ -271,6 +1769,7 @@ SDL_AppResult SDL_AppInit (void **out_state, int argc, char **argv) {
         return SDL_APP_FAILURE;
     }
     app->render_context.fonts[FONT_ID_ROBOTO_REGULAR] = roboto_regular;
+	text_truncator_init(&app->truncator, app->render_context.fonts);
 
 	// -- Load SVG Icons ----------------------------------
 	app->icons = SDL_calloc(NUM_ICON_IDS, sizeof(SDL_Texture *));
@@ -310,15 +1809,21 @@ SDL_AppResult SDL_AppInit (void **out_state, int argc, char **argv) {
 	}
 
 	SDL_SetWindowMinimumSize(app->window, 430, 270);
-	SDL_GetWindowPosition(app->window, &app->window_resize_start_x, &app->window_resize_start_y);
-	SDL_GetWindowSize(app->window, &app->window_resize_start_w, &app->window_resize_start_h);
+	remember_window_geometry(app);
 
-    app->render_context.gl_context = SDL_GL_CreateContext(app->window);
+	create_gl_context(app);
+	if (app->bench_render_frames) {
+		return run_render_benchmark(app);
+	}
 
-    size_t clay_mem_size = Clay_MinMemorySize();
-    app->clay_arena = Clay_CreateArenaWithCapacityAndMemory(clay_mem_size, malloc(clay_mem_size));
-    Clay_Initialize(app->clay_arena, (Clay_Dimensions){960, 540}, (Clay_ErrorHandler){ clay_error_handler, 0 });
-	Clay_SetMeasureTextFunction(measure_text, app->render_context.fonts);
+	init_clay_context(app);
+	ui_init_element_ids();
+
+	if (!start_workers(app)) {
+		return SDL_APP_FAILURE;
+	}
+	open_workspace(app);
+	SDL_StartTextInput(app->window);
 
     return SDL_APP_CONTINUE;
 }
@@ -326,95 +1831,188 @@ SDL_AppResult SDL_AppInit (void **out_state, int argc, char **argv) {
 SDL_AppResult SDL_AppIterate (void *s) {
     ApplicationState *app = (ApplicationState *) s;
     	
+	u64 frame_start = SDL_GetTicksNS();
+	update_frame_time(app);
+	SDL_AppResult replay_result = update_input_log(app);
+	if (replay_result != SDL_APP_CONTINUE) {
+		return replay_result;
+	}
+	scanner_update(&app->scanner);
+	git_status_update(&app->git_status, app->workspace.roots, app->workspace.num_roots);
+	update_search(app);
+	update_duplicates(app);
+	update_file_operations(app);
+	if (sort_engine_update(&app->sort_engine)) {
+		app->explorer_rows_dirty = true;
+	}
+	if (app->explorer_rows_dirty) {
+		rebuild_explorer_rows(app);
+	}
+
+	apply_pending_input(app);
+	update_explorer_scroll(app);
+	update_file_types(app);
+	update_thumbnails(app);
+	update_workspace(app);
+	update_preview(app);
 	update_clay_dimensions_and_mouse_state(app);
 	render(app);
 
-	check_resizing(app);
-	check_dragging(app);
-	
+	// the edges only need testing again once the pointer has moved
+	if (app->mouse_state.global_position_x != app->resize_checked_x || app->mouse_state.global_position_y != app->resize_checked_y) {
+		check_resizing(app);
+		app->resize_checked_x = app->mouse_state.global_position_x;
+		app->resize_checked_y = app->mouse_state.global_position_y;
+	}
+	app->pending_input.pressed_this_frame = false;
+
+	if (app->replay_started) {
+		FrameStats *frame = &app->frame_stats;
+		input_replay_record_frame(&app->replay, SDL_GetTicksNS() - frame_start, frame->layout_ns,
+			frame->num_commands, app->render_context.num_draw_calls, frame->skipped);
+		if (app->replay_speed == REPLAY_SPEED_MAX) {
+			return SDL_APP_CONTINUE;
+		}
+	}
 	SDL_Delay(4);
 	return SDL_APP_CONTINUE;
 }
 
-SDL_AppResult SDL_AppEvent (void *s, SDL_Event *event) {
-    ApplicationState *app = (ApplicationState*)s;
+static SDL_AppResult handle_event (ApplicationState *app, SDL_Event *event) {
     switch (event->type) {
     
 	case SDL_EVENT_QUIT:
         return SDL_APP_SUCCESS;
 
+	case SDL_EVENT_WINDOW_EXPOSED:
+		app->frame_stats.force_redraw = true;
+		break;
+
     case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
     case SDL_EVENT_WINDOW_RESIZED:
+		app->frame_stats.force_redraw = true;
         i32 screen_width, screen_height;
     	SDL_GetWindowSize(app->window, &screen_width, &screen_height);
     	Clay_SetLayoutDimensions((Clay_Dimensions){ screen_width, screen_height }); 
 		break;
 
     case SDL_EVENT_MOUSE_MOTION:
-    	
-		app->mouse_state.position_x = event->motion.x;
-    	app->mouse_state.position_y = event->motion.y;
-    	
-		f32 global_x, global_y;
-		SDL_GetGlobalMouseState(&global_x, &global_y);
-		app->mouse_state.global_position_x = (i32) global_x;
-    	app->mouse_state.global_position_y = (i32) global_y;
-		
-		handle_resizing(app);
-    	handle_dragging(app);
+		note_input_event(app, event->motion.timestamp);
+		app->pending_input.motion = true;
+		app->pending_input.position_x = event->motion.x;
+		app->pending_input.position_y = event->motion.y;
 		
-		Clay_SetPointerState((Clay_Vector2) { event->motion.x, event->motion.y }, app->mouse_state.is_down);
+		if (!app->coalesce_input) {
+			apply_pending_input(app);
+			Clay_SetPointerState((Clay_Vector2) { event->motion.x, event->motion.y }, app->mouse_state.is_down);
+		}
 		break;
 
     case SDL_EVENT_MOUSE_WHEEL:
-        app->mouse_state.wheel_x = event->wheel.x;
-        app->mouse_state.wheel_y = event->wheel.y;
-		Clay_Vector2 wheel_state = { app->mouse_state.wheel_x, app->mouse_state.wheel_y };
-		Clay_UpdateScrollContainers(true, wheel_state, 0.001f);
+		note_input_event(app, event->wheel.timestamp);
+        app->pending_input.wheel_x += event->wheel.x;
+        app->pending_input.wheel_y += event->wheel.y;
+		
+		if (!app->coalesce_input) {
+			apply_pending_input(app);
+		}
 		break;
     
 	case SDL_EVENT_MOUSE_BUTTON_DOWN:
-        app->mouse_state.is_down = true;
-	
-		app->mouse_state.global_drag_start_x = app->mouse_state.global_position_x;
-		app->mouse_state.global_drag_start_y = app->mouse_state.global_position_y;
-		app->mouse_state.drag_start_x = app->mouse_state.position_x;
-		app->mouse_state.drag_start_y = app->mouse_state.position_y;
-       	
-		if (!app->resize_started_from_hit_test && app->resize_mode != EDGE_NONE) {
-			SDL_GetWindowPosition(app->window, &app->window_resize_start_x, &app->window_resize_start_y);
-			SDL_GetWindowSize(app->window, &app->window_resize_start_w, &app->window_resize_start_h);
-			app->resize_started_from_hit_test = true;
-		}
-		
-		if (!app->drag_started_from_hit_test && check_dragging(app)) {
-			SDL_GetWindowPosition(app->window, &app->window_resize_start_x, &app->window_resize_start_y);
-			app->drag_started_from_hit_test = true;
-		}	
-		
-		Clay_SetPointerState((Clay_Vector2) { event->motion.x, event->motion.y }, app->mouse_state.is_down);	
+		note_input_event(app, event->button.timestamp);
+		app->pending_input.position_x = event->button.x;
+		app->pending_input.position_y = event->button.y;
+		app->pending_input.pressed_this_frame = true;
+		press_mouse(app);
 		break;
+
     case SDL_EVENT_MOUSE_BUTTON_UP:
-        app->mouse_state.is_down = false;
-		app->resize_started_from_hit_test = false;
-		app->drag_started_from_hit_test = false;
-		Clay_SetPointerState((Clay_Vector2) { event->motion.x, event->motion.y }, app->mouse_state.is_down);	
+		note_input_event(app, event->button.timestamp);
+		app->pending_input.position_x = event->button.x;
+		app->pending_input.position_y = event->button.y;
+		if (app->pending_input.pressed_this_frame) {
+			app->pending_input.release_deferred = true;
+		} else {
+			release_mouse(app);
+		}
+		break;
+
+	case SDL_EVENT_TEXT_INPUT:
+		append_search_text(app, event->text.text);
 		break;
 
+	// a folder dropped on the window opens as another root
+	case SDL_EVENT_DROP_FILE: {
+		SDL_PathInfo info;
+		if (SDL_GetPathInfo(event->drop.data, &info) && info.type == SDL_PATHTYPE_DIRECTORY &&
+			workspace_add_root(&app->workspace, event->drop.data)) {
+			app->explorer_rows_dirty = true;
+		}
+		break;
+	}
+
 	case SDL_EVENT_KEY_DOWN:
+		if (handle_search_key(app, event->key.key) || handle_duplicates_key(app, event->key.key, event->key.mod) ||
+			handle_file_operation_key(app, event->key.key, event->key.mod) || handle_selection_key(app, event->key.key, event->key.mod) ||
+			handle_sort_key(app, event->key.key, event->key.mod)) {
+			break;
+		}
 		if (event->key.key == SDLK_ESCAPE) {
 			return SDL_APP_SUCCESS;
 		}
+		handle_preview_key(app, event->key.key);
+		break;
     }
     return SDL_APP_CONTINUE;
 }
 
+// a replay owns the input: what the window system sends is dropped
+SDL_AppResult SDL_AppEvent (void *s, SDL_Event *event) {
+    ApplicationState *app = (ApplicationState*)s;
+	if (app->replay_path && input_log_is_input(event->type)) {
+		return SDL_APP_CONTINUE;
+	}
+	input_recorder_event(&app->recorder, event);
+	return handle_event(app, event);
+}
+
 void SDL_AppQuit (void *s, SDL_AppResult result) {
     xtd_ignore_unused(result);
 
 	ApplicationState *app = (ApplicationState*)s;
     if (!app) return;
 
+	log_input_latency_summary(app);
+	preview_close(&app->preview);
+	// workers finish every queued job before exiting, so anything long running
+	// is told to stop first
+	scanner_cancel(&app->scanner);
+	search_cancel(&app->search_engine);
+	file_ops_cancel_all(&app->file_ops);
+	duplicate_finder_cancel(&app->duplicates);
+	job_queue_destroy(&app->file_ops_queue);
+	job_queue_destroy(&app->thumbnail_queue);
+	job_queue_destroy(&app->background_queue);
+	job_queue_destroy(&app->job_queue);
+	scanner_shutdown(&app->scanner);
+	sort_engine_shutdown(&app->sort_engine);
+	search_engine_shutdown(&app->search_engine);
+	duplicate_finder_shutdown(&app->duplicates);
+	git_status_shutdown(&app->git_status);
+	thumbnail_service_shutdown(&app->thumbnails);
+	file_type_sniffer_shutdown(&app->file_type_sniffer);
+	file_ops_shutdown(&app->file_ops);
+	workspace_shutdown(&app->workspace);
+	hit_index_free(&app->hit_index);
+	input_recorder_close(&app->recorder);
+	input_replay_close(&app->replay);
+	SDL_free(app->current_path);
+	free_clipboard(app);
+	selection_free(&app->selection);
+	text_truncator_shutdown(&app->truncator);
+	SDL_free(app->clay_arena.memory);
+
+	gl_renderer_destroy(app->render_context.gl);
     if (app->render_context.gl_context) SDL_GL_DestroyContext(app->render_context.gl_context);
     if (app->window) SDL_DestroyWindow(app->window);
     SDL_Quit();
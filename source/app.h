@@ -3,6 +3,22 @@
 
 #include "ui.h"
 #include "render.h"
+#include "job.h"
+#include "sort.h"
+#include "scroll.h"
+#include "scan.h"
+#include "preview.h"
+#include "search.h"
+#include "duplicates.h"
+#include "git_status.h"
+#include "thumbnail.h"
+#include "filetype.h"
+#include "workspace.h"
+#include "file_ops.h"
+#include "hit_test.h"
+#include "selection.h"
+#include "truncate.h"
+#include "input_log.h"
 
 typedef enum EdgeMask {
 	EDGE_NONE 	= 0,
@@ -29,15 +45,105 @@ typedef struct MouseState {
 
 } MouseState;
 
+// input gathered by SDL_AppEvent and applied once at the start of the next frame
+typedef struct PendingInput {
+	bool motion;
+	f32 position_x;
+	f32 position_y;
+	f32 wheel_x;
+	f32 wheel_y;
+
+	bool pressed_this_frame;
+	bool release_deferred;
+
+	u64 oldest_event_ns;
+	u32 num_events;
+} PendingInput;
+
+typedef struct LatencyStats {
+	bool log_enabled;
+	u64 window_start_ns;
+	u64 total_ns;
+	u64 max_ns;
+	u32 num_samples;
+	u32 num_events;
+	u32 num_unpresented;		// events whose frame was skipped as unchanged, not sampled
+
+	// over the whole run, so a replayed recording can be compared across modes
+	u64 session_total_ns;
+	u64 session_max_ns;
+	u64 session_samples;
+	u64 session_events;
+	u64 session_unpresented;
+	u64 num_geometry_calls;		// SDL_SetWindowPosition and SDL_SetWindowSize
+} LatencyStats;
+
+typedef struct FrameStats {
+	bool log_enabled;
+	u64 window_start_ns;
+	u32 num_frames;
+	u32 num_skipped;
+	u32 num_dropped;		// laid out but out of Clay room, not among num_frames
+
+	u64 last_hash;
+	bool force_redraw;		// the window contents were lost, draw even if nothing changed
+
+	// the last frame's, for replays
+	u64 layout_ns;
+	u32 num_commands;
+	bool skipped;
+} FrameStats;
+
+// Clay's element and measured-word counts follow what frames use instead of
+// a fixed worst case; changing them means a new context in a new arena
+#define CLAY_MIN_ELEMENTS        2048
+#define CLAY_MAX_ELEMENTS        (1 << 20)
+#define CLAY_MIN_MEASURED_WORDS  4096
+#define CLAY_MAX_MEASURED_WORDS  (1 << 21)
+// how long usage has to stay low before the counts come down
+#define CLAY_SHRINK_DELAY_NS     (10 * SDL_NS_PER_SECOND)
+
+typedef struct ClayCapacity {
+	i32 max_elements;
+	i32 max_words;
+	i32 wanted_elements;		// applied before the next layout
+	i32 wanted_words;
+
+	// set by clay_error_handler when a layout ran out of room
+	bool elements_exceeded;
+	bool words_exceeded;
+
+	u64 window_start_ns;
+	i32 peak_elements;			// since window_start_ns
+	i32 peak_words;
+} ClayCapacity;
+
+// --bench-stat tree: 200k files
+#define BENCH_STAT_DIRECTORIES 200
+#define BENCH_STAT_FILES_PER_DIRECTORY 1000
+
+// --bench-render scene: a grid of rounded, bordered cells, every fourth labeled
+#define BENCH_RENDER_COLUMNS 40
+#define BENCH_RENDER_ROWS 25
+
+// a second Shift+Delete within this long confirms a delete
+#define FILE_DELETE_CONFIRM_NS (3 * SDL_NS_PER_SECOND)
+
 typedef struct ApplicationState {
 
 	SDL_Window *window;
 	SDL_Texture **icons; 
 	RenderContext render_context;
     Clay_Arena clay_arena;
+	ClayCapacity clay_capacity;
  	
 	SDL_Cursor *cursors[SDL_SYSTEM_CURSOR_COUNT];
 	MouseState mouse_state;
+	PendingInput pending_input;
+	HitIndex hit_index;
+	bool coalesce_input;
+	LatencyStats input_latency;
+	FrameStats frame_stats;
 	
 	EdgeMask resize_mode;
 	bool resize_started_from_hit_test;
@@ -46,9 +152,86 @@ typedef struct ApplicationState {
 	i32 window_resize_start_y;
 	i32 window_resize_start_w;
 	i32 window_resize_start_h;
+	i32 window_applied_x;
+	i32 window_applied_y;
+	i32 window_applied_w;
+	i32 window_applied_h;
+	i32 resize_checked_x;
+	i32 resize_checked_y;
+	SDL_Cursor *applied_cursor;
+
+	Workspace workspace;
+	const char *root_paths[WORKSPACE_MAX_ROOTS];
+	u32 num_root_paths;
+	u64 memory_budget;
+
+	ExplorerRow *explorer_rows;
+	u32 num_explorer_rows;
+	u32 explorer_rows_capacity;
+	bool explorer_rows_dirty;
+	RowRange explorer_laid_out_rows;
+	Selection selection;
+	f32 explorer_row_width;		// of the list last frame, which names are fitted to
+	TextTruncator truncator;
+	ScrollState explorer_scroll;
+	u32 next_element_serial;
+
+	u64 last_frame_ns;
+	f32 delta_time;
+
+	JobQueue job_queue;
+	JobQueue background_queue;
+	JobQueue thumbnail_queue;
+	Scanner scanner;
+	SortEngine sort_engine;
+	SortColumn sort_column;
+	bool sort_descending;
+
+	Preview preview;
+	ThumbnailService thumbnails;
+	FileTypeSniffer file_type_sniffer;
+
+	SearchEngine search_engine;
+	char search_query[SEARCH_MAX_PATTERN_LENGTH];
+	u32 search_query_length;
+	u32 search_first_hit;
+	u32 search_visible_rows;
+	char search_status[96];
+
+	DuplicateFinder duplicates;
+	bool duplicates_visible;
+	u32 duplicates_first_row;
+	u32 duplicates_visible_rows;
+	u32 duplicates_labeled;		// sets whose label is filled in
+	char duplicates_status[160];
+
+	GitStatus git_status;
+	char *bench_search_pattern;
+	bool bench_duplicates;
+	bool bench_git_status;
+	char *bench_stat_directory;
+	char *scan_backend_name;
+	char *render_backend_name;
+	u32 bench_render_frames;
+
+	// --record and --replay both start once the first scan is done, so a
+	// replay begins from the same tree the recording did
+	char *record_path;
+	InputRecorder recorder;
+	char *replay_path;
+	ReplaySpeed replay_speed;
+	InputReplay replay;
+	bool replay_started;
 
-	Directory *directories;
-	u32 num_directories;
+	JobQueue file_ops_queue;
+	FileOpsEngine file_ops;
+	char *current_path;			// the row last clicked, source and target of file operations
+	bool current_is_directory;
+	char **clipboard_paths;
+	u32 num_clipboard_paths;
+	bool clipboard_cut;
+	u64 delete_armed_ns;
+	char file_ops_status[320];
 
 	Clay_ElementId last_element_clicked;
 
@@ -0,0 +1,123 @@
+#include "bytes.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define BYTES_USE_SSE2 1
+	#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+static inline u32 lowest_set_bit (u32 mask) {
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (u32) index;
+#else
+	return (u32) __builtin_ctz(mask);
+#endif
+}
+
+static inline u32 highest_set_bit (u32 mask) {
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanReverse(&index, mask);
+	return (u32) index;
+#else
+	return 31 - (u32) __builtin_clz(mask);
+#endif
+}
+
+//=============================================================================
+// SEARCH
+//=============================================================================
+
+const u8 *bytes_find (const u8 *data, size_t length, u8 value) {
+	size_t i = 0;
+
+#if BYTES_USE_SSE2
+	const __m128i needle = _mm_set1_epi8((char) value);
+	for (; i + 16 <= length; i += 16) {
+		__m128i chunk = _mm_loadu_si128((const __m128i *) (data + i));
+		u32 mask = (u32) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+		if (mask) {
+			return data + i + lowest_set_bit(mask);
+		}
+	}
+#endif
+
+	for (; i < length; i++) {
+		if (data[i] == value) return data + i;
+	}
+	return NULL;
+}
+
+const u8 *bytes_find_either (const u8 *data, size_t length, u8 first, u8 second) {
+	size_t i = 0;
+
+#if BYTES_USE_SSE2
+	const __m128i needle_first = _mm_set1_epi8((char) first);
+	const __m128i needle_second = _mm_set1_epi8((char) second);
+	for (; i + 16 <= length; i += 16) {
+		__m128i chunk = _mm_loadu_si128((const __m128i *) (data + i));
+		__m128i matches = _mm_or_si128(_mm_cmpeq_epi8(chunk, needle_first), _mm_cmpeq_epi8(chunk, needle_second));
+		u32 mask = (u32) _mm_movemask_epi8(matches);
+		if (mask) {
+			return data + i + lowest_set_bit(mask);
+		}
+	}
+#endif
+
+	for (; i < length; i++) {
+		if (data[i] == first || data[i] == second) return data + i;
+	}
+	return NULL;
+}
+
+const u8 *bytes_find_last (const u8 *data, size_t length, u8 value) {
+	size_t end = length;
+
+#if BYTES_USE_SSE2
+	const __m128i needle = _mm_set1_epi8((char) value);
+	for (; end >= 16; end -= 16) {
+		__m128i chunk = _mm_loadu_si128((const __m128i *) (data + end - 16));
+		u32 mask = (u32) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+		if (mask) {
+			return data + end - 16 + highest_set_bit(mask);
+		}
+	}
+#endif
+
+	while (end > 0) {
+		end--;
+		if (data[end] == value) return data + end;
+	}
+	return NULL;
+}
+
+size_t bytes_count (const u8 *data, size_t length, u8 value) {
+	size_t count = 0;
+	size_t i = 0;
+
+#if BYTES_USE_SSE2
+	const __m128i needle = _mm_set1_epi8((char) value);
+	const __m128i zero = _mm_setzero_si128();
+	while (i + 16 <= length) {
+		// per-lane byte counters can absorb 255 matches before they must be flushed
+		__m128i counters = _mm_setzero_si128();
+		size_t block_end = xtd_min(length - 15, i + 255 * 16);
+		for (; i < block_end; i += 16) {
+			__m128i chunk = _mm_loadu_si128((const __m128i *) (data + i));
+			counters = _mm_sub_epi8(counters, _mm_cmpeq_epi8(chunk, needle));
+		}
+		__m128i sums = _mm_sad_epu8(counters, zero);
+		count += (size_t) _mm_cvtsi128_si32(sums) + (size_t) _mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+	}
+#endif
+
+	for (; i < length; i++) {
+		count += (data[i] == value);
+	}
+	return count;
+}
@@ -0,0 +1,22 @@
+#ifndef BYTES_H
+#define BYTES_H
+
+#include "xtdlib.h"
+
+#include <stddef.h>
+
+//=============================================================================
+// BYTE SCANNING
+//=============================================================================
+
+// memchr-style primitives over raw buffers. On x86 they compare 16 bytes per
+// step with SSE2 (always available on x86-64); elsewhere they fall back to a
+// scalar loop.
+
+const u8 *bytes_find (const u8 *data, size_t length, u8 value);
+// first byte equal to either value, e.g. both cases of a letter
+const u8 *bytes_find_either (const u8 *data, size_t length, u8 first, u8 second);
+const u8 *bytes_find_last (const u8 *data, size_t length, u8 value);
+size_t bytes_count (const u8 *data, size_t length, u8 value);
+
+#endif // BYTES_H
@@ -0,0 +1,610 @@
+#include "duplicates.h"
+
+#include "file_map.h"
+
+typedef enum DuplicateStage {
+	DUPLICATE_STAGE_PROBES,
+	DUPLICATE_STAGE_CONTENTS
+} DuplicateStage;
+
+// files that could still be copies of each other: a contiguous range of
+// DuplicateRun::entries, sorted by hash by whichever job hashes the last one
+typedef struct DuplicateGroup {
+	u32 first;
+	u32 end;
+	DuplicateStage stage;
+	JobCounter remaining;
+	struct DuplicateGroup *next;
+} DuplicateGroup;
+
+typedef struct DuplicateEntry {
+	char *path;
+	u64 size;
+	u64 hash;				// of the probes, then of the contents
+	u64 device;				// with inode, the file behind the path, from probing it
+	u64 inode;
+	bool unreadable;
+	DuplicateGroup *group;
+} DuplicateEntry;
+
+typedef struct DuplicateJob {
+	DuplicateRun *run;
+	DuplicateStage stage;
+	u32 first;
+	u32 end;
+	struct DuplicateJob *next;
+} DuplicateJob;
+
+struct DuplicateRun {
+	JobQueue *job_queue;
+	SDL_AtomicInt cancelled;
+	SDL_AtomicInt finished;
+	SDL_AtomicInt num_jobs;		// pushed and not yet returned
+
+	// never reallocated once jobs run; each job only touches its own range
+	DuplicateEntry *entries;
+	u32 num_entries;
+	u32 entries_capacity;
+	DuplicateGroup *size_groups;
+
+	// guarded by mutex. Jobs and the groups of the contents stage are freed
+	// with the run: a queue being destroyed drops the jobs it still holds
+	SDL_Mutex *mutex;
+	DuplicateJob *jobs;
+	DuplicateGroup *content_groups;
+	DuplicateSet *pending_sets;
+	u32 num_pending_sets;
+	u32 pending_sets_capacity;
+	const char **pending_paths;
+	u32 num_pending_paths;
+	u32 pending_paths_capacity;
+	DuplicateStats stats;
+
+	struct DuplicateRun *next;
+};
+
+//=============================================================================
+// XXH64
+//=============================================================================
+
+#define XXH_PRIME64_1 0x9e3779b185ebca87ull
+#define XXH_PRIME64_2 0xc2b2ae3d27d4eb4full
+#define XXH_PRIME64_3 0x165667b19e3779f9ull
+#define XXH_PRIME64_4 0x85ebca77c2b2ae63ull
+#define XXH_PRIME64_5 0x27d4eb2f165667c5ull
+
+typedef struct Xxh64State {
+	u64 lanes[4];
+} Xxh64State;
+
+static inline u64 rotate_left (u64 value, u32 bits) {
+	return (value << bits) | (value >> (64 - bits));
+}
+
+static inline u64 read_u64 (const u8 *data) {
+	u64 value;
+	SDL_memcpy(&value, data, sizeof(value));
+	return SDL_Swap64LE(value);
+}
+
+static inline u32 read_u32 (const u8 *data) {
+	u32 value;
+	SDL_memcpy(&value, data, sizeof(value));
+	return SDL_Swap32LE(value);
+}
+
+static inline u64 xxh64_round (u64 lane, u64 input) {
+	lane += input * XXH_PRIME64_2;
+	return rotate_left(lane, 31) * XXH_PRIME64_1;
+}
+
+static inline u64 xxh64_merge (u64 hash, u64 lane) {
+	hash ^= xxh64_round(0, lane);
+	return hash * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+static void xxh64_init (Xxh64State *state) {
+	state->lanes[0] = XXH_PRIME64_1 + XXH_PRIME64_2;
+	state->lanes[1] = XXH_PRIME64_2;
+	state->lanes[2] = 0;
+	state->lanes[3] = 0 - XXH_PRIME64_1;
+}
+
+// consumes whole 32-byte stripes; length must be a multiple of 32
+static void xxh64_stripes (Xxh64State *state, const u8 *data, u64 length) {
+	u64 lane0 = state->lanes[0];
+	u64 lane1 = state->lanes[1];
+	u64 lane2 = state->lanes[2];
+	u64 lane3 = state->lanes[3];
+	for (const u8 *end = data + length; data < end; data += 32) {
+		lane0 = xxh64_round(lane0, read_u64(data));
+		lane1 = xxh64_round(lane1, read_u64(data + 8));
+		lane2 = xxh64_round(lane2, read_u64(data + 16));
+		lane3 = xxh64_round(lane3, read_u64(data + 24));
+	}
+	state->lanes[0] = lane0;
+	state->lanes[1] = lane1;
+	state->lanes[2] = lane2;
+	state->lanes[3] = lane3;
+}
+
+// tail is what follows the last whole stripe, less than 32 bytes
+static u64 xxh64_final (Xxh64State *state, const u8 *tail, u64 tail_length, u64 total_length) {
+	u64 hash = XXH_PRIME64_5;
+	if (total_length >= 32) {
+		hash = rotate_left(state->lanes[0], 1) + rotate_left(state->lanes[1], 7) +
+			rotate_left(state->lanes[2], 12) + rotate_left(state->lanes[3], 18);
+		for (u32 i = 0; i < 4; i++) {
+			hash = xxh64_merge(hash, state->lanes[i]);
+		}
+	}
+	hash += total_length;
+
+	for (; tail_length >= 8; tail += 8, tail_length -= 8) {
+		hash ^= xxh64_round(0, read_u64(tail));
+		hash = rotate_left(hash, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+	}
+	if (tail_length >= 4) {
+		hash ^= (u64) read_u32(tail) * XXH_PRIME64_1;
+		hash = rotate_left(hash, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+		tail += 4;
+		tail_length -= 4;
+	}
+	for (; tail_length > 0; tail++, tail_length--) {
+		hash ^= *tail * XXH_PRIME64_5;
+		hash = rotate_left(hash, 11) * XXH_PRIME64_1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= XXH_PRIME64_2;
+	hash ^= hash >> 29;
+	hash *= XXH_PRIME64_3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+static u64 xxh64 (const u8 *data, u64 length) {
+	Xxh64State state;
+	xxh64_init(&state);
+	u64 whole = length & ~31ull;
+	xxh64_stripes(&state, data, whole);
+	return xxh64_final(&state, data + whole, length - whole, length);
+}
+
+//=============================================================================
+// HASHING
+//=============================================================================
+
+static void release_job (DuplicateRun *run) {
+	if (SDL_AddAtomicInt(&run->num_jobs, -1) == 1) {
+		SDL_LockMutex(run->mutex);
+		run->stats.end_ns = SDL_GetTicksNS();
+		SDL_UnlockMutex(run->mutex);
+		SDL_SetAtomicInt(&run->finished, 1);
+	}
+}
+
+static void duplicate_job (void *data);
+
+static void push_job (DuplicateRun *run, DuplicateStage stage, u32 first, u32 end) {
+	DuplicateJob *job = SDL_malloc(sizeof(DuplicateJob));
+	*job = (DuplicateJob) { run, stage, first, end };
+	SDL_LockMutex(run->mutex);
+	job->next = run->jobs;
+	run->jobs = job;
+	SDL_UnlockMutex(run->mutex);
+	SDL_AddAtomicInt(&run->num_jobs, 1);
+	job_queue_push(run->job_queue, duplicate_job, job, JOB_PRIORITY_NORMAL);
+}
+
+static void publish_set (DuplicateRun *run, u32 first, u32 end) {
+	u32 num_files = end - first;
+	u64 size = run->entries[first].size;
+
+	SDL_LockMutex(run->mutex);
+	if (run->num_pending_sets == run->pending_sets_capacity) {
+		run->pending_sets_capacity = xtd_max(run->pending_sets_capacity * 2, 64u);
+		run->pending_sets = SDL_realloc(run->pending_sets, run->pending_sets_capacity * sizeof(DuplicateSet));
+	}
+	if (run->num_pending_paths + num_files > run->pending_paths_capacity) {
+		run->pending_paths_capacity = xtd_max(run->pending_paths_capacity * 2, run->num_pending_paths + num_files);
+		run->pending_paths = SDL_realloc(run->pending_paths, run->pending_paths_capacity * sizeof(char *));
+	}
+	run->pending_sets[run->num_pending_sets++] = (DuplicateSet) { .size = size, .first_path = run->num_pending_paths, .num_files = num_files };
+	for (u32 i = first; i < end; i++) {
+		run->pending_paths[run->num_pending_paths++] = run->entries[i].path;
+	}
+	run->stats.reclaimable_bytes += size * (num_files - 1);
+	SDL_UnlockMutex(run->mutex);
+}
+
+// files sharing size and probes go on to be hashed whole, in jobs of about
+// DUPLICATE_JOB_BYTES
+static void push_contents (DuplicateRun *run, u32 first, u32 end) {
+	DuplicateGroup *group = SDL_malloc(sizeof(DuplicateGroup));
+	group->first = first;
+	group->end = end;
+	group->stage = DUPLICATE_STAGE_CONTENTS;
+	job_counter_set(&group->remaining, (i32) (end - first));
+	for (u32 i = first; i < end; i++) {
+		run->entries[i].group = group;
+	}
+
+	SDL_LockMutex(run->mutex);
+	group->next = run->content_groups;
+	run->content_groups = group;
+	run->stats.num_content_candidates += end - first;
+	SDL_UnlockMutex(run->mutex);
+
+	// the group may be finished and sorted by the first job before the last is pushed
+	u32 files_per_job = (u32) xtd_max(DUPLICATE_JOB_BYTES / run->entries[first].size, 1ull);
+	for (u32 i = first; i < end; i += files_per_job) {
+		push_job(run, DUPLICATE_STAGE_CONTENTS, i, xtd_min(i + files_per_job, end));
+	}
+}
+
+// hard links to one file sort next to each other within a hash
+static int compare_hashes (const void *a, const void *b) {
+	const DuplicateEntry *left = a;
+	const DuplicateEntry *right = b;
+	if (left->unreadable != right->unreadable) {
+		return left->unreadable ? 1 : -1;
+	}
+	if (left->hash != right->hash) {
+		return (left->hash > right->hash) - (left->hash < right->hash);
+	}
+	if (left->device != right->device) {
+		return (left->device > right->device) - (left->device < right->device);
+	}
+	return (left->inode > right->inode) - (left->inode < right->inode);
+}
+
+static bool same_file (const DuplicateEntry *a, const DuplicateEntry *b) {
+	return a->inode != 0 && a->device == b->device && a->inode == b->inode;
+}
+
+// keeps one path of every file in [first, end), moving the other hard links
+// to it past the returned end; deleting them would reclaim nothing
+static u32 drop_hard_links (DuplicateEntry *entries, u32 first, u32 end) {
+	u32 kept = first + 1;
+	for (u32 i = first + 1; i < end; i++) {
+		if (same_file(&entries[kept - 1], &entries[i])) {
+			continue;
+		}
+		DuplicateEntry swap = entries[kept];
+		entries[kept++] = entries[i];
+		entries[i] = swap;
+	}
+	return kept;
+}
+
+// every file of the group is hashed: runs of two or more distinct files with
+// equal hashes are duplicates, or candidates for the next stage
+static void finish_group (DuplicateRun *run, DuplicateGroup *group) {
+	if (!SDL_GetAtomicInt(&run->cancelled)) {
+		DuplicateEntry *entries = run->entries;
+		SDL_qsort(entries + group->first, group->end - group->first, sizeof(DuplicateEntry), compare_hashes);
+
+		u32 first = group->first;
+		while (first < group->end && !entries[first].unreadable) {
+			u32 run_end = first + 1;
+			while (run_end < group->end && !entries[run_end].unreadable && entries[run_end].hash == entries[first].hash) {
+				run_end++;
+			}
+			u32 end = drop_hard_links(entries, first, run_end);
+			if (end - first >= 2) {
+				bool probed_whole = entries[first].size <= 2 * DUPLICATE_PROBE_BYTES;
+				if (group->stage == DUPLICATE_STAGE_PROBES && !probed_whole) {
+					push_contents(run, first, end);
+				} else {
+					publish_set(run, first, end);
+				}
+			}
+			first = run_end;
+		}
+	}
+}
+
+// the first and last DUPLICATE_PROBE_BYTES, or the whole file if that is all
+// there is
+static bool probe_file (DuplicateEntry *entry, MappedFile *file, u8 *buffer, u64 *bytes_read) {
+	u64 length;
+	if (entry->size <= 2 * DUPLICATE_PROBE_BYTES) {
+		length = mapped_file_read(file, 0, buffer, entry->size);
+	} else {
+		length = mapped_file_read(file, 0, buffer, DUPLICATE_PROBE_BYTES);
+		length += mapped_file_read(file, entry->size - DUPLICATE_PROBE_BYTES, buffer + DUPLICATE_PROBE_BYTES, DUPLICATE_PROBE_BYTES);
+	}
+	*bytes_read += length;
+	entry->hash = xxh64(buffer, length);
+	return length == xtd_min(entry->size, 2ull * DUPLICATE_PROBE_BYTES);
+}
+
+static bool hash_contents (DuplicateRun *run, DuplicateEntry *entry, MappedFile *file, u8 *buffer, u64 *bytes_read) {
+	Xxh64State state;
+	xxh64_init(&state);
+	MappedReader reader;
+	mapped_reader_begin(&reader, file, buffer, DUPLICATE_READ_LIMIT, DUPLICATE_WINDOW_SIZE);
+	while (!SDL_GetAtomicInt(&run->cancelled) && mapped_reader_next(&reader)) {
+		u64 length = reader.length;
+		if (reader.offset + length < entry->size) {
+			// chunks are whole stripes, only the last one has a tail
+			length &= ~31ull;
+			xxh64_stripes(&state, reader.data, length);
+		} else {
+			u64 whole = length & ~31ull;
+			xxh64_stripes(&state, reader.data, whole);
+			entry->hash = xxh64_final(&state, reader.data + whole, length - whole, entry->size);
+		}
+		reader.offset += length;
+		*bytes_read += length;
+	}
+	mapped_reader_end(&reader);
+	return reader.offset == entry->size;
+}
+
+static void hash_file (DuplicateRun *run, DuplicateStage stage, DuplicateEntry *entry, u8 *buffer) {
+	u64 bytes_read = 0;
+	MappedFile file;
+	bool hashed = mapped_file_open(&file, entry->path);
+	if (hashed) {
+		// a file that changed since the scan no longer shares the group's size
+		hashed = file.size == entry->size;
+		entry->device = file.device;
+		entry->inode = file.inode;
+		if (hashed) {
+			hashed = stage == DUPLICATE_STAGE_PROBES ?
+				probe_file(entry, &file, buffer, &bytes_read) :
+				hash_contents(run, entry, &file, buffer, &bytes_read);
+		}
+		mapped_file_close(&file);
+	}
+	entry->unreadable = !hashed;
+
+	bool whole = stage == DUPLICATE_STAGE_CONTENTS || entry->size <= 2 * DUPLICATE_PROBE_BYTES;
+	SDL_LockMutex(run->mutex);
+	run->stats.bytes_read += bytes_read;
+	run->stats.num_files_hashed += hashed && whole;
+	run->stats.num_unreadable += !hashed;
+	SDL_UnlockMutex(run->mutex);
+}
+
+static void duplicate_job (void *data) {
+	DuplicateJob *job = data;
+	DuplicateRun *run = job->run;
+	u8 *buffer = SDL_malloc(job->stage == DUPLICATE_STAGE_PROBES ? 2 * DUPLICATE_PROBE_BYTES : DUPLICATE_READ_LIMIT);
+
+	// a cancelled run still counts its files down, so the run finishes
+	for (u32 i = job->first; i < job->end; i++) {
+		DuplicateEntry *entry = &run->entries[i];
+		DuplicateGroup *group = entry->group;
+		if (!SDL_GetAtomicInt(&run->cancelled)) {
+			hash_file(run, job->stage, entry, buffer);
+		}
+		if (job_counter_complete(&group->remaining)) {
+			finish_group(run, group);
+		}
+	}
+
+	SDL_free(buffer);
+	release_job(run);
+}
+
+//=============================================================================
+// RUNS
+//=============================================================================
+
+static void free_run (DuplicateRun *run) {
+	for (u32 i = 0; i < run->num_entries; i++) {
+		SDL_free(run->entries[i].path);
+	}
+	SDL_free(run->entries);
+	SDL_free(run->size_groups);
+	while (run->jobs) {
+		DuplicateJob *job = run->jobs;
+		run->jobs = job->next;
+		SDL_free(job);
+	}
+	while (run->content_groups) {
+		DuplicateGroup *group = run->content_groups;
+		run->content_groups = group->next;
+		SDL_free(group);
+	}
+	SDL_free(run->pending_sets);
+	SDL_free(run->pending_paths);
+	SDL_DestroyMutex(run->mutex);
+	SDL_free(run);
+}
+
+static void collect_files (DuplicateRun *run, Directory *directory) {
+	for (u32 i = 0; i < directory->num_child_files; i++) {
+		File *file = directory->child_files[i];
+
+		// empty files are all alike, but deleting them reclaims nothing; nor
+		// does deleting a link, whose target is found on its own if it is in the tree
+		if (file->removed || file->size == 0 || file->is_link) {
+			continue;
+		}
+		if (run->num_entries == run->entries_capacity) {
+			run->entries_capacity = xtd_max(run->entries_capacity * 2, 256u);
+			run->entries = SDL_realloc(run->entries, run->entries_capacity * sizeof(DuplicateEntry));
+		}
+		run->entries[run->num_entries++] = (DuplicateEntry) { .path = SDL_strdup(file->path), .size = file->size };
+	}
+	for (u32 i = 0; i < directory->num_child_directories; i++) {
+		if (directory->child_directories[i]->removed) continue;
+		collect_files(run, directory->child_directories[i]);
+	}
+}
+
+static int compare_sizes (const void *a, const void *b) {
+	const DuplicateEntry *left = a;
+	const DuplicateEntry *right = b;
+	return (left->size > right->size) - (left->size < right->size);
+}
+
+static u32 size_run_end (DuplicateRun *run, u32 first) {
+	u32 end = first + 1;
+	while (end < run->num_entries && run->entries[end].size == run->entries[first].size) {
+		end++;
+	}
+	return end;
+}
+
+// the first stage, on the calling thread: drops every file whose size is
+// unique and makes a group of each size left
+static void group_by_size (DuplicateRun *run) {
+	SDL_qsort(run->entries, run->num_entries, sizeof(DuplicateEntry), compare_sizes);
+
+	u32 num_kept = 0;
+	u32 num_groups = 0;
+	for (u32 first = 0; first < run->num_entries; ) {
+		u32 end = size_run_end(run, first);
+		if (end - first < 2) {
+			SDL_free(run->entries[first].path);
+		} else {
+			SDL_memmove(run->entries + num_kept, run->entries + first, (end - first) * sizeof(DuplicateEntry));
+			num_kept += end - first;
+			num_groups++;
+		}
+		first = end;
+	}
+	run->num_entries = num_kept;
+
+	run->size_groups = SDL_calloc(xtd_max(num_groups, 1u), sizeof(DuplicateGroup));
+	DuplicateGroup *group = run->size_groups;
+	for (u32 first = 0; first < run->num_entries; group++) {
+		u32 end = size_run_end(run, first);
+		group->first = first;
+		group->end = end;
+		group->stage = DUPLICATE_STAGE_PROBES;
+		job_counter_set(&group->remaining, (i32) (end - first));
+		for (u32 i = first; i < end; i++) {
+			run->entries[i].group = group;
+		}
+		first = end;
+	}
+}
+
+//=============================================================================
+// FINDER
+//=============================================================================
+
+void duplicate_finder_init (DuplicateFinder *finder, JobQueue *job_queue) {
+	SDL_memset(finder, 0, sizeof(*finder));
+	finder->job_queue = job_queue;
+}
+
+void duplicate_finder_shutdown (DuplicateFinder *finder) {
+	while (finder->runs) {
+		DuplicateRun *run = finder->runs;
+		finder->runs = run->next;
+		free_run(run);
+	}
+	SDL_free(finder->sets);
+	SDL_free(finder->paths);
+	SDL_memset(finder, 0, sizeof(*finder));
+}
+
+void duplicate_finder_cancel (DuplicateFinder *finder) {
+	if (finder->runs) {
+		SDL_SetAtomicInt(&finder->runs->cancelled, 1);
+	}
+}
+
+void duplicate_finder_start (DuplicateFinder *finder, Directory *roots, u32 num_roots) {
+	duplicate_finder_cancel(finder);
+	finder->num_sets = 0;
+	finder->num_paths = 0;
+	finder->num_rows = 0;
+	SDL_memset(&finder->stats, 0, sizeof(finder->stats));
+
+	DuplicateRun *run = SDL_calloc(1, sizeof(DuplicateRun));
+	run->job_queue = finder->job_queue;
+	run->mutex = SDL_CreateMutex();
+	run->next = finder->runs;
+	finder->runs = run;
+
+	run->stats.start_ns = SDL_GetTicksNS();
+	for (u32 i = 0; i < num_roots; i++) {
+		collect_files(run, &roots[i]);
+	}
+	run->stats.num_files = run->num_entries;
+	group_by_size(run);
+	run->stats.num_size_candidates = run->num_entries;
+
+	// the run holds a job of its own until every probe job is pushed, so it
+	// cannot be seen finished while they are still going out
+	SDL_SetAtomicInt(&run->num_jobs, 1);
+	for (u32 i = 0; i < run->num_entries; i += DUPLICATE_JOB_FILES) {
+		push_job(run, DUPLICATE_STAGE_PROBES, i, xtd_min(i + DUPLICATE_JOB_FILES, run->num_entries));
+	}
+	release_job(run);
+}
+
+bool duplicate_finder_update (DuplicateFinder *finder) {
+	// a cancelled run's jobs still hash into its entries until release_job
+	// sees the last of them return
+	if (finder->runs) {
+		DuplicateRun **link = &finder->runs->next;
+		while (*link) {
+			DuplicateRun *run = *link;
+			if (SDL_GetAtomicInt(&run->finished)) {
+				*link = run->next;
+				free_run(run);
+			} else {
+				link = &run->next;
+			}
+		}
+	}
+
+	DuplicateRun *run = finder->runs;
+	if (!run) {
+		return false;
+	}
+
+	u32 num_sets_before = finder->num_sets;
+
+	SDL_LockMutex(run->mutex);
+	if (finder->num_sets + run->num_pending_sets > finder->sets_capacity) {
+		finder->sets_capacity = xtd_max(finder->sets_capacity * 2, finder->num_sets + run->num_pending_sets);
+		finder->sets = SDL_realloc(finder->sets, finder->sets_capacity * sizeof(DuplicateSet));
+	}
+	if (finder->num_paths + run->num_pending_paths > finder->paths_capacity) {
+		finder->paths_capacity = xtd_max(finder->paths_capacity * 2, finder->num_paths + run->num_pending_paths);
+		finder->paths = SDL_realloc(finder->paths, finder->paths_capacity * sizeof(char *));
+	}
+	for (u32 i = 0; i < run->num_pending_sets; i++) {
+		DuplicateSet *set = &finder->sets[finder->num_sets++];
+		*set = run->pending_sets[i];
+		set->first_path += finder->num_paths;
+		set->first_row = finder->num_rows;
+		finder->num_rows += 1 + set->num_files;
+	}
+	SDL_memcpy(finder->paths + finder->num_paths, run->pending_paths, run->num_pending_paths * sizeof(char *));
+	finder->num_paths += run->num_pending_paths;
+	run->num_pending_sets = 0;
+	run->num_pending_paths = 0;
+	finder->stats = run->stats;
+	SDL_UnlockMutex(run->mutex);
+
+	return finder->num_sets != num_sets_before;
+}
+
+bool duplicate_finder_is_busy (DuplicateFinder *finder) {
+	return finder->runs && !SDL_GetAtomicInt(&finder->runs->finished);
+}
+
+DuplicateSet *duplicate_finder_set_at_row (DuplicateFinder *finder, u32 row) {
+	u32 low = 0;
+	u32 high = finder->num_sets;
+	while (high - low > 1) {
+		u32 middle = low + (high - low) / 2;
+		if (finder->sets[middle].first_row <= row) {
+			low = middle;
+		} else {
+			high = middle;
+		}
+	}
+	return &finder->sets[low];
+}
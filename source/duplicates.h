@@ -0,0 +1,105 @@
+#ifndef DUPLICATES_H
+#define DUPLICATES_H
+
+#include "xtdlib.h"
+
+#include <SDL3/SDL.h>
+
+#include "job.h"
+#include "ui.h"
+
+//=============================================================================
+// DUPLICATE FINDER
+//=============================================================================
+
+// Files with identical contents below the scanned roots, found in three
+// stages that each pass on only what could still be a duplicate:
+//
+//   1. sizes: duplicate_finder_start snapshots the paths and sizes the
+//      scanner recorded and sorts them by size. Files of a size nothing else
+//      has, and empty files, are dropped without being opened.
+//   2. probes: the first and last DUPLICATE_PROBE_BYTES of every remaining
+//      file are hashed. Files no larger than the two probes are hashed whole
+//      here and need nothing more.
+//   3. contents: files still sharing a size and probe hash are hashed
+//      whole; small ones are read into one reused buffer, larger ones mapped
+//      window by window.
+//
+// The stages are pipelined per group rather than run one after the other.
+// Every group of candidates counts down as its files are hashed, and the job
+// hashing its last file splits it by hash and passes the groups of two or
+// more on, so contents of one size are being read while other sizes are
+// still being probed. A set is confirmed as soon as its last file is hashed;
+// sets stream into the run and are moved into finder->sets by
+// duplicate_finder_update on the UI thread.
+//
+// Hashes are XXH64: four independent lanes of 8 bytes, so the multiplies of
+// a 32-byte stripe overlap. A set is files agreeing on size, probes and a
+// 64-bit hash of everything; they are not compared byte by byte.
+//
+// Only copies count. Symbolic links are left out, and paths that are hard
+// links to one file (the same device and inode, read when it is probed) are
+// kept as one before a group is split, so they are neither hashed whole twice
+// nor reported as reclaimable.
+
+#define DUPLICATE_PROBE_BYTES   4096
+#define DUPLICATE_READ_LIMIT    (1ull << 20)
+#define DUPLICATE_WINDOW_SIZE   (16ull << 20)
+#define DUPLICATE_JOB_FILES     256
+#define DUPLICATE_JOB_BYTES     (32ull << 20)
+
+typedef struct DuplicateSet {
+	u64 size;				// of each file
+	u32 first_path;			// into DuplicateFinder::paths
+	u32 num_files;
+	u32 first_row;			// the set's header row in the view, its files follow
+	char label[64];			// filled in by the view
+} DuplicateSet;
+
+typedef struct DuplicateStats {
+	u64 num_files;
+	u64 num_size_candidates;	// sharing their size with another file
+	u64 num_content_candidates;	// sharing size and probes, too large to be done
+	u64 num_files_hashed;		// whole, by either stage
+	u64 num_unreadable;			// gone, unreadable or changed since the scan
+	u64 bytes_read;
+	u64 reclaimable_bytes;		// all but one copy of every set
+	u64 start_ns;
+	u64 end_ns;
+} DuplicateStats;
+
+typedef struct DuplicateRun DuplicateRun;
+
+typedef struct DuplicateFinder {
+	JobQueue *job_queue;
+	DuplicateRun *runs;		// newest first; only the head is current
+
+	DuplicateSet *sets;
+	u32 num_sets;
+	u32 sets_capacity;
+	const char **paths;		// owned by the run, valid while it is the current one
+	u32 num_paths;
+	u32 paths_capacity;
+	u32 num_rows;
+	DuplicateStats stats;
+} DuplicateFinder;
+
+void duplicate_finder_init (DuplicateFinder *finder, JobQueue *job_queue);
+
+// frees every run; call after the job queue is destroyed
+void duplicate_finder_shutdown (DuplicateFinder *finder);
+
+// looks for duplicates below the given roots, superseding the current run
+void duplicate_finder_start (DuplicateFinder *finder, Directory *roots, u32 num_roots);
+void duplicate_finder_cancel (DuplicateFinder *finder);
+
+// moves confirmed sets into finder->sets; call once per frame from the UI
+// thread. returns true if sets were added
+bool duplicate_finder_update (DuplicateFinder *finder);
+
+bool duplicate_finder_is_busy (DuplicateFinder *finder);
+
+// the set a view row belongs to; row must be below num_rows
+DuplicateSet *duplicate_finder_set_at_row (DuplicateFinder *finder, u32 row);
+
+#endif // DUPLICATES_H
@@ -0,0 +1,188 @@
+#include "file_map.h"
+
+#include <SDL3/SDL.h>
+
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+static u64 allocation_granularity (void) {
+#if defined(_WIN32)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwAllocationGranularity;
+#else
+	return (u64) sysconf(_SC_PAGESIZE);
+#endif
+}
+
+//=============================================================================
+// FILES
+//=============================================================================
+
+bool mapped_file_open (MappedFile *file, const char *path) {
+	SDL_memset(file, 0, sizeof(*file));
+
+#if defined(_WIN32)
+	HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (handle == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER size;
+	GetFileSizeEx(handle, &size);
+	file->size = (u64) size.QuadPart;
+	file->file_handle = handle;
+	BY_HANDLE_FILE_INFORMATION identity;
+	if (GetFileInformationByHandle(handle, &identity)) {
+		file->device = identity.dwVolumeSerialNumber;
+		file->inode = ((u64) identity.nFileIndexHigh << 32) | identity.nFileIndexLow;
+	}
+
+	// empty files cannot be mapped, but they are still valid to open
+	if (file->size > 0) {
+		file->mapping_handle = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (!file->mapping_handle) {
+			CloseHandle(handle);
+			return false;
+		}
+	}
+#else
+	file->descriptor = open(path, O_RDONLY);
+	if (file->descriptor < 0) {
+		return false;
+	}
+	struct stat info;
+	if (fstat(file->descriptor, &info) != 0) {
+		close(file->descriptor);
+		return false;
+	}
+	file->size = (u64) info.st_size;
+	file->device = (u64) info.st_dev;
+	file->inode = (u64) info.st_ino;
+#endif
+
+	file->is_open = true;
+	return true;
+}
+
+void mapped_file_close (MappedFile *file) {
+	if (file->is_open) {
+#if defined(_WIN32)
+		if (file->mapping_handle) CloseHandle(file->mapping_handle);
+		CloseHandle(file->file_handle);
+#else
+		close(file->descriptor);
+#endif
+	}
+	SDL_memset(file, 0, sizeof(*file));
+}
+
+u64 mapped_file_read (MappedFile *file, u64 offset, void *buffer, u64 length) {
+	u64 total = 0;
+	while (total < length) {
+#if defined(_WIN32)
+		OVERLAPPED overlapped = {0};
+		overlapped.Offset = (DWORD) (offset + total);
+		overlapped.OffsetHigh = (DWORD) ((offset + total) >> 32);
+		DWORD chunk = (DWORD) xtd_min(length - total, (u64) (1u << 30));
+		DWORD bytes_read = 0;
+		if (!ReadFile(file->file_handle, (u8 *) buffer + total, chunk, &bytes_read, &overlapped) || bytes_read == 0) {
+			break;
+		}
+#else
+		ssize_t bytes_read = pread(file->descriptor, (u8 *) buffer + total, length - total, (off_t) (offset + total));
+		if (bytes_read <= 0) {
+			break;
+		}
+#endif
+		total += (u64) bytes_read;
+	}
+	return total;
+}
+
+//=============================================================================
+// VIEWS
+//=============================================================================
+
+bool mapped_view_map (MappedFile *file, MappedView *view, u64 offset, u64 length, MappedAccess access) {
+	mapped_view_unmap(view);
+
+	if (offset >= file->size) {
+		view->offset = file->size;
+		return file->size == 0 || offset == file->size;
+	}
+	length = xtd_min(length, file->size - offset);
+
+	u64 granularity = allocation_granularity();
+	u64 base_offset = offset - (offset % granularity);
+	u64 base_length = (offset - base_offset) + length;
+
+#if defined(_WIN32)
+	void *base = MapViewOfFile(file->mapping_handle, FILE_MAP_READ,
+		(DWORD) (base_offset >> 32), (DWORD) base_offset, (SIZE_T) base_length);
+	if (!base) {
+		return false;
+	}
+	xtd_ignore_unused(access);
+#else
+	void *base = mmap(NULL, base_length, PROT_READ, MAP_PRIVATE, file->descriptor, (off_t) base_offset);
+	if (base == MAP_FAILED) {
+		return false;
+	}
+	madvise(base, base_length, access == MAPPED_ACCESS_SEQUENTIAL ? MADV_SEQUENTIAL : MADV_RANDOM);
+#endif
+
+	view->base = base;
+	view->base_length = base_length;
+	view->offset = offset;
+	view->length = length;
+	view->data = (const u8 *) base + (offset - base_offset);
+	return true;
+}
+
+void mapped_view_unmap (MappedView *view) {
+	if (view->base) {
+#if defined(_WIN32)
+		UnmapViewOfFile(view->base);
+#else
+		munmap(view->base, view->base_length);
+#endif
+	}
+	SDL_memset(view, 0, sizeof(*view));
+}
+
+//=============================================================================
+// SEQUENTIAL READS
+//=============================================================================
+
+void mapped_reader_begin (MappedReader *reader, MappedFile *file, u8 *buffer, u64 read_limit, u64 window_size) {
+	*reader = (MappedReader) { .file = file, .buffer = buffer, .read_limit = read_limit, .window_size = window_size };
+}
+
+bool mapped_reader_next (MappedReader *reader) {
+	MappedFile *file = reader->file;
+	if (reader->offset >= file->size) {
+		return false;
+	}
+	if (file->size <= reader->read_limit) {
+		reader->data = reader->buffer;
+		reader->length = mapped_file_read(file, reader->offset, reader->buffer, file->size - reader->offset);
+		return reader->length > 0;
+	}
+	if (!mapped_view_map(file, &reader->view, reader->offset, reader->window_size, MAPPED_ACCESS_SEQUENTIAL)) {
+		return false;
+	}
+	reader->data = reader->view.data;
+	reader->length = reader->view.length;
+	return true;
+}
+
+void mapped_reader_end (MappedReader *reader) {
+	mapped_view_unmap(&reader->view);
+}
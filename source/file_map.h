@@ -0,0 +1,78 @@
+#ifndef FILE_MAP_H
+#define FILE_MAP_H
+
+#include "xtdlib.h"
+
+//=============================================================================
+// MEMORY-MAPPED FILES
+//=============================================================================
+
+// Read-only file mappings. Large files are never mapped whole; callers map a
+// window (MappedView) around the bytes they need and remap as they move, so
+// resident memory stays bounded by the window size no matter the file size.
+
+typedef struct MappedFile {
+	u64 size;
+	u64 device;			// with inode, the same for every hard link to one file
+	u64 inode;
+	bool is_open;		// false for a zeroed MappedFile, which is safe to close
+#if defined(_WIN32)
+	void *file_handle;
+	void *mapping_handle;
+#else
+	i32 descriptor;
+#endif
+} MappedFile;
+
+typedef struct MappedView {
+	const u8 *data;		// first requested byte
+	u64 offset;			// file offset of data
+	u64 length;
+
+	void *base;			// allocation-granularity aligned start of the mapping
+	u64 base_length;
+} MappedView;
+
+typedef enum MappedAccess {
+	MAPPED_ACCESS_RANDOM,
+	MAPPED_ACCESS_SEQUENTIAL
+} MappedAccess;
+
+bool mapped_file_open (MappedFile *file, const char *path);
+void mapped_file_close (MappedFile *file);
+
+// plain positioned read; cheaper than a mapping for small files. returns bytes read
+u64 mapped_file_read (MappedFile *file, u64 offset, void *buffer, u64 length);
+
+// maps [offset, offset + length) clamped to the file size; unmaps view first if mapped
+bool mapped_view_map (MappedFile *file, MappedView *view, u64 offset, u64 length, MappedAccess access);
+void mapped_view_unmap (MappedView *view);
+
+// -- Sequential reads --------------------------------------------------------
+
+// Walks a file front to back in chunks. Mapping costs a few syscalls and page
+// faults, more than reading a small file outright, so a file of at most
+// read_limit bytes is read into buffer and arrives as one chunk; a larger one
+// is mapped window by window. The caller advances offset by what it used of
+// each chunk, which may stop short of its end to take the rest again at the
+// start of the next one.
+typedef struct MappedReader {
+	MappedFile *file;
+	u8 *buffer;				// read_limit bytes
+	u64 read_limit;
+	u64 window_size;
+	MappedView view;
+	u64 offset;				// of the next chunk
+
+	const u8 *data;			// the current chunk
+	u64 length;
+} MappedReader;
+
+void mapped_reader_begin (MappedReader *reader, MappedFile *file, u8 *buffer, u64 read_limit, u64 window_size);
+
+// reads or maps the chunk at offset; false at the end of the file or if it
+// could not be read, which the caller tells apart by offset
+bool mapped_reader_next (MappedReader *reader);
+void mapped_reader_end (MappedReader *reader);
+
+#endif // FILE_MAP_H
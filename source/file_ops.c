@@ -0,0 +1,712 @@
+// copy_file_range is a GNU extension in glibc
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+	#define _GNU_SOURCE
+#endif
+
+#include "file_ops.h"
+
+#include "scan.h"
+
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <errno.h>
+	#include <fcntl.h>
+	#include <string.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+	#if defined(__linux__)
+		#include <sys/sendfile.h>
+	#endif
+#endif
+
+typedef struct FileTask {
+	char *source;
+	char *target;			// NULL when deleting
+	u64 size;
+	u32 item;
+	bool remove_source;		// moves: the source goes once it is copied
+} FileTask;
+
+typedef struct FileBatch {
+	u32 first;
+	u32 end;
+} FileBatch;
+
+typedef struct PlanDirectory {
+	char *path;
+	u32 item;
+} PlanDirectory;
+
+struct FileOperationPlan {
+	FileTask *tasks;
+	u32 num_tasks;
+	u32 tasks_capacity;
+
+	FileBatch *batches;
+	u32 num_batches;
+	SDL_AtomicInt next_batch;
+	JobCounter counter;
+
+	// source directories to remove once their contents are gone, deepest first
+	PlanDirectory *directories;
+	u32 num_directories;
+	u32 directories_capacity;
+};
+
+typedef struct PlanWalk {
+	FileOperation *operation;
+	u32 item;
+	const char *target_directory;	// NULL when deleting
+	bool remove_sources;
+	u32 depth;
+} PlanWalk;
+
+//=============================================================================
+// ERRORS
+//=============================================================================
+
+static void fail_item (FileOperation *operation, u32 item) {
+	SDL_SetAtomicInt(&operation->items[item].failed, 1);
+}
+
+// counts the error against the item and keeps the operation's first message
+static void report_error (FileOperation *operation, u32 item, const char *path, const char *reason) {
+	fail_item(operation, item);
+	SDL_AddAtomicInt(&operation->progress.num_errors, 1);
+	if (SDL_CompareAndSwapAtomicInt(&operation->error_claimed, 0, 1)) {
+		SDL_snprintf(operation->error, sizeof(operation->error), "%s: %s", path, reason);
+		SDL_SetAtomicInt(&operation->error_ready, 1);
+	}
+}
+
+#if defined(_WIN32)
+static void report_system_error (FileOperation *operation, u32 item, const char *path, DWORD code) {
+	char reason[32];
+	SDL_snprintf(reason, sizeof(reason), "error %lu", (unsigned long) code);
+	report_error(operation, item, path, reason);
+}
+#else
+static void report_system_error (FileOperation *operation, u32 item, const char *path, int code) {
+	report_error(operation, item, path, strerror(code));
+}
+#endif
+
+static bool is_cancelled (FileOperation *operation) {
+	return SDL_GetAtomicInt(&operation->cancelled) != 0;
+}
+
+//=============================================================================
+// COPYING
+//=============================================================================
+
+#if defined(_WIN32)
+
+typedef struct CopyProgress {
+	FileOperation *operation;
+	u64 reported;
+} CopyProgress;
+
+static DWORD CALLBACK copy_progress (LARGE_INTEGER total_size, LARGE_INTEGER transferred,
+	LARGE_INTEGER stream_size, LARGE_INTEGER stream_transferred, DWORD stream_number,
+	DWORD reason, HANDLE source, HANDLE target, LPVOID data) {
+	CopyProgress *progress = data;
+	u64 done = (u64) transferred.QuadPart;
+	atomic_u64_add(&progress->operation->progress.bytes_done, done - progress->reported);
+	atomic_u64_add(&progress->operation->progress.bytes_offloaded, done - progress->reported);
+	progress->reported = done;
+	return is_cancelled(progress->operation) ? PROGRESS_CANCEL : PROGRESS_CONTINUE;
+}
+
+// CopyFileEx copies in the kernel (or on the server, for network shares) and
+// removes the partial target itself when cancelled
+static bool copy_file (FileOperation *operation, FileTask *task, u8 **buffer) {
+	xtd_ignore_unused(buffer);
+	CopyProgress progress = { operation, 0 };
+	DWORD flags = COPY_FILE_FAIL_IF_EXISTS | COPY_FILE_COPY_SYMLINK;
+	if (!CopyFileExA(task->source, task->target, copy_progress, &progress, NULL, flags)) {
+		DWORD code = GetLastError();
+		if (code != ERROR_REQUEST_ABORTED) {
+			report_system_error(operation, task->item, task->source, code);
+		} else {
+			fail_item(operation, task->item);
+		}
+		return false;
+	}
+	return true;
+}
+
+#else
+
+typedef enum CopyMethod {
+	COPY_METHOD_COPY_FILE_RANGE,
+	COPY_METHOD_SENDFILE,
+	COPY_METHOD_READ_WRITE
+} CopyMethod;
+
+static bool write_all (int fd, const u8 *data, size_t length) {
+	while (length > 0) {
+		ssize_t written = write(fd, data, length);
+		if (written < 0) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+		data += written;
+		length -= (size_t) written;
+	}
+	return true;
+}
+
+// moves up to one chunk from source to target, both at their current file
+// offsets, so a fallback can pick up wherever the previous method stopped.
+// Returns the bytes moved, 0 at the end of the file, -1 with errno set
+static i64 transfer_chunk (int source, int target, CopyMethod *method, u8 **buffer, bool at_start, u64 expected_size) {
+#if defined(__linux__)
+	if (*method == COPY_METHOD_COPY_FILE_RANGE) {
+		ssize_t moved;
+		do moved = copy_file_range(source, NULL, target, NULL, FILE_OPS_CHUNK_BYTES, 0);
+		while (moved < 0 && errno == EINTR);
+
+		// some pseudo file systems report an empty file rather than refusing
+		bool refused = (moved < 0 && (errno == EXDEV || errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP)) ||
+			(moved == 0 && at_start && expected_size > 0);
+		if (!refused) {
+			return moved;
+		}
+		*method = COPY_METHOD_SENDFILE;
+	}
+	if (*method == COPY_METHOD_SENDFILE) {
+		ssize_t moved;
+		do moved = sendfile(target, source, NULL, FILE_OPS_CHUNK_BYTES);
+		while (moved < 0 && errno == EINTR);
+
+		bool refused = (moved < 0 && (errno == EINVAL || errno == ENOSYS)) ||
+			(moved == 0 && at_start && expected_size > 0);
+		if (!refused) {
+			return moved;
+		}
+		*method = COPY_METHOD_READ_WRITE;
+	}
+#else
+	xtd_ignore_unused(at_start);
+	xtd_ignore_unused(expected_size);
+	*method = COPY_METHOD_READ_WRITE;
+#endif
+
+	if (!*buffer) {
+		*buffer = SDL_aligned_alloc(FILE_OPS_BUFFER_ALIGNMENT, FILE_OPS_BUFFER_BYTES);
+	}
+	i64 moved = 0;
+	while (moved < (i64) FILE_OPS_CHUNK_BYTES) {
+		ssize_t length = read(source, *buffer, FILE_OPS_BUFFER_BYTES);
+		if (length < 0) {
+			if (errno == EINTR) continue;
+			return -1;
+		}
+		if (length == 0 || !write_all(target, *buffer, (size_t) length)) {
+			return length == 0 ? moved : -1;
+		}
+		moved += length;
+	}
+	return moved;
+}
+
+// a link is copied as a link to the same place, whatever it points at
+static bool copy_link (FileOperation *operation, FileTask *task) {
+	char destination[4096];
+	ssize_t length = readlink(task->source, destination, sizeof(destination) - 1);
+	if (length < 0) {
+		report_system_error(operation, task->item, task->source, errno);
+		return false;
+	}
+	destination[length] = '\0';
+	if (symlink(destination, task->target) != 0) {
+		report_system_error(operation, task->item, task->target, errno);
+		return false;
+	}
+	return true;
+}
+
+static bool copy_file (FileOperation *operation, FileTask *task, u8 **buffer) {
+	struct stat link_info;
+	if (lstat(task->source, &link_info) == 0 && S_ISLNK(link_info.st_mode)) {
+		return copy_link(operation, task);
+	}
+
+	int source = open(task->source, O_RDONLY | O_CLOEXEC);
+	if (source < 0) {
+		report_system_error(operation, task->item, task->source, errno);
+		return false;
+	}
+	struct stat info;
+	if (fstat(source, &info) != 0) {
+		report_system_error(operation, task->item, task->source, errno);
+		close(source);
+		return false;
+	}
+	int target = open(task->target, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, info.st_mode & 07777);
+	if (target < 0) {
+		report_system_error(operation, task->item, task->target, errno);
+		close(source);
+		return false;
+	}
+
+	CopyMethod method = COPY_METHOD_COPY_FILE_RANGE;
+	bool ok = true;
+	u64 copied = 0;
+	for (;;) {
+		if (is_cancelled(operation)) {
+			fail_item(operation, task->item);
+			ok = false;
+			break;
+		}
+		i64 moved = transfer_chunk(source, target, &method, buffer, copied == 0, (u64) info.st_size);
+		if (moved < 0) {
+			report_system_error(operation, task->item, task->source, errno);
+			ok = false;
+			break;
+		}
+		if (moved == 0) {
+			break;
+		}
+		copied += (u64) moved;
+		atomic_u64_add(&operation->progress.bytes_done, (u64) moved);
+		if (method != COPY_METHOD_READ_WRITE) {
+			atomic_u64_add(&operation->progress.bytes_offloaded, (u64) moved);
+		}
+	}
+
+	if (ok) {
+#if defined(__APPLE__)
+		struct timespec times[2] = { info.st_atimespec, info.st_mtimespec };
+#else
+		struct timespec times[2] = { info.st_atim, info.st_mtim };
+#endif
+		futimens(target, times);
+	}
+	close(source);
+	close(target);
+
+	// a partial copy is worse than none
+	if (!ok) {
+		unlink(task->target);
+	}
+	return ok;
+}
+
+#endif
+
+// SDL_GetPathInfo without following a symbolic link: the link itself is
+// reported, as a file, so it is deleted, moved or copied as one and never
+// walked into
+static bool get_path_info (const char *path, SDL_PathInfo *info) {
+#if defined(_WIN32)
+	if (!SDL_GetPathInfo(path, info)) {
+		return false;
+	}
+	DWORD attributes = GetFileAttributesA(path);
+	if (attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_REPARSE_POINT)) {
+		info->type = SDL_PATHTYPE_FILE;
+		info->size = 0;
+	}
+	return true;
+#else
+	struct stat stat;
+	if (lstat(path, &stat) != 0) {
+		return SDL_SetError("%s", strerror(errno));
+	}
+	if (S_ISDIR(stat.st_mode)) info->type = SDL_PATHTYPE_DIRECTORY;
+	else if (S_ISREG(stat.st_mode) || S_ISLNK(stat.st_mode)) info->type = SDL_PATHTYPE_FILE;
+	else info->type = SDL_PATHTYPE_OTHER;
+	info->size = (u64) stat.st_size;
+#if defined(__APPLE__)
+	info->modify_time = (SDL_Time) stat.st_mtimespec.tv_sec * SDL_NS_PER_SECOND + stat.st_mtimespec.tv_nsec;
+#else
+	info->modify_time = (SDL_Time) stat.st_mtim.tv_sec * SDL_NS_PER_SECOND + stat.st_mtim.tv_nsec;
+#endif
+	info->create_time = info->access_time = info->modify_time;
+	return true;
+#endif
+}
+
+//=============================================================================
+// PLANNING
+//=============================================================================
+
+static void push_task (FileOperationPlan *plan, char *source, char *target, u64 size, u32 item, bool remove_source) {
+	if (plan->num_tasks == plan->tasks_capacity) {
+		plan->tasks_capacity = xtd_max(plan->tasks_capacity * 2, 256u);
+		plan->tasks = SDL_realloc(plan->tasks, plan->tasks_capacity * sizeof(FileTask));
+	}
+	plan->tasks[plan->num_tasks++] = (FileTask) { source, target, size, item, remove_source };
+}
+
+static void push_directory (FileOperationPlan *plan, char *path, u32 item) {
+	if (plan->num_directories == plan->directories_capacity) {
+		plan->directories_capacity = xtd_max(plan->directories_capacity * 2, 64u);
+		plan->directories = SDL_realloc(plan->directories, plan->directories_capacity * sizeof(PlanDirectory));
+	}
+	plan->directories[plan->num_directories++] = (PlanDirectory) { path, item };
+}
+
+static void plan_file (PlanWalk *walk, char *source, char *target, u64 size) {
+	FileOperation *operation = walk->operation;
+	push_task(operation->plan, source, target, size, walk->item, walk->remove_sources);
+	SDL_AddAtomicInt(&operation->progress.num_files, 1);
+	atomic_u64_add(&operation->progress.total_bytes, size);
+}
+
+static void plan_directory (PlanWalk *walk, const char *source, const char *target);
+
+static SDL_EnumerationResult plan_entry (void *user_data, const char *dirname, const char *fname) {
+	xtd_ignore_unused(dirname);
+	PlanWalk *walk = user_data;
+	FileOperation *operation = walk->operation;
+	if (is_cancelled(operation)) {
+		return SDL_ENUM_SUCCESS;
+	}
+
+	char *source = join_path(dirname, fname);
+	SDL_PathInfo info;
+	if (!get_path_info(source, &info)) {
+		report_error(operation, walk->item, source, SDL_GetError());
+		SDL_free(source);
+		return SDL_ENUM_CONTINUE;
+	}
+	char *target = walk->target_directory ? join_path(walk->target_directory, fname) : NULL;
+
+	if (info.type == SDL_PATHTYPE_DIRECTORY) {
+		plan_directory(walk, source, target);
+		if (walk->remove_sources) {
+			push_directory(operation->plan, source, walk->item);
+		} else {
+			SDL_free(source);
+		}
+		SDL_free(target);
+	} else {
+		plan_file(walk, source, target, info.type == SDL_PATHTYPE_FILE ? info.size : 0);
+	}
+	return SDL_ENUM_CONTINUE;
+}
+
+// creates target (when copying) and plans everything below source
+static void plan_directory (PlanWalk *walk, const char *source, const char *target) {
+	FileOperation *operation = walk->operation;
+	if (walk->depth >= SCAN_MAX_DEPTH) {
+		report_error(operation, walk->item, source, "too deeply nested");
+		return;
+	}
+	if (target && !SDL_CreateDirectory(target)) {
+		report_error(operation, walk->item, target, SDL_GetError());
+		return;
+	}
+
+	PlanWalk child = *walk;
+	child.target_directory = target;
+	child.depth = walk->depth + 1;
+	if (!SDL_EnumerateDirectory(source, plan_entry, &child)) {
+		report_error(operation, walk->item, source, SDL_GetError());
+	}
+}
+
+static bool is_inside (const char *path, const char *directory) {
+	size_t length = SDL_strlen(directory);
+	return SDL_strncmp(path, directory, length) == 0 && (path[length] == '/' || path[length] == '\\');
+}
+
+static void plan_item (FileOperation *operation, u32 index) {
+	FileOperationItem *item = &operation->items[index];
+	FileOperationPlan *plan = operation->plan;
+
+	SDL_PathInfo info;
+	if (!get_path_info(item->source, &info)) {
+		report_error(operation, index, item->source, SDL_GetError());
+		return;
+	}
+	item->is_directory = info.type == SDL_PATHTYPE_DIRECTORY;
+	item->size = info.type == SDL_PATHTYPE_FILE ? info.size : 0;
+	item->modified_time = info.modify_time;
+
+	PlanWalk walk = { operation, index, NULL, operation->kind != FILE_OPERATION_COPY, 0 };
+
+	if (operation->kind == FILE_OPERATION_DELETE) {
+		if (item->is_directory) {
+			plan_directory(&walk, item->source, NULL);
+			push_directory(plan, SDL_strdup(item->source), index);
+		} else {
+			plan_file(&walk, SDL_strdup(item->source), NULL, item->size);
+		}
+		return;
+	}
+
+	// a dangling link is still in the way
+	SDL_PathInfo existing;
+	if (get_path_info(item->target, &existing)) {
+		report_error(operation, index, item->target, "already exists");
+		return;
+	}
+	if (item->is_directory && is_inside(item->target, item->source)) {
+		report_error(operation, index, item->source, "cannot be copied into itself");
+		return;
+	}
+
+	// within one file system a move is a rename, whatever the size
+	if (operation->kind == FILE_OPERATION_MOVE && SDL_RenamePath(item->source, item->target)) {
+		item->created = true;
+		SDL_AddAtomicInt(&operation->progress.num_files, 1);
+		SDL_AddAtomicInt(&operation->progress.num_files_done, 1);
+		return;
+	}
+
+	if (item->is_directory) {
+		plan_directory(&walk, item->source, item->target);
+		item->created = SDL_GetPathInfo(item->target, &existing);
+		if (operation->kind == FILE_OPERATION_MOVE) {
+			push_directory(plan, SDL_strdup(item->source), index);
+		}
+	} else {
+		// the task creates the file; the tree only needs to know it was attempted
+		item->created = true;
+		plan_file(&walk, SDL_strdup(item->source), SDL_strdup(item->target), item->size);
+	}
+}
+
+//=============================================================================
+// EXECUTION
+//=============================================================================
+
+static void run_task (FileOperation *operation, FileTask *task, u8 **buffer) {
+	if (!task->target) {
+		if (SDL_RemovePath(task->source)) {
+			atomic_u64_add(&operation->progress.bytes_done, task->size);
+		} else {
+			report_error(operation, task->item, task->source, SDL_GetError());
+		}
+	} else if (copy_file(operation, task, buffer) && task->remove_source) {
+		if (!SDL_RemovePath(task->source)) {
+			report_error(operation, task->item, task->source, SDL_GetError());
+		}
+	}
+	SDL_AddAtomicInt(&operation->progress.num_files_done, 1);
+}
+
+static void finish (FileOperation *operation) {
+	FileOperationPlan *plan = operation->plan;
+	SDL_SetAtomicInt(&operation->progress.phase, FILE_OPERATION_PHASE_FINISHING);
+
+	// batches nobody claimed before the cancel leave their items incomplete
+	for (u32 i = (u32) xtd_min(SDL_GetAtomicInt(&plan->next_batch), (i32) plan->num_batches); i < plan->num_batches; i++) {
+		for (u32 j = plan->batches[i].first; j < plan->batches[i].end; j++) {
+			fail_item(operation, plan->tasks[j].item);
+		}
+	}
+
+	// deepest first, so each directory is empty by the time it is removed
+	for (u32 i = 0; i < plan->num_directories; i++) {
+		PlanDirectory *directory = &plan->directories[i];
+		if (SDL_GetAtomicInt(&operation->items[directory->item].failed)) {
+			continue;
+		}
+		if (!SDL_RemovePath(directory->path)) {
+			report_error(operation, directory->item, directory->path, SDL_GetError());
+		}
+	}
+
+	operation->end_ns = SDL_GetTicksNS();
+	SDL_SetAtomicInt(&operation->progress.phase, FILE_OPERATION_PHASE_DONE);
+	SDL_SetAtomicInt(&operation->finished, 1);
+}
+
+static void transfer_job (void *data) {
+	FileOperation *operation = data;
+	FileOperationPlan *plan = operation->plan;
+	u8 *buffer = NULL;
+
+	for (;;) {
+		u32 index = (u32) SDL_AddAtomicInt(&plan->next_batch, 1);
+		if (index >= plan->num_batches) {
+			break;
+		}
+		FileBatch *batch = &plan->batches[index];
+		for (u32 i = batch->first; i < batch->end; i++) {
+			if (is_cancelled(operation)) {
+				fail_item(operation, plan->tasks[i].item);
+				continue;
+			}
+			run_task(operation, &plan->tasks[i], &buffer);
+		}
+	}
+
+	SDL_aligned_free(buffer);
+	if (job_counter_complete(&plan->counter)) {
+		finish(operation);
+	}
+}
+
+// one large file, or up to FILE_OPS_BATCH_FILES small ones adding up to at most FILE_OPS_BATCH_BYTES
+static void build_batches (FileOperationPlan *plan) {
+	plan->batches = SDL_malloc((plan->num_tasks + 1) * sizeof(FileBatch));
+	u32 first = 0;
+	u64 bytes = 0;
+	for (u32 i = 0; i < plan->num_tasks; i++) {
+		if (i > first && (i - first >= FILE_OPS_BATCH_FILES || bytes + plan->tasks[i].size > FILE_OPS_BATCH_BYTES)) {
+			plan->batches[plan->num_batches++] = (FileBatch) { first, i };
+			first = i;
+			bytes = 0;
+		}
+		bytes += plan->tasks[i].size;
+	}
+	if (first < plan->num_tasks) {
+		plan->batches[plan->num_batches++] = (FileBatch) { first, plan->num_tasks };
+	}
+}
+
+static void plan_job (void *data) {
+	FileOperation *operation = data;
+	FileOperationPlan *plan = operation->plan;
+
+	for (u32 i = 0; i < operation->num_items && !is_cancelled(operation); i++) {
+		plan_item(operation, i);
+	}
+	if (is_cancelled(operation)) {
+		for (u32 i = 0; i < operation->num_items; i++) {
+			fail_item(operation, i);
+		}
+	}
+
+	build_batches(plan);
+	SDL_SetAtomicInt(&operation->progress.phase, FILE_OPERATION_PHASE_RUNNING);
+
+	u32 num_jobs = xtd_min(plan->num_batches, (u32) FILE_OPS_MAX_IN_FLIGHT);
+	if (num_jobs == 0 || is_cancelled(operation)) {
+		SDL_SetAtomicInt(&plan->next_batch, (i32) plan->num_batches);
+		finish(operation);
+		return;
+	}
+	job_counter_set(&plan->counter, (i32) num_jobs);
+	for (u32 i = 0; i < num_jobs; i++) {
+		job_queue_push(operation->job_queue, transfer_job, operation, JOB_PRIORITY_NORMAL);
+	}
+}
+
+//=============================================================================
+// ENGINE
+//=============================================================================
+
+void file_ops_init (FileOpsEngine *engine, JobQueue *job_queue) {
+	SDL_memset(engine, 0, sizeof(*engine));
+	engine->job_queue = job_queue;
+}
+
+void file_operation_free (FileOperation *operation) {
+	FileOperationPlan *plan = operation->plan;
+	for (u32 i = 0; i < plan->num_tasks; i++) {
+		SDL_free(plan->tasks[i].source);
+		SDL_free(plan->tasks[i].target);
+	}
+	for (u32 i = 0; i < plan->num_directories; i++) {
+		SDL_free(plan->directories[i].path);
+	}
+	SDL_free(plan->tasks);
+	SDL_free(plan->batches);
+	SDL_free(plan->directories);
+	SDL_free(plan);
+
+	for (u32 i = 0; i < operation->num_items; i++) {
+		SDL_free(operation->items[i].source);
+		SDL_free(operation->items[i].target);
+	}
+	SDL_free(operation->items);
+	SDL_free(operation->destination);
+	SDL_free(operation);
+}
+
+void file_ops_shutdown (FileOpsEngine *engine) {
+	while (engine->operations) {
+		FileOperation *operation = engine->operations;
+		engine->operations = operation->next;
+		file_operation_free(operation);
+	}
+	SDL_memset(engine, 0, sizeof(*engine));
+}
+
+static const char *path_name (const char *path) {
+	const char *name = path;
+	for (const char *c = path; *c; c++) {
+		if ((*c == '/' || *c == '\\') && c[1] != '\0') {
+			name = c + 1;
+		}
+	}
+	return name;
+}
+
+FileOperation *file_ops_start (FileOpsEngine *engine, FileOperationKind kind,
+	const char **sources, u32 num_sources, const char *destination) {
+	if (num_sources == 0 || (kind != FILE_OPERATION_DELETE && !destination)) {
+		return NULL;
+	}
+
+	FileOperation *operation = SDL_calloc(1, sizeof(FileOperation));
+	operation->kind = kind;
+	operation->job_queue = engine->job_queue;
+	operation->plan = SDL_calloc(1, sizeof(FileOperationPlan));
+	operation->destination = destination ? SDL_strdup(destination) : NULL;
+	operation->items = SDL_calloc(num_sources, sizeof(FileOperationItem));
+	operation->num_items = num_sources;
+	for (u32 i = 0; i < num_sources; i++) {
+		operation->items[i].source = SDL_strdup(sources[i]);
+		if (kind != FILE_OPERATION_DELETE) {
+			operation->items[i].target = join_path(destination, path_name(sources[i]));
+		}
+	}
+	operation->start_ns = SDL_GetTicksNS();
+
+	FileOperation **link = &engine->operations;
+	while (*link) link = &(*link)->next;
+	*link = operation;
+
+	job_queue_push(engine->job_queue, plan_job, operation, JOB_PRIORITY_NORMAL);
+	return operation;
+}
+
+void file_ops_cancel (FileOperation *operation) {
+	SDL_SetAtomicInt(&operation->cancelled, 1);
+}
+
+void file_ops_cancel_all (FileOpsEngine *engine) {
+	for (FileOperation *operation = engine->operations; operation; operation = operation->next) {
+		file_ops_cancel(operation);
+	}
+}
+
+FileOperation *file_ops_take_finished (FileOpsEngine *engine) {
+	for (FileOperation **link = &engine->operations; *link; link = &(*link)->next) {
+		FileOperation *operation = *link;
+		if (SDL_GetAtomicInt(&operation->finished)) {
+			*link = operation->next;
+			operation->next = NULL;
+			return operation;
+		}
+	}
+	return NULL;
+}
+
+bool file_ops_is_busy (FileOpsEngine *engine) {
+	for (FileOperation *operation = engine->operations; operation; operation = operation->next) {
+		if (!SDL_GetAtomicInt(&operation->finished)) return true;
+	}
+	return false;
+}
+
+f32 file_operation_fraction (FileOperation *operation) {
+	FileOperationProgress *progress = &operation->progress;
+	if (SDL_GetAtomicInt(&progress->phase) == FILE_OPERATION_PHASE_PLANNING) {
+		return 0;
+	}
+	u64 total_bytes = atomic_u64_get(&progress->total_bytes);
+	if (total_bytes) {
+		return (f32) ((f64) atomic_u64_get(&progress->bytes_done) / total_bytes);
+	}
+	i32 num_files = SDL_GetAtomicInt(&progress->num_files);
+	return num_files ? (f32) SDL_GetAtomicInt(&progress->num_files_done) / num_files : 1;
+}
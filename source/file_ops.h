@@ -0,0 +1,132 @@
+#ifndef FILE_OPS_H
+#define FILE_OPS_H
+
+#include "xtdlib.h"
+
+#include <SDL3/SDL.h>
+
+#include "job.h"
+
+//=============================================================================
+// FILE OPERATIONS
+//=============================================================================
+
+// Copies, moves and deletes run entirely on the job queue. Starting an
+// operation queues one planning job, which walks the sources, creates target
+// directories and splits the files into batches (one large file, or up to
+// FILE_OPS_BATCH_FILES small ones). At most FILE_OPS_MAX_IN_FLIGHT jobs then
+// pull batches off a shared index, so many small files copy in parallel
+// without flooding the disk queue; the last job to finish removes emptied
+// directories and marks the operation finished.
+//
+// File data never crosses into user space where the OS can avoid it:
+// copy_file_range (which may also reflink) and then sendfile on Linux,
+// CopyFileEx on Windows. Otherwise, or when a file system refuses, it is
+// read and written through an aligned FILE_OPS_BUFFER_BYTES buffer. Transfers
+// go in FILE_OPS_CHUNK_BYTES steps, checking for cancellation in between.
+//
+// Progress is a set of atomic counters the UI reads every frame without
+// locking. A move within one file system is a rename; otherwise it copies and
+// deletes each source only once its copy succeeded. Nothing is overwritten:
+// an existing target fails its item.
+
+#define FILE_OPS_MAX_IN_FLIGHT      8
+#define FILE_OPS_BATCH_FILES        32
+#define FILE_OPS_BATCH_BYTES        (8ull << 20)
+#define FILE_OPS_CHUNK_BYTES        (8ull << 20)
+#define FILE_OPS_BUFFER_BYTES       (1ull << 20)
+#define FILE_OPS_BUFFER_ALIGNMENT   4096
+
+typedef enum FileOperationKind {
+	FILE_OPERATION_COPY,
+	FILE_OPERATION_MOVE,
+	FILE_OPERATION_DELETE
+} FileOperationKind;
+
+typedef enum FileOperationPhase {
+	FILE_OPERATION_PHASE_PLANNING,
+	FILE_OPERATION_PHASE_RUNNING,
+	FILE_OPERATION_PHASE_FINISHING,
+	FILE_OPERATION_PHASE_DONE
+} FileOperationPhase;
+
+// written by workers, read by the UI at any time
+typedef struct FileOperationProgress {
+	SDL_AtomicInt phase;			// FileOperationPhase
+	SDL_AtomicInt num_files;		// final once planning is over
+	SDL_AtomicInt num_files_done;
+	SDL_AtomicInt num_errors;
+	AtomicU64 total_bytes;
+	AtomicU64 bytes_done;
+	AtomicU64 bytes_offloaded;		// copied by the kernel without a user-space buffer
+} FileOperationProgress;
+
+// one source the operation was started with
+typedef struct FileOperationItem {
+	char *source;
+	char *target;			// NULL for deletes
+
+	// written by the planner; read by the UI once the operation is finished
+	bool is_directory;
+	bool created;			// the target exists, possibly incomplete
+	u64 size;
+	i64 modified_time;
+
+	SDL_AtomicInt failed;	// something below this source was not copied, moved or deleted
+} FileOperationItem;
+
+typedef struct FileOperationPlan FileOperationPlan;
+
+typedef struct FileOperation {
+	FileOperationKind kind;
+	FileOperationItem *items;
+	u32 num_items;
+	char *destination;
+
+	FileOperationProgress progress;
+	SDL_AtomicInt cancelled;
+	SDL_AtomicInt finished;
+
+	// the first error, readable once error_ready is set
+	SDL_AtomicInt error_claimed;
+	SDL_AtomicInt error_ready;
+	char error[256];
+
+	u64 start_ns;
+	u64 end_ns;		// valid once finished
+
+	FileOperationPlan *plan;
+	JobQueue *job_queue;
+	char label[128];	// UI thread only
+	struct FileOperation *next;
+} FileOperation;
+
+typedef struct FileOpsEngine {
+	JobQueue *job_queue;
+	FileOperation *operations;	// oldest first
+} FileOpsEngine;
+
+void file_ops_init (FileOpsEngine *engine, JobQueue *job_queue);
+
+// frees every operation; call after the job queue is destroyed
+void file_ops_shutdown (FileOpsEngine *engine);
+
+// queues an operation on copies of the paths. destination is the directory
+// copies and moves go into, and is ignored for deletes
+FileOperation *file_ops_start (FileOpsEngine *engine, FileOperationKind kind,
+	const char **sources, u32 num_sources, const char *destination);
+
+void file_ops_cancel (FileOperation *operation);
+void file_ops_cancel_all (FileOpsEngine *engine);
+
+// unlinks and returns the oldest finished operation, NULL if none has
+// finished. The caller applies it and frees it with file_operation_free
+FileOperation *file_ops_take_finished (FileOpsEngine *engine);
+void file_operation_free (FileOperation *operation);
+
+bool file_ops_is_busy (FileOpsEngine *engine);
+
+// how much of the planned work is done, by bytes where there are any
+f32 file_operation_fraction (FileOperation *operation);
+
+#endif // FILE_OPS_H
@@ -0,0 +1,272 @@
+#include "filetype.h"
+
+#include "bytes.h"
+#include "file_map.h"
+
+struct FileTypeSniff {
+	File *file;		// UI thread only; NULL once cancelled
+	char *path;
+
+	SDL_AtomicInt cancelled;
+	SDL_AtomicInt finished;
+
+	FileTypeId type;	// written by the job before finished is set
+};
+
+#define FILE_TYPE_RECORD(id, name, kind, flags) { name, kind, flags },
+const FileType file_types[NUM_FILE_TYPES] = {
+	FILE_TYPES(FILE_TYPE_RECORD)
+};
+#undef FILE_TYPE_RECORD
+
+//=============================================================================
+// EXTENSION TABLE
+//=============================================================================
+
+// X(type, lowercase bytes...)
+#define FILE_EXTENSIONS(X) \
+	X(PNG, 'p','n','g') X(JPEG, 'j','p','g') X(JPEG, 'j','p','e','g') X(GIF, 'g','i','f') \
+	X(BMP, 'b','m','p') X(WEBP, 'w','e','b','p') X(TIFF, 't','i','f') X(TIFF, 't','i','f','f') \
+	X(SVG, 's','v','g') X(ICO, 'i','c','o') X(TGA, 't','g','a') X(QOI, 'q','o','i') \
+	X(MP3, 'm','p','3') X(WAV, 'w','a','v') X(FLAC, 'f','l','a','c') X(OGG, 'o','g','g') \
+	X(MP4, 'm','p','4') X(MP4, 'm','4','v') X(MATROSKA, 'm','k','v') X(MATROSKA, 'w','e','b','m') \
+	X(AVI, 'a','v','i') X(QUICKTIME, 'm','o','v') \
+	X(ZIP, 'z','i','p') X(ZIP, 'j','a','r') X(GZIP, 'g','z') X(GZIP, 't','g','z') \
+	X(TAR, 't','a','r') X(SEVEN_ZIP, '7','z') X(XZ, 'x','z') X(ZSTD, 'z','s','t') \
+	X(RAR, 'r','a','r') X(BZIP2, 'b','z','2') X(PDF, 'p','d','f') \
+	X(PE, 'e','x','e') X(PE, 'd','l','l') X(ELF, 's','o') X(ELF, 'o') X(WASM, 'w','a','s','m') \
+	X(MACHO, 'd','y','l','i','b') X(FONT, 't','t','f') X(FONT, 'o','t','f') X(FONT, 'w','o','f','f') \
+	X(FONT, 'w','o','f','f','2') X(SQLITE, 'd','b') X(SQLITE, 's','q','l','i','t','e') \
+	X(C, 'c') X(C_HEADER, 'h') X(CPP, 'c','p','p') X(CPP, 'c','c') X(CPP, 'c','x','x') \
+	X(C_HEADER, 'h','p','p') X(C_HEADER, 'h','h') X(PYTHON, 'p','y') X(JAVASCRIPT, 'j','s') \
+	X(JAVASCRIPT, 'm','j','s') X(TYPESCRIPT, 't','s') X(TYPESCRIPT, 't','s','x') X(JAVASCRIPT, 'j','s','x') \
+	X(RUST, 'r','s') X(GO, 'g','o') X(JAVA, 'j','a','v','a') X(CSHARP, 'c','s') \
+	X(SHELL, 's','h') X(SHELL, 'b','a','s','h') X(SHELL, 'z','s','h') X(SCRIPT, 'p','s','1') \
+	X(SCRIPT, 'b','a','t') X(SCRIPT, 'l','u','a') X(SCRIPT, 'r','b') X(SCRIPT, 'p','h','p') \
+	X(SCRIPT, 's','w','i','f','t') X(SCRIPT, 'k','t') X(SCRIPT, 'z','i','g') X(SHADER, 'g','l','s','l') \
+	X(SHADER, 'h','l','s','l') X(SCRIPT, 'c','m','a','k','e') \
+	X(TEXT, 't','x','t') X(LOG, 'l','o','g') X(MARKDOWN, 'm','d') X(MARKDOWN, 'r','s','t') \
+	X(JSON, 'j','s','o','n') X(XML, 'x','m','l') X(HTML, 'h','t','m','l') X(HTML, 'h','t','m') \
+	X(CSS, 'c','s','s') X(YAML, 'y','a','m','l') X(YAML, 'y','m','l') X(TOML, 't','o','m','l') \
+	X(INI, 'i','n','i') X(INI, 'c','f','g') X(CSV, 'c','s','v') X(CSV, 't','s','v')
+
+// MSVC's traditional preprocessor passes __VA_ARGS__ on as a single argument
+// unless it is rescanned
+#define FILE_EXTENSION_EXPAND(x) x
+#define FILE_EXTENSION_ID(...) FILE_EXTENSION_EXPAND(FILE_EXTENSION_ID_(__VA_ARGS__, 0, 0, 0, 0, 0, 0, 0, 0))
+#define FILE_EXTENSION_ID_(a, b, c, d, e, f, g, h, ...) \
+	((u64) (a) | (u64) (b) << 8 | (u64) (c) << 16 | (u64) (d) << 24 | \
+	(u64) (e) << 32 | (u64) (f) << 40 | (u64) (g) << 48 | (u64) (h) << 56)
+
+#define FILE_EXTENSION_SLOT(id) \
+	((u32) (((u64) (id) * FILE_EXTENSION_HASH_MULTIPLIER) >> (64 - FILE_EXTENSION_HASH_BITS)))
+
+typedef struct FileExtension {
+	u64 id;		// 0 marks an empty slot
+	u8 type;
+} FileExtension;
+
+#define FILE_EXTENSION_ENTRY(type, ...) \
+	[FILE_EXTENSION_SLOT(FILE_EXTENSION_ID(__VA_ARGS__))] = { FILE_EXTENSION_ID(__VA_ARGS__), FILE_TYPE_##type },
+static const FileExtension extension_table[1 << FILE_EXTENSION_HASH_BITS] = {
+	FILE_EXTENSIONS(FILE_EXTENSION_ENTRY)
+};
+#undef FILE_EXTENSION_ENTRY
+
+#define FILE_EXTENSION_LIST_ENTRY(type, ...) FILE_EXTENSION_ID(__VA_ARGS__),
+static const u64 extension_ids[] = {
+	FILE_EXTENSIONS(FILE_EXTENSION_LIST_ENTRY)
+};
+#undef FILE_EXTENSION_LIST_ENTRY
+
+// a colliding extension silently overwrites the slot of an earlier one, which
+// then no longer finds itself
+void file_types_init (void) {
+	for (u32 i = 0; i < SDL_arraysize(extension_ids); i++) {
+		u64 id = extension_ids[i];
+		xtd_assert(extension_table[FILE_EXTENSION_SLOT(id)].id == id);
+		xtd_ignore_unused(id);
+	}
+}
+
+u64 file_extension_id (const char *extension) {
+	u64 id = 0;
+	for (u32 i = 0; extension[i]; i++) {
+		if (i == 8) return 0;
+		u8 c = (u8) extension[i];
+		if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+		id |= (u64) c << (i * 8);
+	}
+	return id;
+}
+
+FileTypeId file_type_from_extension (const char *extension) {
+	if (!extension) {
+		return FILE_TYPE_UNKNOWN;
+	}
+	u64 id = file_extension_id(extension);
+	const FileExtension *entry = &extension_table[FILE_EXTENSION_SLOT(id)];
+	return (id != 0 && entry->id == id) ? (FileTypeId) entry->type : FILE_TYPE_UNKNOWN;
+}
+
+void file_type_classify (File *file) {
+	file->type = (u8) file_type_from_extension(file->extension);
+	file->type_source = file->type != FILE_TYPE_UNKNOWN ? FILE_TYPE_SOURCE_EXTENSION : FILE_TYPE_SOURCE_NONE;
+}
+
+//=============================================================================
+// MAGIC NUMBERS
+//=============================================================================
+
+typedef struct FileSignature {
+	u16 offset;
+	u8 length;
+	const char *bytes;
+	FileTypeId type;
+} FileSignature;
+
+// checked in order; the first match wins
+static const FileSignature signatures[] = {
+	{ 0, 8, "\x89PNG\r\n\x1a\n", FILE_TYPE_PNG },
+	{ 0, 3, "\xff\xd8\xff", FILE_TYPE_JPEG },
+	{ 0, 4, "GIF8", FILE_TYPE_GIF },
+	{ 0, 2, "BM", FILE_TYPE_BMP },
+	{ 8, 4, "WEBP", FILE_TYPE_WEBP },
+	{ 8, 4, "WAVE", FILE_TYPE_WAV },
+	{ 8, 4, "AVI ", FILE_TYPE_AVI },
+	{ 0, 4, "II*\0", FILE_TYPE_TIFF },
+	{ 0, 4, "MM\0*", FILE_TYPE_TIFF },
+	{ 0, 4, "qoif", FILE_TYPE_QOI },
+	{ 0, 3, "ID3", FILE_TYPE_MP3 },
+	{ 0, 4, "fLaC", FILE_TYPE_FLAC },
+	{ 0, 4, "OggS", FILE_TYPE_OGG },
+	{ 4, 6, "ftypqt", FILE_TYPE_QUICKTIME },
+	{ 4, 4, "ftyp", FILE_TYPE_MP4 },
+	{ 0, 4, "\x1a\x45\xdf\xa3", FILE_TYPE_MATROSKA },
+	{ 0, 4, "PK\x03\x04", FILE_TYPE_ZIP },
+	{ 0, 4, "PK\x05\x06", FILE_TYPE_ZIP },
+	{ 0, 2, "\x1f\x8b", FILE_TYPE_GZIP },
+	{ 257, 5, "ustar", FILE_TYPE_TAR },
+	{ 0, 6, "7z\xbc\xaf\x27\x1c", FILE_TYPE_SEVEN_ZIP },
+	{ 0, 6, "\xfd" "7zXZ\0", FILE_TYPE_XZ },
+	{ 0, 4, "\x28\xb5\x2f\xfd", FILE_TYPE_ZSTD },
+	{ 0, 4, "Rar!", FILE_TYPE_RAR },
+	{ 0, 3, "BZh", FILE_TYPE_BZIP2 },
+	{ 0, 5, "%PDF-", FILE_TYPE_PDF },
+	{ 0, 4, "\x7f" "ELF", FILE_TYPE_ELF },
+	{ 0, 2, "MZ", FILE_TYPE_PE },
+	{ 0, 4, "\xfe\xed\xfa\xce", FILE_TYPE_MACHO },
+	{ 0, 4, "\xfe\xed\xfa\xcf", FILE_TYPE_MACHO },
+	{ 0, 4, "\xce\xfa\xed\xfe", FILE_TYPE_MACHO },
+	{ 0, 4, "\xcf\xfa\xed\xfe", FILE_TYPE_MACHO },
+	{ 0, 4, "\xca\xfe\xba\xbe", FILE_TYPE_MACHO },
+	{ 0, 4, "\0asm", FILE_TYPE_WASM },
+	{ 0, 4, "wOFF", FILE_TYPE_FONT },
+	{ 0, 4, "wOF2", FILE_TYPE_FONT },
+	{ 0, 4, "OTTO", FILE_TYPE_FONT },
+	{ 0, 5, "\0\x01\0\0\0", FILE_TYPE_FONT },
+	{ 0, 16, "SQLite format 3\0", FILE_TYPE_SQLITE },
+	{ 0, 5, "<?xml", FILE_TYPE_XML },
+	{ 0, 2, "#!", FILE_TYPE_SCRIPT },
+};
+
+FileTypeId file_type_from_magic (const u8 *data, size_t length) {
+	for (u32 i = 0; i < SDL_arraysize(signatures); i++) {
+		const FileSignature *signature = &signatures[i];
+		if ((size_t) signature->offset + signature->length <= length &&
+			SDL_memcmp(data + signature->offset, signature->bytes, signature->length) == 0) {
+			return signature->type;
+		}
+	}
+	// the same test search uses: text never contains NUL
+	return bytes_find(data, length, 0) ? FILE_TYPE_BINARY : FILE_TYPE_TEXT;
+}
+
+//=============================================================================
+// SNIFFING
+//=============================================================================
+
+static void sniff_job (void *data) {
+	FileTypeSniff *sniff = data;
+	sniff->type = FILE_TYPE_UNKNOWN;
+
+	MappedFile file;
+	if (!SDL_GetAtomicInt(&sniff->cancelled) && mapped_file_open(&file, sniff->path)) {
+		u8 buffer[FILE_TYPE_SNIFF_BYTES];
+		u64 length = mapped_file_read(&file, 0, buffer, sizeof(buffer));
+		sniff->type = file_type_from_magic(buffer, (size_t) length);
+		mapped_file_close(&file);
+	}
+	SDL_SetAtomicInt(&sniff->finished, 1);
+}
+
+void file_type_sniffer_init (FileTypeSniffer *sniffer, JobQueue *job_queue) {
+	SDL_memset(sniffer, 0, sizeof(*sniffer));
+	sniffer->job_queue = job_queue;
+}
+
+static void free_sniff (FileTypeSniff *sniff) {
+	SDL_free(sniff->path);
+	SDL_free(sniff);
+}
+
+void file_type_sniffer_shutdown (FileTypeSniffer *sniffer) {
+	for (u32 i = 0; i < FILE_TYPE_MAX_SNIFFS; i++) {
+		if (sniffer->sniffs[i]) free_sniff(sniffer->sniffs[i]);
+	}
+	SDL_memset(sniffer, 0, sizeof(*sniffer));
+}
+
+bool file_type_sniffer_update (FileTypeSniffer *sniffer, ExplorerRow *rows, RowRange visible) {
+	if (!sniffer->job_queue) {
+		return false;
+	}
+
+	bool changed = false;
+	for (u32 i = 0; i < FILE_TYPE_MAX_SNIFFS; i++) {
+		FileTypeSniff *sniff = sniffer->sniffs[i];
+		if (!sniff) continue;
+
+		if (SDL_GetAtomicInt(&sniff->finished)) {
+			if (sniff->file) {
+				sniff->file->type = (u8) sniff->type;
+				sniff->file->type_source = FILE_TYPE_SOURCE_SNIFFED;
+				changed = true;
+			}
+			free_sniff(sniff);
+			sniffer->sniffs[i] = NULL;
+			continue;
+		}
+
+		if (sniff->file && !explorer_rows_contain_file(rows, visible, sniff->file)) {
+			SDL_SetAtomicInt(&sniff->cancelled, 1);
+			sniff->file->type_source = FILE_TYPE_SOURCE_NONE;
+			sniff->file = NULL;
+		}
+	}
+
+	u32 slot = 0;
+	for (u32 i = visible.first; i < visible.end; i++) {
+		File *file = rows[i].file;
+		if (!file || file->type_source != FILE_TYPE_SOURCE_NONE) continue;
+
+		// nothing to read in an empty file
+		if (file->size == 0) {
+			file->type = FILE_TYPE_TEXT;
+			file->type_source = FILE_TYPE_SOURCE_SNIFFED;
+			changed = true;
+			continue;
+		}
+
+		while (slot < FILE_TYPE_MAX_SNIFFS && sniffer->sniffs[slot]) slot++;
+		if (slot == FILE_TYPE_MAX_SNIFFS) break;
+
+		FileTypeSniff *sniff = SDL_calloc(1, sizeof(FileTypeSniff));
+		sniff->file = file;
+		sniff->path = SDL_strdup(file->path);
+		file->type_source = FILE_TYPE_SOURCE_SNIFF_PENDING;
+		sniffer->sniffs[slot] = sniff;
+		job_queue_push(sniffer->job_queue, sniff_job, sniff, JOB_PRIORITY_NORMAL);
+	}
+	return changed;
+}
@@ -0,0 +1,176 @@
+#ifndef FILETYPE_H
+#define FILETYPE_H
+
+#include "xtdlib.h"
+
+#include <SDL3/SDL.h>
+
+#include "job.h"
+#include "scroll.h"
+#include "ui.h"
+
+//=============================================================================
+// FILE TYPES
+//=============================================================================
+
+// Classifies files for icons, previews and binary detection. The type is
+// cached on the File node, so reading it at render time is a field load.
+//
+// Extensions are interned into a u64 id (up to 8 case-folded bytes, packed
+// little-endian) and looked up in a perfect hash table: the slot is
+// (id * FILE_EXTENSION_HASH_MULTIPLIER) >> (64 - FILE_EXTENSION_HASH_BITS),
+// and the table is built with designated initializers, so it is laid out by
+// the compiler. The multiplier was searched offline for the current list;
+// file_types_init asserts that no two extensions share a slot, so adding an
+// extension that collides fails loudly and needs a new multiplier.
+//
+// The scanner classifies by extension as it creates nodes. Files it cannot
+// place (no or unknown extension) are sniffed lazily: when such a file is
+// laid out, a job on the I/O pool reads its first FILE_TYPE_SNIFF_BYTES and
+// matches magic numbers. The UI thread only ever applies results.
+
+#define FILE_EXTENSION_HASH_BITS        9
+#define FILE_EXTENSION_HASH_MULTIPLIER  0x1d61cd509a6b79cdull
+#define FILE_TYPE_SNIFF_BYTES           512
+#define FILE_TYPE_MAX_SNIFFS            32
+
+typedef enum FileKind {
+	FILE_KIND_UNKNOWN,
+	FILE_KIND_TEXT,
+	FILE_KIND_SOURCE,
+	FILE_KIND_IMAGE,
+	FILE_KIND_AUDIO,
+	FILE_KIND_VIDEO,
+	FILE_KIND_ARCHIVE,
+	FILE_KIND_DOCUMENT,
+	FILE_KIND_EXECUTABLE,
+	FILE_KIND_FONT,
+	FILE_KIND_DATABASE,
+	NUM_FILE_KINDS
+} FileKind;
+
+typedef enum FileTypeFlags {
+	FILE_TYPE_FLAG_NONE      = 0,
+	FILE_TYPE_FLAG_BINARY    = 1 << 0,	// not worth searching or previewing as text
+	FILE_TYPE_FLAG_THUMBNAIL = 1 << 1,	// SDL_image can decode it
+} FileTypeFlags;
+
+// X(id, name, kind, flags)
+#define FILE_TYPES(X) \
+	X(UNKNOWN,    "File",               FILE_KIND_UNKNOWN,    FILE_TYPE_FLAG_NONE) \
+	X(TEXT,       "Text",               FILE_KIND_TEXT,       FILE_TYPE_FLAG_NONE) \
+	X(BINARY,     "Binary",             FILE_KIND_UNKNOWN,    FILE_TYPE_FLAG_BINARY) \
+	X(LOG,        "Log",                FILE_KIND_TEXT,       FILE_TYPE_FLAG_NONE) \
+	X(MARKDOWN,   "Markdown",           FILE_KIND_TEXT,       FILE_TYPE_FLAG_NONE) \
+	X(JSON,       "JSON",               FILE_KIND_TEXT,       FILE_TYPE_FLAG_NONE) \
+	X(XML,        "XML",                FILE_KIND_TEXT,       FILE_TYPE_FLAG_NONE) \
+	X(HTML,       "HTML",               FILE_KIND_TEXT,       FILE_TYPE_FLAG_NONE) \
+	X(CSS,        "CSS",                FILE_KIND_TEXT,       FILE_TYPE_FLAG_NONE) \
+	X(YAML,       "YAML",               FILE_KIND_TEXT,       FILE_TYPE_FLAG_NONE) \
+	X(TOML,       "TOML",               FILE_KIND_TEXT,       FILE_TYPE_FLAG_NONE) \
+	X(INI,        "Config",             FILE_KIND_TEXT,       FILE_TYPE_FLAG_NONE) \
+	X(CSV,        "CSV",                FILE_KIND_TEXT,       FILE_TYPE_FLAG_NONE) \
+	X(C,          "C source",           FILE_KIND_SOURCE,     FILE_TYPE_FLAG_NONE) \
+	X(C_HEADER,   "C header",           FILE_KIND_SOURCE,     FILE_TYPE_FLAG_NONE) \
+	X(CPP,        "C++ source",         FILE_KIND_SOURCE,     FILE_TYPE_FLAG_NONE) \
+	X(PYTHON,     "Python",             FILE_KIND_SOURCE,     FILE_TYPE_FLAG_NONE) \
+	X(JAVASCRIPT, "JavaScript",         FILE_KIND_SOURCE,     FILE_TYPE_FLAG_NONE) \
+	X(TYPESCRIPT, "TypeScript",         FILE_KIND_SOURCE,     FILE_TYPE_FLAG_NONE) \
+	X(RUST,       "Rust",               FILE_KIND_SOURCE,     FILE_TYPE_FLAG_NONE) \
+	X(GO,         "Go",                 FILE_KIND_SOURCE,     FILE_TYPE_FLAG_NONE) \
+	X(JAVA,       "Java",               FILE_KIND_SOURCE,     FILE_TYPE_FLAG_NONE) \
+	X(CSHARP,     "C#",                 FILE_KIND_SOURCE,     FILE_TYPE_FLAG_NONE) \
+	X(SHELL,      "Shell script",       FILE_KIND_SOURCE,     FILE_TYPE_FLAG_NONE) \
+	X(SCRIPT,     "Script",             FILE_KIND_SOURCE,     FILE_TYPE_FLAG_NONE) \
+	X(SHADER,     "Shader",             FILE_KIND_SOURCE,     FILE_TYPE_FLAG_NONE) \
+	X(PNG,        "PNG image",          FILE_KIND_IMAGE,      FILE_TYPE_FLAG_BINARY | FILE_TYPE_FLAG_THUMBNAIL) \
+	X(JPEG,       "JPEG image",         FILE_KIND_IMAGE,      FILE_TYPE_FLAG_BINARY | FILE_TYPE_FLAG_THUMBNAIL) \
+	X(GIF,        "GIF image",          FILE_KIND_IMAGE,      FILE_TYPE_FLAG_BINARY | FILE_TYPE_FLAG_THUMBNAIL) \
+	X(BMP,        "Bitmap image",       FILE_KIND_IMAGE,      FILE_TYPE_FLAG_BINARY | FILE_TYPE_FLAG_THUMBNAIL) \
+	X(WEBP,       "WebP image",         FILE_KIND_IMAGE,      FILE_TYPE_FLAG_BINARY | FILE_TYPE_FLAG_THUMBNAIL) \
+	X(TIFF,       "TIFF image",         FILE_KIND_IMAGE,      FILE_TYPE_FLAG_BINARY | FILE_TYPE_FLAG_THUMBNAIL) \
+	X(TGA,        "TGA image",          FILE_KIND_IMAGE,      FILE_TYPE_FLAG_BINARY | FILE_TYPE_FLAG_THUMBNAIL) \
+	X(QOI,        "QOI image",          FILE_KIND_IMAGE,      FILE_TYPE_FLAG_BINARY | FILE_TYPE_FLAG_THUMBNAIL) \
+	X(ICO,        "Icon",               FILE_KIND_IMAGE,      FILE_TYPE_FLAG_BINARY | FILE_TYPE_FLAG_THUMBNAIL) \
+	X(SVG,        "SVG image",          FILE_KIND_IMAGE,      FILE_TYPE_FLAG_THUMBNAIL) \
+	X(MP3,        "MP3 audio",          FILE_KIND_AUDIO,      FILE_TYPE_FLAG_BINARY) \
+	X(WAV,        "WAV audio",          FILE_KIND_AUDIO,      FILE_TYPE_FLAG_BINARY) \
+	X(FLAC,       "FLAC audio",         FILE_KIND_AUDIO,      FILE_TYPE_FLAG_BINARY) \
+	X(OGG,        "Ogg media",          FILE_KIND_AUDIO,      FILE_TYPE_FLAG_BINARY) \
+	X(MP4,        "MP4 video",          FILE_KIND_VIDEO,      FILE_TYPE_FLAG_BINARY) \
+	X(MATROSKA,   "Matroska video",     FILE_KIND_VIDEO,      FILE_TYPE_FLAG_BINARY) \
+	X(AVI,        "AVI video",          FILE_KIND_VIDEO,      FILE_TYPE_FLAG_BINARY) \
+	X(QUICKTIME,  "QuickTime video",    FILE_KIND_VIDEO,      FILE_TYPE_FLAG_BINARY) \
+	X(ZIP,        "ZIP archive",        FILE_KIND_ARCHIVE,    FILE_TYPE_FLAG_BINARY) \
+	X(GZIP,       "Gzip archive",       FILE_KIND_ARCHIVE,    FILE_TYPE_FLAG_BINARY) \
+	X(TAR,        "Tar archive",        FILE_KIND_ARCHIVE,    FILE_TYPE_FLAG_BINARY) \
+	X(SEVEN_ZIP,  "7-Zip archive",      FILE_KIND_ARCHIVE,    FILE_TYPE_FLAG_BINARY) \
+	X(XZ,         "XZ archive",         FILE_KIND_ARCHIVE,    FILE_TYPE_FLAG_BINARY) \
+	X(ZSTD,       "Zstandard archive",  FILE_KIND_ARCHIVE,    FILE_TYPE_FLAG_BINARY) \
+	X(RAR,        "RAR archive",        FILE_KIND_ARCHIVE,    FILE_TYPE_FLAG_BINARY) \
+	X(BZIP2,      "Bzip2 archive",      FILE_KIND_ARCHIVE,    FILE_TYPE_FLAG_BINARY) \
+	X(PDF,        "PDF document",       FILE_KIND_DOCUMENT,   FILE_TYPE_FLAG_BINARY) \
+	X(ELF,        "ELF binary",         FILE_KIND_EXECUTABLE, FILE_TYPE_FLAG_BINARY) \
+	X(PE,         "Windows binary",     FILE_KIND_EXECUTABLE, FILE_TYPE_FLAG_BINARY) \
+	X(MACHO,      "Mach-O binary",      FILE_KIND_EXECUTABLE, FILE_TYPE_FLAG_BINARY) \
+	X(WASM,       "WebAssembly",        FILE_KIND_EXECUTABLE, FILE_TYPE_FLAG_BINARY) \
+	X(FONT,       "Font",               FILE_KIND_FONT,       FILE_TYPE_FLAG_BINARY) \
+	X(SQLITE,     "SQLite database",    FILE_KIND_DATABASE,   FILE_TYPE_FLAG_BINARY)
+
+#define FILE_TYPE_ENUM(id, name, kind, flags) FILE_TYPE_##id,
+typedef enum FileTypeId {
+	FILE_TYPES(FILE_TYPE_ENUM)
+	NUM_FILE_TYPES
+} FileTypeId;
+#undef FILE_TYPE_ENUM
+
+typedef struct FileType {
+	const char *name;
+	FileKind kind;
+	u32 flags;
+} FileType;
+
+// how File::type was decided
+typedef enum FileTypeSource {
+	FILE_TYPE_SOURCE_NONE,		// not classified yet
+	FILE_TYPE_SOURCE_EXTENSION,
+	FILE_TYPE_SOURCE_SNIFF_PENDING,
+	FILE_TYPE_SOURCE_SNIFFED,
+} FileTypeSource;
+
+typedef struct FileTypeSniff FileTypeSniff;
+
+typedef struct FileTypeSniffer {
+	JobQueue *job_queue;
+	FileTypeSniff *sniffs[FILE_TYPE_MAX_SNIFFS];
+} FileTypeSniffer;
+
+extern const FileType file_types[NUM_FILE_TYPES];
+
+// checks the extension table is collision-free; call once at startup
+void file_types_init (void);
+
+u64 file_extension_id (const char *extension);
+
+// classifies by extension only; FILE_TYPE_UNKNOWN when it is missing or unknown
+FileTypeId file_type_from_extension (const char *extension);
+
+// classifies the first bytes of a file by magic number, falling back to text/binary
+FileTypeId file_type_from_magic (const u8 *data, size_t length);
+
+// sets File::type from the extension; safe to call on a worker for a node it owns
+void file_type_classify (File *file);
+
+static inline const FileType *file_type_of (const File *file) {
+	return &file_types[file->type];
+}
+
+void file_type_sniffer_init (FileTypeSniffer *sniffer, JobQueue *job_queue);
+
+// frees pending sniffs; call after the job queue is destroyed
+void file_type_sniffer_shutdown (FileTypeSniffer *sniffer);
+
+// applies finished sniffs and queues new ones for unclassified files in the given rows
+bool file_type_sniffer_update (FileTypeSniffer *sniffer, ExplorerRow *rows, RowRange visible);
+
+#endif // FILETYPE_H
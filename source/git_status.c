@@ -0,0 +1,1055 @@
+#include "git_status.h"
+
+#include "aggregate.h"
+#include "file_map.h"
+#include "scan.h"
+
+#define GIT_INDEX_HEADER_SIZE   12
+#define GIT_ENTRY_FIXED_SIZE    62		// stat data, a SHA-1 object id and the flags
+
+typedef enum GitEntryFlags {
+	GIT_ENTRY_CONFLICT      = 1 << 0,	// a merge stage other than 0
+	GIT_ENTRY_SKIP_WORKTREE = 1 << 1,	// sparse checkout: not expected on disk
+	GIT_ENTRY_INTENT_TO_ADD = 1 << 2,
+	GIT_ENTRY_GITLINK       = 1 << 3,	// a submodule, which is a directory
+	GIT_ENTRY_SYMLINK       = 1 << 4
+} GitEntryFlags;
+
+typedef struct GitIndexEntry {
+	u32 path;				// offset into GitIndex::paths
+	u32 path_length;
+	u32 modified_seconds;
+	u32 size;				// the low 32 bits, as git stores it
+	u32 flags;				// GitEntryFlags
+} GitIndexEntry;
+
+struct GitIndex {
+	SDL_AtomicInt refs;
+	GitIndexEntry *entries;	// in git's order: by path bytes, then by stage
+	u32 num_entries;
+	char *paths;			// every path NUL terminated
+
+	// of the index file, to notice git rewriting it
+	i64 file_modified_time;
+	u64 file_size;
+};
+
+typedef enum GitPatternFlags {
+	GIT_PATTERN_NEGATED   = 1 << 0,
+	GIT_PATTERN_DIRECTORY = 1 << 1,	// had a trailing slash
+	GIT_PATTERN_ANCHORED  = 1 << 2,	// has a slash, so it matches the path below the base rather than the name
+} GitPatternFlags;
+
+typedef struct GitPattern {
+	const char *glob;		// into GitIgnore::text
+	u32 length;
+	u32 flags;				// GitPatternFlags
+} GitPattern;
+
+// the patterns of one ignore file, chained to those of the directories above
+struct GitIgnore {
+	GitIgnore *parent;
+	char *base;				// the file's directory relative to the work tree, "" at the top
+	u32 base_length;
+	char *text;
+	GitPattern *patterns;
+	u32 num_patterns;
+	GitIgnore *next;		// in GitStatus::ignores
+};
+
+// counts for one directory's direct children
+typedef struct GitCounts {
+	u32 num_modified;
+	u32 num_untracked;
+	u32 num_deleted;
+} GitCounts;
+
+static bool is_separator (char c) {
+	return c == '/' || c == '\\';
+}
+
+static u32 read_u32_be (const u8 *data) {
+	return ((u32) data[0] << 24) | ((u32) data[1] << 16) | ((u32) data[2] << 8) | (u32) data[3];
+}
+
+static u16 read_u16_be (const u8 *data) {
+	return (u16) ((data[0] << 8) | data[1]);
+}
+
+//=============================================================================
+// INDEX
+//=============================================================================
+
+static void free_index (GitIndex *index) {
+	if (index) {
+		SDL_free(index->entries);
+		SDL_free(index->paths);
+		SDL_free(index);
+	}
+}
+
+static void release_index (GitIndex *index) {
+	if (index && SDL_AddAtomicInt(&index->refs, -1) == 1) {
+		free_index(index);
+	}
+}
+
+// git's offset varint: every continuation adds one before shifting, so no
+// value has two encodings. Returns NULL on a truncated or oversized number
+static const u8 *read_varint (const u8 *data, const u8 *end, u64 *value) {
+	if (data == end) return NULL;
+	u8 c = *data++;
+	u64 result = c & 127;
+	while (c & 128) {
+		if (data == end || result >= (1ull << 56)) return NULL;
+		c = *data++;
+		result = ((result + 1) << 7) | (c & 127);
+	}
+	*value = result;
+	return data;
+}
+
+static bool parse_entries (GitIndex *index, const u8 *data, const u8 *end, u32 version, u32 capacity) {
+	const u8 *at = data + GIT_INDEX_HEADER_SIZE;
+	u32 paths_length = 0;
+	u32 previous_path = 0;
+	u32 previous_length = 0;
+
+	for (u32 i = 0; i < index->num_entries; i++) {
+		if ((size_t) (end - at) < GIT_ENTRY_FIXED_SIZE) return false;
+		GitIndexEntry *entry = &index->entries[i];
+		entry->modified_seconds = read_u32_be(at + 8);
+		entry->size = read_u32_be(at + 36);
+
+		u32 mode = read_u32_be(at + 24);
+		u16 flags = read_u16_be(at + 60);
+		entry->flags = 0;
+		if ((mode >> 12) == 0xE) entry->flags |= GIT_ENTRY_GITLINK;
+		if ((mode >> 12) == 0xA) entry->flags |= GIT_ENTRY_SYMLINK;
+		if (flags & 0x3000) entry->flags |= GIT_ENTRY_CONFLICT;
+
+		const u8 *name = at + GIT_ENTRY_FIXED_SIZE;
+		if (version >= 3 && (flags & 0x4000)) {
+			if (end - name < 2) return false;
+			u16 extended = read_u16_be(name);
+			if (extended & 0x4000) entry->flags |= GIT_ENTRY_SKIP_WORKTREE;
+			if (extended & 0x2000) entry->flags |= GIT_ENTRY_INTENT_TO_ADD;
+			name += 2;
+		}
+
+		// version 4 strips the end of the previous path and appends what follows
+		u64 strip = 0;
+		if (version == 4 && !(name = read_varint(name, end, &strip))) return false;
+		if (strip > previous_length) return false;
+		const u8 *terminator = SDL_memchr(name, '\0', (size_t) (end - name));
+		if (!terminator) return false;
+		u32 suffix_length = (u32) (terminator - name);
+		u32 kept = previous_length - (u32) strip;
+		u32 path_length = kept + suffix_length;
+
+		if ((u64) paths_length + path_length + 1 > capacity) {
+			capacity = xtd_max(capacity * 2, paths_length + path_length + 1);
+			index->paths = SDL_realloc(index->paths, capacity);
+		}
+		char *path = index->paths + paths_length;
+		SDL_memmove(path, index->paths + previous_path, kept);
+		SDL_memcpy(path + kept, name, suffix_length);
+		path[path_length] = '\0';
+
+		entry->path = paths_length;
+		entry->path_length = path_length;
+		previous_path = paths_length;
+		previous_length = version == 4 ? path_length : 0;
+		paths_length += path_length + 1;
+
+		// earlier versions pad every entry with NULs to a multiple of 8 bytes
+		if (version == 4) {
+			at = terminator + 1;
+		} else {
+			size_t entry_size = ((size_t) (name - at) + suffix_length + 8) & ~(size_t) 7;
+			if ((size_t) (end - at) < entry_size) return false;
+			at += entry_size;
+		}
+	}
+	return true;
+}
+
+static GitIndex *load_index (GitStatus *status, const char *path) {
+	SDL_PathInfo info;
+	if (!SDL_GetPathInfo(path, &info)) {
+		return NULL;
+	}
+	MappedFile file;
+	if (!mapped_file_open(&file, path)) {
+		return NULL;
+	}
+	u64 start = SDL_GetTicksNS();
+	MappedView view = {0};
+	GitIndex *index = NULL;
+
+	if (file.size >= GIT_INDEX_HEADER_SIZE && mapped_view_map(&file, &view, 0, file.size, MAPPED_ACCESS_SEQUENTIAL)) {
+		const u8 *data = view.data;
+		u32 version = read_u32_be(data + 4);
+		u32 num_entries = read_u32_be(data + 8);
+
+		if (SDL_memcmp(data, "DIRC", 4) != 0 || version < 2 || version > 4 || num_entries > view.length / 8) {
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "%s is not a git index this build can read", path);
+		} else {
+			index = SDL_calloc(1, sizeof(GitIndex));
+			index->num_entries = num_entries;
+			index->entries = SDL_malloc(xtd_max(num_entries, 1u) * sizeof(GitIndexEntry));
+			// paths take less room than the entries holding them, except compressed ones
+			u32 capacity = (u32) xtd_min(view.length, (u64) UINT32_MAX / 2) + 1;
+			index->paths = SDL_malloc(capacity);
+			index->file_modified_time = info.modify_time;
+			index->file_size = info.size;
+			SDL_SetAtomicInt(&index->refs, 1);
+
+			if (!parse_entries(index, data, data + view.length, version, capacity)) {
+				SDL_LogError(SDL_LOG_CATEGORY_ERROR, "The git index %s is damaged", path);
+				free_index(index);
+				index = NULL;
+			}
+		}
+		mapped_view_unmap(&view);
+	}
+	mapped_file_close(&file);
+
+	if (index) {
+		SDL_LockMutex(status->mutex);
+		status->stats.num_indexes_parsed++;
+		status->stats.num_entries_parsed += index->num_entries;
+		status->stats.parse_ns += SDL_GetTicksNS() - start;
+		SDL_UnlockMutex(status->mutex);
+	}
+	return index;
+}
+
+// -- Lookup ------------------------------------------------------------------
+
+static i32 compare_path (GitIndex *index, u32 i, const char *key, u32 key_length) {
+	GitIndexEntry *entry = &index->entries[i];
+	i32 order = SDL_memcmp(index->paths + entry->path, key, xtd_min(entry->path_length, key_length));
+	if (order != 0) return order;
+	return (entry->path_length > key_length) - (entry->path_length < key_length);
+}
+
+// like compare_path, but every path starting with key compares equal
+static i32 compare_prefix (GitIndex *index, u32 i, const char *key, u32 key_length) {
+	GitIndexEntry *entry = &index->entries[i];
+	i32 order = SDL_memcmp(index->paths + entry->path, key, xtd_min(entry->path_length, key_length));
+	if (order != 0) return order;
+	return entry->path_length < key_length ? -1 : 0;
+}
+
+// the first entry in [first, end) not ordered before key
+static u32 lower_bound (GitIndex *index, u32 first, u32 end, const char *key, u32 key_length) {
+	while (first < end) {
+		u32 middle = first + (end - first) / 2;
+		if (compare_path(index, middle, key, key_length) < 0) {
+			first = middle + 1;
+		} else {
+			end = middle;
+		}
+	}
+	return first;
+}
+
+// the first entry in [first, end) ordered after every path starting with key
+static u32 prefix_end (GitIndex *index, u32 first, u32 end, const char *key, u32 key_length) {
+	while (first < end) {
+		u32 middle = first + (end - first) / 2;
+		if (compare_prefix(index, middle, key, key_length) <= 0) {
+			first = middle + 1;
+		} else {
+			end = middle;
+		}
+	}
+	return first;
+}
+
+static bool same_path (GitIndex *index, u32 a, u32 b) {
+	GitIndexEntry *left = &index->entries[a];
+	GitIndexEntry *right = &index->entries[b];
+	return left->path_length == right->path_length &&
+		SDL_memcmp(index->paths + left->path, index->paths + right->path, left->path_length) == 0;
+}
+
+// entries a deleted file would leave behind; sparse and submodule entries have no file
+static bool expects_file (GitIndexEntry *entry) {
+	return !(entry->flags & (GIT_ENTRY_SKIP_WORKTREE | GIT_ENTRY_GITLINK));
+}
+
+// distinct paths in [first, end) expected on disk; conflicts have an entry per stage
+static u32 count_expected (GitIndex *index, u32 first, u32 end) {
+	u32 count = 0;
+	for (u32 i = first; i < end; i++) {
+		if (i > first && same_path(index, i, i - 1)) continue;
+		count += expects_file(&index->entries[i]);
+	}
+	return count;
+}
+
+// git's stat check, minus the inode, owner and change time the scanner
+// does not record. Only whole seconds count, as git compares them unless
+// built with USE_NSEC
+static VcsStatus entry_status (GitIndexEntry *entry, File *file) {
+	if (entry->flags & (GIT_ENTRY_CONFLICT | GIT_ENTRY_INTENT_TO_ADD)) {
+		return VCS_STATUS_MODIFIED;
+	}
+	if (entry->flags & GIT_ENTRY_SKIP_WORKTREE) {
+		return VCS_STATUS_CLEAN;
+	}
+	// links are looked up without being followed, as git does, so their size
+	// and time compare like a file's; one that became a file or the other way
+	// round changed type
+	if (((entry->flags & GIT_ENTRY_SYMLINK) != 0) != file->is_link) {
+		return VCS_STATUS_MODIFIED;
+	}
+	if (entry->size != (u32) file->size || entry->modified_seconds != (u32) (file->modified_time / (i64) SDL_NS_PER_SECOND)) {
+		return VCS_STATUS_MODIFIED;
+	}
+	return VCS_STATUS_CLEAN;
+}
+
+//=============================================================================
+// IGNORE PATTERNS
+//=============================================================================
+
+// a wildmatch subset: * and ? stop at slashes, ** crosses them and "**/"
+// also matches no directory at all
+static bool glob_match (const char *glob, const char *glob_end, const char *text, const char *text_end) {
+	while (glob < glob_end) {
+		char c = *glob;
+		if (c == '*') {
+			if (glob + 1 < glob_end && glob[1] == '*') {
+				glob += 2;
+				if (glob < glob_end && *glob == '/' && glob_match(glob + 1, glob_end, text, text_end)) {
+					return true;
+				}
+				for (const char *rest = text; rest <= text_end; rest++) {
+					if (glob_match(glob, glob_end, rest, text_end)) return true;
+				}
+				return false;
+			}
+			glob++;
+			for (const char *rest = text; ; rest++) {
+				if (glob_match(glob, glob_end, rest, text_end)) return true;
+				if (rest == text_end || *rest == '/') return false;
+			}
+		}
+		if (text == text_end) {
+			return false;
+		}
+		if (c == '?') {
+			if (*text == '/') return false;
+		}
+		else if (c == '[') {
+			const char *at = glob + 1;
+			bool negated = at < glob_end && (*at == '!' || *at == '^');
+			at += negated;
+			bool matched = false;
+			for (bool first = true; at < glob_end && (*at != ']' || first); at++, first = false) {
+				u8 low = (u8) *at;
+				if (low == '\\' && at + 1 < glob_end) low = (u8) *++at;
+				u8 high = low;
+				if (at + 2 < glob_end && at[1] == '-' && at[2] != ']') {
+					high = (u8) at[2];
+					at += 2;
+				}
+				matched |= (u8) *text >= low && (u8) *text <= high;
+			}
+			if (at == glob_end || matched == negated || *text == '/') return false;
+			glob = at;
+		}
+		else {
+			if (c == '\\' && glob + 1 < glob_end) c = *++glob;
+			if (c != *text) return false;
+		}
+		glob++;
+		text++;
+	}
+	return text == text_end;
+}
+
+// path is relative to the work tree and ends in name. The deepest file
+// decides, and within one file the last matching pattern
+static bool is_ignored (GitIgnore *ignore, const char *path, u32 path_length, const char *name, u32 name_length, bool is_directory) {
+	for (GitIgnore *level = ignore; level; level = level->parent) {
+		const char *below = path;
+		if (level->base_length) {
+			if (path_length <= level->base_length || path[level->base_length] != '/' ||
+				SDL_memcmp(path, level->base, level->base_length) != 0) {
+				continue;
+			}
+			below = path + level->base_length + 1;
+		}
+		for (u32 i = level->num_patterns; i-- > 0;) {
+			GitPattern *pattern = &level->patterns[i];
+			if ((pattern->flags & GIT_PATTERN_DIRECTORY) && !is_directory) continue;
+
+			bool matched = (pattern->flags & GIT_PATTERN_ANCHORED) ?
+				glob_match(pattern->glob, pattern->glob + pattern->length, below, path + path_length) :
+				glob_match(pattern->glob, pattern->glob + pattern->length, name, name + name_length);
+			if (matched) {
+				return !(pattern->flags & GIT_PATTERN_NEGATED);
+			}
+		}
+	}
+	return false;
+}
+
+static void free_ignore (GitIgnore *ignore) {
+	SDL_free(ignore->patterns);
+	SDL_free(ignore->text);
+	SDL_free(ignore->base);
+	SDL_free(ignore);
+}
+
+// reads one ignore file into a level above parent; returns parent if there is none
+static GitIgnore *load_ignore (GitStatus *status, GitIgnore *parent, const char *path, const char *base, u32 base_length) {
+	size_t size;
+	char *text = SDL_LoadFile(path, &size);
+	if (!text) {
+		return parent;
+	}
+
+	GitIgnore *ignore = SDL_calloc(1, sizeof(GitIgnore));
+	ignore->parent = parent;
+	ignore->base = SDL_malloc(base_length + 1);
+	SDL_memcpy(ignore->base, base, base_length);
+	ignore->base[base_length] = '\0';
+	ignore->base_length = base_length;
+	ignore->text = text;
+
+	u32 capacity = 0;
+	for (char *line = text; line < text + size;) {
+		char *line_end = SDL_memchr(line, '\n', (size_t) (text + size - line));
+		char *next = line_end ? line_end + 1 : text + size;
+		if (!line_end) line_end = text + size;
+
+		// trailing spaces go unless escaped; a leading # is a comment
+		while (line_end > line && (line_end[-1] == '\r' || (line_end[-1] == ' ' && !(line_end - 1 > line && line_end[-2] == '\\')))) {
+			line_end--;
+		}
+		u32 flags = 0;
+		if (line < line_end && *line == '!') {
+			flags |= GIT_PATTERN_NEGATED;
+			line++;
+		}
+		else if (line + 1 < line_end && *line == '\\' && (line[1] == '!' || line[1] == '#')) {
+			line++;
+		}
+		else if (line < line_end && *line == '#') {
+			line = line_end;
+		}
+		if (line_end > line && line_end[-1] == '/') {
+			flags |= GIT_PATTERN_DIRECTORY;
+			line_end--;
+		}
+		if (SDL_memchr(line, '/', (size_t) (line_end - line))) {
+			flags |= GIT_PATTERN_ANCHORED;
+			if (*line == '/') line++;
+		}
+
+		if (line < line_end) {
+			if (ignore->num_patterns == capacity) {
+				capacity = xtd_max(capacity * 2, 16u);
+				ignore->patterns = SDL_realloc(ignore->patterns, capacity * sizeof(GitPattern));
+			}
+			ignore->patterns[ignore->num_patterns++] = (GitPattern) { line, (u32) (line_end - line), flags };
+		}
+		line = next;
+	}
+
+	SDL_LockMutex(status->mutex);
+	ignore->next = status->ignores;
+	status->ignores = ignore;
+	SDL_UnlockMutex(status->mutex);
+	return ignore;
+}
+
+//=============================================================================
+// REPOSITORIES
+//=============================================================================
+
+// a .git file names the real git directory, as in submodules and worktrees
+static char *read_git_file (const char *work_tree, const char *path) {
+	size_t size;
+	char *text = SDL_LoadFile(path, &size);
+	if (!text || SDL_strncmp(text, "gitdir: ", 8) != 0) {
+		SDL_free(text);
+		return NULL;
+	}
+	char *target = text + 8;
+	char *line_end = SDL_strpbrk(target, "\r\n");
+	if (line_end) {
+		*line_end = '\0';
+	}
+
+	bool absolute = is_separator(target[0]) || (target[0] && target[1] == ':');
+	char *git_dir = absolute ? SDL_strdup(target) : join_path(work_tree, target);
+	SDL_free(text);
+	return git_dir;
+}
+
+// the repository whose work tree is work_tree, opened on first use. dot_git
+// is the .git entry found there
+static GitRepo *open_repo (GitStatus *status, const char *work_tree, u32 work_tree_length, const char *dot_git, bool is_file) {
+	SDL_LockMutex(status->mutex);
+	for (GitRepo *repo = status->repos; repo; repo = repo->next) {
+		if (repo->work_tree_length == work_tree_length && SDL_strncmp(repo->work_tree, work_tree, work_tree_length) == 0) {
+			SDL_UnlockMutex(status->mutex);
+			return repo;
+		}
+	}
+	SDL_UnlockMutex(status->mutex);
+
+	GitRepo *repo = SDL_calloc(1, sizeof(GitRepo));
+	repo->work_tree = SDL_malloc(work_tree_length + 1);
+	SDL_memcpy(repo->work_tree, work_tree, work_tree_length);
+	repo->work_tree[work_tree_length] = '\0';
+	repo->work_tree_length = work_tree_length;
+	repo->git_dir = is_file ? read_git_file(repo->work_tree, dot_git) : SDL_strdup(dot_git);
+	if (!repo->git_dir) {
+		SDL_free(repo->work_tree);
+		SDL_free(repo);
+		return NULL;
+	}
+	repo->index_path = join_path(repo->git_dir, "index");
+	repo->index = load_index(status, repo->index_path);
+	repo->generation = 1;
+
+	char *exclude_path = join_path(repo->git_dir, "info/exclude");
+	repo->exclude = load_ignore(status, NULL, exclude_path, "", 0);
+	SDL_free(exclude_path);
+
+	// another listing may have opened it meanwhile; the first one wins
+	SDL_LockMutex(status->mutex);
+	for (GitRepo *existing = status->repos; existing; existing = existing->next) {
+		if (existing->work_tree_length == work_tree_length && SDL_strcmp(existing->work_tree, repo->work_tree) == 0) {
+			SDL_UnlockMutex(status->mutex);
+			free_index(repo->index);
+			SDL_free(repo->index_path);
+			SDL_free(repo->git_dir);
+			SDL_free(repo->work_tree);
+			SDL_free(repo);
+			return existing;
+		}
+	}
+	repo->next = status->repos;
+	status->repos = repo;
+	status->stats.num_repos++;
+	SDL_UnlockMutex(status->mutex);
+	return repo;
+}
+
+static GitIndex *acquire_index (GitStatus *status, GitRepo *repo, u32 *generation) {
+	SDL_LockMutex(status->mutex);
+	GitIndex *index = repo->index;
+	if (index) {
+		SDL_AddAtomicInt(&index->refs, 1);
+	}
+	*generation = repo->generation;
+	SDL_UnlockMutex(status->mutex);
+	return index;
+}
+
+static u32 trimmed_length (const char *path) {
+	u32 length = (u32) SDL_strlen(path);
+	while (length > 1 && is_separator(path[length - 1])) length--;
+	return length;
+}
+
+// writes path relative to the repository's work tree into key with '/'
+// separators and returns its length, or -1 if it is outside or too long
+static i32 relative_path (GitRepo *repo, const char *path, char *key) {
+	u32 length = trimmed_length(path);
+	if (length < repo->work_tree_length || SDL_strncmp(path, repo->work_tree, repo->work_tree_length) != 0) {
+		return -1;
+	}
+	const char *rest = path + repo->work_tree_length;
+	const char *end = path + length;
+	while (rest < end && is_separator(*rest)) rest++;
+	if (end - rest >= GIT_PATH_MAX - 1) {
+		return -1;
+	}
+	for (i32 i = 0; rest + i < end; i++) {
+		key[i] = is_separator(rest[i]) ? '/' : rest[i];
+	}
+	return (i32) (end - rest);
+}
+
+static bool is_git_dir_name (const char *name, u32 length) {
+	return length == 4 && SDL_memcmp(name, ".git", 4) == 0;
+}
+
+// Roots opened inside a work tree find it by walking up. The ignore files of
+// the directories between the work tree and the root are loaded on the way,
+// and the root is ignored if any of them is
+static GitRepo *find_repo_above (GitStatus *status, const char *path, GitIgnore **ignore, bool *ignored) {
+	char *ancestor = SDL_strdup(path);
+	u32 length = trimmed_length(ancestor);
+	GitRepo *repo = NULL;
+
+	while (!repo) {
+		while (length > 0 && !is_separator(ancestor[length - 1])) length--;
+		if (length == 0) break;
+		// keep the separator of a filesystem root, drop any other
+		u32 parent_length = length > 1 ? length - 1 : length;
+		ancestor[parent_length] = '\0';
+
+		char *dot_git = join_path(ancestor, ".git");
+		SDL_PathInfo info;
+		if (SDL_GetPathInfo(dot_git, &info) && (info.type == SDL_PATHTYPE_DIRECTORY || info.type == SDL_PATHTYPE_FILE)) {
+			repo = open_repo(status, ancestor, parent_length, dot_git, info.type == SDL_PATHTYPE_FILE);
+		}
+		SDL_free(dot_git);
+		if (parent_length == length) break;
+		length = parent_length;
+	}
+	SDL_free(ancestor);
+	if (!repo) {
+		return NULL;
+	}
+
+	char key[GIT_PATH_MAX];
+	i32 key_length = relative_path(repo, path, key);
+	if (key_length < 0) {
+		return NULL;
+	}
+	*ignore = repo->exclude;
+	*ignored = false;
+	for (i32 start = 0; start < key_length;) {
+		i32 end = start;
+		while (end < key_length && key[end] != '/') end++;
+		if (is_git_dir_name(key + start, (u32) (end - start))) {
+			return NULL;
+		}
+
+		// the patterns of the directory holding this component, then the component
+		char *directory = SDL_malloc(repo->work_tree_length + (u32) start + 2);
+		SDL_memcpy(directory, repo->work_tree, repo->work_tree_length);
+		directory[repo->work_tree_length] = PATH_SEPARATOR;
+		SDL_memcpy(directory + repo->work_tree_length + 1, key, (size_t) start);
+		directory[repo->work_tree_length + 1 + start] = '\0';
+		char *ignore_path = join_path(directory, ".gitignore");
+		*ignore = load_ignore(status, *ignore, ignore_path, key, start ? (u32) start - 1 : 0);
+		SDL_free(ignore_path);
+		SDL_free(directory);
+
+		*ignored = *ignored || is_ignored(*ignore, key, (u32) end, key + start, (u32) (end - start), true);
+		start = end + 1;
+	}
+	return repo;
+}
+
+//=============================================================================
+// CLASSIFICATION
+//=============================================================================
+
+static int compare_names (const void *a, const void *b) {
+	return SDL_strcmp(*(const char **) a, *(const char **) b);
+}
+
+// whether the sorted names hold the first length bytes of name
+static bool has_name (const char **names, u32 count, const char *name, u32 length) {
+	u32 first = 0;
+	while (first < count) {
+		u32 middle = first + (count - first) / 2;
+		i32 order = SDL_strncmp(names[middle], name, length);
+		if (order == 0) {
+			if (names[middle][length] == '\0') return true;
+			order = 1;
+		}
+		if (order < 0) {
+			first = middle + 1;
+		} else {
+			count = middle;
+		}
+	}
+	return false;
+}
+
+// Compares a directory's children with the index. key holds the
+// directory's path below the work tree followed by '/', or nothing at the
+// top, in its first prefix_length bytes. Tracked paths directly below it
+// without a file, and whole tracked subtrees without a directory, count as
+// deleted. Removed nodes are skipped, so whatever they were tracked as
+// counts as deleted too
+static void compare_children (GitIndex *index, GitIgnore *ignore, bool ignored, char *key, u32 prefix_length,
+	Directory **child_directories, u32 num_child_directories, File **child_files, u32 num_child_files, GitCounts *counts)
+{
+	SDL_zerop(counts);
+	u32 first = 0;
+	u32 end = 0;
+	if (index) {
+		first = lower_bound(index, 0, index->num_entries, key, prefix_length);
+		end = prefix_length ? prefix_end(index, first, index->num_entries, key, prefix_length) : index->num_entries;
+	}
+
+	u32 num_matched = 0;
+	for (u32 i = 0; i < num_child_files; i++) {
+		File *file = child_files[i];
+		u32 name_length = (u32) SDL_strlen(file->name);
+		if (file->removed || prefix_length + name_length >= GIT_PATH_MAX || is_git_dir_name(file->name, name_length)) {
+			continue;
+		}
+		SDL_memcpy(key + prefix_length, file->name, name_length);
+		u32 path_length = prefix_length + name_length;
+
+		u32 at = lower_bound(index, first, end, key, path_length);
+		if (at < end && compare_path(index, at, key, path_length) == 0 && !(index->entries[at].flags & GIT_ENTRY_GITLINK)) {
+			file->vcs_status = (u8) entry_status(&index->entries[at], file);
+			num_matched += expects_file(&index->entries[at]);
+		}
+		else if (ignored || is_ignored(ignore, key, path_length, file->name, name_length, false)) {
+			file->vcs_status = VCS_STATUS_IGNORED;
+		}
+		else {
+			file->vcs_status = VCS_STATUS_UNTRACKED;
+		}
+		counts->num_modified += file->vcs_status == VCS_STATUS_MODIFIED;
+		counts->num_untracked += file->vcs_status == VCS_STATUS_UNTRACKED;
+	}
+	if (first == end) {
+		return;
+	}
+
+	const char **names = num_child_directories ? SDL_malloc(num_child_directories * sizeof(char *)) : NULL;
+	u32 num_names = 0;
+	for (u32 i = 0; i < num_child_directories; i++) {
+		if (!child_directories[i]->removed) {
+			names[num_names++] = child_directories[i]->name;
+		}
+	}
+	if (num_names) {
+		SDL_qsort(names, num_names, sizeof(char *), compare_names);
+	}
+
+	// walk the direct entries, jumping over each subdirectory's range
+	u32 num_expected = 0;
+	u32 num_missing_below = 0;
+	for (u32 i = first; i < end;) {
+		GitIndexEntry *entry = &index->entries[i];
+		const char *path = index->paths + entry->path;
+		const char *name = path + prefix_length;
+		const char *slash = SDL_memchr(name, '/', entry->path_length - prefix_length);
+		if (slash) {
+			u32 next = prefix_end(index, i, end, path, (u32) (slash - path) + 1);
+			if (!has_name(names, num_names, name, (u32) (slash - name))) {
+				num_missing_below += count_expected(index, i, next);
+			}
+			i = next;
+			continue;
+		}
+		num_expected += expects_file(entry);
+		for (i++; i < end && same_path(index, i, i - 1); i++) {}
+	}
+	SDL_free(names);
+
+	counts->num_deleted = num_expected - xtd_min(num_matched, num_expected) + num_missing_below;
+}
+
+void git_status_classify_listing (GitStatus *status, Directory *directory,
+	Directory **child_directories, u32 num_child_directories,
+	File **child_files, u32 num_child_files,
+	DirectoryStats *file_stats, GitListing *listing)
+{
+	SDL_zerop(listing);
+	GitRepo *repo = NULL;
+	GitIgnore *ignore = NULL;
+	bool ignored = false;
+
+	// a .git of its own makes the directory the top of a work tree
+	const char *dot_git = NULL;
+	bool dot_git_is_file = false;
+	const char *gitignore = NULL;
+	for (u32 i = 0; i < num_child_directories; i++) {
+		if (SDL_strcmp(child_directories[i]->name, ".git") == 0) dot_git = child_directories[i]->path;
+	}
+	for (u32 i = 0; i < num_child_files; i++) {
+		if (SDL_strcmp(child_files[i]->name, ".git") == 0 && !dot_git) {
+			dot_git = child_files[i]->path;
+			dot_git_is_file = true;
+		}
+		if (SDL_strcmp(child_files[i]->name, ".gitignore") == 0) gitignore = child_files[i]->path;
+	}
+
+	char key[GIT_PATH_MAX];
+	if (dot_git) {
+		repo = open_repo(status, directory->path, trimmed_length(directory->path), dot_git, dot_git_is_file);
+		ignore = repo ? repo->exclude : NULL;
+	}
+	else if (!directory->parent) {
+		repo = find_repo_above(status, directory->path, &ignore, &ignored);
+	}
+	else {
+		repo = directory->git_repo;
+		ignore = directory->git_ignore;
+		ignored = directory->git_ignored;
+	}
+	i32 path_length = repo ? relative_path(repo, directory->path, key) : -1;
+
+	for (u32 i = 0; i < num_child_directories; i++) {
+		child_directories[i]->git_repo = NULL;
+	}
+	if (path_length < 0) {
+		return;
+	}
+
+	// a directory listed again already has its own patterns on top
+	if (ignore && path_length > 0 && ignore->base_length == (u32) path_length && SDL_memcmp(ignore->base, key, (size_t) path_length) == 0) {
+		listing->replaced = ignore;
+		ignore = ignore->parent;
+	}
+	if (gitignore) {
+		ignore = load_ignore(status, ignore, gitignore, key, (u32) path_length);
+	}
+	u32 prefix_length = (u32) path_length;
+	if (prefix_length) {
+		key[prefix_length++] = '/';
+	}
+
+	for (u32 i = 0; i < num_child_directories; i++) {
+		Directory *child = child_directories[i];
+		u32 name_length = (u32) SDL_strlen(child->name);
+		child->git_ignore = ignore;
+		child->git_ignored = ignored;
+		if (is_git_dir_name(child->name, name_length) || prefix_length + name_length >= GIT_PATH_MAX) {
+			continue;
+		}
+		child->git_repo = repo;
+		if (!ignored) {
+			SDL_memcpy(key + prefix_length, child->name, name_length);
+			child->git_ignored = is_ignored(ignore, key, prefix_length + name_length, child->name, name_length, true);
+		}
+	}
+
+	u32 generation;
+	GitIndex *index = acquire_index(status, repo, &generation);
+	GitCounts counts;
+	compare_children(index, ignore, ignored, key, prefix_length, child_directories, num_child_directories, child_files, num_child_files, &counts);
+	release_index(index);
+	atomic_u64_add(&status->stats.num_files_compared, num_child_files);
+
+	listing->repo = repo;
+	listing->ignore = ignore;
+	listing->generation = generation;
+	listing->num_deleted = counts.num_deleted;
+	file_stats->num_modified += counts.num_modified + counts.num_deleted;
+	file_stats->num_untracked += counts.num_untracked;
+}
+
+// -- UI thread ---------------------------------------------------------------
+
+static bool ignore_descends_from (GitIgnore *ignore, GitIgnore *ancestor) {
+	for (GitIgnore *level = ignore; level; level = level->parent) {
+		if (level == ancestor) return true;
+	}
+	return false;
+}
+
+void git_status_release_ignore (GitStatus *status, GitIgnore *ignore) {
+	// everything is unlinked before anything is freed, since the chains are
+	// walked through the levels being released
+	GitIgnore *released = NULL;
+	SDL_LockMutex(status->mutex);
+	for (GitIgnore **link = &status->ignores; *link;) {
+		GitIgnore *level = *link;
+		if (ignore_descends_from(level, ignore)) {
+			*link = level->next;
+			level->next = released;
+			released = level;
+		} else {
+			link = &level->next;
+		}
+	}
+	SDL_UnlockMutex(status->mutex);
+
+	while (released) {
+		GitIgnore *level = released;
+		released = level->next;
+		free_ignore(level);
+	}
+}
+
+void git_status_reclassify (GitStatus *status, Directory *directory) {
+	GitRepo *repo = directory->git_repo;
+	if (!repo || !directory->git_generation || directory->unloaded) {
+		return;
+	}
+	char key[GIT_PATH_MAX];
+	i32 path_length = relative_path(repo, directory->path, key);
+	if (path_length < 0) {
+		return;
+	}
+	u32 prefix_length = (u32) path_length;
+	if (prefix_length) {
+		key[prefix_length++] = '/';
+	}
+
+	DirectoryStats before = { .num_modified = directory->num_git_deleted };
+	for (u32 i = 0; i < directory->num_child_files; i++) {
+		File *file = directory->child_files[i];
+		if (file->removed) continue;
+		before.num_modified += file->vcs_status == VCS_STATUS_MODIFIED;
+		before.num_untracked += file->vcs_status == VCS_STATUS_UNTRACKED;
+	}
+
+	// only the UI thread replaces indexes, so no reference is needed here
+	GitCounts counts;
+	compare_children(repo->index, directory->git_ignore, directory->git_ignored, key, prefix_length,
+		directory->child_directories, directory->num_child_directories,
+		directory->child_files, directory->num_child_files, &counts);
+	atomic_u64_add(&status->stats.num_files_compared, directory->num_child_files);
+	directory->num_git_deleted = counts.num_deleted;
+	directory->git_generation = repo->generation;
+
+	DirectoryStats after = { .num_modified = counts.num_modified + counts.num_deleted, .num_untracked = counts.num_untracked };
+	DirectoryStats gained = {
+		.num_modified = after.num_modified - xtd_min(after.num_modified, before.num_modified),
+		.num_untracked = after.num_untracked - xtd_min(after.num_untracked, before.num_untracked),
+	};
+	DirectoryStats lost = {
+		.num_modified = before.num_modified - xtd_min(after.num_modified, before.num_modified),
+		.num_untracked = before.num_untracked - xtd_min(after.num_untracked, before.num_untracked),
+	};
+	aggregate_add(directory, gained);
+	aggregate_subtract(directory, lost);
+}
+
+void git_status_on_listed (GitStatus *status, Directory *directory) {
+	if (directory->git_repo && directory->git_generation != directory->git_repo->generation) {
+		git_status_reclassify(status, directory);
+	}
+}
+
+//=============================================================================
+// REFRESH
+//=============================================================================
+
+// stats every index and parses the ones git rewrote since they were read
+static void poll_indexes_job (void *data) {
+	GitStatus *status = data;
+	SDL_LockMutex(status->mutex);
+	GitRepo *repos = status->repos;
+	SDL_UnlockMutex(status->mutex);
+
+	// repos are only ever added at the head, so the list from here on is stable
+	for (GitRepo *repo = repos; repo; repo = repo->next) {
+		SDL_PathInfo info;
+		if (!SDL_GetPathInfo(repo->index_path, &info)) {
+			continue;
+		}
+		SDL_LockMutex(status->mutex);
+		GitIndex *latest = repo->pending ? repo->pending : repo->index;
+		bool changed = !latest || latest->file_modified_time != info.modify_time || latest->file_size != info.size;
+		SDL_UnlockMutex(status->mutex);
+		if (!changed) {
+			continue;
+		}
+
+		GitIndex *index = load_index(status, repo->index_path);
+		if (index) {
+			SDL_LockMutex(status->mutex);
+			release_index(repo->pending);
+			repo->pending = index;
+			SDL_UnlockMutex(status->mutex);
+		}
+	}
+	SDL_SetAtomicInt(&status->polling, 0);
+}
+
+static void push_refresh (GitStatus *status, Directory *directory) {
+	if (status->refresh_depth == status->refresh_capacity) {
+		status->refresh_capacity = xtd_max(status->refresh_capacity * 2, 256u);
+		status->refresh_stack = SDL_realloc(status->refresh_stack, status->refresh_capacity * sizeof(Directory *));
+	}
+	status->refresh_stack[status->refresh_depth++] = directory;
+}
+
+void git_status_update (GitStatus *status, Directory *roots, u32 num_roots) {
+	u64 now = SDL_GetTicksNS();
+	if (status->repos && now - status->last_poll_ns >= GIT_STATUS_POLL_NS && !SDL_GetAtomicInt(&status->polling)) {
+		status->last_poll_ns = now;
+		SDL_SetAtomicInt(&status->polling, 1);
+		job_queue_push(status->job_queue, poll_indexes_job, status, JOB_PRIORITY_LOW);
+	}
+
+	bool swapped = false;
+	SDL_LockMutex(status->mutex);
+	for (GitRepo *repo = status->repos; repo; repo = repo->next) {
+		if (repo->pending) {
+			release_index(repo->index);
+			repo->index = repo->pending;
+			repo->pending = NULL;
+			repo->generation++;
+			swapped = true;
+		}
+	}
+	SDL_UnlockMutex(status->mutex);
+
+	// the walk starts over; directories already compared are passed over cheaply
+	if (swapped) {
+		status->refresh_depth = 0;
+		for (u32 i = 0; i < num_roots; i++) {
+			push_refresh(status, &roots[i]);
+		}
+	}
+
+	while (status->refresh_depth && SDL_GetTicksNS() - now < GIT_STATUS_BUDGET_NS) {
+		Directory *directory = status->refresh_stack[--status->refresh_depth];
+		if (directory->removed || directory->unloaded) {
+			continue;
+		}
+		if (directory->git_repo && directory->git_generation && directory->git_generation != directory->git_repo->generation) {
+			git_status_reclassify(status, directory);
+		}
+		for (u32 i = 0; i < directory->num_child_directories; i++) {
+			push_refresh(status, directory->child_directories[i]);
+		}
+	}
+}
+
+bool git_status_is_refreshing (GitStatus *status) {
+	return status->refresh_depth > 0;
+}
+
+//=============================================================================
+// LIFETIME
+//=============================================================================
+
+bool git_status_init (GitStatus *status, JobQueue *job_queue) {
+	SDL_zerop(status);
+	status->job_queue = job_queue;
+	status->mutex = SDL_CreateMutex();
+	if (!status->mutex) {
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create git status mutex: %s", SDL_GetError());
+		return false;
+	}
+	return true;
+}
+
+void git_status_shutdown (GitStatus *status) {
+	while (status->repos) {
+		GitRepo *repo = status->repos;
+		status->repos = repo->next;
+		release_index(repo->index);
+		release_index(repo->pending);
+		SDL_free(repo->index_path);
+		SDL_free(repo->git_dir);
+		SDL_free(repo->work_tree);
+		SDL_free(repo);
+	}
+	while (status->ignores) {
+		GitIgnore *ignore = status->ignores;
+		status->ignores = ignore->next;
+		free_ignore(ignore);
+	}
+	SDL_free(status->refresh_stack);
+	if (status->mutex) {
+		SDL_DestroyMutex(status->mutex);
+	}
+	SDL_zerop(status);
+}
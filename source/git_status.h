@@ -0,0 +1,145 @@
+#ifndef GIT_STATUS_H
+#define GIT_STATUS_H
+
+#include "xtdlib.h"
+
+#include <SDL3/SDL.h>
+
+#include "job.h"
+#include "ui.h"
+
+//=============================================================================
+// GIT STATUS
+//=============================================================================
+
+// Per-row modified and untracked markers for files inside git work trees,
+// without running git. A repository is found by the scanner when a listing
+// holds a .git entry (a directory, or a file pointing at one as submodules
+// and worktrees use), or above a root when the root is opened inside one.
+// Its .git/index is mapped and parsed directly, versions 2 to 4 including
+// the path-compressed entries of version 4, into a sorted array of paths
+// with the stat data git cached for them.
+//
+// The comparison runs on the scanner's workers: every listing looks its
+// files up in the index before it is published and marks them clean,
+// modified or untracked the way git's stat check would, from size and
+// modification time. Tracked files the listing does not contain are counted
+// as deleted. Directory::stats carries the counts, so aggregate.h rolls them
+// up to every ancestor as listings attach.
+//
+// Nothing watches the disk, so status changes arrive three ways: rescans of
+// unloaded or new directories classify afresh, edits made through file_ops
+// reclassify their parent directories, and git_status_update polls every
+// repository's index once per GIT_STATUS_POLL_NS. A changed index is parsed
+// on a worker, swapped in by the UI thread and compared against the loaded
+// tree in time-budgeted slices, directory by directory.
+//
+// Untracked files are filtered through .gitignore files and
+// .git/info/exclude. Patterns support * ? [...] and ** globs, leading and
+// trailing slashes and ! negation; a file inside an ignored directory stays
+// ignored. Files changed on disk after their directory was listed keep
+// their status until it is listed again.
+
+#define GIT_STATUS_POLL_NS      (1 * SDL_NS_PER_SECOND)
+#define GIT_STATUS_BUDGET_NS    (2 * SDL_NS_PER_MS)
+#define GIT_PATH_MAX            4096
+
+typedef enum VcsStatus {
+	VCS_STATUS_NONE,		// outside every repository, or not looked up
+	VCS_STATUS_CLEAN,
+	VCS_STATUS_MODIFIED,	// size or time differs from the index, or merge conflicted
+	VCS_STATUS_UNTRACKED,
+	VCS_STATUS_IGNORED		// untracked and matched by an ignore pattern
+} VcsStatus;
+
+typedef struct GitIndex GitIndex;
+typedef struct GitIgnore GitIgnore;
+
+typedef struct GitRepo {
+	char *work_tree;		// without a trailing separator
+	u32 work_tree_length;
+	char *git_dir;
+	char *index_path;
+
+	// written by the UI thread under GitStatus::mutex, which workers take to read
+	GitIndex *index;
+	u32 generation;			// bumped whenever index is replaced
+
+	GitIndex *pending;		// parsed by the poll job, not yet swapped in
+	GitIgnore *exclude;		// .git/info/exclude, the bottom of every pattern chain
+	struct GitRepo *next;
+} GitRepo;
+
+// what a scanner listing found, handed to the directory when it attaches
+typedef struct GitListing {
+	GitRepo *repo;
+	GitIgnore *ignore;		// patterns applying to the directory's children
+	GitIgnore *replaced;	// the directory's own patterns from its last listing, if any
+	u32 generation;			// of the index its files were compared against
+	u32 num_deleted;
+} GitListing;
+
+typedef struct GitStatusStats {
+	u32 num_repos;
+	u32 num_indexes_parsed;
+	u64 num_entries_parsed;
+	u64 parse_ns;
+	AtomicU64 num_files_compared;
+} GitStatusStats;
+
+typedef struct GitStatus {
+	JobQueue *job_queue;
+	SDL_Mutex *mutex;
+	GitRepo *repos;
+	GitIgnore *ignores;		// every pattern list loaded and not yet released
+
+	u64 last_poll_ns;
+	SDL_AtomicInt polling;
+
+	// directories still to compare against a swapped in index
+	Directory **refresh_stack;
+	u32 refresh_depth;
+	u32 refresh_capacity;
+
+	GitStatusStats stats;
+} GitStatus;
+
+bool git_status_init (GitStatus *status, JobQueue *job_queue);
+
+// frees every repository; call after the job queue is destroyed
+void git_status_shutdown (GitStatus *status);
+
+// -- Scanner side ------------------------------------------------------------
+
+// Classifies freshly created children of directory before they are published:
+// sets File::vcs_status and the children's repository, adds the counts to
+// file_stats and fills in listing. Runs on scanner workers; only reads
+// directory, whose own fields are set from listing once it attaches
+void git_status_classify_listing (GitStatus *status, Directory *directory,
+	Directory **child_directories, u32 num_child_directories,
+	File **child_files, u32 num_child_files,
+	DirectoryStats *file_stats, GitListing *listing);
+
+// compares a listing against the current index again if one was swapped in
+// while it was in flight; call from the scanner's attach callback
+void git_status_on_listed (GitStatus *status, Directory *directory);
+
+// frees GitListing::replaced once the listing has attached, with the pattern
+// lists of the unloaded subtree chained to it. Nothing else can point at them
+// by then: a directory is only listed again after its children were freed
+void git_status_release_ignore (GitStatus *status, GitIgnore *ignore);
+
+// -- UI thread ---------------------------------------------------------------
+
+// compares a loaded directory's files against its repository's current
+// index again and propagates the change in counts; for edits made by the app
+void git_status_reclassify (GitStatus *status, Directory *directory);
+
+// polls indexes for changes, swaps in the ones that did and advances the
+// refresh of the loaded trees within GIT_STATUS_BUDGET_NS
+void git_status_update (GitStatus *status, Directory *roots, u32 num_roots);
+
+// a refresh holds directory pointers, so nothing may be unloaded while it runs
+bool git_status_is_refreshing (GitStatus *status);
+
+#endif // GIT_STATUS_H
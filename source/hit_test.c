@@ -0,0 +1,205 @@
+#include "hit_test.h"
+
+#include <SDL3/SDL.h>
+
+#define HIT_MAX_CLIP_DEPTH 16
+
+static bool box_contains (Clay_BoundingBox box, f32 x, f32 y) {
+	return x >= box.x && x < box.x + box.width && y >= box.y && y < box.y + box.height;
+}
+
+static Clay_BoundingBox box_intersect (Clay_BoundingBox a, Clay_BoundingBox b) {
+	f32 left = xtd_max(a.x, b.x);
+	f32 top = xtd_max(a.y, b.y);
+	f32 right = xtd_min(a.x + a.width, b.x + b.width);
+	f32 bottom = xtd_min(a.y + a.height, b.y + b.height);
+	return (Clay_BoundingBox) { left, top, xtd_max(right - left, 0.0f), xtd_max(bottom - top, 0.0f) };
+}
+
+// the cells a box overlaps, clamped to the grid
+static void box_cells (HitIndex *index, Clay_BoundingBox box, u32 *first_column, u32 *end_column, u32 *first_row, u32 *end_row) {
+	f32 last_column = (f32) index->num_columns - 1;
+	f32 last_row = (f32) index->num_rows - 1;
+	*first_column = (u32) SDL_clamp(box.x / HIT_CELL_SIZE, 0.0f, last_column);
+	*end_column = (u32) SDL_clamp((box.x + box.width) / HIT_CELL_SIZE, 0.0f, last_column) + 1;
+	*first_row = (u32) SDL_clamp(box.y / HIT_CELL_SIZE, 0.0f, last_row);
+	*end_row = (u32) SDL_clamp((box.y + box.height) / HIT_CELL_SIZE, 0.0f, last_row) + 1;
+}
+
+static void collect_boxes (HitIndex *index, Clay_RenderCommandArray *commands) {
+	Clay_BoundingBox clips[HIT_MAX_CLIP_DEPTH];
+	u32 clip_depth = 0;
+
+	index->num_boxes = 0;
+	for (i32 i = 0; i < commands->length; i++) {
+		Clay_RenderCommand *command = Clay_RenderCommandArray_Get(commands, i);
+		Clay_BoundingBox box = command->boundingBox;
+		if (clip_depth) {
+			box = box_intersect(box, clips[clip_depth - 1]);
+		}
+
+		switch (command->commandType) {
+		case CLAY_RENDER_COMMAND_TYPE_SCISSOR_START:
+			if (clip_depth < HIT_MAX_CLIP_DEPTH) clips[clip_depth++] = box;
+			break;
+		case CLAY_RENDER_COMMAND_TYPE_SCISSOR_END:
+			if (clip_depth) clip_depth--;
+			continue;
+		// text is always inside the element that handles it
+		case CLAY_RENDER_COMMAND_TYPE_TEXT:
+			continue;
+		default:
+			break;
+		}
+		if (box.width <= 0 || box.height <= 0) {
+			continue;
+		}
+
+		if (index->num_boxes == index->boxes_capacity) {
+			index->boxes_capacity = xtd_max(index->boxes_capacity * 2, 256u);
+			index->boxes = SDL_realloc(index->boxes, index->boxes_capacity * sizeof(HitBox));
+		}
+		index->boxes[index->num_boxes++] = (HitBox) { box, command->id };
+	}
+}
+
+// counting sort of the boxes into cells, keeping paint order within each cell
+static void bucket_boxes (HitIndex *index) {
+	u32 num_cells = index->num_columns * index->num_rows;
+	if (num_cells + 1 > index->cells_capacity) {
+		index->cells_capacity = num_cells + 1;
+		index->cell_starts = SDL_realloc(index->cell_starts, index->cells_capacity * sizeof(u32));
+	}
+	SDL_memset(index->cell_starts, 0, (num_cells + 1) * sizeof(u32));
+
+	u32 num_entries = 0;
+	for (u32 i = 0; i < index->num_boxes; i++) {
+		u32 first_column, end_column, first_row, end_row;
+		box_cells(index, index->boxes[i].box, &first_column, &end_column, &first_row, &end_row);
+		for (u32 row = first_row; row < end_row; row++) {
+			for (u32 column = first_column; column < end_column; column++) {
+				index->cell_starts[row * index->num_columns + column + 1]++;
+				num_entries++;
+			}
+		}
+	}
+	for (u32 cell = 0; cell < num_cells; cell++) {
+		index->cell_starts[cell + 1] += index->cell_starts[cell];
+	}
+
+	if (num_entries > index->cell_boxes_capacity) {
+		index->cell_boxes_capacity = xtd_max(num_entries, index->cell_boxes_capacity * 2);
+		index->cell_boxes = SDL_realloc(index->cell_boxes, index->cell_boxes_capacity * sizeof(u32));
+	}
+
+	// cell_starts[cell] doubles as the fill cursor, then is shifted back
+	for (u32 i = 0; i < index->num_boxes; i++) {
+		u32 first_column, end_column, first_row, end_row;
+		box_cells(index, index->boxes[i].box, &first_column, &end_column, &first_row, &end_row);
+		for (u32 row = first_row; row < end_row; row++) {
+			for (u32 column = first_column; column < end_column; column++) {
+				index->cell_boxes[index->cell_starts[row * index->num_columns + column]++] = i;
+			}
+		}
+	}
+	for (u32 cell = num_cells; cell > 0; cell--) {
+		index->cell_starts[cell] = index->cell_starts[cell - 1];
+	}
+	index->cell_starts[0] = 0;
+}
+
+static void hit_pointer (HitIndex *index) {
+	index->num_hovered = 0;
+	f32 x = index->pointer_x;
+	f32 y = index->pointer_y;
+	if (!index->num_columns || x < 0 || y < 0) {
+		return;
+	}
+	u32 column = (u32) (x / HIT_CELL_SIZE);
+	u32 row = (u32) (y / HIT_CELL_SIZE);
+	if (column >= index->num_columns || row >= index->num_rows) {
+		return;
+	}
+
+	u32 cell = row * index->num_columns + column;
+	for (u32 i = index->cell_starts[cell]; i < index->cell_starts[cell + 1] && index->num_hovered < HIT_MAX_HOVERED; i++) {
+		HitBox *box = &index->boxes[index->cell_boxes[i]];
+		if (box_contains(box->box, x, y)) {
+			index->hovered[index->num_hovered++] = box->id;
+		}
+	}
+}
+
+static bool contains_id (const u32 *ids, u32 num_ids, u32 id) {
+	for (u32 i = 0; i < num_ids; i++) {
+		if (ids[i] == id) return true;
+	}
+	return false;
+}
+
+//=============================================================================
+// HIT INDEX
+//=============================================================================
+
+void hit_index_free (HitIndex *index) {
+	SDL_free(index->boxes);
+	SDL_free(index->cell_starts);
+	SDL_free(index->cell_boxes);
+	SDL_memset(index, 0, sizeof(*index));
+}
+
+void hit_index_build (HitIndex *index, Clay_RenderCommandArray *commands, f32 width, f32 height) {
+	index->num_columns = (u32) SDL_ceilf(xtd_max(width, 1.0f) / HIT_CELL_SIZE);
+	index->num_rows = (u32) SDL_ceilf(xtd_max(height, 1.0f) / HIT_CELL_SIZE);
+	index->list_found = false;
+
+	collect_boxes(index, commands);
+	bucket_boxes(index);
+
+	// what is under a still pointer can change with the layout too
+	hit_pointer(index);
+}
+
+void hit_index_set_rows (HitIndex *index, u32 list_id, f32 scroll_offset, f32 row_height, RowRange rows) {
+	index->list_id = list_id;
+	index->list_found = false;
+	for (u32 i = 0; i < index->num_boxes; i++) {
+		if (index->boxes[i].id == list_id) {
+			index->list_box = index->boxes[i].box;
+			index->list_found = true;
+			break;
+		}
+	}
+	index->row_origin_y = index->list_box.y - scroll_offset;
+	index->row_height = row_height;
+	index->list_rows = rows;
+}
+
+void hit_index_set_pointer (HitIndex *index, f32 x, f32 y) {
+	if (x == index->pointer_x && y == index->pointer_y) {
+		return;
+	}
+	index->pointer_x = x;
+	index->pointer_y = y;
+	hit_pointer(index);
+}
+
+bool hit_index_pointer_over (HitIndex *index, u32 id) {
+	return contains_id(index->hovered, index->num_hovered, id);
+}
+
+bool hit_index_pointer_row (HitIndex *index, u32 *row) {
+	if (!index->list_found || index->row_height <= 0 || !box_contains(index->list_box, index->pointer_x, index->pointer_y)) {
+		return false;
+	}
+	f32 offset = index->pointer_y - index->row_origin_y;
+	if (offset < 0) {
+		return false;
+	}
+	u32 hit = (u32) (offset / index->row_height);
+	if (hit < index->list_rows.first || hit >= index->list_rows.end) {
+		return false;
+	}
+	*row = hit;
+	return true;
+}
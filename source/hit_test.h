@@ -0,0 +1,72 @@
+#ifndef HIT_TEST_H
+#define HIT_TEST_H
+
+#include "xtdlib.h"
+
+#include "clay.h"
+#include "scroll.h"
+
+//=============================================================================
+// HIT TESTING
+//=============================================================================
+
+// Pointer queries against what is on screen, rebuilt from every frame's
+// render commands. Boxes are clipped to their scissor regions and bucketed
+// into a uniform grid of HIT_CELL_SIZE cells, so a query only looks at the
+// few boxes overlapping one cell. The explorer rows, most of which draw
+// nothing of their own, are an interval index instead: fixed-height rows
+// from an origin, so the row under the pointer is one division.
+//
+// The elements under the pointer are found once per pointer move or layout
+// and kept, so any number of queries in between cost a scan of that set.
+
+#define HIT_CELL_SIZE   64.0f
+#define HIT_MAX_HOVERED 32
+
+typedef struct HitBox {
+	Clay_BoundingBox box;
+	u32 id;
+} HitBox;
+
+typedef struct HitIndex {
+	HitBox *boxes;			// paint order, so later boxes are on top
+	u32 num_boxes;
+	u32 boxes_capacity;
+
+	u32 num_columns;
+	u32 num_rows;
+	u32 *cell_starts;		// num_columns * num_rows + 1 offsets into cell_boxes
+	u32 cells_capacity;
+	u32 *cell_boxes;
+	u32 cell_boxes_capacity;
+
+	// the row list: row i spans row_origin_y + i * row_height inside the list's box
+	u32 list_id;
+	Clay_BoundingBox list_box;
+	bool list_found;
+	f32 row_origin_y;
+	f32 row_height;
+	RowRange list_rows;
+
+	f32 pointer_x;
+	f32 pointer_y;
+	u32 hovered[HIT_MAX_HOVERED];
+	u32 num_hovered;
+} HitIndex;
+
+void hit_index_free (HitIndex *index);
+
+// replaces the index with the boxes of commands and re-tests the pointer
+void hit_index_build (HitIndex *index, Clay_RenderCommandArray *commands, f32 width, f32 height);
+
+// declares the rows laid out inside the clipped element list_id, row first
+// starting scroll_offset above the top of its box; call after hit_index_build
+void hit_index_set_rows (HitIndex *index, u32 list_id, f32 scroll_offset, f32 row_height, RowRange rows);
+
+void hit_index_set_pointer (HitIndex *index, f32 x, f32 y);
+bool hit_index_pointer_over (HitIndex *index, u32 id);
+
+// the laid out row under the pointer
+bool hit_index_pointer_row (HitIndex *index, u32 *row);
+
+#endif // HIT_TEST_H
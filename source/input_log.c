@@ -0,0 +1,336 @@
+#include "input_log.h"
+
+bool input_log_is_input (u32 type) {
+	switch (type) {
+	case SDL_EVENT_MOUSE_MOTION:
+	case SDL_EVENT_MOUSE_WHEEL:
+	case SDL_EVENT_MOUSE_BUTTON_DOWN:
+	case SDL_EVENT_MOUSE_BUTTON_UP:
+	case SDL_EVENT_KEY_DOWN:
+	case SDL_EVENT_TEXT_INPUT:
+	case SDL_EVENT_DROP_FILE:
+	case SDL_EVENT_WINDOW_RESIZED:
+		return true;
+	default:
+		return false;
+	}
+}
+
+//=============================================================================
+// RECORDING
+//=============================================================================
+
+static void flush_recording (InputRecorder *recorder) {
+	if (recorder->buffer_length && SDL_WriteIO(recorder->stream, recorder->buffer, recorder->buffer_length) != recorder->buffer_length) {
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to write the input log: %s", SDL_GetError());
+	}
+	recorder->buffer_length = 0;
+}
+
+static void write_recording (InputRecorder *recorder, const void *data, u32 length) {
+	if (recorder->buffer_length + length > INPUT_LOG_BUFFER_SIZE) {
+		flush_recording(recorder);
+	}
+	SDL_memcpy(recorder->buffer + recorder->buffer_length, data, length);
+	recorder->buffer_length += length;
+}
+
+static void write_record (InputRecorder *recorder, InputRecord *record, const char *text) {
+	u32 text_length = text ? (u32) xtd_min(SDL_strlen(text) + 1, (size_t) INPUT_LOG_BUFFER_SIZE / 2) : 0;
+	record->time_ns = SDL_GetTicksNS() - recorder->start_ns;
+	record->text_length = (u16) xtd_min(text_length, (u32) UINT16_MAX);
+	write_recording(recorder, record, sizeof(*record));
+	if (record->text_length) {
+		// a truncated text still ends in its terminator
+		write_recording(recorder, text, record->text_length - 1u);
+		write_recording(recorder, "", 1);
+	}
+}
+
+bool input_recorder_open (InputRecorder *recorder, SDL_Window *window, const char *path) {
+	SDL_zerop(recorder);
+	recorder->stream = SDL_IOFromFile(path, "wb");
+	if (!recorder->stream) {
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create input log %s: %s", path, SDL_GetError());
+		return false;
+	}
+	recorder->buffer = SDL_malloc(INPUT_LOG_BUFFER_SIZE);
+	recorder->start_ns = SDL_GetTicksNS();
+
+	InputLogHeader header = { INPUT_LOG_MAGIC, INPUT_LOG_VERSION, sizeof(InputRecord), 0 };
+	write_recording(recorder, &header, sizeof(header));
+
+	// a replay starts from the same window size, and places the recorded
+	// desktop around its own window by this position
+	i32 x, y, width, height;
+	SDL_GetWindowPosition(window, &x, &y);
+	SDL_GetWindowSize(window, &width, &height);
+	InputRecord record = {
+		.type = SDL_EVENT_WINDOW_RESIZED,
+		.x = (f32) width, .y = (f32) height,
+		.global_x = (f32) x, .global_y = (f32) y
+	};
+	write_record(recorder, &record, NULL);
+	return true;
+}
+
+void input_recorder_event (InputRecorder *recorder, const SDL_Event *event) {
+	if (!recorder->stream || !input_log_is_input(event->type)) {
+		return;
+	}
+	InputRecord record = { .type = event->type };
+	const char *text = NULL;
+	switch (event->type) {
+	case SDL_EVENT_MOUSE_MOTION:
+		record.x = event->motion.x;
+		record.y = event->motion.y;
+		SDL_GetGlobalMouseState(&record.global_x, &record.global_y);
+		break;
+	case SDL_EVENT_MOUSE_WHEEL:
+		record.x = event->wheel.x;
+		record.y = event->wheel.y;
+		break;
+	case SDL_EVENT_MOUSE_BUTTON_DOWN:
+	case SDL_EVENT_MOUSE_BUTTON_UP:
+		record.key = event->button.button;
+		record.mod = (u16) SDL_GetModState();	// Ctrl and Shift clicks extend the selection
+		record.x = event->button.x;
+		record.y = event->button.y;
+		SDL_GetGlobalMouseState(&record.global_x, &record.global_y);
+		break;
+	case SDL_EVENT_KEY_DOWN:
+		record.key = event->key.key;
+		record.mod = event->key.mod;
+		break;
+	case SDL_EVENT_TEXT_INPUT:
+		text = event->text.text;
+		break;
+	case SDL_EVENT_DROP_FILE:
+		text = event->drop.data;
+		break;
+	case SDL_EVENT_WINDOW_RESIZED: {
+		record.x = (f32) event->window.data1;
+		record.y = (f32) event->window.data2;
+		i32 x = 0, y = 0;
+		SDL_GetWindowPosition(SDL_GetWindowFromID(event->window.windowID), &x, &y);
+		record.global_x = (f32) x;
+		record.global_y = (f32) y;
+		break;
+	}
+	}
+	write_record(recorder, &record, text);
+	recorder->num_events++;
+}
+
+void input_recorder_frame (InputRecorder *recorder) {
+	if (!recorder->stream) {
+		return;
+	}
+	InputRecord record = { .type = INPUT_RECORD_FRAME };
+	write_record(recorder, &record, NULL);
+	recorder->num_frames++;
+}
+
+void input_recorder_close (InputRecorder *recorder) {
+	if (!recorder->stream) {
+		return;
+	}
+	flush_recording(recorder);
+	SDL_CloseIO(recorder->stream);
+	SDL_Log("recorded %u input events over %u frames", recorder->num_events, recorder->num_frames);
+	SDL_free(recorder->buffer);
+	SDL_zerop(recorder);
+}
+
+//=============================================================================
+// REPLAY
+//=============================================================================
+
+bool input_replay_open (InputReplay *replay, const char *path, ReplaySpeed speed) {
+	SDL_zerop(replay);
+	replay->data = SDL_LoadFile(path, &replay->size);
+	if (!replay->data) {
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to read input log %s: %s", path, SDL_GetError());
+		return false;
+	}
+
+	InputLogHeader header;
+	if (replay->size < sizeof(header)) {
+		header.magic = 0;
+	} else {
+		SDL_memcpy(&header, replay->data, sizeof(header));
+	}
+	if (header.magic != INPUT_LOG_MAGIC || header.version != INPUT_LOG_VERSION || header.record_size != sizeof(InputRecord)) {
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "%s is not an input log this build can replay", path);
+		input_replay_close(replay);
+		return false;
+	}
+	replay->offset = sizeof(header);
+	replay->speed = speed;
+	return true;
+}
+
+void input_replay_close (InputReplay *replay) {
+	SDL_free(replay->data);
+	SDL_free(replay->stats.frame_ns);
+	SDL_zerop(replay);
+}
+
+static void event_from_record (SDL_Event *event, const InputRecord *record, const char *text) {
+	SDL_zerop(event);
+	event->type = record->type;
+	event->common.timestamp = SDL_GetTicksNS();
+	switch (record->type) {
+	case SDL_EVENT_MOUSE_MOTION:
+		event->motion.x = record->x;
+		event->motion.y = record->y;
+		break;
+	case SDL_EVENT_MOUSE_WHEEL:
+		event->wheel.x = record->x;
+		event->wheel.y = record->y;
+		break;
+	case SDL_EVENT_MOUSE_BUTTON_DOWN:
+	case SDL_EVENT_MOUSE_BUTTON_UP:
+		event->button.button = (u8) record->key;
+		event->button.down = record->type == SDL_EVENT_MOUSE_BUTTON_DOWN;
+		event->button.clicks = 1;
+		event->button.x = record->x;
+		event->button.y = record->y;
+		SDL_SetModState((SDL_Keymod) record->mod);
+		break;
+	case SDL_EVENT_KEY_DOWN:
+		event->key.key = record->key;
+		event->key.mod = record->mod;
+		event->key.down = true;
+		break;
+	case SDL_EVENT_TEXT_INPUT:
+		event->text.text = text;
+		break;
+	case SDL_EVENT_DROP_FILE:
+		event->drop.data = text;
+		break;
+	case SDL_EVENT_WINDOW_RESIZED:
+		event->window.data1 = (i32) record->x;
+		event->window.data2 = (i32) record->y;
+		break;
+	}
+}
+
+// the first window record lines the recorded desktop up with this one; until
+// a pointer event says otherwise the pointer rests in the window's middle
+static void track_pointer (InputReplay *replay, const InputRecord *record) {
+	switch (record->type) {
+	case SDL_EVENT_WINDOW_RESIZED:
+		if (!replay->placed) {
+			replay->desktop_offset_x = (f32) replay->window_x - record->global_x;
+			replay->desktop_offset_y = (f32) replay->window_y - record->global_y;
+			replay->pointer_x = (f32) replay->window_x + record->x / 2;
+			replay->pointer_y = (f32) replay->window_y + record->y / 2;
+			replay->placed = true;
+		}
+		break;
+	case SDL_EVENT_MOUSE_MOTION:
+	case SDL_EVENT_MOUSE_BUTTON_DOWN:
+	case SDL_EVENT_MOUSE_BUTTON_UP:
+		replay->pointer_x = record->global_x + replay->desktop_offset_x;
+		replay->pointer_y = record->global_y + replay->desktop_offset_y;
+		break;
+	}
+}
+
+bool input_replay_next_event (InputReplay *replay, SDL_Event *event) {
+	if (!replay->start_ns) {
+		replay->start_ns = replay->stats.start_ns = SDL_GetTicksNS();
+	}
+
+	while (replay->offset + sizeof(InputRecord) <= replay->size) {
+		InputRecord record;
+		SDL_memcpy(&record, replay->data + replay->offset, sizeof(record));
+
+		if (record.type == INPUT_RECORD_FRAME) {
+			replay->offset += sizeof(record);
+			replay->frame_delta_ns = record.time_ns - replay->frame_time_ns;
+			replay->frame_time_ns = record.time_ns;
+			if (replay->speed == REPLAY_SPEED_MAX) {
+				return false;
+			}
+			continue;
+		}
+		if (replay->speed == REPLAY_SPEED_ORIGINAL && record.time_ns > SDL_GetTicksNS() - replay->start_ns) {
+			return false;
+		}
+
+		size_t next = replay->offset + sizeof(record) + record.text_length;
+		const char *text = (const char *) replay->data + replay->offset + sizeof(record);
+		if (next > replay->size || !input_log_is_input(record.type) || (record.text_length && text[record.text_length - 1] != '\0')) {
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "The input log is damaged; replay stops here");
+			replay->offset = replay->size;
+			return false;
+		}
+		replay->offset = next;
+		track_pointer(replay, &record);
+		event_from_record(event, &record, record.text_length ? text : NULL);
+		replay->stats.num_events++;
+		return true;
+	}
+	return false;
+}
+
+bool input_replay_finished (InputReplay *replay) {
+	return replay->offset + sizeof(InputRecord) > replay->size;
+}
+
+void input_replay_record_frame (InputReplay *replay, u64 frame_ns, u64 layout_ns, u32 num_commands, u32 num_draw_calls, bool skipped) {
+	ReplayStats *stats = &replay->stats;
+	if (stats->num_frames == stats->frames_capacity) {
+		stats->frames_capacity = xtd_max(stats->frames_capacity * 2, 1024u);
+		stats->frame_ns = SDL_realloc(stats->frame_ns, stats->frames_capacity * sizeof(u64));
+	}
+	stats->frame_ns[stats->num_frames++] = frame_ns;
+	stats->layout_ns += layout_ns;
+	stats->max_layout_ns = xtd_max(stats->max_layout_ns, layout_ns);
+	if (!skipped) {
+		stats->num_drawn++;
+		stats->num_commands += num_commands;
+		stats->num_draw_calls += num_draw_calls;
+	}
+}
+
+static int compare_u64 (const void *a, const void *b) {
+	u64 left = *(const u64 *) a;
+	u64 right = *(const u64 *) b;
+	return (left > right) - (left < right);
+}
+
+static f64 percentile_ms (const u64 *sorted, u32 count, u32 percent) {
+	return (f64) sorted[(u64) (count - 1) * percent / 100] / SDL_NS_PER_MS;
+}
+
+void input_replay_report (InputReplay *replay) {
+	ReplayStats *stats = &replay->stats;
+	if (!stats->num_frames) {
+		SDL_Log("replay: no frames");
+		return;
+	}
+	SDL_qsort(stats->frame_ns, stats->num_frames, sizeof(u64), compare_u64);
+	u64 total_ns = 0;
+	for (u32 i = 0; i < stats->num_frames; i++) {
+		total_ns += stats->frame_ns[i];
+	}
+	u32 num_drawn = xtd_max(stats->num_drawn, 1u);
+
+	SDL_Log("replay: %u events over %u frames in %.2f s at %s speed",
+		stats->num_events, stats->num_frames, (f64) (SDL_GetTicksNS() - stats->start_ns) / SDL_NS_PER_SECOND,
+		replay->speed == REPLAY_SPEED_MAX ? "max" : "original");
+	SDL_Log("replay frame time: avg %.3f ms, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms",
+		(f64) total_ns / stats->num_frames / SDL_NS_PER_MS,
+		percentile_ms(stats->frame_ns, stats->num_frames, 50),
+		percentile_ms(stats->frame_ns, stats->num_frames, 95),
+		percentile_ms(stats->frame_ns, stats->num_frames, 99),
+		(f64) stats->frame_ns[stats->num_frames - 1] / SDL_NS_PER_MS);
+	SDL_Log("replay layout: avg %.3f ms, max %.3f ms",
+		(f64) stats->layout_ns / stats->num_frames / SDL_NS_PER_MS, (f64) stats->max_layout_ns / SDL_NS_PER_MS);
+	SDL_Log("replay draw: %u of %u frames drawn, %.1f render commands and %.1f draw calls per drawn frame",
+		stats->num_drawn, stats->num_frames,
+		(f64) stats->num_commands / num_drawn, (f64) stats->num_draw_calls / num_drawn);
+}
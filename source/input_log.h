@@ -0,0 +1,124 @@
+#ifndef INPUT_LOG_H
+#define INPUT_LOG_H
+
+#include "xtdlib.h"
+
+#include <SDL3/SDL.h>
+
+//=============================================================================
+// INPUT LOG
+//=============================================================================
+
+// Input sessions recorded to a file and fed back in as a repeatable
+// benchmark. A log is a header followed by fixed-size records: the input
+// events SDL_AppEvent acted on, each followed by its text for text input,
+// and a frame record at the start of every frame. Times are nanoseconds
+// from the start of the recording.
+//
+// Replay runs either at the original speed, delivering each event once its
+// time has passed, or at maximum speed, where each frame gets exactly the
+// events of its recorded frame and the recorded frame's duration as its
+// time step, so animations advance the same way whatever the frame rate.
+//
+// Dragging and resizing the window follow the pointer on the desktop, so
+// pointer events also record where it was there. A replay reports those
+// positions in place of the real cursor's, shifted by how far the replaying
+// window starts from where the recorded one did.
+
+#define INPUT_LOG_MAGIC        0x4e495149u	// "IQIN"
+#define INPUT_LOG_VERSION      2
+#define INPUT_LOG_BUFFER_SIZE  (64 * 1024)
+
+// the record type of frame starts, never an SDL event type
+#define INPUT_RECORD_FRAME     0
+
+typedef struct InputLogHeader {
+	u32 magic;
+	u32 version;
+	u32 record_size;
+	u32 reserved;
+} InputLogHeader;
+
+typedef struct InputRecord {
+	u64 time_ns;
+	u32 type;			// SDL_EventType or INPUT_RECORD_FRAME
+	u32 key;			// SDL_Keycode, or the mouse button
+	f32 x, y;			// pointer position, wheel delta or window size
+	f32 global_x, global_y;	// the pointer on the desktop, or with a window size the window position
+	u16 mod;
+	u16 text_length;	// bytes of text following the record, with its terminator
+	u32 reserved;
+} InputRecord;
+
+typedef struct InputRecorder {
+	SDL_IOStream *stream;
+	u64 start_ns;
+	u8 *buffer;
+	u32 buffer_length;
+	u32 num_events;
+	u32 num_frames;
+} InputRecorder;
+
+typedef enum ReplaySpeed {
+	REPLAY_SPEED_ORIGINAL,
+	REPLAY_SPEED_MAX,
+} ReplaySpeed;
+
+// what a replayed run measured, per frame where it says so
+typedef struct ReplayStats {
+	u64 start_ns;
+	u64 *frame_ns;			// how long each frame took to update and draw
+	u32 num_frames;
+	u32 frames_capacity;
+	u32 num_events;
+
+	u64 layout_ns;
+	u64 max_layout_ns;
+	u32 num_drawn;			// frames not skipped as unchanged
+	u64 num_commands;		// over the drawn frames
+	u64 num_draw_calls;
+} ReplayStats;
+
+typedef struct InputReplay {
+	u8 *data;
+	size_t size;
+	size_t offset;
+	ReplaySpeed speed;
+	u64 start_ns;
+	u64 frame_time_ns;		// recorded time of the last frame started
+	u64 frame_delta_ns;		// recorded duration of the frame being replayed
+	ReplayStats stats;
+
+	// the recorded desktop moved to where the replaying window starts
+	i32 window_x, window_y;	// of the replaying window before the first event; set by the caller
+	f32 desktop_offset_x;
+	f32 desktop_offset_y;
+	bool placed;			// the offset is known
+	f32 pointer_x, pointer_y;	// on this desktop, as of the last pointer event replayed
+} InputReplay;
+
+// the event types a log holds
+bool input_log_is_input (u32 type);
+
+// -- Recording --------------------------------------------------------------
+
+bool input_recorder_open (InputRecorder *recorder, SDL_Window *window, const char *path);
+// events that are not input are ignored
+void input_recorder_event (InputRecorder *recorder, const SDL_Event *event);
+void input_recorder_frame (InputRecorder *recorder);
+void input_recorder_close (InputRecorder *recorder);
+
+// -- Replay -----------------------------------------------------------------
+
+bool input_replay_open (InputReplay *replay, const char *path, ReplaySpeed speed);
+void input_replay_close (InputReplay *replay);
+
+// the next event due in the frame being replayed; false once there is none.
+// Events point into the log, which outlives them
+bool input_replay_next_event (InputReplay *replay, SDL_Event *event);
+bool input_replay_finished (InputReplay *replay);
+
+void input_replay_record_frame (InputReplay *replay, u64 frame_ns, u64 layout_ns, u32 num_commands, u32 num_draw_calls, bool skipped);
+void input_replay_report (InputReplay *replay);
+
+#endif // INPUT_LOG_H
@@ -0,0 +1,168 @@
+#include "job.h"
+
+#if defined(_WIN32)
+	#include <windows.h>
+#elif defined(__linux__)
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+//=============================================================================
+// WORKERS
+//=============================================================================
+
+typedef struct WorkerStartup {
+	JobQueue *queue;
+	SDL_ThreadPriority thread_priority;
+} WorkerStartup;
+
+static Job *pop_job (JobQueue *queue) {
+	for (u32 priority = 0; priority < NUM_JOB_PRIORITIES; priority++) {
+		Job *job = queue->heads[priority];
+		if (job) {
+			queue->heads[priority] = job->next;
+			if (!queue->heads[priority]) {
+				queue->tails[priority] = NULL;
+			}
+			return job;
+		}
+	}
+	return NULL;
+}
+
+// background workers also drop to idle I/O so their reads queue behind interactive ones
+static void lower_io_priority (void) {
+#if defined(_WIN32)
+	SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#elif defined(__linux__)
+	// IOPRIO_WHO_PROCESS with id 0 is the calling thread; IOPRIO_CLASS_IDLE is 3
+	syscall(SYS_ioprio_set, 1, 0, 3 << 13);
+#endif
+}
+
+static int worker_main (void *data) {
+	WorkerStartup *startup = data;
+	JobQueue *queue = startup->queue;
+	SDL_SetCurrentThreadPriority(startup->thread_priority);
+	if (startup->thread_priority == SDL_THREAD_PRIORITY_LOW) {
+		lower_io_priority();
+	}
+	SDL_free(startup);
+
+	SDL_LockMutex(queue->mutex);
+	while (true) {
+		Job *job = pop_job(queue);
+		if (!job) {
+			if (queue->shutting_down) break;
+			SDL_WaitCondition(queue->condition, queue->mutex);
+			continue;
+		}
+
+		JobFunction function = job->function;
+		void *job_data = job->data;
+		job->next = queue->free_list;
+		queue->free_list = job;
+		SDL_UnlockMutex(queue->mutex);
+
+		function(job_data);
+		SDL_AddAtomicInt(&queue->num_pending, -1);
+
+		SDL_LockMutex(queue->mutex);
+	}
+	SDL_UnlockMutex(queue->mutex);
+
+	return 0;
+}
+
+//=============================================================================
+// QUEUE
+//=============================================================================
+
+bool job_queue_create (JobQueue *queue, u32 num_threads, SDL_ThreadPriority thread_priority, const char *name) {
+	SDL_memset(queue, 0, sizeof(*queue));
+
+	queue->mutex = SDL_CreateMutex();
+	queue->condition = SDL_CreateCondition();
+	queue->threads = SDL_calloc(num_threads, sizeof(SDL_Thread *));
+	if (!queue->mutex || !queue->condition || !queue->threads) {
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create job queue: %s", SDL_GetError());
+		return false;
+	}
+
+	for (u32 i = 0; i < num_threads; i++) {
+		WorkerStartup *startup = SDL_malloc(sizeof(WorkerStartup));
+		startup->queue = queue;
+		startup->thread_priority = thread_priority;
+
+		queue->threads[i] = SDL_CreateThread(worker_main, name, startup);
+		if (!queue->threads[i]) {
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create worker thread: %s", SDL_GetError());
+			SDL_free(startup);
+			break;
+		}
+		queue->num_threads++;
+	}
+
+	return queue->num_threads > 0;
+}
+
+void job_queue_destroy (JobQueue *queue) {
+	if (!queue->mutex) return;
+
+	SDL_LockMutex(queue->mutex);
+	queue->shutting_down = true;
+	SDL_BroadcastCondition(queue->condition);
+	SDL_UnlockMutex(queue->mutex);
+
+	for (u32 i = 0; i < queue->num_threads; i++) {
+		SDL_WaitThread(queue->threads[i], NULL);
+	}
+
+	for (u32 priority = 0; priority < NUM_JOB_PRIORITIES; priority++) {
+		while (queue->heads[priority]) {
+			Job *job = queue->heads[priority];
+			queue->heads[priority] = job->next;
+			SDL_free(job);
+		}
+	}
+	while (queue->free_list) {
+		Job *job = queue->free_list;
+		queue->free_list = job->next;
+		SDL_free(job);
+	}
+
+	SDL_free(queue->threads);
+	SDL_DestroyCondition(queue->condition);
+	SDL_DestroyMutex(queue->mutex);
+	SDL_memset(queue, 0, sizeof(*queue));
+}
+
+void job_queue_push (JobQueue *queue, JobFunction function, void *data, JobPriority priority) {
+	SDL_AddAtomicInt(&queue->num_pending, 1);
+
+	SDL_LockMutex(queue->mutex);
+
+	Job *job = queue->free_list;
+	if (job) {
+		queue->free_list = job->next;
+	} else {
+		job = SDL_malloc(sizeof(Job));
+	}
+	job->function = function;
+	job->data = data;
+	job->next = NULL;
+
+	if (queue->tails[priority]) {
+		queue->tails[priority]->next = job;
+	} else {
+		queue->heads[priority] = job;
+	}
+	queue->tails[priority] = job;
+
+	SDL_SignalCondition(queue->condition);
+	SDL_UnlockMutex(queue->mutex);
+}
+
+u32 job_queue_num_pending (JobQueue *queue) {
+	return (u32) SDL_GetAtomicInt(&queue->num_pending);
+}
@@ -0,0 +1,99 @@
+#ifndef JOB_H
+#define JOB_H
+
+#include "xtdlib.h"
+
+#include <SDL3/SDL.h>
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+//=============================================================================
+// JOB QUEUE
+//=============================================================================
+
+// Jobs are plain function pointers pulled off a shared queue by a fixed set of
+// worker threads. Workers always drain higher priorities first. Jobs must
+// never block waiting on other jobs; fork/join work is expressed by having the
+// last job of a batch (see JobCounter) push the continuation.
+// Queues created with SDL_THREAD_PRIORITY_LOW also run their workers at idle
+// I/O priority, for background indexing that must not compete with the UI.
+
+typedef void (*JobFunction) (void *data);
+
+typedef enum JobPriority {
+	JOB_PRIORITY_HIGH,
+	JOB_PRIORITY_NORMAL,
+	JOB_PRIORITY_LOW,
+	NUM_JOB_PRIORITIES
+} JobPriority;
+
+typedef struct Job {
+	JobFunction function;
+	void *data;
+	struct Job *next;
+} Job;
+
+typedef struct JobQueue {
+	SDL_Mutex *mutex;
+	SDL_Condition *condition;
+
+	Job *heads[NUM_JOB_PRIORITIES];
+	Job *tails[NUM_JOB_PRIORITIES];
+	Job *free_list;
+
+	SDL_Thread **threads;
+	u32 num_threads;
+	bool shutting_down;
+
+	SDL_AtomicInt num_pending;
+} JobQueue;
+
+typedef struct JobCounter {
+	SDL_AtomicInt remaining;
+} JobCounter;
+
+bool job_queue_create (JobQueue *queue, u32 num_threads, SDL_ThreadPriority thread_priority, const char *name);
+void job_queue_destroy (JobQueue *queue);
+
+void job_queue_push (JobQueue *queue, JobFunction function, void *data, JobPriority priority);
+u32  job_queue_num_pending (JobQueue *queue);
+
+static inline void job_counter_set (JobCounter *counter, i32 count) {
+	SDL_SetAtomicInt(&counter->remaining, count);
+}
+
+// returns true for exactly one caller: the one that completed the batch
+static inline bool job_counter_complete (JobCounter *counter) {
+	return SDL_AddAtomicInt(&counter->remaining, -1) == 1;
+}
+
+//=============================================================================
+// 64-BIT COUNTERS
+//=============================================================================
+
+// SDL only has 32-bit atomics; byte counts that workers bump and the UI reads
+// every frame need 64. Relaxed ordering: readers only ever want a recent value
+
+typedef struct AtomicU64 {
+	volatile u64 value;
+} AtomicU64;
+
+static inline void atomic_u64_add (AtomicU64 *counter, u64 amount) {
+#if defined(_MSC_VER)
+	_InterlockedExchangeAdd64((volatile __int64 *) &counter->value, (__int64) amount);
+#else
+	__atomic_fetch_add(&counter->value, amount, __ATOMIC_RELAXED);
+#endif
+}
+
+static inline u64 atomic_u64_get (AtomicU64 *counter) {
+#if defined(_MSC_VER)
+	return (u64) _InterlockedCompareExchange64((volatile __int64 *) &counter->value, 0, 0);
+#else
+	return __atomic_load_n(&counter->value, __ATOMIC_RELAXED);
+#endif
+}
+
+#endif // JOB_H
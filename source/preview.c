@@ -0,0 +1,356 @@
+#include "preview.h"
+
+#include "bytes.h"
+
+//=============================================================================
+// LINE INDEX
+//=============================================================================
+
+static void release_index (PreviewLineIndex *index) {
+	if (SDL_AddAtomicInt(&index->references, -1) != 1) {
+		return;
+	}
+	SDL_DestroyMutex(index->mutex);
+	SDL_free(index->checkpoints);
+	SDL_free(index->path);
+	SDL_free(index);
+}
+
+static void push_checkpoint (PreviewLineIndex *index, PreviewCheckpoint checkpoint) {
+	if (index->num_checkpoints == index->checkpoints_capacity) {
+		index->checkpoints_capacity = xtd_max(index->checkpoints_capacity * 2, 64u);
+		index->checkpoints = SDL_realloc(index->checkpoints, index->checkpoints_capacity * sizeof(PreviewCheckpoint));
+	}
+	index->checkpoints[index->num_checkpoints++] = checkpoint;
+}
+
+// checkpoints found by the job, handed over under the lock a few at a time
+typedef struct CheckpointBatch {
+	PreviewCheckpoint checkpoints[16];
+	u32 count;
+	u64 last_offset;
+} CheckpointBatch;
+
+static void flush_checkpoints (PreviewLineIndex *index, CheckpointBatch *batch) {
+	SDL_LockMutex(index->mutex);
+	for (u32 i = 0; i < batch->count; i++) push_checkpoint(index, batch->checkpoints[i]);
+	SDL_UnlockMutex(index->mutex);
+	batch->count = 0;
+}
+
+static void add_checkpoint (PreviewLineIndex *index, CheckpointBatch *batch, u64 offset, u64 line) {
+	batch->checkpoints[batch->count++] = (PreviewCheckpoint) { offset, line };
+	batch->last_offset = offset;
+	if (batch->count == SDL_arraysize(batch->checkpoints)) {
+		flush_checkpoints(index, batch);
+	}
+}
+
+static void index_lines_job (void *data) {
+	PreviewLineIndex *index = data;
+
+	MappedFile file;
+	if (!mapped_file_open(&file, index->path)) {
+		release_index(index);
+		return;
+	}
+
+	MappedView view = {0};
+	CheckpointBatch batch = {0};
+	u64 offset = 0;
+	u64 num_lines = 0;
+	u32 lines_until_checkpoint = PREVIEW_CHECKPOINT_LINES;
+
+	while (offset < file.size && !SDL_GetAtomicInt(&index->cancelled)) {
+		if (!mapped_view_map(&file, &view, offset, PREVIEW_INDEX_WINDOW_SIZE, MAPPED_ACCESS_SEQUENTIAL)) {
+			break;
+		}
+
+		// whole blocks are only counted; a block is walked line by line
+		// only when it contains the next checkpoint
+		for (u64 block = 0; block < view.length; block += PREVIEW_INDEX_BLOCK_SIZE) {
+			const u8 *start = view.data + block;
+			u64 length = xtd_min((u64) PREVIEW_INDEX_BLOCK_SIZE, view.length - block);
+			size_t count = bytes_count(start, length, '\n');
+
+			if (count < lines_until_checkpoint) {
+				lines_until_checkpoint -= (u32) count;
+				num_lines += count;
+			} else {
+				const u8 *cursor = start;
+				const u8 *end = start + length;
+				while (cursor < end) {
+					const u8 *newline = bytes_find(cursor, end - cursor, '\n');
+					if (!newline) break;
+					cursor = newline + 1;
+					num_lines++;
+					if (--lines_until_checkpoint == 0) {
+						lines_until_checkpoint = PREVIEW_CHECKPOINT_LINES;
+						add_checkpoint(index, &batch, view.offset + (u64) (cursor - view.data), num_lines);
+					}
+				}
+			}
+
+			// long lines space the line checkpoints out; these bound the
+			// count the UI thread does from one
+			u64 block_end = view.offset + block + length;
+			if (block_end - batch.last_offset >= PREVIEW_CHECKPOINT_BYTES) {
+				lines_until_checkpoint = PREVIEW_CHECKPOINT_LINES;
+				add_checkpoint(index, &batch, block_end, num_lines);
+			}
+		}
+
+		offset += view.length;
+
+		flush_checkpoints(index, &batch);
+		SDL_LockMutex(index->mutex);
+		index->bytes_indexed = offset;
+		index->num_lines = num_lines;
+		SDL_UnlockMutex(index->mutex);
+	}
+
+	mapped_view_unmap(&view);
+
+	SDL_LockMutex(index->mutex);
+	// a final line without a trailing newline is still a line
+	if (offset == file.size && !SDL_GetAtomicInt(&index->cancelled)) {
+		bool ends_with_newline = false;
+		if (file.size > 0 && mapped_view_map(&file, &view, file.size - 1, 1, MAPPED_ACCESS_RANDOM)) {
+			ends_with_newline = view.data[0] == '\n';
+			mapped_view_unmap(&view);
+		}
+		index->num_lines = num_lines + (file.size > 0 && !ends_with_newline);
+		index->complete = true;
+	}
+	SDL_UnlockMutex(index->mutex);
+
+	mapped_file_close(&file);
+	release_index(index);
+}
+
+//=============================================================================
+// WINDOW
+//=============================================================================
+
+static inline u64 view_end (Preview *preview) {
+	return preview->view.offset + preview->view.length;
+}
+
+// keeps PREVIEW_WINDOW_MARGIN bytes mapped on both sides of offset
+static bool ensure_window (Preview *preview, u64 offset) {
+	u64 size = preview->mapped.size;
+	bool has_before = offset - preview->view.offset >= xtd_min(offset, (u64) PREVIEW_WINDOW_MARGIN);
+	bool has_after = view_end(preview) - offset >= xtd_min(size - offset, (u64) PREVIEW_WINDOW_MARGIN);
+
+	if (preview->view.base && offset >= preview->view.offset && offset <= view_end(preview) && has_before && has_after) {
+		return true;
+	}
+
+	u64 start = (offset > PREVIEW_WINDOW_SIZE / 2) ? offset - PREVIEW_WINDOW_SIZE / 2 : 0;
+	return mapped_view_map(&preview->mapped, &preview->view, start, PREVIEW_WINDOW_SIZE, MAPPED_ACCESS_RANDOM);
+}
+
+static inline const u8 *window_at (Preview *preview, u64 offset) {
+	return preview->view.data + (offset - preview->view.offset);
+}
+
+// start of the line after the one beginning at offset, or the file size
+static u64 next_line_start (Preview *preview, u64 offset) {
+	if (offset >= preview->mapped.size || !ensure_window(preview, offset)) {
+		return preview->mapped.size;
+	}
+	const u8 *newline = bytes_find(window_at(preview, offset), view_end(preview) - offset, '\n');
+	if (!newline) {
+		// no newline left in the file, or a line longer than the window margin
+		return view_end(preview);
+	}
+	return preview->view.offset + (u64) (newline - preview->view.data) + 1;
+}
+
+// start of the line before the one beginning at offset
+static u64 previous_line_start (Preview *preview, u64 offset) {
+	if (offset == 0 || !ensure_window(preview, offset)) {
+		return 0;
+	}
+	// skip the newline that terminates the previous line
+	u64 search_end = offset - 1;
+	const u8 *newline = bytes_find_last(window_at(preview, preview->view.offset), search_end - preview->view.offset, '\n');
+	if (!newline) {
+		return preview->view.offset;
+	}
+	return preview->view.offset + (u64) (newline - preview->view.data) + 1;
+}
+
+//=============================================================================
+// PREVIEW
+//=============================================================================
+
+void preview_init (Preview *preview, JobQueue *job_queue) {
+	SDL_memset(preview, 0, sizeof(*preview));
+	preview->job_queue = job_queue;
+}
+
+bool preview_open (Preview *preview, File *file) {
+	preview_close(preview);
+
+	if (!mapped_file_open(&preview->mapped, file->path)) {
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to open %s for preview", file->path);
+		return false;
+	}
+	preview->file = file;
+	preview->is_open = true;
+	preview->anchor = 0;
+	preview->anchor_line_known = false;
+
+	PreviewLineIndex *index = SDL_calloc(1, sizeof(PreviewLineIndex));
+	index->mutex = SDL_CreateMutex();
+	index->path = SDL_strdup(file->path);
+	SDL_SetAtomicInt(&index->references, 2);	// the preview and the job
+	push_checkpoint(index, (PreviewCheckpoint) { 0, 0 });
+	preview->index = index;
+
+	job_queue_push(preview->job_queue, index_lines_job, index, JOB_PRIORITY_LOW);
+	return true;
+}
+
+void preview_close (Preview *preview) {
+	if (!preview->is_open) {
+		return;
+	}
+	SDL_SetAtomicInt(&preview->index->cancelled, 1);
+	release_index(preview->index);
+	preview->index = NULL;
+
+	mapped_view_unmap(&preview->view);
+	mapped_file_close(&preview->mapped);
+	preview->file = NULL;
+	preview->is_open = false;
+	preview->num_lines = 0;
+}
+
+void preview_scroll_lines (Preview *preview, i32 num_lines) {
+	if (!preview->is_open) return;
+
+	for (; num_lines > 0; num_lines--) {
+		u64 next = next_line_start(preview, preview->anchor);
+		if (next >= preview->mapped.size) break;
+		preview->anchor = next;
+	}
+	for (; num_lines < 0 && preview->anchor > 0; num_lines++) {
+		preview->anchor = previous_line_start(preview, preview->anchor);
+	}
+}
+
+void preview_scroll_wheel (Preview *preview, f32 wheel_delta) {
+	preview->wheel_remainder -= wheel_delta * PREVIEW_WHEEL_LINES;
+	i32 whole_lines = (i32) preview->wheel_remainder;
+	preview->wheel_remainder -= (f32) whole_lines;
+	preview_scroll_lines(preview, whole_lines);
+}
+
+void preview_jump_to_start (Preview *preview) {
+	preview->anchor = 0;
+}
+
+void preview_jump_to_end (Preview *preview) {
+	if (!preview->is_open) return;
+
+	preview->anchor = preview->mapped.size;
+	u32 num_lines = xtd_max(preview->max_visible_lines, 1u);
+	for (u32 i = 0; i < num_lines && preview->anchor > 0; i++) {
+		preview->anchor = previous_line_start(preview, preview->anchor);
+	}
+}
+
+// line number of the anchor from the nearest checkpoint at or before it, at
+// most PREVIEW_CHECKPOINT_BYTES back once the index has got that far
+static void update_anchor_line (Preview *preview) {
+	if (preview->anchor_line_known && preview->anchor_line_for == preview->anchor) {
+		return;
+	}
+	preview->anchor_line_known = false;
+
+	PreviewLineIndex *index = preview->index;
+	u64 checkpoint_offset = 0;
+	u64 checkpoint_line = 0;
+
+	SDL_LockMutex(index->mutex);
+	bool covered = index->complete || index->bytes_indexed >= preview->anchor;
+	if (covered) {
+		u32 low = 0, high = index->num_checkpoints;
+		while (high - low > 1) {
+			u32 middle = (low + high) / 2;
+			if (index->checkpoints[middle].offset <= preview->anchor) low = middle;
+			else high = middle;
+		}
+		checkpoint_offset = index->checkpoints[low].offset;
+		checkpoint_line = index->checkpoints[low].line;
+	}
+	SDL_UnlockMutex(index->mutex);
+
+	if (!covered) {
+		return;
+	}
+
+	MappedView view = {0};
+	u64 distance = preview->anchor - checkpoint_offset;
+	if (distance > 0 && !mapped_view_map(&preview->mapped, &view, checkpoint_offset, distance, MAPPED_ACCESS_SEQUENTIAL)) {
+		return;
+	}
+	preview->anchor_line = checkpoint_line + (distance ? bytes_count(view.data, view.length, '\n') : 0);
+	mapped_view_unmap(&view);
+
+	preview->anchor_line_known = true;
+	preview->anchor_line_for = preview->anchor;
+}
+
+void preview_update (Preview *preview, u32 max_visible_lines) {
+	preview->max_visible_lines = xtd_min(max_visible_lines, (u32) PREVIEW_MAX_LINES);
+	preview->num_lines = 0;
+	if (!preview->is_open) {
+		return;
+	}
+
+	// lines point into the window, so it is placed once and must not move again before render
+	if (!ensure_window(preview, preview->anchor)) {
+		SDL_snprintf(preview->status, sizeof(preview->status), "Failed to map file");
+		return;
+	}
+
+	u64 offset = preview->anchor;
+	while (preview->num_lines < preview->max_visible_lines && offset < view_end(preview)) {
+		const char *chars = (const char *) window_at(preview, offset);
+		const u8 *newline = bytes_find((const u8 *) chars, view_end(preview) - offset, '\n');
+		u64 next = newline ? preview->view.offset + (u64) (newline - preview->view.data) + 1 : view_end(preview);
+
+		u64 length = next - offset;
+		while (length > 0 && (chars[length - 1] == '\n' || chars[length - 1] == '\r')) {
+			length--;
+		}
+
+		preview->lines[preview->num_lines++] = (Clay_String) {
+			.isStaticallyAllocated = false,
+			.length = (i32) xtd_min(length, (u64) PREVIEW_MAX_LINE_BYTES),
+			.chars = chars,
+		};
+		offset = next;
+	}
+
+	update_anchor_line(preview);
+
+	SDL_LockMutex(preview->index->mutex);
+	u64 total_lines = preview->index->num_lines;
+	bool complete = preview->index->complete;
+	f64 progress = preview->mapped.size ? (f64) preview->index->bytes_indexed / preview->mapped.size : 1.0;
+	SDL_UnlockMutex(preview->index->mutex);
+
+	if (preview->anchor_line_known && complete) {
+		SDL_snprintf(preview->status, sizeof(preview->status), "Line %llu of %llu",
+			(unsigned long long) preview->anchor_line + 1, (unsigned long long) total_lines);
+	} else if (preview->anchor_line_known) {
+		SDL_snprintf(preview->status, sizeof(preview->status), "Line %llu (indexing %.0f%%)",
+			(unsigned long long) preview->anchor_line + 1, progress * 100.0);
+	} else {
+		SDL_snprintf(preview->status, sizeof(preview->status), "Indexing %.0f%%", progress * 100.0);
+	}
+}
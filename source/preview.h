@@ -0,0 +1,96 @@
+#ifndef PREVIEW_H
+#define PREVIEW_H
+
+#include "xtdlib.h"
+
+#include <SDL3/SDL.h>
+
+#include "clay.h"
+#include "file_map.h"
+#include "job.h"
+#include "ui.h"
+
+//=============================================================================
+// FILE PREVIEW
+//=============================================================================
+
+// Shows the text of the selected file without ever reading it whole. The
+// viewport is addressed by the byte offset of its first line (the anchor):
+// scrolling walks newlines forwards or backwards from the anchor inside a
+// mapped window that follows it, so jumping to the end of a 10 GB file costs
+// one remap and a backwards scan of a few lines.
+//
+// Line numbers come from a sparse index built on a background job: it maps
+// the file window by window, counts newlines with bytes_count and records a
+// checkpoint every PREVIEW_CHECKPOINT_LINES lines, or sooner once
+// PREVIEW_CHECKPOINT_BYTES have gone by, so a file of few, long lines is
+// covered as densely. The UI thread numbers the anchor by counting from the
+// checkpoint before it, never more than PREVIEW_CHECKPOINT_BYTES. Resident
+// memory is bounded by the two windows, whatever the file size.
+
+#define PREVIEW_WINDOW_SIZE        (8ull << 20)
+#define PREVIEW_WINDOW_MARGIN      (PREVIEW_WINDOW_SIZE / 4)
+#define PREVIEW_INDEX_WINDOW_SIZE  (16ull << 20)
+#define PREVIEW_INDEX_BLOCK_SIZE   (64u << 10)
+#define PREVIEW_CHECKPOINT_LINES   4096
+#define PREVIEW_CHECKPOINT_BYTES   (1u << 20)
+#define PREVIEW_MAX_LINES          128
+#define PREVIEW_MAX_LINE_BYTES     512
+#define PREVIEW_LINE_HEIGHT        18
+#define PREVIEW_FONT_SIZE          14
+#define PREVIEW_WHEEL_LINES        3
+
+typedef struct PreviewCheckpoint {
+	u64 offset;
+	u64 line;			// lines before offset
+} PreviewCheckpoint;
+
+typedef struct PreviewLineIndex {
+	SDL_AtomicInt references;
+	SDL_AtomicInt cancelled;
+	SDL_Mutex *mutex;
+	char *path;
+
+	// guarded by mutex
+	PreviewCheckpoint *checkpoints;
+	u32 num_checkpoints;
+	u32 checkpoints_capacity;
+	u64 bytes_indexed;
+	u64 num_lines;
+	bool complete;
+} PreviewLineIndex;
+
+typedef struct Preview {
+	File *file;
+	MappedFile mapped;
+	MappedView view;
+	bool is_open;
+
+	u64 anchor;
+	u64 anchor_line;
+	bool anchor_line_known;
+	u64 anchor_line_for;
+	f32 wheel_remainder;
+
+	u32 max_visible_lines;
+	Clay_String lines[PREVIEW_MAX_LINES];
+	u32 num_lines;
+	char status[64];
+
+	JobQueue *job_queue;
+	PreviewLineIndex *index;
+} Preview;
+
+void preview_init (Preview *preview, JobQueue *job_queue);
+bool preview_open (Preview *preview, File *file);
+void preview_close (Preview *preview);
+
+void preview_scroll_lines (Preview *preview, i32 num_lines);
+void preview_scroll_wheel (Preview *preview, f32 wheel_delta);
+void preview_jump_to_start (Preview *preview);
+void preview_jump_to_end (Preview *preview);
+
+// gathers the visible lines for this frame's layout; call on the UI thread before layout
+void preview_update (Preview *preview, u32 max_visible_lines);
+
+#endif // PREVIEW_H
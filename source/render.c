@@ -2,6 +2,11 @@
 
 #define CLAY_COLOR_TO_SDL_COLOR(color) {(color).r / 255.f, (color).g / 255.f, (color).b / 255.f, (color).a / 255.f};
 
+static const char *backend_names[NUM_RENDER_BACKENDS] = {
+	[RENDER_BACKEND_SDL] = "sdl",
+	[RENDER_BACKEND_GL]  = "gl",
+};
+
 //=============================================================================
 // HELPERS
 //=============================================================================
@@ -278,7 +283,43 @@ void render_text (f32 x_position, f32 y_position, TTF_TextEngine *text_engine, T
 // RENDER COMMAND DISPATCH
 //=============================================================================
 
+const char *render_backend_name (RenderBackend backend) {
+	return backend < NUM_RENDER_BACKENDS ? backend_names[backend] : "unknown";
+}
+
+void render_clear (RenderContext *render_context) {
+	if (render_context->backend == RENDER_BACKEND_GL) {
+		gl_render_begin_frame(render_context->gl);
+		return;
+	}
+	SDL_SetRenderDrawColor(render_context->renderer, 0, 0, 0, 0);
+	SDL_RenderClear(render_context->renderer);
+}
+
+void render_present (RenderContext *render_context) {
+	if (render_context->backend == RENDER_BACKEND_GL) {
+		gl_render_present(render_context->gl);
+		return;
+	}
+	SDL_RenderPresent(render_context->renderer);
+}
+
+void render_finish (RenderContext *render_context) {
+	if (render_context->backend == RENDER_BACKEND_GL) {
+		gl_render_finish(render_context->gl);
+		return;
+	}
+	// reading a pixel back waits for the renderer to catch up
+	SDL_Surface *pixel = SDL_RenderReadPixels(render_context->renderer, &(SDL_Rect) { 0, 0, 1, 1 });
+	if (pixel) SDL_DestroySurface(pixel);
+}
+
 void render_clay_commands (RenderContext *render_context, Clay_RenderCommandArray *render_commands) {
+	if (render_context->backend == RENDER_BACKEND_GL) {
+		render_context->num_draw_calls = gl_render_clay_commands(render_context->gl, render_context->fonts, render_commands);
+		return;
+	}
+	render_context->num_draw_calls = 0;
     for (i32 i = 0; i < render_commands->length; i++) {
         Clay_RenderCommand *render_command = Clay_RenderCommandArray_Get(render_commands, i);
         
@@ -290,6 +331,11 @@ void render_clay_commands (RenderContext *render_context, Clay_RenderCommandArra
             (i32) bounding_box.height
         };
 
+		if (render_command->commandType != CLAY_RENDER_COMMAND_TYPE_SCISSOR_START &&
+			render_command->commandType != CLAY_RENDER_COMMAND_TYPE_SCISSOR_END) {
+			render_context->num_draw_calls++;
+		}
+
         switch (render_command->commandType) {
 		case CLAY_RENDER_COMMAND_TYPE_RECTANGLE: {
 			Clay_RectangleRenderData *config = &render_command->renderData.rectangle; 
@@ -328,3 +374,55 @@ void render_clay_commands (RenderContext *render_context, Clay_RenderCommandArra
         } // switch end
     }
 }
+
+//=============================================================================
+// FRAME HASHING
+//=============================================================================
+
+static u64 hash_bytes (u64 hash, const void *data, size_t length) {
+	const u8 *bytes = data;
+	for (size_t i = 0; i < length; i++) {
+		hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+	}
+	return hash;
+}
+
+#define HASH_FIELD(hash, field) hash_bytes((hash), &(field), sizeof(field))
+
+// Only the fields that reach the screen are hashed, field by field, so union
+// padding never counts. Text is hashed by content: labels are rewritten in
+// place in the same buffers, so pointer and length alone would miss changes
+u64 render_commands_hash (Clay_RenderCommandArray *render_commands) {
+	u64 hash = 0xcbf29ce484222325ull;
+	for (i32 i = 0; i < render_commands->length; i++) {
+		Clay_RenderCommand *command = Clay_RenderCommandArray_Get(render_commands, i);
+		Clay_RenderData *data = &command->renderData;
+		hash = HASH_FIELD(hash, command->commandType);
+		hash = HASH_FIELD(hash, command->boundingBox);
+
+		switch (command->commandType) {
+		case CLAY_RENDER_COMMAND_TYPE_RECTANGLE:
+			hash = HASH_FIELD(hash, data->rectangle.backgroundColor);
+			hash = HASH_FIELD(hash, data->rectangle.cornerRadius);
+			break;
+		case CLAY_RENDER_COMMAND_TYPE_BORDER:
+			hash = HASH_FIELD(hash, data->border.color);
+			hash = HASH_FIELD(hash, data->border.cornerRadius);
+			hash = HASH_FIELD(hash, data->border.width);
+			break;
+		case CLAY_RENDER_COMMAND_TYPE_TEXT:
+			hash = hash_bytes(hash, data->text.stringContents.chars, (size_t) data->text.stringContents.length);
+			hash = HASH_FIELD(hash, data->text.stringContents.length);
+			hash = HASH_FIELD(hash, data->text.textColor);
+			hash = HASH_FIELD(hash, data->text.fontId);
+			hash = HASH_FIELD(hash, data->text.fontSize);
+			break;
+		case CLAY_RENDER_COMMAND_TYPE_IMAGE:
+			hash = HASH_FIELD(hash, data->image.imageData);
+			break;
+		default:
+			break;
+		}
+	}
+	return hash;
+}
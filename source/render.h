@@ -9,14 +9,26 @@
 #include <SDL3_image/SDL_image.h>
 
 #include "clay.h"
+#include "render_gl.h"
 
 #define NUM_CIRCLE_SEGMENTS 32
 
+// what draws the render commands, picked once at startup. Both draw into the
+// same window; the OpenGL backend still uses the SDL_Renderer's textures
+typedef enum RenderBackend {
+	RENDER_BACKEND_SDL,
+	RENDER_BACKEND_GL,
+	NUM_RENDER_BACKENDS
+} RenderBackend;
+
 typedef struct {
     SDL_Renderer *renderer;
     SDL_GLContext gl_context;
 	TTF_TextEngine *text_engine;
     TTF_Font **fonts;
+	RenderBackend backend;
+	GlRenderer *gl;
+	u32 num_draw_calls;		// by the last render_clay_commands; one per drawing command for SDL_Renderer
 } RenderContext;
 
 static SDL_Rect currentClippingRectangle;
@@ -32,6 +44,17 @@ void render_text (f32 x_position, f32 y_position, TTF_TextEngine *text_engine, T
 
 void render_border (SDL_Renderer *renderer, const SDL_FRect rect, const Clay_BorderWidth width, const Clay_CornerRadius corner_radius, const Clay_Color color);
 
+const char *render_backend_name (RenderBackend backend);
+
+// a frame is render_clear, render_clay_commands, then render_present
+void render_clear (RenderContext *render_context);
 void render_clay_commands (RenderContext *render_context, Clay_RenderCommandArray *rcommands);
+void render_present (RenderContext *render_context);
+
+// waits until everything submitted so far has been drawn
+void render_finish (RenderContext *render_context);
+
+// changes whenever anything the commands would draw changes
+u64 render_commands_hash (Clay_RenderCommandArray *render_commands);
 
 #endif // RENDER_H
@@ -0,0 +1,627 @@
+#include "render_gl.h"
+
+#include <SDL3/SDL_opengl.h>
+
+//=============================================================================
+// OPENGL FUNCTIONS
+//=============================================================================
+
+// everything is loaded through SDL_GL_GetProcAddress, so nothing links against libGL
+#define GL_FUNCTIONS(X) \
+	X(void,   Clear,                   (GLbitfield mask)) \
+	X(void,   ClearColor,              (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)) \
+	X(void,   Viewport,                (GLint x, GLint y, GLsizei width, GLsizei height)) \
+	X(void,   Scissor,                 (GLint x, GLint y, GLsizei width, GLsizei height)) \
+	X(void,   Enable,                  (GLenum capability)) \
+	X(void,   Disable,                 (GLenum capability)) \
+	X(void,   BlendFuncSeparate,       (GLenum source_rgb, GLenum destination_rgb, GLenum source_alpha, GLenum destination_alpha)) \
+	X(void,   Flush,                   (void)) \
+	X(void,   Finish,                  (void)) \
+	X(void,   PixelStorei,             (GLenum name, GLint value)) \
+	X(void,   GenTextures,             (GLsizei count, GLuint *textures)) \
+	X(void,   DeleteTextures,          (GLsizei count, const GLuint *textures)) \
+	X(void,   ActiveTexture,           (GLenum unit)) \
+	X(void,   BindTexture,             (GLenum target, GLuint texture)) \
+	X(void,   TexParameteri,           (GLenum target, GLenum name, GLint value)) \
+	X(void,   TexImage2D,              (GLenum target, GLint level, GLint internal_format, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels)) \
+	X(void,   TexSubImage2D,           (GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels)) \
+	X(GLuint, CreateShader,            (GLenum type)) \
+	X(void,   ShaderSource,            (GLuint shader, GLsizei count, const GLchar *const *strings, const GLint *lengths)) \
+	X(void,   CompileShader,           (GLuint shader)) \
+	X(void,   GetShaderiv,             (GLuint shader, GLenum name, GLint *value)) \
+	X(void,   GetShaderInfoLog,        (GLuint shader, GLsizei capacity, GLsizei *length, GLchar *log)) \
+	X(void,   DeleteShader,            (GLuint shader)) \
+	X(GLuint, CreateProgram,           (void)) \
+	X(void,   AttachShader,            (GLuint program, GLuint shader)) \
+	X(void,   LinkProgram,             (GLuint program)) \
+	X(void,   GetProgramiv,            (GLuint program, GLenum name, GLint *value)) \
+	X(void,   GetProgramInfoLog,       (GLuint program, GLsizei capacity, GLsizei *length, GLchar *log)) \
+	X(void,   DeleteProgram,           (GLuint program)) \
+	X(void,   UseProgram,              (GLuint program)) \
+	X(GLint,  GetUniformLocation,      (GLuint program, const GLchar *name)) \
+	X(void,   Uniform1i,               (GLint location, GLint value)) \
+	X(void,   Uniform2f,               (GLint location, GLfloat x, GLfloat y)) \
+	X(void,   GenVertexArrays,         (GLsizei count, GLuint *arrays)) \
+	X(void,   DeleteVertexArrays,      (GLsizei count, const GLuint *arrays)) \
+	X(void,   BindVertexArray,         (GLuint array)) \
+	X(void,   GenBuffers,              (GLsizei count, GLuint *buffers)) \
+	X(void,   DeleteBuffers,           (GLsizei count, const GLuint *buffers)) \
+	X(void,   BindBuffer,              (GLenum target, GLuint buffer)) \
+	X(void,   BufferData,              (GLenum target, GLsizeiptr size, const void *data, GLenum usage)) \
+	X(void,   EnableVertexAttribArray, (GLuint index)) \
+	X(void,   VertexAttribPointer,     (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *offset)) \
+	X(void,   VertexAttribDivisor,     (GLuint index, GLuint divisor)) \
+	X(void,   DrawArraysInstanced,     (GLenum mode, GLint first, GLsizei count, GLsizei instance_count))
+
+typedef struct GlApi {
+#define GL_API_MEMBER(ret, name, params) ret (APIENTRY *name) params;
+	GL_FUNCTIONS(GL_API_MEMBER)
+#undef GL_API_MEMBER
+} GlApi;
+
+static bool load_api (GlApi *api) {
+#define GL_API_LOAD(ret, name, params) \
+	api->name = (ret (APIENTRY *) params) SDL_GL_GetProcAddress("gl" #name); \
+	if (!api->name) { \
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "OpenGL function gl%s is missing", #name); \
+		return false; \
+	}
+	GL_FUNCTIONS(GL_API_LOAD)
+#undef GL_API_LOAD
+	return true;
+}
+
+//=============================================================================
+// SHADERS
+//=============================================================================
+
+// what an instance draws; the shaders below use the same numbers
+typedef enum InstanceKind {
+	INSTANCE_FILL,
+	INSTANCE_BORDER,
+	INSTANCE_IMAGE,
+	INSTANCE_TEXT,
+} InstanceKind;
+
+// one primitive, read by the vertex shader once per quad
+typedef struct GlInstance {
+	f32 rect[4];		// x, y, width, height in pixels
+	f32 radii[4];		// top left, top right, bottom right, bottom left
+	f32 border[4];		// left, right, top, bottom widths
+	f32 color[4];		// straight alpha
+	f32 uv[4];			// left, top, right, bottom of the sampled texture
+	f32 kind;
+} GlInstance;
+
+static const char *vertex_shader_source =
+	"#version 330 core\n"
+	"layout(location = 0) in vec4 a_rect;\n"
+	"layout(location = 1) in vec4 a_radii;\n"
+	"layout(location = 2) in vec4 a_border;\n"
+	"layout(location = 3) in vec4 a_color;\n"
+	"layout(location = 4) in vec4 a_uv;\n"
+	"layout(location = 5) in float a_kind;\n"
+	"uniform vec2 u_viewport;\n"
+	"out vec2 v_local;\n"
+	"flat out vec4 v_rect;\n"
+	"flat out vec4 v_radii;\n"
+	"flat out vec4 v_border;\n"
+	"flat out vec4 v_color;\n"
+	"flat out vec4 v_uv;\n"
+	"flat out int v_kind;\n"
+	"void main () {\n"
+	"	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+	"	// a pixel of margin so anti-aliased edges are not cut off\n"
+	"	vec2 position = a_rect.xy - 1.0 + corner * (a_rect.zw + 2.0);\n"
+	"	v_local = position - a_rect.xy;\n"
+	"	v_rect = a_rect;\n"
+	"	v_radii = a_radii;\n"
+	"	v_border = a_border;\n"
+	"	v_color = a_color;\n"
+	"	v_uv = a_uv;\n"
+	"	v_kind = int(a_kind + 0.5);\n"
+	"	vec2 ndc = position / u_viewport * 2.0 - 1.0;\n"
+	"	gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);\n"
+	"}\n";
+
+static const char *fragment_shader_source =
+	"#version 330 core\n"
+	"in vec2 v_local;\n"
+	"flat in vec4 v_rect;\n"
+	"flat in vec4 v_radii;\n"
+	"flat in vec4 v_border;\n"
+	"flat in vec4 v_color;\n"
+	"flat in vec4 v_uv;\n"
+	"flat in int v_kind;\n"
+	"uniform sampler2D u_image;\n"
+	"uniform sampler2D u_atlas;\n"
+	"out vec4 out_color;\n"
+	"\n"
+	"// radii are top left, top right, bottom right, bottom left; y points down\n"
+	"float corner_radius (vec2 p, vec4 radii) {\n"
+	"	if (p.x < 0.0) return p.y < 0.0 ? radii.x : radii.w;\n"
+	"	return p.y < 0.0 ? radii.y : radii.z;\n"
+	"}\n"
+	"\n"
+	"// signed distance from p to a rounded box of half_size centered on the origin\n"
+	"float rounded_box (vec2 p, vec2 half_size, vec4 radii) {\n"
+	"	float r = corner_radius(p, radii);\n"
+	"	vec2 q = abs(p) - half_size + r;\n"
+	"	return min(max(q.x, q.y), 0.0) + length(max(q, 0.0)) - r;\n"
+	"}\n"
+	"\n"
+	"void main () {\n"
+	"	vec2 half_size = v_rect.zw * 0.5;\n"
+	"	float coverage = clamp(0.5 - rounded_box(v_local - half_size, half_size, v_radii), 0.0, 1.0);\n"
+	"	vec4 color = v_color;\n"
+	"	if (v_kind == 1) {\n"
+	"		// the border is the box minus the box inset by each side's width\n"
+	"		vec2 inner_min = v_border.xz;\n"
+	"		vec2 inner_max = v_rect.zw - v_border.yw;\n"
+	"		vec2 inner_half = max(inner_max - inner_min, 0.0) * 0.5;\n"
+	"		vec4 inset = vec4(max(v_border.x, v_border.z), max(v_border.y, v_border.z),\n"
+	"			max(v_border.y, v_border.w), max(v_border.x, v_border.w));\n"
+	"		float inner = rounded_box(v_local - (inner_min + inner_max) * 0.5, inner_half, max(v_radii - inset, 0.0));\n"
+	"		coverage *= clamp(0.5 + inner, 0.0, 1.0);\n"
+	"	}\n"
+	"	else if (v_kind >= 2) {\n"
+	"		vec2 uv = mix(v_uv.xy, v_uv.zw, v_local / v_rect.zw);\n"
+	"		if (v_kind == 2) color *= textureLod(u_image, uv, 0.0);\n"
+	"		else color.a *= textureLod(u_atlas, uv, 0.0).r;\n"
+	"	}\n"
+	"	out_color = vec4(color.rgb, color.a * coverage);\n"
+	"}\n";
+
+//=============================================================================
+// RENDERER STATE
+//=============================================================================
+
+// a string rendered into the atlas, keyed by font, size and contents
+typedef struct GlTextEntry {
+	u64 key;			// 0 marks an empty slot
+	u16 x, y;
+	u16 width, height;
+} GlTextEntry;
+
+struct GlRenderer {
+	GlApi api;
+	bool api_loaded;
+	SDL_Window *window;
+	SDL_GLContext context;
+	SDL_Renderer *renderer;
+	i32 width, height;
+
+	GLuint program;
+	GLint viewport_location;
+	GLuint vertex_array;
+	GLuint instance_buffer;
+
+	GlInstance instances[GL_BATCH_CAPACITY];
+	u32 num_instances;
+	GLuint batch_image;		// the image texture bound for the current batch
+	u32 num_draw_calls;
+	bool warned_image;
+
+	// strings are packed left to right in shelves as tall as their tallest
+	// string; a full atlas is cleared and refilled
+	GLuint atlas;
+	GlTextEntry *text_entries;
+	u32 num_text_entries;
+	u32 shelf_x, shelf_y, shelf_height;
+	u8 *text_pixels;
+	u32 text_pixels_capacity;
+};
+
+static GLuint compile_shader (GlApi *api, GLenum type, const char *source) {
+	GLuint shader = api->CreateShader(type);
+	api->ShaderSource(shader, 1, &source, NULL);
+	api->CompileShader(shader);
+
+	GLint compiled = 0;
+	api->GetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+	if (!compiled) {
+		char log[1024];
+		api->GetShaderInfoLog(shader, sizeof(log), NULL, log);
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to compile shader: %s", log);
+		api->DeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+static bool create_program (GlRenderer *gl) {
+	GlApi *api = &gl->api;
+	GLuint vertex_shader = compile_shader(api, GL_VERTEX_SHADER, vertex_shader_source);
+	GLuint fragment_shader = compile_shader(api, GL_FRAGMENT_SHADER, fragment_shader_source);
+	if (!vertex_shader || !fragment_shader) {
+		if (vertex_shader) api->DeleteShader(vertex_shader);
+		if (fragment_shader) api->DeleteShader(fragment_shader);
+		return false;
+	}
+
+	gl->program = api->CreateProgram();
+	api->AttachShader(gl->program, vertex_shader);
+	api->AttachShader(gl->program, fragment_shader);
+	api->LinkProgram(gl->program);
+	api->DeleteShader(vertex_shader);
+	api->DeleteShader(fragment_shader);
+
+	GLint linked = 0;
+	api->GetProgramiv(gl->program, GL_LINK_STATUS, &linked);
+	if (!linked) {
+		char log[1024];
+		api->GetProgramInfoLog(gl->program, sizeof(log), NULL, log);
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to link shader program: %s", log);
+		return false;
+	}
+
+	api->UseProgram(gl->program);
+	gl->viewport_location = api->GetUniformLocation(gl->program, "u_viewport");
+	api->Uniform1i(api->GetUniformLocation(gl->program, "u_image"), 0);
+	api->Uniform1i(api->GetUniformLocation(gl->program, "u_atlas"), 1);
+	return true;
+}
+
+// the quad's four corners come from gl_VertexID; every attribute is per instance
+static void create_instance_buffer (GlRenderer *gl) {
+	static const struct { GLint size; size_t offset; } attributes[] = {
+		{ 4, offsetof(GlInstance, rect) },
+		{ 4, offsetof(GlInstance, radii) },
+		{ 4, offsetof(GlInstance, border) },
+		{ 4, offsetof(GlInstance, color) },
+		{ 4, offsetof(GlInstance, uv) },
+		{ 1, offsetof(GlInstance, kind) },
+	};
+
+	GlApi *api = &gl->api;
+	api->GenVertexArrays(1, &gl->vertex_array);
+	api->BindVertexArray(gl->vertex_array);
+	api->GenBuffers(1, &gl->instance_buffer);
+	api->BindBuffer(GL_ARRAY_BUFFER, gl->instance_buffer);
+	for (GLuint i = 0; i < SDL_arraysize(attributes); i++) {
+		api->EnableVertexAttribArray(i);
+		api->VertexAttribPointer(i, attributes[i].size, GL_FLOAT, GL_FALSE, sizeof(GlInstance), (const void *) attributes[i].offset);
+		api->VertexAttribDivisor(i, 1);
+	}
+}
+
+static void create_atlas (GlRenderer *gl) {
+	GlApi *api = &gl->api;
+	api->GenTextures(1, &gl->atlas);
+	api->ActiveTexture(GL_TEXTURE1);
+	api->BindTexture(GL_TEXTURE_2D, gl->atlas);
+	api->TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	api->TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	api->TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	api->TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	api->TexImage2D(GL_TEXTURE_2D, 0, GL_R8, GL_TEXT_ATLAS_SIZE, GL_TEXT_ATLAS_SIZE, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+	api->ActiveTexture(GL_TEXTURE0);
+	gl->text_entries = SDL_calloc(GL_TEXT_CACHE_SLOTS, sizeof(GlTextEntry));
+}
+
+//=============================================================================
+// BATCHING
+//=============================================================================
+
+static void flush_batch (GlRenderer *gl) {
+	if (!gl->num_instances) {
+		return;
+	}
+	GlApi *api = &gl->api;
+	api->BufferData(GL_ARRAY_BUFFER, gl->num_instances * sizeof(GlInstance), gl->instances, GL_STREAM_DRAW);
+	api->DrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei) gl->num_instances);
+	gl->num_instances = 0;
+	gl->num_draw_calls++;
+}
+
+// shapes and text join any batch; an image needs its texture bound
+static GlInstance *push_instance (GlRenderer *gl, InstanceKind kind, GLuint image) {
+	if (image && image != gl->batch_image) {
+		flush_batch(gl);
+		gl->api.ActiveTexture(GL_TEXTURE0);
+		gl->api.BindTexture(GL_TEXTURE_2D, image);
+		gl->batch_image = image;
+	}
+	if (gl->num_instances == GL_BATCH_CAPACITY) {
+		flush_batch(gl);
+	}
+	GlInstance *instance = &gl->instances[gl->num_instances++];
+	SDL_zerop(instance);
+	instance->kind = (f32) kind;
+	return instance;
+}
+
+static void set_rect (GlInstance *instance, SDL_FRect rect, Clay_CornerRadius radius) {
+	f32 max_radius = xtd_min(rect.w, rect.h) * 0.5f;
+	instance->rect[0] = rect.x;
+	instance->rect[1] = rect.y;
+	instance->rect[2] = rect.w;
+	instance->rect[3] = rect.h;
+	instance->radii[0] = SDL_clamp(radius.topLeft, 0.0f, max_radius);
+	instance->radii[1] = SDL_clamp(radius.topRight, 0.0f, max_radius);
+	instance->radii[2] = SDL_clamp(radius.bottomRight, 0.0f, max_radius);
+	instance->radii[3] = SDL_clamp(radius.bottomLeft, 0.0f, max_radius);
+}
+
+static void set_color (GlInstance *instance, Clay_Color color) {
+	instance->color[0] = color.r / 255.0f;
+	instance->color[1] = color.g / 255.0f;
+	instance->color[2] = color.b / 255.0f;
+	instance->color[3] = color.a / 255.0f;
+}
+
+//=============================================================================
+// TEXT ATLAS
+//=============================================================================
+
+static u64 text_key (u16 font_id, u16 font_size, const char *chars, i32 length) {
+	u64 hash = 0xcbf29ce484222325ull;
+	hash = (hash ^ font_id) * 0x100000001b3ull;
+	hash = (hash ^ font_size) * 0x100000001b3ull;
+	for (i32 i = 0; i < length; i++) {
+		hash = (hash ^ (u8) chars[i]) * 0x100000001b3ull;
+	}
+	return hash ? hash : 1;
+}
+
+static GlTextEntry *find_text_slot (GlRenderer *gl, u64 key) {
+	u32 slot = (u32) key & (GL_TEXT_CACHE_SLOTS - 1);
+	while (gl->text_entries[slot].key && gl->text_entries[slot].key != key) {
+		slot = (slot + 1) & (GL_TEXT_CACHE_SLOTS - 1);
+	}
+	return &gl->text_entries[slot];
+}
+
+// instances already queued sample the old contents, so they are drawn first
+static void reset_text_atlas (GlRenderer *gl) {
+	flush_batch(gl);
+	SDL_memset(gl->text_entries, 0, GL_TEXT_CACHE_SLOTS * sizeof(GlTextEntry));
+	gl->num_text_entries = 0;
+	gl->shelf_x = gl->shelf_y = gl->shelf_height = 0;
+}
+
+static bool allocate_text_space (GlRenderer *gl, u32 width, u32 height, u32 *x, u32 *y) {
+	if (gl->shelf_x + width > GL_TEXT_ATLAS_SIZE) {
+		gl->shelf_x = 0;
+		gl->shelf_y += gl->shelf_height + 1;
+		gl->shelf_height = 0;
+	}
+	if (gl->shelf_y + height > GL_TEXT_ATLAS_SIZE) {
+		return false;
+	}
+	*x = gl->shelf_x;
+	*y = gl->shelf_y;
+	gl->shelf_x += width + 1;
+	gl->shelf_height = xtd_max(gl->shelf_height, height);
+	return true;
+}
+
+// the string's coverage in the atlas, rendering it on first use
+static GlTextEntry *cached_text (GlRenderer *gl, TTF_Font *font, Clay_TextRenderData *text) {
+	u64 key = text_key(text->fontId, text->fontSize, text->stringContents.chars, text->stringContents.length);
+	GlTextEntry *entry = find_text_slot(gl, key);
+	if (entry->key) {
+		return entry;
+	}
+
+	TTF_SetFontSize(font, text->fontSize);
+	SDL_Surface *surface = TTF_RenderText_Blended(font, text->stringContents.chars, (size_t) text->stringContents.length, (SDL_Color) { 255, 255, 255, 255 });
+	if (!surface) {
+		return NULL;
+	}
+	u32 width = (u32) xtd_min(surface->w, GL_TEXT_ATLAS_SIZE);
+	u32 height = (u32) xtd_min(surface->h, GL_TEXT_ATLAS_SIZE);
+
+	u32 x, y;
+	if (gl->num_text_entries >= GL_TEXT_CACHE_SLOTS * 3 / 4 || !allocate_text_space(gl, width, height, &x, &y)) {
+		reset_text_atlas(gl);
+		allocate_text_space(gl, width, height, &x, &y);
+		entry = find_text_slot(gl, key);
+	}
+
+	// blended text is white with the coverage in alpha, which is all the atlas keeps
+	if (width * height > gl->text_pixels_capacity) {
+		gl->text_pixels_capacity = width * height;
+		gl->text_pixels = SDL_realloc(gl->text_pixels, gl->text_pixels_capacity);
+	}
+	for (u32 row = 0; row < height; row++) {
+		const u32 *source = (const u32 *) ((const u8 *) surface->pixels + row * surface->pitch);
+		u8 *destination = gl->text_pixels + row * width;
+		for (u32 column = 0; column < width; column++) {
+			destination[column] = (u8) (source[column] >> 24);
+		}
+	}
+	SDL_DestroySurface(surface);
+
+	GlApi *api = &gl->api;
+	api->ActiveTexture(GL_TEXTURE1);
+	api->PixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	api->TexSubImage2D(GL_TEXTURE_2D, 0, (GLint) x, (GLint) y, (GLsizei) width, (GLsizei) height, GL_RED, GL_UNSIGNED_BYTE, gl->text_pixels);
+	api->PixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	api->ActiveTexture(GL_TEXTURE0);
+
+	*entry = (GlTextEntry) { key, (u16) x, (u16) y, (u16) width, (u16) height };
+	gl->num_text_entries++;
+	return entry;
+}
+
+//=============================================================================
+// COMMANDS
+//=============================================================================
+
+static void push_text (GlRenderer *gl, TTF_Font *font, SDL_FRect rect, Clay_TextRenderData *text) {
+	if (text->stringContents.length <= 0) {
+		return;
+	}
+	GlTextEntry *entry = cached_text(gl, font, text);
+	if (!entry) {
+		return;
+	}
+	GlInstance *instance = push_instance(gl, INSTANCE_TEXT, 0);
+	set_rect(instance, (SDL_FRect) { rect.x, rect.y, entry->width, entry->height }, (Clay_CornerRadius) { 0 });
+	set_color(instance, text->textColor);
+	instance->uv[0] = (f32) entry->x / GL_TEXT_ATLAS_SIZE;
+	instance->uv[1] = (f32) entry->y / GL_TEXT_ATLAS_SIZE;
+	instance->uv[2] = (f32) (entry->x + entry->width) / GL_TEXT_ATLAS_SIZE;
+	instance->uv[3] = (f32) (entry->y + entry->height) / GL_TEXT_ATLAS_SIZE;
+}
+
+// images are the SDL_Renderer's textures, sampled through the shared context
+static void push_image (GlRenderer *gl, SDL_FRect rect, Clay_ImageRenderData *image) {
+	SDL_Texture *texture = (SDL_Texture *) image->imageData;
+	if (!texture) {
+		return;
+	}
+	SDL_PropertiesID properties = SDL_GetTextureProperties(texture);
+	GLuint id = (GLuint) SDL_GetNumberProperty(properties, SDL_PROP_TEXTURE_OPENGL_TEXTURE_NUMBER, 0);
+	i64 target = SDL_GetNumberProperty(properties, SDL_PROP_TEXTURE_OPENGL_TEXTURE_TARGET_NUMBER, 0);
+	if (!id || target != GL_TEXTURE_2D) {
+		if (!gl->warned_image) {
+			SDL_LogWarn(SDL_LOG_CATEGORY_RENDER, "Images need an OpenGL SDL_Renderer with 2D textures; skipping them");
+			gl->warned_image = true;
+		}
+		return;
+	}
+
+	GlInstance *instance = push_instance(gl, INSTANCE_IMAGE, id);
+	set_rect(instance, rect, image->cornerRadius);
+	set_color(instance, (Clay_Color) { 255, 255, 255, 255 });
+	// textures padded to a power of two only use part of their extent
+	instance->uv[2] = SDL_GetFloatProperty(properties, SDL_PROP_TEXTURE_OPENGL_TEX_W_FLOAT, 1.0f);
+	instance->uv[3] = SDL_GetFloatProperty(properties, SDL_PROP_TEXTURE_OPENGL_TEX_H_FLOAT, 1.0f);
+}
+
+static void set_scissor (GlRenderer *gl, SDL_FRect rect) {
+	flush_batch(gl);
+	gl->api.Enable(GL_SCISSOR_TEST);
+	gl->api.Scissor((GLint) rect.x, (GLint) (gl->height - (rect.y + rect.h)), (GLsizei) rect.w, (GLsizei) rect.h);
+}
+
+//=============================================================================
+// OPENGL RENDERER
+//=============================================================================
+
+void gl_renderer_destroy (GlRenderer *gl) {
+	if (!gl) {
+		return;
+	}
+	if (gl->api_loaded && SDL_GL_MakeCurrent(gl->window, gl->context)) {
+		GlApi *api = &gl->api;
+		if (gl->atlas) api->DeleteTextures(1, &gl->atlas);
+		if (gl->instance_buffer) api->DeleteBuffers(1, &gl->instance_buffer);
+		if (gl->vertex_array) api->DeleteVertexArrays(1, &gl->vertex_array);
+		if (gl->program) api->DeleteProgram(gl->program);
+	}
+	SDL_free(gl->text_entries);
+	SDL_free(gl->text_pixels);
+	SDL_free(gl);
+}
+
+GlRenderer *gl_renderer_create (SDL_Window *window, SDL_GLContext context, SDL_Renderer *renderer) {
+	if (!context || !SDL_GL_MakeCurrent(window, context)) {
+		return NULL;
+	}
+	GlRenderer *gl = SDL_calloc(1, sizeof(GlRenderer));
+	if (!gl) {
+		return NULL;
+	}
+	gl->window = window;
+	gl->context = context;
+	gl->renderer = renderer;
+
+	gl->api_loaded = load_api(&gl->api);
+	if (!gl->api_loaded || !create_program(gl)) {
+		gl_renderer_destroy(gl);
+		return NULL;
+	}
+	create_instance_buffer(gl);
+	create_atlas(gl);
+
+	// the same blending as SDL_BLENDMODE_BLEND
+	gl->api.Enable(GL_BLEND);
+	gl->api.BlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	return gl;
+}
+
+void gl_render_begin_frame (GlRenderer *gl) {
+	// submit what the SDL_Renderer has queued, including texture uploads,
+	// before another context samples its textures
+	SDL_FlushRenderer(gl->renderer);
+	gl->api.Flush();
+
+	SDL_GL_MakeCurrent(gl->window, gl->context);
+	SDL_GetWindowSizeInPixels(gl->window, &gl->width, &gl->height);
+
+	// render commands are in pixels, as they are for SDL_Renderer
+	GlApi *api = &gl->api;
+	api->Viewport(0, 0, gl->width, gl->height);
+	api->Uniform2f(gl->viewport_location, (f32) gl->width, (f32) gl->height);
+	api->Disable(GL_SCISSOR_TEST);
+	api->ClearColor(0, 0, 0, 0);
+	api->Clear(GL_COLOR_BUFFER_BIT);
+	gl->num_instances = 0;
+	gl->batch_image = 0;
+}
+
+u32 gl_render_clay_commands (GlRenderer *gl, TTF_Font **fonts, Clay_RenderCommandArray *render_commands) {
+	gl->num_draw_calls = 0;
+	for (i32 i = 0; i < render_commands->length; i++) {
+		Clay_RenderCommand *render_command = Clay_RenderCommandArray_Get(render_commands, i);
+		Clay_RenderData *data = &render_command->renderData;
+
+		// truncated like the SDL_Renderer path, so both put edges on the same pixels
+		const Clay_BoundingBox bounding_box = render_command->boundingBox;
+		const SDL_FRect rect = {
+			(i32) bounding_box.x,
+			(i32) bounding_box.y,
+			(i32) bounding_box.width,
+			(i32) bounding_box.height
+		};
+
+		switch (render_command->commandType) {
+		case CLAY_RENDER_COMMAND_TYPE_RECTANGLE: {
+			GlInstance *instance = push_instance(gl, INSTANCE_FILL, 0);
+			set_rect(instance, rect, data->rectangle.cornerRadius);
+			set_color(instance, data->rectangle.backgroundColor);
+			break;
+		}
+		case CLAY_RENDER_COMMAND_TYPE_BORDER: {
+			GlInstance *instance = push_instance(gl, INSTANCE_BORDER, 0);
+			set_rect(instance, rect, data->border.cornerRadius);
+			set_color(instance, data->border.color);
+			instance->border[0] = data->border.width.left;
+			instance->border[1] = data->border.width.right;
+			instance->border[2] = data->border.width.top;
+			instance->border[3] = data->border.width.bottom;
+			break;
+		}
+		case CLAY_RENDER_COMMAND_TYPE_TEXT:
+			push_text(gl, fonts[data->text.fontId], rect, &data->text);
+			break;
+		case CLAY_RENDER_COMMAND_TYPE_IMAGE:
+			push_image(gl, rect, &data->image);
+			break;
+		case CLAY_RENDER_COMMAND_TYPE_SCISSOR_START:
+			set_scissor(gl, rect);
+			break;
+		case CLAY_RENDER_COMMAND_TYPE_SCISSOR_END:
+			flush_batch(gl);
+			gl->api.Disable(GL_SCISSOR_TEST);
+			break;
+		default:
+			SDL_Log("Unknown render command type: %d", render_command->commandType);
+		}
+	}
+	flush_batch(gl);
+	return gl->num_draw_calls;
+}
+
+void gl_render_present (GlRenderer *gl) {
+	flush_batch(gl);
+	SDL_GL_SwapWindow(gl->window);
+}
+
+void gl_render_finish (GlRenderer *gl) {
+	flush_batch(gl);
+	gl->api.Finish();
+}
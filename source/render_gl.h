@@ -0,0 +1,46 @@
+#ifndef RENDER_GL_H
+#define RENDER_GL_H
+
+#include <xtdlib.h>
+
+#include <SDL3/SDL.h>
+#include <SDL3_ttf/SDL_ttf.h>
+
+#include "clay.h"
+
+//=============================================================================
+// OPENGL RENDERER
+//=============================================================================
+
+// Draws render commands as instanced quads, one instance record per command.
+// Rectangles, rounded rectangles and borders are shaded with a signed
+// distance to a rounded box, so corners are anti-aliased per pixel with no
+// tessellation. Text is rendered once per string into a glyph atlas that is
+// sampled by the same shader, so runs of shapes and text are a single draw;
+// only images, which sample the SDL_Renderer's own textures, and scissor
+// changes split a batch. Paint order is kept exactly.
+//
+// Needs OpenGL 3.3 core in a context sharing objects with an OpenGL
+// SDL_Renderer on the same window. Mesa's llvmpipe is enough, so it can run
+// without a GPU (SDL_VIDEO_DRIVER=offscreen).
+
+#define GL_BATCH_CAPACITY       4096
+#define GL_TEXT_ATLAS_SIZE      2048
+#define GL_TEXT_CACHE_SLOTS     4096
+
+typedef struct GlRenderer GlRenderer;
+
+// context must be current and share with renderer's; returns NULL if the
+// driver cannot run the backend
+GlRenderer *gl_renderer_create (SDL_Window *window, SDL_GLContext context, SDL_Renderer *renderer);
+void gl_renderer_destroy (GlRenderer *gl);
+
+void gl_render_begin_frame (GlRenderer *gl);
+// returns the number of draw calls the commands took
+u32 gl_render_clay_commands (GlRenderer *gl, TTF_Font **fonts, Clay_RenderCommandArray *render_commands);
+void gl_render_present (GlRenderer *gl);
+
+// waits until everything submitted so far has been drawn
+void gl_render_finish (GlRenderer *gl);
+
+#endif // RENDER_GL_H
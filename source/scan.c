@@ -0,0 +1,337 @@
+#include "scan.h"
+
+#include "aggregate.h"
+#include "filetype.h"
+
+typedef struct ScanJob {
+	Scanner *scanner;
+	Directory *directory;
+	u32 depth;
+} ScanJob;
+
+// a directory's entries between being listed and being published
+typedef struct ScanListing {
+	Scanner *scanner;
+	Directory *directory;
+	u32 depth;
+
+	ScanStat *entries;
+	u32 num_entries;
+	u32 capacity;
+
+	JobCounter chunks_remaining;
+} ScanListing;
+
+typedef struct ScanChunk {
+	ScanListing *listing;
+	u32 first;
+	u32 count;
+} ScanChunk;
+
+//=============================================================================
+// PATHS
+//=============================================================================
+
+char *join_path (const char *directory_path, const char *name) {
+	size_t directory_length = SDL_strlen(directory_path);
+	size_t name_length = SDL_strlen(name);
+	bool needs_separator = directory_length > 0 &&
+		directory_path[directory_length - 1] != '/' && directory_path[directory_length - 1] != '\\';
+
+	char *path = SDL_malloc(directory_length + needs_separator + name_length + 1);
+	SDL_memcpy(path, directory_path, directory_length);
+	if (needs_separator) {
+		path[directory_length] = PATH_SEPARATOR;
+	}
+	SDL_memcpy(path + directory_length + needs_separator, name, name_length + 1);
+	return path;
+}
+
+// name and extension point into the path allocation
+static char *path_file_name (char *path) {
+	char *name = path;
+	for (char *c = path; *c; c++) {
+		if ((*c == '/' || *c == '\\') && c[1] != '\0') {
+			name = c + 1;
+		}
+	}
+	return name;
+}
+
+static char *file_extension (char *name) {
+	char *dot = SDL_strrchr(name, '.');
+	return (dot && dot != name) ? dot + 1 : NULL;
+}
+
+//=============================================================================
+// NODES
+//=============================================================================
+
+Directory *directory_create (Directory *parent, char *path, i64 modified_time) {
+	Directory *directory = SDL_calloc(1, sizeof(Directory));
+	directory->path = path;
+	directory->name = path_file_name(path);
+	directory->parent = parent;
+	directory->modified_time = modified_time;
+	directory->stats_label_dirty = true;
+	// until its parent's listing says otherwise, it is in the parent's work tree
+	if (parent) {
+		directory->git_repo = parent->git_repo;
+		directory->git_ignore = parent->git_ignore;
+		directory->git_ignored = parent->git_ignored;
+	}
+	return directory;
+}
+
+File *file_create (Directory *parent, char *path, u64 size, i64 modified_time) {
+	File *file = SDL_calloc(1, sizeof(File));
+	file->path = path;
+	file->name = path_file_name(path);
+	file->extension = file_extension(file->name);
+	file_type_classify(file);
+	file->parent = parent;
+	file->size = size;
+	file->modified_time = modified_time;
+	return file;
+}
+
+//=============================================================================
+// LISTING
+//=============================================================================
+
+static SDL_EnumerationResult collect_entry (void *user_data, const char *dirname, const char *fname) {
+	xtd_ignore_unused(dirname);
+	ScanListing *listing = user_data;
+
+	if (SDL_GetAtomicInt(&listing->scanner->cancelled)) {
+		return SDL_ENUM_SUCCESS;
+	}
+
+	if (listing->num_entries == listing->capacity) {
+		listing->capacity = xtd_max(listing->capacity * 2, 64u);
+		listing->entries = SDL_realloc(listing->entries, listing->capacity * sizeof(ScanStat));
+	}
+	ScanStat *entry = &listing->entries[listing->num_entries++];
+	entry->path = join_path(listing->directory->path, fname);
+	entry->type = SDL_PATHTYPE_NONE;
+	return SDL_ENUM_CONTINUE;
+}
+
+static void scan_directory_job (void *data);
+
+// turns the looked up entries into nodes, queues the subdirectories and hands
+// the result to the UI thread
+static void publish_listing (ScanListing *listing) {
+	Scanner *scanner = listing->scanner;
+	ScanResult *result = SDL_calloc(1, sizeof(ScanResult));
+	result->directory = listing->directory;
+
+	u32 num_directories = 0;
+	u32 num_files = 0;
+	for (u32 i = 0; i < listing->num_entries; i++) {
+		num_directories += listing->entries[i].type == SDL_PATHTYPE_DIRECTORY;
+		num_files += listing->entries[i].type == SDL_PATHTYPE_FILE;
+	}
+	if (num_directories) result->child_directories = SDL_malloc(num_directories * sizeof(Directory *));
+	if (num_files) result->child_files = SDL_malloc(num_files * sizeof(File *));
+
+	for (u32 i = 0; i < listing->num_entries; i++) {
+		ScanStat *entry = &listing->entries[i];
+		if (entry->type == SDL_PATHTYPE_DIRECTORY) {
+			result->child_directories[result->num_child_directories++] = directory_create(listing->directory, entry->path, entry->modified_time);
+		}
+		else if (entry->type == SDL_PATHTYPE_FILE) {
+			File *file = file_create(listing->directory, entry->path, entry->size, entry->modified_time);
+			file->is_link = entry->is_link;
+			result->child_files[result->num_child_files++] = file;
+
+			result->file_stats.total_size += file->size;
+			result->file_stats.num_files++;
+			result->file_stats.newest_modified_time = xtd_max(result->file_stats.newest_modified_time, file->modified_time);
+		}
+		else {
+			SDL_free(entry->path);
+		}
+	}
+	if (scanner->git_status) {
+		git_status_classify_listing(scanner->git_status, listing->directory,
+			result->child_directories, result->num_child_directories,
+			result->child_files, result->num_child_files,
+			&result->file_stats, &result->git);
+	}
+
+	// children are queued before this listing is published, so the
+	// pending count never drops to zero while the tree is still growing
+	if (listing->depth < SCAN_MAX_DEPTH) {
+		SDL_AddAtomicInt(&scanner->num_pending, (i32) result->num_child_directories);
+		for (u32 i = 0; i < result->num_child_directories; i++) {
+			ScanJob *child_job = SDL_malloc(sizeof(ScanJob));
+			child_job->scanner = scanner;
+			child_job->directory = result->child_directories[i];
+			child_job->depth = listing->depth + 1;
+			job_queue_push(scanner->job_queue, scan_directory_job, child_job, JOB_PRIORITY_NORMAL);
+		}
+	}
+
+	SDL_LockMutex(scanner->mutex);
+	if (scanner->completed_tail) {
+		scanner->completed_tail->next = result;
+	} else {
+		scanner->completed_head = result;
+	}
+	scanner->completed_tail = result;
+	SDL_UnlockMutex(scanner->mutex);
+
+	SDL_AddAtomicInt(&scanner->num_pending, -1);
+	SDL_free(listing->entries);
+	SDL_free(listing);
+}
+
+static void stat_chunk (ScanListing *listing, u32 first, u32 count) {
+	if (!SDL_GetAtomicInt(&listing->scanner->cancelled)) {
+		scan_io_stat(&listing->scanner->io, listing->entries + first, count);
+	}
+	if (job_counter_complete(&listing->chunks_remaining)) {
+		publish_listing(listing);
+	}
+}
+
+static void stat_chunk_job (void *data) {
+	ScanChunk *chunk = data;
+	stat_chunk(chunk->listing, chunk->first, chunk->count);
+	SDL_free(chunk);
+}
+
+// Lists names first and looks them up in SCAN_STAT_CHUNK sized batches.
+// Large directories spread their batches over the job queue; the job that
+// finishes the last one publishes the listing
+static void scan_directory_job (void *data) {
+	ScanJob *job = data;
+	Scanner *scanner = job->scanner;
+
+	if (SDL_GetAtomicInt(&scanner->cancelled)) {
+		SDL_AddAtomicInt(&scanner->num_pending, -1);
+		SDL_free(job);
+		return;
+	}
+
+	ScanListing *listing = SDL_calloc(1, sizeof(ScanListing));
+	listing->scanner = scanner;
+	listing->directory = job->directory;
+	listing->depth = job->depth;
+	SDL_free(job);
+	SDL_EnumerateDirectory(listing->directory->path, collect_entry, listing);
+
+	u32 num_chunks = xtd_max((listing->num_entries + SCAN_STAT_CHUNK - 1) / SCAN_STAT_CHUNK, 1u);
+	job_counter_set(&listing->chunks_remaining, (i32) num_chunks);
+	for (u32 i = 1; i < num_chunks; i++) {
+		ScanChunk *chunk = SDL_malloc(sizeof(ScanChunk));
+		chunk->listing = listing;
+		chunk->first = i * SCAN_STAT_CHUNK;
+		chunk->count = xtd_min(listing->num_entries - chunk->first, (u32) SCAN_STAT_CHUNK);
+		job_queue_push(scanner->job_queue, stat_chunk_job, chunk, JOB_PRIORITY_NORMAL);
+	}
+	stat_chunk(listing, 0, xtd_min(listing->num_entries, (u32) SCAN_STAT_CHUNK));
+}
+
+//=============================================================================
+// SCANNER
+//=============================================================================
+
+bool scanner_init (Scanner *scanner, JobQueue *job_queue, ScanAttachCallback on_attach, void *user_data) {
+	SDL_memset(scanner, 0, sizeof(*scanner));
+	scanner->job_queue = job_queue;
+	scanner->on_attach = on_attach;
+	scanner->user_data = user_data;
+	scan_io_init(&scanner->io);
+	scanner->mutex = SDL_CreateMutex();
+	if (!scanner->mutex) {
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create scanner mutex: %s", SDL_GetError());
+		return false;
+	}
+	return true;
+}
+
+// the job queue must already be destroyed so no worker is still listing
+void scanner_shutdown (Scanner *scanner) {
+	if (!scanner->mutex) return;
+
+	while (scanner->completed_head) {
+		ScanResult *result = scanner->completed_head;
+		scanner->completed_head = result->next;
+		SDL_free(result->child_directories);
+		SDL_free(result->child_files);
+		SDL_free(result);
+	}
+	SDL_DestroyMutex(scanner->mutex);
+	scanner->mutex = NULL;
+}
+
+void scanner_scan (Scanner *scanner, Directory *directory) {
+	ScanJob *job = SDL_malloc(sizeof(ScanJob));
+	job->scanner = scanner;
+	job->directory = directory;
+	job->depth = 0;
+
+	SDL_AddAtomicInt(&scanner->num_pending, 1);
+	job_queue_push(scanner->job_queue, scan_directory_job, job, JOB_PRIORITY_NORMAL);
+}
+
+void scanner_cancel (Scanner *scanner) {
+	SDL_LockMutex(scanner->mutex);
+	SDL_SetAtomicInt(&scanner->cancelled, 1);
+	SDL_UnlockMutex(scanner->mutex);
+}
+
+bool scanner_update (Scanner *scanner) {
+	u64 start = SDL_GetTicksNS();
+	bool changed = false;
+
+	while (SDL_GetTicksNS() - start < SCAN_ATTACH_BUDGET_NS) {
+		SDL_LockMutex(scanner->mutex);
+		ScanResult *result = scanner->completed_head;
+		if (result) {
+			scanner->completed_head = result->next;
+			if (!scanner->completed_head) {
+				scanner->completed_tail = NULL;
+			}
+		}
+		SDL_UnlockMutex(scanner->mutex);
+
+		if (!result) {
+			break;
+		}
+
+		Directory *directory = result->directory;
+		SDL_free(directory->child_directories);
+		SDL_free(directory->child_files);
+		directory->child_directories = result->child_directories;
+		directory->num_child_directories = result->num_child_directories;
+		directory->child_files = result->child_files;
+		directory->num_child_files = result->num_child_files;
+		directory->git_repo = result->git.repo;
+		directory->git_ignore = result->git.ignore;
+		directory->git_generation = result->git.generation;
+		directory->num_git_deleted = result->git.num_deleted;
+		if (result->git.replaced) {
+			git_status_release_ignore(scanner->git_status, result->git.replaced);
+		}
+
+		aggregate_add(directory, result->file_stats);
+
+		scanner->num_directories_attached += result->num_child_directories;
+		scanner->num_files_attached += result->num_child_files;
+		if (scanner->on_attach) {
+			scanner->on_attach(directory, scanner->user_data);
+		}
+
+		SDL_free(result);
+		changed = true;
+	}
+
+	return changed;
+}
+
+bool scanner_is_busy (Scanner *scanner) {
+	return SDL_GetAtomicInt(&scanner->num_pending) > 0 || scanner->completed_head != NULL;
+}
@@ -0,0 +1,92 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include "xtdlib.h"
+
+#include <SDL3/SDL.h>
+
+#include "git_status.h"
+#include "job.h"
+#include "scan_io.h"
+#include "ui.h"
+
+//=============================================================================
+// SCANNER
+//=============================================================================
+
+// Reads directory trees from disk on a background job queue. Every directory
+// is one job: it lists its entries, looks up their metadata in batches of
+// SCAN_STAT_CHUNK (see scan_io.h) into freshly allocated nodes, sums its own
+// files and queues a job per subdirectory, so the tree is indexed in
+// parallel. Workers never modify nodes the UI can see; finished listings are
+// attached by scanner_update on the UI thread, which adds each listing's file
+// totals to the directory and its ancestors (see aggregate.h). Listings inside
+// git work trees get their files' status before they are published (see
+// git_status.h).
+
+#define SCAN_MAX_DEPTH 128
+#define SCAN_ATTACH_BUDGET_NS (2 * SDL_NS_PER_MS)
+#define SCAN_STAT_CHUNK 1024
+
+#if defined(_WIN32)
+	#define PATH_SEPARATOR '\\'
+#else
+	#define PATH_SEPARATOR '/'
+#endif
+
+typedef void (*ScanAttachCallback) (Directory *directory, void *user_data);
+
+typedef struct ScanResult {
+	Directory *directory;
+
+	Directory **child_directories;
+	u32 num_child_directories;
+	File **child_files;
+	u32 num_child_files;
+
+	DirectoryStats file_stats;
+	GitListing git;
+	struct ScanResult *next;
+} ScanResult;
+
+typedef struct Scanner {
+	JobQueue *job_queue;
+	ScanIo io;
+
+	SDL_Mutex *mutex;
+	ScanResult *completed_head;
+	ScanResult *completed_tail;
+
+	SDL_AtomicInt num_pending;
+	SDL_AtomicInt cancelled;
+
+	u64 num_directories_attached;
+	u64 num_files_attached;
+
+	ScanAttachCallback on_attach;
+	void *user_data;
+	GitStatus *git_status;		// optional; without it no listing gets a git status
+} Scanner;
+
+bool scanner_init (Scanner *scanner, JobQueue *job_queue, ScanAttachCallback on_attach, void *user_data);
+void scanner_shutdown (Scanner *scanner);
+
+// indexes everything below directory->path
+void scanner_scan (Scanner *scanner, Directory *directory);
+
+// stops listing: queued jobs return at once and running ones stop early, so
+// the job queue drains quickly; call before destroying it
+void scanner_cancel (Scanner *scanner);
+
+// attaches finished listings within a small time budget; returns true if the tree changed
+bool scanner_update (Scanner *scanner);
+
+bool scanner_is_busy (Scanner *scanner);
+
+char *join_path (const char *directory_path, const char *name);
+
+// allocate a node that takes ownership of path; usable from any thread
+Directory *directory_create (Directory *parent, char *path, i64 modified_time);
+File *file_create (Directory *parent, char *path, u64 size, i64 modified_time);
+
+#endif // SCAN_H
@@ -0,0 +1,336 @@
+// statx and its flags need _GNU_SOURCE from glibc
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+	#define _GNU_SOURCE
+#endif
+
+#include "scan_io.h"
+
+#if !defined(_WIN32)
+	#include <sys/stat.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+	#if __has_include(<linux/io_uring.h>)
+		#include <errno.h>
+		#include <fcntl.h>
+		#include <linux/io_uring.h>
+		#include <sys/mman.h>
+		#include <sys/stat.h>
+		#include <sys/syscall.h>
+		#include <unistd.h>
+		#if defined(__NR_io_uring_setup) && defined(STATX_TYPE)
+			#define SCAN_IO_HAS_IO_URING
+		#endif
+	#endif
+#endif
+
+static const char *backend_names[NUM_SCAN_IO_BACKENDS] = {
+	[SCAN_IO_BACKEND_BLOCKING] = "blocking",
+	[SCAN_IO_BACKEND_IO_URING] = "io_uring",
+};
+
+//=============================================================================
+// BLOCKING
+//=============================================================================
+
+#if defined(_WIN32)
+
+// GetFileAttributesEx, under SDL_GetPathInfo, does not follow reparse points
+static void stat_blocking (ScanStat *stat) {
+	SDL_PathInfo info;
+	stat->is_link = false;
+	if (SDL_GetPathInfo(stat->path, &info)) {
+		stat->type = info.type;
+		stat->size = info.size;
+		stat->modified_time = info.modify_time;
+	} else {
+		stat->type = SDL_PATHTYPE_NONE;
+	}
+}
+
+#else
+
+static void stat_blocking (ScanStat *stat) {
+	struct stat info;
+	if (lstat(stat->path, &info) != 0) {
+		stat->type = SDL_PATHTYPE_NONE;
+		return;
+	}
+	stat->is_link = S_ISLNK(info.st_mode);
+	if (S_ISDIR(info.st_mode)) stat->type = SDL_PATHTYPE_DIRECTORY;
+	else if (S_ISREG(info.st_mode) || stat->is_link) stat->type = SDL_PATHTYPE_FILE;
+	else stat->type = SDL_PATHTYPE_OTHER;
+	stat->size = (u64) info.st_size;
+#if defined(__APPLE__)
+	stat->modified_time = (i64) info.st_mtimespec.tv_sec * SDL_NS_PER_SECOND + info.st_mtimespec.tv_nsec;
+#else
+	stat->modified_time = (i64) info.st_mtim.tv_sec * SDL_NS_PER_SECOND + info.st_mtim.tv_nsec;
+#endif
+}
+
+#endif
+
+//=============================================================================
+// IO_URING
+//=============================================================================
+
+#if defined(SCAN_IO_HAS_IO_URING)
+
+// Talks to the kernel through the raw system calls rather than liburing. A
+// batch goes in waves of up to num_entries requests: fill the submission
+// queue, then one io_uring_enter submits the wave and waits for all of it.
+
+typedef struct StatRing {
+	i32 descriptor;
+	u32 num_entries;
+	bool broken;
+
+	void *sq_map;
+	size_t sq_map_size;
+	void *cq_map;
+	size_t cq_map_size;
+	struct io_uring_sqe *sqes;
+	size_t sqes_size;
+
+	u32 *sq_tail;
+	u32 *sq_array;
+	u32 sq_mask;
+	u32 *cq_head;
+	u32 *cq_tail;
+	u32 cq_mask;
+	struct io_uring_cqe *cqes;
+
+	struct statx results[SCAN_IO_RING_ENTRIES];
+} StatRing;
+
+// stored for threads whose ring could not be set up, so they stop trying
+static StatRing ring_unavailable;
+static SDL_TLSID ring_slot;
+
+static i32 ring_setup (struct io_uring_params *params) {
+	return (i32) syscall(__NR_io_uring_setup, SCAN_IO_RING_ENTRIES, params);
+}
+
+static i32 ring_enter (i32 descriptor, u32 to_submit, u32 min_complete) {
+	return (i32) syscall(__NR_io_uring_enter, descriptor, to_submit, min_complete, IORING_ENTER_GETEVENTS, NULL, 0);
+}
+
+static void ring_destroy (void *data) {
+	StatRing *ring = data;
+	// a broken ring may still have requests writing into results
+	if (!ring || ring == &ring_unavailable || ring->broken) {
+		return;
+	}
+	if (ring->sqes) munmap(ring->sqes, ring->sqes_size);
+	if (ring->cq_map && ring->cq_map != ring->sq_map) munmap(ring->cq_map, ring->cq_map_size);
+	if (ring->sq_map) munmap(ring->sq_map, ring->sq_map_size);
+	close(ring->descriptor);
+	SDL_free(ring);
+}
+
+static StatRing *ring_create (void) {
+	struct io_uring_params params;
+	SDL_zero(params);
+	i32 descriptor = ring_setup(&params);
+	if (descriptor < 0) {
+		return NULL;
+	}
+
+	StatRing *ring = SDL_calloc(1, sizeof(StatRing));
+	ring->descriptor = descriptor;
+	ring->num_entries = xtd_min(params.sq_entries, (u32) SCAN_IO_RING_ENTRIES);
+	ring->sq_map_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+	ring->cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+	// newer kernels map both rings with one call
+	bool single_map = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (single_map) {
+		ring->sq_map_size = ring->cq_map_size = xtd_max(ring->sq_map_size, ring->cq_map_size);
+	}
+
+	ring->sq_map = mmap(NULL, ring->sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor, IORING_OFF_SQ_RING);
+	if (ring->sq_map == MAP_FAILED) {
+		ring->sq_map = NULL;
+		ring_destroy(ring);
+		return NULL;
+	}
+	ring->cq_map = single_map ? ring->sq_map :
+		mmap(NULL, ring->cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor, IORING_OFF_CQ_RING);
+	if (ring->cq_map == MAP_FAILED) {
+		ring->cq_map = NULL;
+		ring_destroy(ring);
+		return NULL;
+	}
+	ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor, IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED) {
+		ring->sqes = NULL;
+		ring_destroy(ring);
+		return NULL;
+	}
+
+	u8 *sq = ring->sq_map;
+	u8 *cq = ring->cq_map;
+	ring->sq_tail = (u32 *) (sq + params.sq_off.tail);
+	ring->sq_array = (u32 *) (sq + params.sq_off.array);
+	ring->sq_mask = *(u32 *) (sq + params.sq_off.ring_mask);
+	ring->cq_head = (u32 *) (cq + params.cq_off.head);
+	ring->cq_tail = (u32 *) (cq + params.cq_off.tail);
+	ring->cq_mask = *(u32 *) (cq + params.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+	return ring;
+}
+
+static StatRing *thread_ring (void) {
+	StatRing *ring = SDL_GetTLS(&ring_slot);
+	if (!ring) {
+		ring = ring_create();
+		if (!ring) {
+			ring = &ring_unavailable;
+		}
+		SDL_SetTLS(&ring_slot, ring, ring_destroy);
+	}
+	return (ring == &ring_unavailable || ring->broken) ? NULL : ring;
+}
+
+static bool ring_supports_statx (void) {
+	struct io_uring_params params;
+	SDL_zero(params);
+	i32 descriptor = ring_setup(&params);
+	if (descriptor < 0) {
+		return false;
+	}
+
+	size_t probe_size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+	struct io_uring_probe *probe = SDL_calloc(1, probe_size);
+	bool supported = syscall(__NR_io_uring_register, descriptor, IORING_REGISTER_PROBE, probe, 256) >= 0 &&
+		probe->last_op >= IORING_OP_STATX &&
+		(probe->ops[IORING_OP_STATX].flags & IO_URING_OP_SUPPORTED);
+	SDL_free(probe);
+	close(descriptor);
+	return supported;
+}
+
+static void stat_from_statx (ScanStat *stat, const struct statx *result) {
+	stat->is_link = S_ISLNK(result->stx_mode);
+	if (S_ISDIR(result->stx_mode)) stat->type = SDL_PATHTYPE_DIRECTORY;
+	else if (S_ISREG(result->stx_mode) || stat->is_link) stat->type = SDL_PATHTYPE_FILE;
+	else stat->type = SDL_PATHTYPE_OTHER;
+	stat->size = result->stx_size;
+	stat->modified_time = (i64) result->stx_mtime.tv_sec * SDL_NS_PER_SECOND + result->stx_mtime.tv_nsec;
+}
+
+// returns false if the ring failed; the entries it did not complete are left to the caller
+static bool ring_stat_wave (StatRing *ring, ScanStat *stats, u32 num_stats, bool *completed) {
+	u32 tail = *ring->sq_tail;
+	for (u32 i = 0; i < num_stats; i++) {
+		u32 index = (tail + i) & ring->sq_mask;
+		struct io_uring_sqe *sqe = &ring->sqes[index];
+		SDL_zerop(sqe);
+		sqe->opcode = IORING_OP_STATX;
+		sqe->fd = AT_FDCWD;
+		sqe->statx_flags = AT_SYMLINK_NOFOLLOW;
+		sqe->addr = (u64) (uintptr_t) stats[i].path;
+		sqe->len = STATX_TYPE | STATX_SIZE | STATX_MTIME;
+		sqe->off = (u64) (uintptr_t) &ring->results[i];
+		sqe->user_data = i;
+		ring->sq_array[index] = index;
+		completed[i] = false;
+	}
+	__atomic_store_n(ring->sq_tail, tail + num_stats, __ATOMIC_RELEASE);
+
+	u32 to_submit = num_stats;
+	u32 num_completed = 0;
+	while (num_completed < num_stats) {
+		i32 entered = ring_enter(ring->descriptor, to_submit, num_stats - num_completed);
+		if (entered >= 0) {
+			to_submit -= (u32) entered;
+		}
+		else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+			return false;
+		}
+
+		u32 head = *ring->cq_head;
+		u32 cq_tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+		for (; head != cq_tail; head++) {
+			struct io_uring_cqe *cqe = &ring->cqes[head & ring->cq_mask];
+			u32 i = (u32) cqe->user_data;
+			if (cqe->res < 0) {
+				stats[i].type = SDL_PATHTYPE_NONE;
+			} else {
+				stat_from_statx(&stats[i], &ring->results[i]);
+			}
+			completed[i] = true;
+			num_completed++;
+		}
+		__atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+	}
+	return true;
+}
+
+static bool stat_io_uring (ScanStat *stats, u32 num_stats) {
+	StatRing *ring = thread_ring();
+	if (!ring) {
+		return false;
+	}
+
+	bool completed[SCAN_IO_RING_ENTRIES];
+	for (u32 first = 0; first < num_stats; first += ring->num_entries) {
+		u32 count = xtd_min(num_stats - first, ring->num_entries);
+		if (!ring_stat_wave(ring, stats + first, count, completed)) {
+			// requests already submitted may still complete into the
+			// ring's buffers, so it is never used or freed again
+			ring->broken = true;
+			for (u32 i = 0; i < count; i++) {
+				if (!completed[i]) stat_blocking(&stats[first + i]);
+			}
+			for (u32 i = first + count; i < num_stats; i++) {
+				stat_blocking(&stats[i]);
+			}
+			return true;
+		}
+	}
+	return true;
+}
+
+#endif // SCAN_IO_HAS_IO_URING
+
+//=============================================================================
+// SCAN I/O
+//=============================================================================
+
+void scan_io_init (ScanIo *io) {
+	io->backend = scan_io_backend_is_supported(SCAN_IO_BACKEND_IO_URING) ? SCAN_IO_BACKEND_IO_URING : SCAN_IO_BACKEND_BLOCKING;
+}
+
+bool scan_io_backend_is_supported (ScanIoBackend backend) {
+	switch (backend) {
+	case SCAN_IO_BACKEND_BLOCKING:
+		return true;
+	case SCAN_IO_BACKEND_IO_URING:
+#if defined(SCAN_IO_HAS_IO_URING)
+		return ring_supports_statx();
+#else
+		return false;
+#endif
+	default:
+		return false;
+	}
+}
+
+const char *scan_io_backend_name (ScanIoBackend backend) {
+	return backend < NUM_SCAN_IO_BACKENDS ? backend_names[backend] : "unknown";
+}
+
+void scan_io_stat (ScanIo *io, ScanStat *stats, u32 num_stats) {
+#if defined(SCAN_IO_HAS_IO_URING)
+	if (io->backend == SCAN_IO_BACKEND_IO_URING && stat_io_uring(stats, num_stats)) {
+		return;
+	}
+#else
+	xtd_ignore_unused(io);
+#endif
+	for (u32 i = 0; i < num_stats; i++) {
+		stat_blocking(&stats[i]);
+	}
+}
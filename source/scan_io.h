@@ -0,0 +1,62 @@
+#ifndef SCAN_IO_H
+#define SCAN_IO_H
+
+#include "xtdlib.h"
+
+#include <SDL3/SDL.h>
+
+//=============================================================================
+// SCAN I/O
+//=============================================================================
+
+// Metadata lookups for the scanner. Showing a size and a modification time
+// per row costs one stat per entry, which for a large directory is most of
+// the time spent indexing it. Lookups are made in batches through one of two
+// backends:
+//
+// - io_uring (Linux 5.6+): the batch is queued as statx requests on a
+//   submission ring owned by the calling thread, so a batch of
+//   SCAN_IO_RING_ENTRIES lookups costs a single system call each way.
+// - blocking: one lstat per entry, SDL_GetPathInfo on Windows. The scanner
+//   splits large listings into chunks across its job queue, so on every
+//   platform the blocking calls still run on several threads at once.
+//
+// The backend is picked once at scan_io_init by probing the kernel; a thread
+// that fails to set up its ring falls back to blocking calls on its own.
+//
+// Symbolic links are looked up themselves, never followed, and come back as
+// files: a link to a directory is a leaf, so links looping back up the tree
+// cannot make the scan descend forever.
+
+#define SCAN_IO_RING_ENTRIES 256
+
+typedef enum ScanIoBackend {
+	SCAN_IO_BACKEND_BLOCKING,
+	SCAN_IO_BACKEND_IO_URING,
+	NUM_SCAN_IO_BACKENDS
+} ScanIoBackend;
+
+// one lookup: path is the input, the rest is filled in. Failed lookups
+// report SDL_PATHTYPE_NONE
+typedef struct ScanStat {
+	char *path;
+	SDL_PathType type;
+	bool is_link;			// type is then SDL_PATHTYPE_FILE, size and time the link's own
+	u64 size;
+	i64 modified_time;
+} ScanStat;
+
+typedef struct ScanIo {
+	ScanIoBackend backend;
+} ScanIo;
+
+// picks the fastest backend the system supports
+void scan_io_init (ScanIo *io);
+
+bool scan_io_backend_is_supported (ScanIoBackend backend);
+const char *scan_io_backend_name (ScanIoBackend backend);
+
+// fills in every entry of stats before returning; safe to call from any number of threads at once
+void scan_io_stat (ScanIo *io, ScanStat *stats, u32 num_stats);
+
+#endif // SCAN_IO_H
@@ -0,0 +1,114 @@
+#include "scroll.h"
+
+#include <SDL3/SDL.h>
+
+//=============================================================================
+// OFFSET
+//=============================================================================
+
+f32 scroll_max_offset (ScrollState *scroll) {
+	return xtd_max(scroll->content_height - scroll->viewport_height, 0.0f);
+}
+
+void scroll_set_offset (ScrollState *scroll, f32 offset) {
+	scroll->offset = SDL_clamp(offset, 0.0f, scroll_max_offset(scroll));
+}
+
+void scroll_add_wheel (ScrollState *scroll, f32 wheel_delta) {
+	// reversing direction cancels the fling instead of fighting it
+	if ((scroll->velocity > 0) != (wheel_delta < 0)) {
+		scroll->velocity = 0;
+	}
+	scroll->velocity -= wheel_delta * SCROLL_WHEEL_IMPULSE;
+	scroll->velocity = SDL_clamp(scroll->velocity, -SCROLL_MAX_VELOCITY, SCROLL_MAX_VELOCITY);
+}
+
+void scroll_update (ScrollState *scroll, f32 delta_time) {
+	scroll->last_delta_time = delta_time;
+
+	if (scroll->dragging_thumb) {
+		scroll->velocity = 0;
+	}
+
+	if (scroll->velocity != 0) {
+		scroll->offset += scroll->velocity * delta_time;
+		scroll->velocity *= SDL_expf(-SCROLL_FRICTION * delta_time);
+		if (SDL_fabsf(scroll->velocity) < SCROLL_STOP_VELOCITY) {
+			scroll->velocity = 0;
+		}
+	}
+
+	f32 max_offset = scroll_max_offset(scroll);
+	if (scroll->offset <= 0 || scroll->offset >= max_offset) {
+		scroll->velocity = 0;
+	}
+	scroll->offset = SDL_clamp(scroll->offset, 0.0f, max_offset);
+}
+
+//=============================================================================
+// VIRTUALIZATION
+//=============================================================================
+
+RowRange scroll_prefetch_range (ScrollState *scroll, f32 row_height, u32 num_rows) {
+	f32 top = scroll->offset;
+	f32 bottom = scroll->offset + scroll->viewport_height;
+
+	f32 lookahead = scroll->velocity * scroll->last_delta_time * SCROLL_PREFETCH_FRAMES;
+	if (lookahead > 0) {
+		bottom += lookahead;
+	} else {
+		top += lookahead;
+	}
+
+	i64 first = (i64) SDL_floorf(top / row_height) - SCROLL_PREFETCH_ROWS;
+	i64 end = (i64) SDL_ceilf(bottom / row_height) + SCROLL_PREFETCH_ROWS;
+
+	RowRange range;
+	range.first = (u32) SDL_clamp(first, 0, (i64) num_rows);
+	range.end = (u32) SDL_clamp(end, (i64) range.first, (i64) num_rows);
+	return range;
+}
+
+//=============================================================================
+// SCROLLBAR
+//=============================================================================
+
+f32 scroll_thumb_height (ScrollState *scroll, f32 track_height) {
+	if (scroll->content_height <= scroll->viewport_height || scroll->content_height <= 0) {
+		return track_height;
+	}
+	f32 height = track_height * (scroll->viewport_height / scroll->content_height);
+	return SDL_clamp(height, xtd_min(SCROLL_MIN_THUMB, track_height), track_height);
+}
+
+f32 scroll_thumb_position (ScrollState *scroll, f32 track_height) {
+	f32 max_offset = scroll_max_offset(scroll);
+	if (max_offset <= 0) {
+		return 0;
+	}
+	f32 travel = track_height - scroll_thumb_height(scroll, track_height);
+	return travel * (scroll->offset / max_offset);
+}
+
+void scroll_begin_thumb_drag (ScrollState *scroll, f32 pointer_y) {
+	scroll->dragging_thumb = true;
+	scroll->velocity = 0;
+	scroll->drag_start_offset = scroll->offset;
+	scroll->drag_start_pointer_y = pointer_y;
+}
+
+void scroll_update_thumb_drag (ScrollState *scroll, f32 pointer_y, f32 track_height) {
+	if (!scroll->dragging_thumb) {
+		return;
+	}
+	f32 travel = track_height - scroll_thumb_height(scroll, track_height);
+	if (travel <= 0) {
+		return;
+	}
+	f32 pixels_per_offset = scroll_max_offset(scroll) / travel;
+	scroll_set_offset(scroll, scroll->drag_start_offset + (pointer_y - scroll->drag_start_pointer_y) * pixels_per_offset);
+}
+
+void scroll_end_thumb_drag (ScrollState *scroll) {
+	scroll->dragging_thumb = false;
+}
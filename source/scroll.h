@@ -0,0 +1,57 @@
+#ifndef SCROLL_H
+#define SCROLL_H
+
+#include "xtdlib.h"
+
+//=============================================================================
+// KINETIC SCROLLING
+//=============================================================================
+
+// Vertical scroll state for one list. Wheel notches add velocity instead of
+// jumping, and scroll_update integrates it against the real frame time, so
+// the offset is continuous (sub-row) and decays the same at any frame rate.
+
+#define SCROLL_WHEEL_IMPULSE   1400.0f	// px/s added per wheel notch
+#define SCROLL_MAX_VELOCITY    12000.0f	// px/s
+#define SCROLL_FRICTION        6.0f		// exponential decay per second
+#define SCROLL_STOP_VELOCITY   8.0f		// px/s below which motion stops
+#define SCROLL_MIN_THUMB       20.0f	// px
+#define SCROLL_PREFETCH_FRAMES 6		// frames of motion to lay out ahead of the viewport
+#define SCROLL_PREFETCH_ROWS   2		// rows kept laid out on both sides regardless of motion
+
+typedef struct ScrollState {
+	f32 offset;
+	f32 velocity;
+
+	f32 content_height;
+	f32 viewport_height;
+	f32 last_delta_time;
+
+	bool dragging_thumb;
+	f32 drag_start_offset;
+	f32 drag_start_pointer_y;
+} ScrollState;
+
+typedef struct RowRange {
+	u32 first;
+	u32 end;
+} RowRange;
+
+void scroll_add_wheel (ScrollState *scroll, f32 wheel_delta);
+void scroll_update (ScrollState *scroll, f32 delta_time);
+void scroll_set_offset (ScrollState *scroll, f32 offset);
+f32  scroll_max_offset (ScrollState *scroll);
+
+// rows that must be laid out this frame: the viewport plus whatever the
+// current velocity will bring into view over the next few frames
+RowRange scroll_prefetch_range (ScrollState *scroll, f32 row_height, u32 num_rows);
+
+// scrollbar geometry for a track of the given height
+f32 scroll_thumb_height (ScrollState *scroll, f32 track_height);
+f32 scroll_thumb_position (ScrollState *scroll, f32 track_height);
+
+void scroll_begin_thumb_drag (ScrollState *scroll, f32 pointer_y);
+void scroll_update_thumb_drag (ScrollState *scroll, f32 pointer_y, f32 track_height);
+void scroll_end_thumb_drag (ScrollState *scroll);
+
+#endif // SCROLL_H
@@ -0,0 +1,529 @@
+#include "search.h"
+
+#include "bytes.h"
+#include "file_map.h"
+#include "filetype.h"
+
+typedef struct SearchJob {
+	SearchRun *run;
+	u32 first;
+	u32 end;
+} SearchJob;
+
+struct SearchRun {
+	SearchPattern pattern;
+	SDL_AtomicInt cancelled;
+	SDL_AtomicInt finished;
+	JobCounter counter;
+
+	char **paths;
+	u32 num_paths;
+	u32 paths_capacity;
+	SearchJob *jobs;
+	u32 num_jobs;
+
+	// guarded by mutex
+	SDL_Mutex *mutex;
+	SearchHit *pending;
+	u32 num_pending;
+	u32 pending_capacity;
+	SearchStats stats;
+
+	struct SearchRun *next;
+};
+
+//=============================================================================
+// PATTERNS
+//=============================================================================
+
+static inline u8 fold_char (u8 c) {
+	return (c >= 'A' && c <= 'Z') ? (u8) (c + ('a' - 'A')) : c;
+}
+
+static inline bool chars_equal (u8 a, u8 b, bool ignore_case) {
+	return ignore_case ? fold_char(a) == fold_char(b) : a == b;
+}
+
+static inline u32 atom_length (const char *re, const char *re_end) {
+	return (re[0] == '\\' && re + 1 < re_end) ? 2 : 1;
+}
+
+static inline bool atom_matches (const char *re, u8 c, bool ignore_case) {
+	if (re[0] == '.')  return true;
+	if (re[0] == '\\') return chars_equal((u8) re[1], c, ignore_case);
+	return chars_equal((u8) re[0], c, ignore_case);
+}
+
+static inline bool is_quantifier (char c) {
+	return c == '*' || c == '+' || c == '?';
+}
+
+static bool match_here (const char *re, const char *re_end, const u8 *text, const u8 *text_end, bool ignore_case);
+
+// greedy repetition of one atom, backing off until the rest matches
+static bool match_repeat (const char *atom, const char *rest, const char *re_end,
+	const u8 *text, const u8 *text_end, u32 min_count, bool ignore_case) {
+	const u8 *cursor = text;
+	while (cursor < text_end && atom_matches(atom, *cursor, ignore_case)) {
+		cursor++;
+	}
+	for (;;) {
+		if ((u64) (cursor - text) < min_count) return false;
+		if (match_here(rest, re_end, cursor, text_end, ignore_case)) return true;
+		if (cursor == text) return false;
+		cursor--;
+	}
+}
+
+static bool match_here (const char *re, const char *re_end, const u8 *text, const u8 *text_end, bool ignore_case) {
+	if (re == re_end) {
+		return true;
+	}
+	if (re[0] == '$' && re + 1 == re_end) {
+		return text == text_end;
+	}
+
+	u32 length = atom_length(re, re_end);
+	char quantifier = (re + length < re_end) ? re[length] : 0;
+
+	switch (quantifier) {
+	case '*': return match_repeat(re, re + length + 1, re_end, text, text_end, 0, ignore_case);
+	case '+': return match_repeat(re, re + length + 1, re_end, text, text_end, 1, ignore_case);
+	case '?':
+		if (text < text_end && atom_matches(re, *text, ignore_case) &&
+			match_here(re + length + 1, re_end, text + 1, text_end, ignore_case)) {
+			return true;
+		}
+		return match_here(re + length + 1, re_end, text, text_end, ignore_case);
+	}
+
+	if (text < text_end && atom_matches(re, *text, ignore_case)) {
+		return match_here(re + length, re_end, text + 1, text_end, ignore_case);
+	}
+	return false;
+}
+
+// longest run of atoms that must appear verbatim in any match
+static void extract_required_literal (SearchPattern *pattern) {
+	const char *re = pattern->text;
+	const char *re_end = pattern->text + pattern->length;
+
+	char run[SEARCH_MAX_PATTERN_LENGTH];
+	u32 run_length = 0;
+	pattern->required_length = 0;
+
+	while (re < re_end) {
+		u32 length = atom_length(re, re_end);
+		char quantifier = (re + length < re_end) ? re[length] : 0;
+		bool is_anchor = (re == pattern->text && re[0] == '^') || (re + 1 == re_end && re[0] == '$');
+		bool is_literal = !is_anchor && re[0] != '.' && quantifier != '*' && quantifier != '?';
+
+		if (is_literal) {
+			run[run_length++] = (length == 2) ? re[1] : re[0];
+		}
+		// a repeated atom is required once, but whatever follows it is not adjacent
+		if (!is_literal || quantifier == '+') {
+			if (run_length > pattern->required_length) {
+				SDL_memcpy(pattern->required, run, run_length);
+				pattern->required_length = run_length;
+			}
+			run_length = 0;
+		}
+		re += length + (is_quantifier(quantifier) ? 1 : 0);
+	}
+
+	if (run_length > pattern->required_length) {
+		SDL_memcpy(pattern->required, run, run_length);
+		pattern->required_length = run_length;
+	}
+}
+
+bool search_pattern_compile (SearchPattern *pattern, const char *text, SearchFlags flags) {
+	SDL_memset(pattern, 0, sizeof(*pattern));
+	size_t length = SDL_strlen(text);
+	if (length == 0 || length >= SEARCH_MAX_PATTERN_LENGTH) {
+		return false;
+	}
+	SDL_memcpy(pattern->text, text, length);
+	pattern->length = (u32) length;
+	pattern->flags = flags;
+
+	if (flags & SEARCH_FLAG_REGEX) {
+		extract_required_literal(pattern);
+	} else {
+		SDL_memcpy(pattern->required, text, length);
+		pattern->required_length = (u32) length;
+	}
+	return true;
+}
+
+bool search_match_line (const SearchPattern *pattern, const char *line, size_t length) {
+	bool ignore_case = pattern->flags & SEARCH_FLAG_IGNORE_CASE;
+	const u8 *text = (const u8 *) line;
+	const u8 *text_end = text + length;
+
+	if (!(pattern->flags & SEARCH_FLAG_REGEX)) {
+		for (const u8 *start = text; start + pattern->length <= text_end; start++) {
+			u32 i = 0;
+			while (i < pattern->length && chars_equal(start[i], (u8) pattern->text[i], ignore_case)) i++;
+			if (i == pattern->length) return true;
+		}
+		return false;
+	}
+
+	const char *re = pattern->text;
+	const char *re_end = pattern->text + pattern->length;
+	if (re[0] == '^') {
+		return match_here(re + 1, re_end, text, text_end, ignore_case);
+	}
+	for (const u8 *start = text; ; start++) {
+		if (match_here(re, re_end, start, text_end, ignore_case)) return true;
+		if (start == text_end) return false;
+	}
+}
+
+//=============================================================================
+// FILE SEARCH
+//=============================================================================
+
+typedef struct FileSearch {
+	SearchRun *run;
+	u8 *read_buffer;
+	const char *path;
+	SearchHit *hits;
+	u32 num_hits;
+	u32 hits_capacity;
+	u32 num_file_hits;
+} FileSearch;
+
+static void push_hit (FileSearch *search, u64 line_number, u64 offset, const u8 *line, u64 length) {
+	if (search->num_hits == search->hits_capacity) {
+		search->hits_capacity = xtd_max(search->hits_capacity * 2, 64u);
+		search->hits = SDL_realloc(search->hits, search->hits_capacity * sizeof(SearchHit));
+	}
+	SearchHit *hit = &search->hits[search->num_hits++];
+	hit->path = search->path;
+	hit->line_number = line_number;
+	hit->offset = offset;
+	SDL_snprintf(hit->line_label, sizeof(hit->line_label), "%llu", (unsigned long long) line_number);
+
+	while (length > 0 && (*line == ' ' || *line == '\t')) {
+		line++;
+		length--;
+	}
+	hit->text_length = (u32) xtd_min(length, (u64) SEARCH_HIT_TEXT_LENGTH);
+	SDL_memcpy(hit->text, line, hit->text_length);
+	search->num_file_hits++;
+}
+
+static void flush_hits (FileSearch *search, u64 bytes_searched) {
+	SearchRun *run = search->run;
+	SDL_LockMutex(run->mutex);
+	if (run->num_pending + search->num_hits > run->pending_capacity) {
+		run->pending_capacity = xtd_max(run->pending_capacity * 2, run->num_pending + search->num_hits);
+		run->pending = SDL_realloc(run->pending, run->pending_capacity * sizeof(SearchHit));
+	}
+	SDL_memcpy(run->pending + run->num_pending, search->hits, search->num_hits * sizeof(SearchHit));
+	run->num_pending += search->num_hits;
+	run->stats.bytes_searched += bytes_searched;
+	SDL_UnlockMutex(run->mutex);
+	search->num_hits = 0;
+}
+
+static inline const u8 *find_required (const SearchPattern *pattern, const u8 *data, u64 length) {
+	u8 first = (u8) pattern->required[0];
+	if ((pattern->flags & SEARCH_FLAG_IGNORE_CASE) && fold_char(first) >= 'a' && fold_char(first) <= 'z') {
+		return bytes_find_either(data, length, fold_char(first), (u8) (fold_char(first) - ('a' - 'A')));
+	}
+	return bytes_find(data, length, first);
+}
+
+// searches the complete lines in data; line_number is the line data starts on
+static void search_lines (FileSearch *search, const u8 *data, u64 length, u64 base_offset, u64 *line_number) {
+	const SearchPattern *pattern = &search->run->pattern;
+	bool is_regex = pattern->flags & SEARCH_FLAG_REGEX;
+	bool ignore_case = pattern->flags & SEARCH_FLAG_IGNORE_CASE;
+
+	const u8 *end = data + length;
+	const u8 *cursor = data;
+	const u8 *line_floor = data;	// a line start at or before cursor
+	const u8 *counted = data;		// newlines before this are in line_number
+
+	while (cursor < end && search->num_file_hits < SEARCH_MAX_HITS_PER_FILE) {
+		const u8 *candidate = cursor;
+		if (pattern->required_length > 0) {
+			candidate = find_required(pattern, cursor, end - cursor);
+			if (!candidate) break;
+
+			// literals are fully verified here; regex lines are checked below
+			if (!is_regex) {
+				u32 i = 1;
+				while (i < pattern->required_length && candidate + i < end &&
+					chars_equal(candidate[i], (u8) pattern->required[i], ignore_case)) i++;
+				if (i < pattern->required_length) {
+					cursor = candidate + 1;
+					continue;
+				}
+			}
+		}
+
+		const u8 *previous_newline = bytes_find_last(line_floor, candidate - line_floor, '\n');
+		const u8 *line_start = previous_newline ? previous_newline + 1 : line_floor;
+		const u8 *line_end = bytes_find(candidate, end - candidate, '\n');
+		if (!line_end) line_end = end;
+
+		u64 line_length = line_end - line_start;
+		if (line_length > 0 && line_start[line_length - 1] == '\r') line_length--;
+
+		if (!is_regex || search_match_line(pattern, (const char *) line_start, line_length)) {
+			*line_number += bytes_count(counted, line_start - counted, '\n');
+			counted = line_start;
+			push_hit(search, *line_number, base_offset + (u64) (line_start - data), line_start, line_length);
+		}
+
+		cursor = line_end + 1;
+		line_floor = cursor;
+	}
+
+	*line_number += bytes_count(counted, end - counted, '\n');
+}
+
+// hits of large files stream in per window rather than per file
+static void search_contents (FileSearch *search, MappedFile *file, bool *is_binary) {
+	MappedReader reader;
+	mapped_reader_begin(&reader, file, search->read_buffer, SEARCH_READ_LIMIT, SEARCH_WINDOW_SIZE);
+	u64 line_number = 1;
+	while (search->num_file_hits < SEARCH_MAX_HITS_PER_FILE && !SDL_GetAtomicInt(&search->run->cancelled)) {
+		if (!mapped_reader_next(&reader)) break;
+		if (reader.offset == 0) {
+			*is_binary = bytes_find(reader.data, xtd_min(reader.length, (u64) SEARCH_BINARY_PROBE_BYTES), 0) != NULL;
+			if (*is_binary) break;
+		}
+
+		// a line cut by the window edge is searched whole by the next window,
+		// unless it is longer than the window itself
+		u64 length = reader.length;
+		if (reader.offset + length < file->size) {
+			const u8 *last_newline = bytes_find_last(reader.data, length, '\n');
+			if (last_newline) length = (u64) (last_newline - reader.data) + 1;
+		}
+
+		search_lines(search, reader.data, length, reader.offset, &line_number);
+		reader.offset += length;
+		flush_hits(search, length);
+	}
+	mapped_reader_end(&reader);
+}
+
+static void search_file (FileSearch *search, const char *path) {
+	MappedFile file;
+	if (!mapped_file_open(&file, path)) {
+		return;
+	}
+	search->path = path;
+	search->num_file_hits = 0;
+
+	bool is_binary = false;
+	search_contents(search, &file, &is_binary);
+	mapped_file_close(&file);
+
+	SDL_LockMutex(search->run->mutex);
+	search->run->stats.num_files_searched++;
+	search->run->stats.num_binary_files += is_binary;
+	SDL_UnlockMutex(search->run->mutex);
+}
+
+static void search_job (void *data) {
+	SearchJob *job = data;
+	SearchRun *run = job->run;
+
+	FileSearch search = { .run = run };
+	search.read_buffer = SDL_malloc(SEARCH_READ_LIMIT);
+
+	for (u32 i = job->first; i < job->end; i++) {
+		if (SDL_GetAtomicInt(&run->cancelled)) break;
+		search_file(&search, run->paths[i]);
+	}
+
+	SDL_free(search.read_buffer);
+	SDL_free(search.hits);
+
+	if (job_counter_complete(&run->counter)) {
+		SDL_LockMutex(run->mutex);
+		run->stats.end_ns = SDL_GetTicksNS();
+		SDL_UnlockMutex(run->mutex);
+		SDL_SetAtomicInt(&run->finished, 1);
+	}
+}
+
+//=============================================================================
+// RUNS
+//=============================================================================
+
+static void free_run (SearchRun *run) {
+	for (u32 i = 0; i < run->num_paths; i++) {
+		SDL_free(run->paths[i]);
+	}
+	SDL_free(run->paths);
+	SDL_free(run->jobs);
+	SDL_free(run->pending);
+	SDL_DestroyMutex(run->mutex);
+	SDL_free(run);
+}
+
+typedef struct JobBuilder {
+	SearchRun *run;
+	u32 jobs_capacity;
+	u32 job_first;
+	u64 job_bytes;
+} JobBuilder;
+
+static void push_job (JobBuilder *builder) {
+	SearchRun *run = builder->run;
+	if (run->num_jobs == builder->jobs_capacity) {
+		builder->jobs_capacity = xtd_max(builder->jobs_capacity * 2, 64u);
+		run->jobs = SDL_realloc(run->jobs, builder->jobs_capacity * sizeof(SearchJob));
+	}
+	run->jobs[run->num_jobs++] = (SearchJob) { run, builder->job_first, run->num_paths };
+	builder->job_first = run->num_paths;
+	builder->job_bytes = 0;
+}
+
+// splits the files into jobs of at most SEARCH_JOB_FILES files or SEARCH_JOB_BYTES
+// bytes, going by the sizes the scanner recorded
+static void collect_files (JobBuilder *builder, Directory *directory) {
+	SearchRun *run = builder->run;
+	for (u32 i = 0; i < directory->num_child_files; i++) {
+		File *file = directory->child_files[i];
+
+		if (file->removed) {
+			continue;
+		}
+
+		// known binary types are counted without being opened
+		if (file_type_of(file)->flags & FILE_TYPE_FLAG_BINARY) {
+			run->stats.num_binary_files++;
+			continue;
+		}
+		if (run->num_paths == run->paths_capacity) {
+			run->paths_capacity = xtd_max(run->paths_capacity * 2, 256u);
+			run->paths = SDL_realloc(run->paths, run->paths_capacity * sizeof(char *));
+		}
+		run->paths[run->num_paths++] = SDL_strdup(file->path);
+		builder->job_bytes += file->size;
+
+		if (run->num_paths - builder->job_first >= SEARCH_JOB_FILES || builder->job_bytes >= SEARCH_JOB_BYTES) {
+			push_job(builder);
+		}
+	}
+	for (u32 i = 0; i < directory->num_child_directories; i++) {
+		if (directory->child_directories[i]->removed) continue;
+		collect_files(builder, directory->child_directories[i]);
+	}
+}
+
+//=============================================================================
+// ENGINE
+//=============================================================================
+
+void search_engine_init (SearchEngine *engine, JobQueue *job_queue) {
+	SDL_memset(engine, 0, sizeof(*engine));
+	engine->job_queue = job_queue;
+}
+
+void search_engine_shutdown (SearchEngine *engine) {
+	while (engine->runs) {
+		SearchRun *run = engine->runs;
+		engine->runs = run->next;
+		free_run(run);
+	}
+	SDL_free(engine->hits);
+	SDL_memset(engine, 0, sizeof(*engine));
+}
+
+void search_cancel (SearchEngine *engine) {
+	if (engine->runs) {
+		SDL_SetAtomicInt(&engine->runs->cancelled, 1);
+	}
+}
+
+bool search_start (SearchEngine *engine, Directory *roots, u32 num_roots, const char *pattern, SearchFlags flags) {
+	search_cancel(engine);
+	engine->num_hits = 0;
+	SDL_memset(&engine->stats, 0, sizeof(engine->stats));
+
+	SearchRun *run = SDL_calloc(1, sizeof(SearchRun));
+	if (!search_pattern_compile(&run->pattern, pattern, flags)) {
+		SDL_free(run);
+		return false;
+	}
+	run->mutex = SDL_CreateMutex();
+	run->next = engine->runs;
+	engine->runs = run;
+
+	JobBuilder builder = { .run = run };
+	for (u32 i = 0; i < num_roots; i++) {
+		collect_files(&builder, &roots[i]);
+	}
+	if (builder.job_first < run->num_paths) {
+		push_job(&builder);
+	}
+	run->stats.num_files = run->num_paths;
+	run->stats.start_ns = SDL_GetTicksNS();
+
+	if (run->num_jobs == 0) {
+		run->stats.end_ns = run->stats.start_ns;
+		SDL_SetAtomicInt(&run->finished, 1);
+		return true;
+	}
+
+	job_counter_set(&run->counter, (i32) run->num_jobs);
+	for (u32 i = 0; i < run->num_jobs; i++) {
+		job_queue_push(engine->job_queue, search_job, &run->jobs[i], JOB_PRIORITY_NORMAL);
+	}
+	return true;
+}
+
+bool search_update (SearchEngine *engine) {
+	// superseded runs are freed once their jobs have drained
+	if (engine->runs) {
+		SearchRun **link = &engine->runs->next;
+		while (*link) {
+			SearchRun *run = *link;
+			if (SDL_GetAtomicInt(&run->finished)) {
+				*link = run->next;
+				free_run(run);
+			} else {
+				link = &run->next;
+			}
+		}
+	}
+
+	SearchRun *run = engine->runs;
+	if (!run) {
+		return false;
+	}
+
+	u32 num_hits_before = engine->num_hits;
+
+	SDL_LockMutex(run->mutex);
+	u32 num_new = xtd_min(run->num_pending, SEARCH_MAX_HITS - engine->num_hits);
+	if (engine->num_hits + num_new > engine->hits_capacity) {
+		engine->hits_capacity = xtd_max(engine->hits_capacity * 2, engine->num_hits + num_new);
+		engine->hits = SDL_realloc(engine->hits, engine->hits_capacity * sizeof(SearchHit));
+	}
+	SDL_memcpy(engine->hits + engine->num_hits, run->pending, num_new * sizeof(SearchHit));
+	engine->num_hits += num_new;
+	run->num_pending = 0;
+	engine->stats = run->stats;
+	SDL_UnlockMutex(run->mutex);
+
+	if (engine->num_hits == SEARCH_MAX_HITS) {
+		SDL_SetAtomicInt(&run->cancelled, 1);
+	}
+	return engine->num_hits != num_hits_before;
+}
+
+bool search_is_busy (SearchEngine *engine) {
+	return engine->runs && !SDL_GetAtomicInt(&engine->runs->finished);
+}
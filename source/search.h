@@ -0,0 +1,109 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "xtdlib.h"
+
+#include <SDL3/SDL.h>
+
+#include "job.h"
+#include "ui.h"
+
+//=============================================================================
+// CONTENT SEARCH
+//=============================================================================
+
+// "Find in files" over the scanned tree. search_start snapshots the file
+// paths below the roots and splits them into jobs of roughly equal byte
+// counts. Each job reads small files into one reused buffer and maps larger
+// ones window by window, skips binaries (a NUL in the first
+// SEARCH_BINARY_PROBE_BYTES) and finds candidate lines by scanning for the
+// first byte of the pattern's required literal with bytes_find, so the
+// per-byte cost is one SSE2 compare; only candidate lines are verified.
+//
+// Patterns are literals, or a small regex subset (. * + ? ^ $ and \ escapes)
+// when SEARCH_FLAG_REGEX is set. Matching is per line, one hit per line.
+//
+// Hits stream into the run as files finish and are moved into engine->hits
+// by search_update on the UI thread. Starting a new search cancels the
+// previous run; jobs check for cancellation between files and between
+// windows, so a superseded run stops within one window of every file in
+// flight.
+
+#define SEARCH_MAX_PATTERN_LENGTH   256
+#define SEARCH_BINARY_PROBE_BYTES   8192
+#define SEARCH_WINDOW_SIZE          (16ull << 20)
+#define SEARCH_READ_LIMIT           (1ull << 20)
+#define SEARCH_JOB_FILES            64
+#define SEARCH_JOB_BYTES            (32ull << 20)
+#define SEARCH_MAX_HITS             100000
+#define SEARCH_MAX_HITS_PER_FILE    1000
+#define SEARCH_HIT_TEXT_LENGTH      160
+
+typedef enum SearchFlags {
+	SEARCH_FLAG_NONE        = 0,
+	SEARCH_FLAG_REGEX       = 1 << 0,
+	SEARCH_FLAG_IGNORE_CASE = 1 << 1
+} SearchFlags;
+
+typedef struct SearchPattern {
+	char text[SEARCH_MAX_PATTERN_LENGTH];
+	u32 length;
+	SearchFlags flags;
+
+	// a literal every matching line must contain; its first byte drives the prefilter
+	char required[SEARCH_MAX_PATTERN_LENGTH];
+	u32 required_length;
+} SearchPattern;
+
+typedef struct SearchHit {
+	const char *path;	// owned by the run, valid while it is the current one
+	u64 line_number;
+	u64 offset;
+	char text[SEARCH_HIT_TEXT_LENGTH];
+	u32 text_length;
+	char line_label[24];
+} SearchHit;
+
+typedef struct SearchStats {
+	u64 num_files;
+	u64 num_files_searched;
+	u64 num_binary_files;
+	u64 bytes_searched;
+	u64 start_ns;
+	u64 end_ns;
+} SearchStats;
+
+typedef struct SearchRun SearchRun;
+
+typedef struct SearchEngine {
+	JobQueue *job_queue;
+	SearchRun *runs;		// newest first; only the head is current
+
+	SearchHit *hits;
+	u32 num_hits;
+	u32 hits_capacity;
+	SearchStats stats;
+} SearchEngine;
+
+void search_engine_init (SearchEngine *engine, JobQueue *job_queue);
+
+// frees every run; call after the job queue is destroyed
+void search_engine_shutdown (SearchEngine *engine);
+
+// compiles pattern; returns false if it is empty or too long
+bool search_pattern_compile (SearchPattern *pattern, const char *text, SearchFlags flags);
+
+// searches every file below the given roots, superseding the current search
+bool search_start (SearchEngine *engine, Directory *roots, u32 num_roots, const char *pattern, SearchFlags flags);
+void search_cancel (SearchEngine *engine);
+
+// moves streamed hits into engine->hits; call once per frame from the UI thread.
+// returns true if hits were added
+bool search_update (SearchEngine *engine);
+
+bool search_is_busy (SearchEngine *engine);
+
+// matches one line (without its newline) against a compiled pattern
+bool search_match_line (const SearchPattern *pattern, const char *line, size_t length);
+
+#endif // SEARCH_H
@@ -0,0 +1,240 @@
+#include "selection.h"
+
+#include <SDL3/SDL.h>
+
+static u32 range_length (RowRange range) {
+	return range.end - range.first;
+}
+
+// first range with end > row
+static u32 first_ending_after (Selection *selection, u32 row) {
+	u32 low = 0, high = selection->num_ranges;
+	while (low < high) {
+		u32 middle = low + (high - low) / 2;
+		if (selection->ranges[middle].end > row) high = middle;
+		else low = middle + 1;
+	}
+	return low;
+}
+
+// first range with first > row
+static u32 first_starting_after (Selection *selection, u32 row) {
+	u32 low = 0, high = selection->num_ranges;
+	while (low < high) {
+		u32 middle = low + (high - low) / 2;
+		if (selection->ranges[middle].first > row) high = middle;
+		else low = middle + 1;
+	}
+	return low;
+}
+
+static void reserve_ranges (Selection *selection, u32 count) {
+	if (count <= selection->capacity) {
+		return;
+	}
+	selection->capacity = xtd_max(xtd_max(selection->capacity * 2, count), 16u);
+	selection->ranges = SDL_realloc(selection->ranges, selection->capacity * sizeof(RowRange));
+}
+
+// replaces ranges [first, end) with the given ones, keeping the row count
+static void splice_ranges (Selection *selection, u32 first, u32 end, const RowRange *with, u32 count) {
+	for (u32 i = first; i < end; i++) {
+		selection->num_selected -= range_length(selection->ranges[i]);
+	}
+	for (u32 i = 0; i < count; i++) {
+		selection->num_selected += range_length(with[i]);
+	}
+	u32 num_ranges = selection->num_ranges - (end - first) + count;
+	reserve_ranges(selection, num_ranges);
+	SDL_memmove(selection->ranges + first + count, selection->ranges + end, (selection->num_ranges - end) * sizeof(RowRange));
+	if (count) {
+		SDL_memcpy(selection->ranges + first, with, count * sizeof(RowRange));
+	}
+	selection->num_ranges = num_ranges;
+}
+
+void selection_init (Selection *selection) {
+	*selection = (Selection) { .anchor = SELECTION_NO_ANCHOR };
+}
+
+void selection_free (Selection *selection) {
+	SDL_free(selection->ranges);
+	SDL_free(selection->remap_nodes);
+	selection_init(selection);
+}
+
+void selection_clear (Selection *selection) {
+	selection->num_ranges = 0;
+	selection->num_selected = 0;
+	selection->anchor = SELECTION_NO_ANCHOR;
+}
+
+void selection_add (Selection *selection, RowRange range) {
+	if (range.first >= range.end) {
+		return;
+	}
+	// everything overlapping or touching the range merges into it
+	u32 first = first_ending_after(selection, range.first ? range.first - 1 : 0);
+	u32 end = first_starting_after(selection, range.end);
+	if (first < end) {
+		range.first = xtd_min(range.first, selection->ranges[first].first);
+		range.end = xtd_max(range.end, selection->ranges[end - 1].end);
+	}
+	splice_ranges(selection, first, end, &range, 1);
+}
+
+void selection_remove (Selection *selection, RowRange range) {
+	if (range.first >= range.end) {
+		return;
+	}
+	u32 first = first_ending_after(selection, range.first);
+	u32 end = first_starting_after(selection, range.end - 1);
+	if (first >= end) {
+		return;
+	}
+	// the ranges at either end may stick out past what is removed
+	RowRange remains[2];
+	u32 num_remains = 0;
+	if (selection->ranges[first].first < range.first) {
+		remains[num_remains++] = (RowRange) { selection->ranges[first].first, range.first };
+	}
+	if (selection->ranges[end - 1].end > range.end) {
+		remains[num_remains++] = (RowRange) { range.end, selection->ranges[end - 1].end };
+	}
+	splice_ranges(selection, first, end, remains, num_remains);
+}
+
+void selection_toggle (Selection *selection, u32 row) {
+	RowRange range = { row, row + 1 };
+	if (selection_contains(selection, row)) {
+		selection_remove(selection, range);
+	} else {
+		selection_add(selection, range);
+	}
+}
+
+void selection_invert (Selection *selection, u32 num_rows) {
+	// the gaps between ranges become the ranges; there is at most one more
+	u32 capacity = selection->num_ranges + 1;
+	RowRange *inverted = SDL_malloc(capacity * sizeof(RowRange));
+	u32 num_inverted = 0;
+	u32 num_selected = 0;
+	u32 next = 0;
+	for (u32 i = 0; i < selection->num_ranges && next < num_rows; i++) {
+		RowRange range = selection->ranges[i];
+		if (range.first > next) {
+			inverted[num_inverted++] = (RowRange) { next, xtd_min(range.first, num_rows) };
+			num_selected += range_length(inverted[num_inverted - 1]);
+		}
+		next = range.end;
+	}
+	if (next < num_rows) {
+		inverted[num_inverted++] = (RowRange) { next, num_rows };
+		num_selected += num_rows - next;
+	}
+	SDL_free(selection->ranges);
+	selection->ranges = inverted;
+	selection->num_ranges = num_inverted;
+	selection->capacity = capacity;
+	selection->num_selected = num_selected;
+}
+
+bool selection_contains (Selection *selection, u32 row) {
+	u32 i = first_ending_after(selection, row);
+	return i < selection->num_ranges && selection->ranges[i].first <= row;
+}
+
+u32 selection_find (Selection *selection, u32 row) {
+	return first_ending_after(selection, row);
+}
+
+//=============================================================================
+// REMAPPING
+//=============================================================================
+
+static const void *row_node (ExplorerRow *row) {
+	return row->directory ? (const void *) row->directory : (const void *) row->file;
+}
+
+static u32 node_slot (Selection *selection, const void *node) {
+	u64 hash = (u64) (uintptr_t) node * 0x9E3779B97F4A7C15ull;
+	return (u32) (hash >> 32) & (selection->remap_capacity - 1);
+}
+
+static void insert_node (Selection *selection, const void *node) {
+	u32 slot = node_slot(selection, node);
+	while (selection->remap_nodes[slot] && selection->remap_nodes[slot] != node) {
+		slot = (slot + 1) & (selection->remap_capacity - 1);
+	}
+	selection->remap_nodes[slot] = node;
+}
+
+static bool contains_node (Selection *selection, const void *node) {
+	u32 slot = node_slot(selection, node);
+	while (selection->remap_nodes[slot]) {
+		if (selection->remap_nodes[slot] == node) return true;
+		slot = (slot + 1) & (selection->remap_capacity - 1);
+	}
+	return false;
+}
+
+void selection_begin_remap (Selection *selection, ExplorerRow *rows, u32 num_rows) {
+	selection->anchor_node = selection->anchor < num_rows ? row_node(&rows[selection->anchor]) : NULL;
+	if (!selection->num_selected) {
+		return;
+	}
+
+	// at most half full
+	u32 capacity = 16;
+	while (capacity < selection->num_selected * 2) capacity *= 2;
+	if (capacity > selection->remap_capacity) {
+		SDL_free(selection->remap_nodes);
+		selection->remap_nodes = SDL_malloc(capacity * sizeof(*selection->remap_nodes));
+		selection->remap_capacity = capacity;
+	}
+	SDL_memset(selection->remap_nodes, 0, selection->remap_capacity * sizeof(*selection->remap_nodes));
+
+	for (u32 i = 0; i < selection->num_ranges; i++) {
+		RowRange range = selection->ranges[i];
+		for (u32 row = range.first; row < xtd_min(range.end, num_rows); row++) {
+			insert_node(selection, row_node(&rows[row]));
+		}
+	}
+}
+
+void selection_end_remap (Selection *selection, ExplorerRow *rows, u32 num_rows) {
+	bool remap = selection->num_selected != 0;
+	selection->num_ranges = 0;
+	selection->num_selected = 0;
+	selection->anchor = SELECTION_NO_ANCHOR;
+	if (!remap && !selection->anchor_node) {
+		return;
+	}
+
+	for (u32 row = 0; row < num_rows; row++) {
+		const void *node = row_node(&rows[row]);
+		if (node == selection->anchor_node) {
+			selection->anchor = row;
+		}
+		if (!remap || !contains_node(selection, node)) {
+			continue;
+		}
+		// rows arrive in order, so a range only ever grows at the end
+		RowRange *last = selection->num_ranges ? &selection->ranges[selection->num_ranges - 1] : NULL;
+		if (last && last->end == row) {
+			last->end++;
+		} else {
+			reserve_ranges(selection, selection->num_ranges + 1);
+			selection->ranges[selection->num_ranges++] = (RowRange) { row, row + 1 };
+		}
+		selection->num_selected++;
+	}
+	selection->anchor_node = NULL;
+
+	// a huge selection should not pin its table once it shrinks
+	if (selection->remap_capacity > 4096 && selection->remap_capacity > selection->num_selected * 8) {
+		SDL_free(selection->remap_nodes);
+		selection->remap_nodes = NULL;
+		selection->remap_capacity = 0;
+	}
+}
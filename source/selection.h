@@ -0,0 +1,64 @@
+#ifndef SELECTION_H
+#define SELECTION_H
+
+#include "xtdlib.h"
+
+#include "scroll.h"
+#include "ui.h"
+
+//=============================================================================
+// SELECTION
+//=============================================================================
+
+// The selected explorer rows, kept as sorted, disjoint and non-adjacent
+// RowRanges over the flattened row order rather than a flag per node, so
+// selecting a million rows with Ctrl+A or Shift+click is a single range.
+// Lookups binary search the ranges; adding or removing a range finds the
+// ones it touches the same way and splices the array in one move, so the
+// cost follows the number of ranges, not the number of rows.
+//
+// Row indices only hold until the rows are rebuilt. Around
+// rebuild_explorer_rows the selected nodes are gathered into a pointer set
+// and the ranges rebuilt from where those nodes land, so selections survive
+// sorting, expansion and file operations; rows that disappear, by being
+// collapsed or removed, leave the selection.
+
+#define SELECTION_NO_ANCHOR UINT32_MAX
+
+typedef struct Selection {
+	RowRange *ranges;
+	u32 num_ranges;
+	u32 capacity;
+	u32 num_selected;		// rows, summed over the ranges
+	u32 anchor;				// the row Shift+click extends from
+
+	// only used while the rows are rebuilt
+	const void **remap_nodes;	// open addressed, power of two sized
+	u32 remap_capacity;
+	const void *anchor_node;
+} Selection;
+
+void selection_init (Selection *selection);
+void selection_free (Selection *selection);
+void selection_clear (Selection *selection);
+
+void selection_add (Selection *selection, RowRange range);
+void selection_remove (Selection *selection, RowRange range);
+void selection_toggle (Selection *selection, u32 row);
+
+// selects every row in [0, num_rows) that was not selected and deselects the rest
+void selection_invert (Selection *selection, u32 num_rows);
+
+bool selection_contains (Selection *selection, u32 row);
+
+// index of the first range ending after row, num_ranges if there is none;
+// a caller visiting rows in order finds its start once and walks from there
+u32 selection_find (Selection *selection, u32 row);
+
+// -- Row rebuilds ------------------------------------------------------------
+
+// call with the rows about to be replaced, then with the new ones
+void selection_begin_remap (Selection *selection, ExplorerRow *rows, u32 num_rows);
+void selection_end_remap (Selection *selection, ExplorerRow *rows, u32 num_rows);
+
+#endif // SELECTION_H
@@ -0,0 +1,449 @@
+#include "sort.h"
+
+// below this many children a single job sorts the whole array
+#define SORT_PARALLEL_THRESHOLD 4096
+#define SORT_INSERTION_THRESHOLD 16
+
+// digit runs are packed into name keys as this byte: above end-of-string, below any character
+#define SORT_DIGIT_RUN_BYTE 0x01
+
+struct SortTask {
+	SortEngine *engine;
+	Directory *directory;
+	SortTarget target;
+	SortColumn column;
+	bool descending;
+	u32 generation;
+
+	void **items;
+	void **result;
+	u32 num_items;
+	struct SortValue *values;	// sizes and times, when the column needs them
+
+	SortKey *keys;
+	SortKey *scratch;
+
+	struct SortRange *ranges;
+	u32 chunk_length;
+	u32 run_length;
+	JobCounter counter;
+	SDL_AtomicInt finished;
+
+	struct SortTask *next;
+};
+
+// copied on the UI thread, which keeps changing the nodes while workers sort
+typedef struct SortValue {
+	u64 size;
+	i64 modified_time;
+} SortValue;
+
+typedef struct SortRange {
+	SortTask *task;
+	u32 begin;
+	u32 end;
+} SortRange;
+
+//=============================================================================
+// KEYS
+//=============================================================================
+
+static inline u8 fold_char (u8 c) {
+	return (c >= 'A' && c <= 'Z') ? (u8) (c + ('a' - 'A')) : c;
+}
+
+static inline bool is_digit (u8 c) {
+	return c >= '0' && c <= '9';
+}
+
+// packs up to 8 case-folded bytes big-endian; stops after the first digit run,
+// whose numeric value is returned through numeric_run
+static u64 pack_name_prefix (const char *name, u64 *numeric_run) {
+	u64 packed = 0;
+	u32 shift = 56;
+	*numeric_run = 0;
+
+	const u8 *c = (const u8 *) name;
+	for (u32 i = 0; i < 8 && c && *c; i++, shift -= 8) {
+		if (is_digit(*c)) {
+			packed |= (u64) SORT_DIGIT_RUN_BYTE << shift;
+			u64 value = 0;
+			for (; is_digit(*c); c++) {
+				u64 next = value * 10 + (*c - '0');
+				value = (next < value) ? UINT64_MAX : next;
+			}
+			*numeric_run = value;
+			break;
+		}
+		packed |= (u64) fold_char(*c++) << shift;
+	}
+
+	return packed;
+}
+
+static u64 pack_folded_bytes (const char *string) {
+	u64 packed = 0;
+	u32 shift = 56;
+	const u8 *c = (const u8 *) string;
+	for (u32 i = 0; i < 8 && c && *c; i++, shift -= 8) {
+		packed |= (u64) fold_char(*c++) << shift;
+	}
+	return packed;
+}
+
+static const char *item_name (SortTask *task, u32 index) {
+	if (task->target == SORT_TARGET_DIRECTORIES) {
+		return ((Directory *) task->items[index])->name;
+	}
+	return ((File *) task->items[index])->name;
+}
+
+static const char *item_extension (SortTask *task, u32 index) {
+	if (task->target == SORT_TARGET_DIRECTORIES) {
+		return NULL;
+	}
+	return ((File *) task->items[index])->extension;
+}
+
+static void build_key (SortTask *task, u32 index, SortKey *key) {
+	u64 numeric_run;
+	u64 name_prefix = pack_name_prefix(item_name(task, index), &numeric_run);
+
+	key->index = index;
+	switch (task->column) {
+	case SORT_COLUMN_NAME:
+		key->primary = name_prefix;
+		key->secondary = numeric_run;
+		break;
+	case SORT_COLUMN_EXTENSION:
+		key->primary = pack_folded_bytes(item_extension(task, index));
+		key->secondary = name_prefix;
+		break;
+	case SORT_COLUMN_SIZE:
+		key->primary = task->values[index].size;
+		key->secondary = name_prefix;
+		break;
+	case SORT_COLUMN_MODIFIED_TIME:
+		// flip the sign bit so negative timestamps order before positive ones
+		key->primary = (u64) task->values[index].modified_time ^ (1ull << 63);
+		key->secondary = name_prefix;
+		break;
+	default:
+		key->primary = 0;
+		key->secondary = 0;
+	}
+}
+
+//=============================================================================
+// COMPARISON
+//=============================================================================
+
+i32 sort_natural_compare (const char *a, const char *b) {
+	const u8 *x = (const u8 *) (a ? a : "");
+	const u8 *y = (const u8 *) (b ? b : "");
+
+	while (*x && *y) {
+		if (is_digit(*x) && is_digit(*y)) {
+			while (*x == '0') x++;
+			while (*y == '0') y++;
+
+			const u8 *run_x = x, *run_y = y;
+			while (is_digit(*x)) x++;
+			while (is_digit(*y)) y++;
+
+			size_t length_x = x - run_x, length_y = y - run_y;
+			if (length_x != length_y) return length_x < length_y ? -1 : 1;
+
+			i32 result = SDL_memcmp(run_x, run_y, length_x);
+			if (result != 0) return result < 0 ? -1 : 1;
+			continue;
+		}
+
+		u8 fx = is_digit(*x) ? SORT_DIGIT_RUN_BYTE : fold_char(*x);
+		u8 fy = is_digit(*y) ? SORT_DIGIT_RUN_BYTE : fold_char(*y);
+		if (fx != fy) return fx < fy ? -1 : 1;
+		x++;
+		y++;
+	}
+
+	if (*x == *y) return 0;
+	return *x ? 1 : -1;
+}
+
+static i32 folded_compare (const char *a, const char *b) {
+	const u8 *x = (const u8 *) (a ? a : "");
+	const u8 *y = (const u8 *) (b ? b : "");
+	while (*x && fold_char(*x) == fold_char(*y)) {
+		x++;
+		y++;
+	}
+	return (i32) fold_char(*x) - (i32) fold_char(*y);
+}
+
+static inline i32 compare_keys (SortTask *task, const SortKey *a, const SortKey *b) {
+	if (a->primary != b->primary) return a->primary < b->primary ? -1 : 1;
+	if (a->secondary != b->secondary) return a->secondary < b->secondary ? -1 : 1;
+
+	i32 result = 0;
+	if (task->column == SORT_COLUMN_EXTENSION) {
+		result = folded_compare(item_extension(task, a->index), item_extension(task, b->index));
+	}
+	if (result == 0) {
+		result = sort_natural_compare(item_name(task, a->index), item_name(task, b->index));
+	}
+	if (result == 0) {
+		result = (a->index < b->index) ? -1 : (a->index > b->index);
+	}
+	return result;
+}
+
+//=============================================================================
+// MERGE SORT
+//=============================================================================
+
+static void merge_runs (SortTask *task, const SortKey *source, SortKey *destination, u32 begin, u32 middle, u32 end) {
+	u32 left = begin, right = middle, out = begin;
+	while (left < middle && right < end) {
+		if (compare_keys(task, &source[right], &source[left]) < 0) {
+			destination[out++] = source[right++];
+		} else {
+			destination[out++] = source[left++];
+		}
+	}
+	while (left < middle) destination[out++] = source[left++];
+	while (right < end)   destination[out++] = source[right++];
+}
+
+// sorts keys[begin, end) in place using the same range of scratch
+static void merge_sort (SortTask *task, SortKey *keys, SortKey *scratch, u32 begin, u32 end) {
+	if (end - begin <= SORT_INSERTION_THRESHOLD) {
+		for (u32 i = begin + 1; i < end; i++) {
+			SortKey key = keys[i];
+			u32 j = i;
+			while (j > begin && compare_keys(task, &key, &keys[j - 1]) < 0) {
+				keys[j] = keys[j - 1];
+				j--;
+			}
+			keys[j] = key;
+		}
+		return;
+	}
+
+	u32 middle = begin + (end - begin) / 2;
+	merge_sort(task, keys, scratch, begin, middle);
+	merge_sort(task, keys, scratch, middle, end);
+
+	if (compare_keys(task, &keys[middle - 1], &keys[middle]) <= 0) {
+		return;
+	}
+
+	merge_runs(task, keys, scratch, begin, middle, end);
+	SDL_memcpy(&keys[begin], &scratch[begin], (end - begin) * sizeof(SortKey));
+}
+
+//=============================================================================
+// JOBS
+//=============================================================================
+
+static void merge_pass_job (void *data);
+
+static void finish_task (SortTask *task) {
+	task->result = SDL_malloc(task->num_items * sizeof(void *));
+	for (u32 i = 0; i < task->num_items; i++) {
+		u32 position = task->descending ? (task->num_items - 1 - i) : i;
+		task->result[i] = task->items[task->keys[position].index];
+	}
+	SDL_SetAtomicInt(&task->finished, 1);
+}
+
+// called by whichever job completed the previous stage; runs single-threaded
+static void schedule_next_pass (SortTask *task) {
+	if (task->run_length >= task->num_items) {
+		finish_task(task);
+		return;
+	}
+
+	u32 pair_length = task->run_length * 2;
+	u32 num_pairs = (task->num_items + pair_length - 1) / pair_length;
+	SortRange *ranges = SDL_malloc(num_pairs * sizeof(SortRange));
+	task->ranges = ranges;
+
+	job_counter_set(&task->counter, (i32) num_pairs);
+	for (u32 i = 0; i < num_pairs; i++) {
+		ranges[i].task = task;
+		ranges[i].begin = i * pair_length;
+		ranges[i].end = xtd_min(ranges[i].begin + pair_length, task->num_items);
+		job_queue_push(task->engine->job_queue, merge_pass_job, &ranges[i], JOB_PRIORITY_HIGH);
+	}
+}
+
+static void merge_pass_job (void *data) {
+	SortRange *range = data;
+	SortTask *task = range->task;
+
+	u32 middle = xtd_min(range->begin + task->run_length, range->end);
+	merge_runs(task, task->keys, task->scratch, range->begin, middle, range->end);
+
+	if (job_counter_complete(&task->counter)) {
+		SDL_free(task->ranges);
+		task->ranges = NULL;
+
+		SortKey *merged = task->scratch;
+		task->scratch = task->keys;
+		task->keys = merged;
+		task->run_length *= 2;
+
+		schedule_next_pass(task);
+	}
+}
+
+static void chunk_job (void *data) {
+	SortRange *range = data;
+	SortTask *task = range->task;
+
+	for (u32 i = range->begin; i < range->end; i++) {
+		build_key(task, i, &task->keys[i]);
+	}
+	merge_sort(task, task->keys, task->scratch, range->begin, range->end);
+
+	if (job_counter_complete(&task->counter)) {
+		SDL_free(task->ranges);
+		task->ranges = NULL;
+		task->run_length = task->chunk_length;
+		schedule_next_pass(task);
+	}
+}
+
+//=============================================================================
+// ENGINE
+//=============================================================================
+
+static void free_task (SortTask *task) {
+	SDL_free(task->items);
+	SDL_free(task->values);
+	SDL_free(task->result);
+	SDL_free(task->keys);
+	SDL_free(task->scratch);
+	SDL_free(task->ranges);
+	SDL_free(task);
+}
+
+static void queue_task (SortEngine *engine, Directory *directory, SortTarget target, SortColumn column, bool descending) {
+	void **children = (target == SORT_TARGET_DIRECTORIES) ?
+		(void **) directory->child_directories : (void **) directory->child_files;
+	u32 num_children = (target == SORT_TARGET_DIRECTORIES) ?
+		directory->num_child_directories : directory->num_child_files;
+
+	if (num_children < 2) {
+		return;
+	}
+
+	SortTask *task = SDL_calloc(1, sizeof(SortTask));
+	task->engine = engine;
+	task->directory = directory;
+	task->target = target;
+	task->column = column;
+	task->descending = descending;
+	task->generation = directory->sort_generation;
+	task->num_items = num_children;
+
+	// snapshot the pointers so workers never read an array the UI thread may replace
+	task->items = SDL_malloc(num_children * sizeof(void *));
+	SDL_memcpy(task->items, children, num_children * sizeof(void *));
+
+	// stats and file sizes are written by the UI thread as listings attach
+	// and files change, so workers read copies taken here
+	if (column == SORT_COLUMN_SIZE || column == SORT_COLUMN_MODIFIED_TIME) {
+		task->values = SDL_malloc(num_children * sizeof(SortValue));
+		for (u32 i = 0; i < num_children; i++) {
+			if (target == SORT_TARGET_DIRECTORIES) {
+				Directory *child = children[i];
+				task->values[i] = (SortValue) { child->stats.total_size, child->modified_time };
+			} else {
+				File *child = children[i];
+				task->values[i] = (SortValue) { child->size, child->modified_time };
+			}
+		}
+	}
+	task->keys = SDL_malloc(num_children * sizeof(SortKey));
+	task->scratch = SDL_malloc(num_children * sizeof(SortKey));
+
+	u32 num_chunks = 1;
+	if (num_children >= SORT_PARALLEL_THRESHOLD) {
+		num_chunks = xtd_max(engine->job_queue->num_threads, 1u);
+	}
+	task->chunk_length = (num_children + num_chunks - 1) / num_chunks;
+	num_chunks = (num_children + task->chunk_length - 1) / task->chunk_length;
+
+	task->next = engine->tasks;
+	engine->tasks = task;
+
+	SortRange *ranges = SDL_malloc(num_chunks * sizeof(SortRange));
+	task->ranges = ranges;
+	job_counter_set(&task->counter, (i32) num_chunks);
+	for (u32 i = 0; i < num_chunks; i++) {
+		ranges[i].task = task;
+		ranges[i].begin = i * task->chunk_length;
+		ranges[i].end = xtd_min(ranges[i].begin + task->chunk_length, num_children);
+		job_queue_push(engine->job_queue, chunk_job, &ranges[i], JOB_PRIORITY_HIGH);
+	}
+}
+
+void sort_engine_init (SortEngine *engine, JobQueue *job_queue) {
+	engine->job_queue = job_queue;
+	engine->tasks = NULL;
+}
+
+// the job queue must already be destroyed so no worker still references a task
+void sort_engine_shutdown (SortEngine *engine) {
+	while (engine->tasks) {
+		SortTask *task = engine->tasks;
+		engine->tasks = task->next;
+		free_task(task);
+	}
+}
+
+void sort_directory_children (SortEngine *engine, Directory *directory, SortColumn column, bool descending) {
+	directory->sort_generation++;
+	queue_task(engine, directory, SORT_TARGET_DIRECTORIES, column, descending);
+	queue_task(engine, directory, SORT_TARGET_FILES, column, descending);
+}
+
+bool sort_engine_update (SortEngine *engine) {
+	bool published = false;
+	SortTask **link = &engine->tasks;
+	while (*link) {
+		SortTask *task = *link;
+		if (!SDL_GetAtomicInt(&task->finished)) {
+			link = &task->next;
+			continue;
+		}
+		*link = task->next;
+
+		Directory *directory = task->directory;
+		bool is_current = (task->generation == directory->sort_generation);
+
+		if (is_current && task->target == SORT_TARGET_DIRECTORIES &&
+			task->num_items == directory->num_child_directories) {
+			SDL_free(directory->child_directories);
+			directory->child_directories = (Directory **) task->result;
+			task->result = NULL;
+			published = true;
+		}
+		else if (is_current && task->target == SORT_TARGET_FILES &&
+			task->num_items == directory->num_child_files) {
+			SDL_free(directory->child_files);
+			directory->child_files = (File **) task->result;
+			task->result = NULL;
+			published = true;
+		}
+
+		free_task(task);
+	}
+
+	return published;
+}
+
+bool sort_engine_is_busy (SortEngine *engine) {
+	return engine->tasks != NULL;
+}
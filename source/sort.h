@@ -0,0 +1,61 @@
+#ifndef SORT_H
+#define SORT_H
+
+#include "xtdlib.h"
+
+#include "job.h"
+#include "ui.h"
+
+//=============================================================================
+// SORT ENGINE
+//=============================================================================
+
+// Sorts the child arrays of a Directory on the job queue. Every child gets a
+// precomputed SortKey so nearly all comparisons are two integer compares; the
+// full natural-order string compare only runs when both keys tie. Chunks are
+// key-built and merge sorted in parallel, then merged pairwise in parallel
+// passes. The finished, permuted pointer array is swapped into the Directory
+// by sort_engine_update on the UI thread, so layout never sees a partial sort.
+
+typedef enum SortColumn {
+	SORT_COLUMN_NAME,
+	SORT_COLUMN_EXTENSION,
+	SORT_COLUMN_SIZE,
+	SORT_COLUMN_MODIFIED_TIME,
+	NUM_SORT_COLUMNS
+} SortColumn;
+
+typedef enum SortTarget {
+	SORT_TARGET_DIRECTORIES,
+	SORT_TARGET_FILES
+} SortTarget;
+
+typedef struct SortKey {
+	u64 primary;
+	u64 secondary;
+	u32 index;
+} SortKey;
+
+typedef struct SortTask SortTask;
+
+typedef struct SortEngine {
+	JobQueue *job_queue;
+	SortTask *tasks;
+} SortEngine;
+
+void sort_engine_init (SortEngine *engine, JobQueue *job_queue);
+void sort_engine_shutdown (SortEngine *engine);
+
+// queues a sort of both child arrays, superseding any sort still in flight
+void sort_directory_children (SortEngine *engine, Directory *directory, SortColumn column, bool descending);
+
+// publishes finished sorts; call once per frame from the UI thread.
+// returns true if any child array was reordered
+bool sort_engine_update (SortEngine *engine);
+
+bool sort_engine_is_busy (SortEngine *engine);
+
+// case-insensitive compare with digit runs ordered by numeric value
+i32 sort_natural_compare (const char *a, const char *b);
+
+#endif // SORT_H
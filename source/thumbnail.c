@@ -0,0 +1,407 @@
+#include "thumbnail.h"
+
+#include <SDL3_image/SDL_image.h>
+
+#include "filetype.h"
+#include "scan.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define THUMBNAIL_USE_SSE2 1
+	#include <emmintrin.h>
+#endif
+
+struct ThumbnailTask {
+	File *file;		// UI thread only; NULL once cancelled
+
+	char *path;
+	char *cache_path;
+	i64 modified_time;
+	u64 size;
+
+	SDL_AtomicInt cancelled;
+	SDL_AtomicInt finished;
+
+	// written by the job before finished is set
+	u8 *pixels;
+	u32 width;
+	u32 height;
+	bool from_cache;
+};
+
+typedef struct ThumbnailCacheHeader {
+	u32 magic;
+	u32 version;
+	u32 width;
+	u32 height;
+	u64 size;
+	i64 modified_time;
+} ThumbnailCacheHeader;
+
+bool thumbnail_is_supported (const File *file) {
+	return (file_type_of(file)->flags & FILE_TYPE_FLAG_THUMBNAIL) != 0;
+}
+
+//=============================================================================
+// DOWNSAMPLING
+//=============================================================================
+
+// adds one row of RGBA8 pixels into per-channel u32 sums
+static void accumulate_row (u32 *sums, const u8 *row, u32 width) {
+	u32 x = 0;
+
+#if THUMBNAIL_USE_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	for (; x + 4 <= width; x += 4) {
+		__m128i pixels = _mm_loadu_si128((const __m128i *) (row + x * 4));
+		__m128i low = _mm_unpacklo_epi8(pixels, zero);
+		__m128i high = _mm_unpackhi_epi8(pixels, zero);
+
+		__m128i *out = (__m128i *) (sums + x * 4);
+		_mm_storeu_si128(out + 0, _mm_add_epi32(_mm_loadu_si128(out + 0), _mm_unpacklo_epi16(low, zero)));
+		_mm_storeu_si128(out + 1, _mm_add_epi32(_mm_loadu_si128(out + 1), _mm_unpackhi_epi16(low, zero)));
+		_mm_storeu_si128(out + 2, _mm_add_epi32(_mm_loadu_si128(out + 2), _mm_unpacklo_epi16(high, zero)));
+		_mm_storeu_si128(out + 3, _mm_add_epi32(_mm_loadu_si128(out + 3), _mm_unpackhi_epi16(high, zero)));
+	}
+#endif
+
+	for (; x < width; x++) {
+		for (u32 channel = 0; channel < 4; channel++) {
+			sums[x * 4 + channel] += row[x * 4 + channel];
+		}
+	}
+}
+
+// averages sums[x0, x1) into one RGBA8 pixel
+static void resolve_pixel (const u32 *sums, u32 x0, u32 x1, u32 num_rows, u8 *out) {
+	f32 scale = 1.0f / (f32) ((x1 - x0) * num_rows);
+
+#if THUMBNAIL_USE_SSE2
+	__m128i total = _mm_setzero_si128();
+	for (u32 x = x0; x < x1; x++) {
+		total = _mm_add_epi32(total, _mm_loadu_si128((const __m128i *) (sums + x * 4)));
+	}
+	__m128i average = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(total), _mm_set1_ps(scale)));
+	__m128i words = _mm_packs_epi32(average, average);
+	__m128i packed = _mm_packus_epi16(words, words);
+	u32 pixel = (u32) _mm_cvtsi128_si32(packed);
+	SDL_memcpy(out, &pixel, 4);
+#else
+	for (u32 channel = 0; channel < 4; channel++) {
+		u32 total = 0;
+		for (u32 x = x0; x < x1; x++) {
+			total += sums[x * 4 + channel];
+		}
+		out[channel] = (u8) xtd_min((u32) ((f32) total * scale + 0.5f), 255u);
+	}
+#endif
+}
+
+// every destination pixel averages the block of source pixels it covers. Rows
+// of a block are summed first, so each source byte is touched once
+void thumbnail_downsample (const u8 *src, u32 src_width, u32 src_height, u32 src_pitch,
+	u8 *dst, u32 dst_width, u32 dst_height) {
+	u32 *sums = SDL_malloc((size_t) src_width * 4 * sizeof(u32));
+
+	for (u32 y = 0; y < dst_height; y++) {
+		u32 y0 = (u32) ((u64) y * src_height / dst_height);
+		u32 y1 = xtd_max((u32) ((u64) (y + 1) * src_height / dst_height), y0 + 1);
+
+		SDL_memset(sums, 0, (size_t) src_width * 4 * sizeof(u32));
+		for (u32 row = y0; row < y1; row++) {
+			accumulate_row(sums, src + (size_t) row * src_pitch, src_width);
+		}
+
+		for (u32 x = 0; x < dst_width; x++) {
+			u32 x0 = (u32) ((u64) x * src_width / dst_width);
+			u32 x1 = xtd_max((u32) ((u64) (x + 1) * src_width / dst_width), x0 + 1);
+			resolve_pixel(sums, x0, x1, y1 - y0, dst + ((size_t) y * dst_width + x) * 4);
+		}
+	}
+
+	SDL_free(sums);
+}
+
+//=============================================================================
+// DISK CACHE
+//=============================================================================
+
+static u64 hash_bytes (u64 hash, const void *data, size_t length) {
+	const u8 *bytes = data;
+	for (size_t i = 0; i < length; i++) {
+		hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+	}
+	return hash;
+}
+
+static char *cache_path_for (ThumbnailService *service, const char *path, i64 modified_time, u64 size) {
+	u64 hash = 0xcbf29ce484222325ull;
+	hash = hash_bytes(hash, path, SDL_strlen(path));
+	hash = hash_bytes(hash, &modified_time, sizeof(modified_time));
+	hash = hash_bytes(hash, &size, sizeof(size));
+
+	char name[32];
+	SDL_snprintf(name, sizeof(name), "%016llx.thumb", (unsigned long long) hash);
+	return join_path(service->cache_directory, name);
+}
+
+static bool read_cache (ThumbnailTask *task) {
+	size_t length = 0;
+	u8 *data = SDL_LoadFile(task->cache_path, &length);
+	if (!data) {
+		return false;
+	}
+
+	// the key is a hash, so the header repeats what it was built from
+	ThumbnailCacheHeader header;
+	bool valid = length >= sizeof(header);
+	if (valid) {
+		SDL_memcpy(&header, data, sizeof(header));
+		valid = header.magic == THUMBNAIL_CACHE_MAGIC && header.version == THUMBNAIL_CACHE_VERSION &&
+			header.size == task->size && header.modified_time == task->modified_time &&
+			header.width > 0 && header.width <= THUMBNAIL_SIZE && header.height > 0 && header.height <= THUMBNAIL_SIZE &&
+			length == sizeof(header) + (size_t) header.width * header.height * 4;
+	}
+	if (valid) {
+		task->width = header.width;
+		task->height = header.height;
+		task->pixels = SDL_malloc((size_t) header.width * header.height * 4);
+		SDL_memcpy(task->pixels, data + sizeof(header), (size_t) header.width * header.height * 4);
+		task->from_cache = true;
+	}
+	SDL_free(data);
+	return valid;
+}
+
+static void write_cache (ThumbnailTask *task) {
+	ThumbnailCacheHeader header = {
+		.magic = THUMBNAIL_CACHE_MAGIC,
+		.version = THUMBNAIL_CACHE_VERSION,
+		.width = task->width,
+		.height = task->height,
+		.size = task->size,
+		.modified_time = task->modified_time,
+	};
+	size_t pixels_length = (size_t) task->width * task->height * 4;
+	size_t length = sizeof(header) + pixels_length;
+	u8 *data = SDL_malloc(length);
+	SDL_memcpy(data, &header, sizeof(header));
+	SDL_memcpy(data + sizeof(header), task->pixels, pixels_length);
+
+	// written aside and renamed, so a reader never sees a partial entry
+	char temporary_path[1024];
+	SDL_snprintf(temporary_path, sizeof(temporary_path), "%s.%p.tmp", task->cache_path, (void *) task);
+	if (SDL_SaveFile(temporary_path, data, length) && !SDL_RenamePath(temporary_path, task->cache_path)) {
+		SDL_RemovePath(temporary_path);
+	}
+	SDL_free(data);
+}
+
+//=============================================================================
+// DECODING
+//=============================================================================
+
+static bool decode (ThumbnailTask *task) {
+	SDL_Surface *surface = IMG_Load(task->path);
+	if (!surface) {
+		return false;
+	}
+	SDL_Surface *rgba = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_RGBA32);
+	SDL_DestroySurface(surface);
+	if (!rgba || rgba->w <= 0 || rgba->h <= 0) {
+		if (rgba) SDL_DestroySurface(rgba);
+		return false;
+	}
+
+	// fit inside THUMBNAIL_SIZE keeping the aspect ratio, never upscaling
+	u32 width = (u32) rgba->w;
+	u32 height = (u32) rgba->h;
+	u32 longest = xtd_max(width, height);
+	if (longest > THUMBNAIL_SIZE) {
+		width = xtd_max((u32) ((u64) width * THUMBNAIL_SIZE / longest), 1u);
+		height = xtd_max((u32) ((u64) height * THUMBNAIL_SIZE / longest), 1u);
+	}
+
+	if (!SDL_GetAtomicInt(&task->cancelled)) {
+		task->pixels = SDL_malloc((size_t) width * height * 4);
+		task->width = width;
+		task->height = height;
+		thumbnail_downsample(rgba->pixels, (u32) rgba->w, (u32) rgba->h, (u32) rgba->pitch,
+			task->pixels, width, height);
+	}
+	SDL_DestroySurface(rgba);
+	return task->pixels != NULL;
+}
+
+static void thumbnail_job (void *data) {
+	ThumbnailTask *task = data;
+
+	if (!SDL_GetAtomicInt(&task->cancelled) && !read_cache(task)) {
+		if (!SDL_GetAtomicInt(&task->cancelled) && decode(task)) {
+			write_cache(task);
+		}
+	}
+	SDL_SetAtomicInt(&task->finished, 1);
+}
+
+//=============================================================================
+// SERVICE
+//=============================================================================
+
+void thumbnail_service_init (ThumbnailService *service, JobQueue *job_queue, SDL_Renderer *renderer) {
+	SDL_memset(service, 0, sizeof(*service));
+	service->job_queue = job_queue;
+	service->renderer = renderer;
+	service->max_tasks = xtd_min(job_queue->num_threads * 2, (u32) THUMBNAIL_MAX_TASKS);
+
+	char *preferences = SDL_GetPrefPath("grant-tm", "iq");
+	if (preferences) {
+		service->cache_directory = join_path(preferences, "thumbnails");
+		SDL_CreateDirectory(service->cache_directory);
+		SDL_free(preferences);
+	}
+}
+
+static void free_task (ThumbnailTask *task) {
+	SDL_free(task->path);
+	SDL_free(task->cache_path);
+	SDL_free(task->pixels);
+	SDL_free(task);
+}
+
+void thumbnail_service_shutdown (ThumbnailService *service) {
+	for (u32 i = 0; i < THUMBNAIL_MAX_TASKS; i++) {
+		if (service->tasks[i]) free_task(service->tasks[i]);
+	}
+	SDL_free(service->resident);
+	SDL_free(service->cache_directory);
+	SDL_memset(service, 0, sizeof(*service));
+}
+
+static void upload (ThumbnailService *service, ThumbnailTask *task) {
+	File *file = task->file;
+	if (!task->pixels) {
+		file->thumbnail_state = THUMBNAIL_STATE_FAILED;
+		return;
+	}
+
+	SDL_Texture *texture = SDL_CreateTexture(service->renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC,
+		(i32) task->width, (i32) task->height);
+	if (!texture) {
+		file->thumbnail_state = THUMBNAIL_STATE_FAILED;
+		return;
+	}
+	SDL_UpdateTexture(texture, NULL, task->pixels, (i32) task->width * 4);
+	file->thumbnail = texture;
+	file->thumbnail_state = THUMBNAIL_STATE_READY;
+
+	if (service->num_resident == service->resident_capacity) {
+		service->resident_capacity = xtd_max(service->resident_capacity * 2, 64u);
+		service->resident = SDL_realloc(service->resident, service->resident_capacity * sizeof(File *));
+	}
+	service->resident[service->num_resident++] = file;
+	service->num_textures++;
+
+	if (task->from_cache) service->num_cache_hits++;
+	else service->num_decoded++;
+}
+
+static void destroy_texture (ThumbnailService *service, File *file) {
+	SDL_DestroyTexture(file->thumbnail);
+	file->thumbnail = NULL;
+	file->thumbnail_state = THUMBNAIL_STATE_NONE;
+	service->num_textures--;
+}
+
+void thumbnail_release (ThumbnailService *service, File *file) {
+	if (!service || !file->thumbnail) {
+		return;
+	}
+	for (u32 i = 0; i < service->num_resident; i++) {
+		if (service->resident[i] == file) {
+			service->resident[i] = NULL;
+			break;
+		}
+	}
+	destroy_texture(service, file);
+}
+
+// oldest first, keeping what is on screen; the survivors are packed to the
+// front, in the order they were uploaded
+static void evict_textures (ThumbnailService *service, ExplorerRow *rows, RowRange visible) {
+	if (service->num_textures <= THUMBNAIL_MAX_TEXTURES && service->num_resident < service->resident_capacity) {
+		return;
+	}
+	u32 kept = 0;
+	for (u32 i = 0; i < service->num_resident; i++) {
+		File *file = service->resident[i];
+		if (!file) continue;
+		if (service->num_textures > THUMBNAIL_MAX_TEXTURES && !explorer_rows_contain_file(rows, visible, file)) {
+			destroy_texture(service, file);
+			service->num_evicted++;
+			continue;
+		}
+		service->resident[kept++] = file;
+	}
+	service->num_resident = kept;
+}
+
+static void start_task (ThumbnailService *service, u32 slot, File *file) {
+	ThumbnailTask *task = SDL_calloc(1, sizeof(ThumbnailTask));
+	task->file = file;
+	task->path = SDL_strdup(file->path);
+	task->modified_time = file->modified_time;
+	task->size = file->size;
+	task->cache_path = cache_path_for(service, file->path, file->modified_time, file->size);
+
+	file->thumbnail_state = THUMBNAIL_STATE_LOADING;
+	service->tasks[slot] = task;
+	job_queue_push(service->job_queue, thumbnail_job, task, JOB_PRIORITY_NORMAL);
+}
+
+void thumbnail_update (ThumbnailService *service, ExplorerRow *rows, RowRange visible) {
+	if (!service->job_queue || !service->cache_directory) {
+		return;
+	}
+
+	u32 num_active = 0;
+	for (u32 i = 0; i < THUMBNAIL_MAX_TASKS; i++) {
+		ThumbnailTask *task = service->tasks[i];
+		if (!task) continue;
+
+		if (SDL_GetAtomicInt(&task->finished)) {
+			if (task->file) upload(service, task);
+			free_task(task);
+			service->tasks[i] = NULL;
+			continue;
+		}
+
+		// a cancelled task keeps its slot until its job returns, but stops counting
+		// against the pool so the rows that replaced it start right away
+		if (task->file && !explorer_rows_contain_file(rows, visible, task->file)) {
+			SDL_SetAtomicInt(&task->cancelled, 1);
+			task->file->thumbnail_state = THUMBNAIL_STATE_NONE;
+			task->file = NULL;
+		}
+		num_active += (task->file != NULL);
+	}
+	evict_textures(service, rows, visible);
+
+	u32 slot = 0;
+	for (u32 i = visible.first; i < visible.end && num_active < service->max_tasks; i++) {
+		File *file = rows[i].file;
+		if (!file || file->thumbnail_state != THUMBNAIL_STATE_NONE) continue;
+
+		// files without a known extension are sniffed first
+		if (file->type_source == FILE_TYPE_SOURCE_NONE || file->type_source == FILE_TYPE_SOURCE_SNIFF_PENDING) continue;
+		if (!thumbnail_is_supported(file)) {
+			file->thumbnail_state = THUMBNAIL_STATE_FAILED;
+			continue;
+		}
+
+		while (slot < THUMBNAIL_MAX_TASKS && service->tasks[slot]) slot++;
+		if (slot == THUMBNAIL_MAX_TASKS) break;
+
+		start_task(service, slot, file);
+		num_active++;
+	}
+}
@@ -0,0 +1,88 @@
+#ifndef THUMBNAIL_H
+#define THUMBNAIL_H
+
+#include "xtdlib.h"
+
+#include <SDL3/SDL.h>
+
+#include "job.h"
+#include "scroll.h"
+#include "ui.h"
+
+//=============================================================================
+// THUMBNAILS
+//=============================================================================
+
+// Row-icon thumbnails for image files. Decoding (SDL_image) and downsampling
+// run on a dedicated worker pool; only the texture upload happens on the UI
+// thread. Requests are driven by the virtualized explorer list: every frame
+// thumbnail_update fills the free task slots from the rows being laid out,
+// top to bottom, and cancels in-flight tasks whose rows have scrolled away,
+// so the pool only ever works on what is on screen.
+//
+// Downsampled pixels are stored in an on-disk cache keyed by path, modified
+// time and size, so revisiting a folder costs one small file read per image
+// instead of a decode.
+//
+// At most THUMBNAIL_MAX_TEXTURES textures are kept. Past that, the ones
+// uploaded longest ago are destroyed, skipping those still on screen, and
+// their files go back to THUMBNAIL_STATE_NONE to be reloaded from the disk
+// cache if they scroll back in. Whatever frees a File holding a texture
+// hands it to thumbnail_release first.
+
+#define THUMBNAIL_SIZE              20
+#define THUMBNAIL_MAX_TASKS         16
+#define THUMBNAIL_MAX_TEXTURES      1024
+#define THUMBNAIL_CACHE_MAGIC       0x48545149u	// "IQTH"
+#define THUMBNAIL_CACHE_VERSION     1
+
+typedef enum ThumbnailState {
+	THUMBNAIL_STATE_NONE,
+	THUMBNAIL_STATE_LOADING,
+	THUMBNAIL_STATE_READY,
+	THUMBNAIL_STATE_FAILED
+} ThumbnailState;
+
+typedef struct ThumbnailTask ThumbnailTask;
+
+typedef struct ThumbnailService {
+	JobQueue *job_queue;
+	SDL_Renderer *renderer;
+	char *cache_directory;
+
+	ThumbnailTask *tasks[THUMBNAIL_MAX_TASKS];
+	u32 max_tasks;
+
+	// files holding a texture, oldest upload first; released ones are NULL
+	// until the next eviction pass packs the array
+	File **resident;
+	u32 num_resident;
+	u32 resident_capacity;
+	u32 num_textures;
+
+	u64 num_decoded;
+	u64 num_cache_hits;
+	u64 num_evicted;
+} ThumbnailService;
+
+void thumbnail_service_init (ThumbnailService *service, JobQueue *job_queue, SDL_Renderer *renderer);
+
+// frees the task slots; call after the job queue is destroyed. Textures belong
+// to the renderer and go with it
+void thumbnail_service_shutdown (ThumbnailService *service);
+
+bool thumbnail_is_supported (const File *file);
+
+// uploads finished thumbnails, cancels tasks for rows outside [rows.first, rows.end),
+// evicts textures past the budget and starts tasks for visible rows without
+// one; call once per frame before layout
+void thumbnail_update (ThumbnailService *service, ExplorerRow *rows, RowRange visible);
+
+// destroys the file's texture, if it has one; call before freeing a File
+void thumbnail_release (ThumbnailService *service, File *file);
+
+// downsamples RGBA pixels with a box filter; dst must hold dst_width * dst_height pixels
+void thumbnail_downsample (const u8 *src, u32 src_width, u32 src_height, u32 src_pitch,
+	u8 *dst, u32 dst_width, u32 dst_height);
+
+#endif // THUMBNAIL_H
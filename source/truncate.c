@@ -0,0 +1,285 @@
+#include "truncate.h"
+
+// the widths one string was last fitted to; a row and a tooltip, or the
+// explorer and the search results, show the same name at different widths
+#define TRUNCATE_FITS_PER_ENTRY 4
+
+typedef struct TruncateFit {
+	f32 width;				// negative if unused
+	u64 frame;				// the last frame it was handed out in
+	char *buffer;			// the cut string
+	u32 buffer_length;
+	u32 buffer_capacity;
+} TruncateFit;
+
+struct TruncateEntry {
+	u64 key;				// font, size and contents; 0 if empty
+	char *text;				// copy of the contents, to tell apart strings sharing a key
+	u32 length;
+	u16 font_id;
+	u16 font_size;
+	f32 total_width;
+
+	// built the first time the string does not fit
+	u32 num_codepoints;
+	u32 *offsets;			// byte offset of every codepoint, and the length last
+	f32 *prefix;			// width of the first i codepoints
+
+	TruncateFit fits[TRUNCATE_FITS_PER_ENTRY];
+};
+
+static u64 text_key (u16 font_id, u16 font_size, const char *text, u32 length) {
+	u64 hash = 0xcbf29ce484222325ull;
+	hash = (hash ^ font_id) * 0x100000001b3ull;
+	hash = (hash ^ font_size) * 0x100000001b3ull;
+	for (u32 i = 0; i < length; i++) {
+		hash = (hash ^ (u8) text[i]) * 0x100000001b3ull;
+	}
+	return hash ? hash : 1;
+}
+
+static u32 slot_of (u64 key, u32 num_slots) {
+	return (u32) ((key * 0x9E3779B97F4A7C15ull) >> 32) & (num_slots - 1);
+}
+
+static void free_entries (TextTruncator *truncator) {
+	for (u32 i = 0; i < TRUNCATE_CACHE_SLOTS; i++) {
+		TruncateEntry *entry = &truncator->entries[i];
+		if (entry->key) {
+			SDL_free(entry->text);
+			SDL_free(entry->offsets);
+			for (u32 j = 0; j < TRUNCATE_FITS_PER_ENTRY; j++) {
+				SDL_free(entry->fits[j].buffer);
+			}
+		}
+	}
+	SDL_memset(truncator->entries, 0, TRUNCATE_CACHE_SLOTS * sizeof(TruncateEntry));
+	truncator->num_entries = 0;
+}
+
+static void free_overflow (TextTruncator *truncator) {
+	for (u32 i = 0; i < truncator->num_overflow; i++) {
+		SDL_free(truncator->overflow[i]);
+	}
+	truncator->num_overflow = 0;
+}
+
+void text_truncator_init (TextTruncator *truncator, TTF_Font **fonts) {
+	SDL_zerop(truncator);
+	truncator->fonts = fonts;
+	truncator->entries = SDL_calloc(TRUNCATE_CACHE_SLOTS, sizeof(TruncateEntry));
+	truncator->glyphs = SDL_calloc(TRUNCATE_GLYPH_SLOTS, sizeof(TruncateGlyph));
+}
+
+void text_truncator_shutdown (TextTruncator *truncator) {
+	if (truncator->entries) {
+		free_entries(truncator);
+	}
+	free_overflow(truncator);
+	SDL_free(truncator->entries);
+	SDL_free(truncator->glyphs);
+	SDL_free(truncator->overflow);
+	SDL_zerop(truncator);
+}
+
+void text_truncator_begin_frame (TextTruncator *truncator) {
+	truncator->frame++;
+	free_overflow(truncator);
+	if (truncator->num_entries >= TRUNCATE_CACHE_SLOTS * 3 / 4) {
+		free_entries(truncator);
+	}
+}
+
+//=============================================================================
+// GLYPHS
+//=============================================================================
+
+static f32 glyph_advance (TextTruncator *truncator, u16 font_id, u16 font_size, u32 codepoint) {
+	u64 key = ((u64) font_id << 48) | ((u64) font_size << 32) | codepoint;
+	u32 slot = slot_of(key, TRUNCATE_GLYPH_SLOTS);
+	while (truncator->glyphs[slot].key) {
+		if (truncator->glyphs[slot].key == key) {
+			return truncator->glyphs[slot].advance;
+		}
+		slot = (slot + 1) & (TRUNCATE_GLYPH_SLOTS - 1);
+	}
+
+	TTF_Font *font = truncator->fonts[font_id];
+	int advance = 0;
+	TTF_SetFontSize(font, font_size);
+	TTF_GetGlyphMetrics(font, codepoint, NULL, NULL, NULL, NULL, &advance);
+	truncator->stats.num_glyphs_measured++;
+
+	// a full table still answers, it just stops remembering
+	if (truncator->num_glyphs < TRUNCATE_GLYPH_SLOTS * 3 / 4) {
+		truncator->glyphs[slot] = (TruncateGlyph) { key, (f32) advance };
+		truncator->num_glyphs++;
+	}
+	return (f32) advance;
+}
+
+f32 text_truncator_measure (TextTruncator *truncator, u16 font_id, u16 font_size, const char *text, u32 length) {
+	f32 width = 0;
+	size_t remaining = length;
+	while (remaining) {
+		u32 codepoint = SDL_StepUTF8(&text, &remaining);
+		if (!codepoint) break;
+		width += glyph_advance(truncator, font_id, font_size, codepoint);
+	}
+	return width;
+}
+
+//=============================================================================
+// FITTING
+//=============================================================================
+
+static void build_prefix_table (TextTruncator *truncator, TruncateEntry *entry) {
+	// one allocation for both arrays, sized for the worst case of one byte per codepoint
+	u32 capacity = entry->length + 1;
+	entry->offsets = SDL_malloc(capacity * (sizeof(u32) + sizeof(f32)));
+	entry->prefix = (f32 *) (entry->offsets + capacity);
+
+	const char *text = entry->text;
+	const char *cursor = text;
+	size_t remaining = entry->length;
+	u32 count = 0;
+	f32 width = 0;
+	while (remaining) {
+		entry->offsets[count] = (u32) (cursor - text);
+		entry->prefix[count] = width;
+		u32 codepoint = SDL_StepUTF8(&cursor, &remaining);
+		if (!codepoint) break;
+		width += glyph_advance(truncator, entry->font_id, entry->font_size, codepoint);
+		count++;
+	}
+	entry->offsets[count] = (u32) (cursor - text);
+	entry->prefix[count] = width;
+	entry->num_codepoints = count;
+	truncator->stats.num_tables_built++;
+}
+
+// width of the first head and last tail codepoints
+static f32 split_width (TruncateEntry *entry, u32 head, u32 tail) {
+	u32 n = entry->num_codepoints;
+	return entry->prefix[head] + entry->prefix[n] - entry->prefix[n - tail];
+}
+
+// cuts a string too wide for width, keeping the most codepoints that fit
+// beside the ellipsis, the head getting the odd one; every codepoint kept
+// widens the string, so the count can be binary searched
+static void fit_entry (TextTruncator *truncator, TruncateEntry *entry, TruncateFit *fit, f32 width) {
+	fit->width = width;
+	if (!entry->offsets) {
+		build_prefix_table(truncator, entry);
+	}
+	truncator->stats.num_fitted++;
+
+	f32 budget = width - glyph_advance(truncator, entry->font_id, entry->font_size, 0x2026);
+	u32 low = 0, high = entry->num_codepoints ? entry->num_codepoints - 1 : 0;
+	while (low < high) {
+		u32 middle = low + (high - low + 1) / 2;
+		if (split_width(entry, (middle + 1) / 2, middle / 2) <= budget) low = middle;
+		else high = middle - 1;
+	}
+	u32 head = (low + 1) / 2, tail = low / 2;
+	if (split_width(entry, head, tail) > budget) {
+		head = tail = 0;
+	}
+
+	u32 head_bytes = entry->offsets[head];
+	u32 tail_start = entry->offsets[entry->num_codepoints - tail];
+	u32 tail_bytes = entry->length - tail_start;
+	u32 ellipsis_bytes = sizeof(TRUNCATE_ELLIPSIS) - 1;
+	u32 length = head_bytes + ellipsis_bytes + tail_bytes;
+	if (length > fit->buffer_capacity) {
+		fit->buffer_capacity = length;
+		fit->buffer = SDL_realloc(fit->buffer, length);
+	}
+	SDL_memcpy(fit->buffer, entry->text, head_bytes);
+	SDL_memcpy(fit->buffer + head_bytes, TRUNCATE_ELLIPSIS, ellipsis_bytes);
+	SDL_memcpy(fit->buffer + head_bytes + ellipsis_bytes, entry->text + tail_start, tail_bytes);
+	fit->buffer_length = length;
+}
+
+// the fit for width, or a slot to fit it into: an unused one, else the one
+// handed out longest ago. A slot handed out this frame is never reused, since
+// a Clay_String laid out earlier in the frame still points at its buffer
+static TruncateFit *find_fit (TextTruncator *truncator, TruncateEntry *entry, f32 width) {
+	TruncateFit *oldest = NULL;
+	for (u32 i = 0; i < TRUNCATE_FITS_PER_ENTRY; i++) {
+		TruncateFit *fit = &entry->fits[i];
+		if (fit->width == width) {
+			return fit;
+		}
+		if (!oldest || fit->width < 0 || (oldest->width >= 0 && fit->frame < oldest->frame)) {
+			oldest = fit;
+		}
+	}
+	if (oldest->width >= 0 && oldest->frame == truncator->frame) {
+		return NULL;
+	}
+	oldest->width = -1;
+	return oldest;
+}
+
+static Clay_String keep_for_frame (TextTruncator *truncator, TruncateFit *fit) {
+	if (truncator->num_overflow == truncator->overflow_capacity) {
+		truncator->overflow_capacity = xtd_max(truncator->overflow_capacity * 2, 16u);
+		truncator->overflow = SDL_realloc(truncator->overflow, truncator->overflow_capacity * sizeof(char *));
+	}
+	truncator->overflow[truncator->num_overflow++] = fit->buffer;
+	return (Clay_String) { false, (i32) fit->buffer_length, fit->buffer };
+}
+
+Clay_String text_truncator_fit (TextTruncator *truncator, u16 font_id, u16 font_size, const char *text, f32 width) {
+	u32 length = (u32) SDL_strlen(text);
+	Clay_String whole = { false, (i32) length, text };
+	if (!truncator->entries || !length) {
+		return whole;
+	}
+
+	// a key shared by two strings only means probing on
+	u64 key = text_key(font_id, font_size, text, length);
+	u32 slot = slot_of(key, TRUNCATE_CACHE_SLOTS);
+	for (;;) {
+		TruncateEntry *probe = &truncator->entries[slot];
+		if (!probe->key || (probe->key == key && probe->length == length && SDL_memcmp(probe->text, text, length) == 0)) {
+			break;
+		}
+		slot = (slot + 1) & (TRUNCATE_CACHE_SLOTS - 1);
+	}
+	TruncateEntry *entry = &truncator->entries[slot];
+
+	if (!entry->key) {
+		// fitted strings must outlive the frame, so nothing is evicted until
+		// the next one begins; a cache this full measures without keeping
+		if (truncator->num_entries >= TRUNCATE_CACHE_SLOTS - 1) {
+			return text_truncator_measure(truncator, font_id, font_size, text, length) <= width ? whole :
+				(Clay_String) { true, sizeof(TRUNCATE_ELLIPSIS) - 1, TRUNCATE_ELLIPSIS };
+		}
+		*entry = (TruncateEntry) { .key = key, .length = length, .font_id = font_id, .font_size = font_size };
+		entry->text = SDL_malloc(length);
+		SDL_memcpy(entry->text, text, length);
+		entry->total_width = text_truncator_measure(truncator, font_id, font_size, text, length);
+		for (u32 i = 0; i < TRUNCATE_FITS_PER_ENTRY; i++) {
+			entry->fits[i].width = -1;
+		}
+		truncator->num_entries++;
+	}
+
+	if (entry->total_width <= width) {
+		return whole;
+	}
+	TruncateFit *fit = find_fit(truncator, entry, width);
+	if (!fit) {
+		// more widths of one string in a frame than it keeps
+		TruncateFit scratch = { 0 };
+		fit_entry(truncator, entry, &scratch, width);
+		return keep_for_frame(truncator, &scratch);
+	}
+	if (fit->width != width) {
+		fit_entry(truncator, entry, fit, width);
+	}
+	fit->frame = truncator->frame;
+	return (Clay_String) { false, (i32) fit->buffer_length, fit->buffer };
+}
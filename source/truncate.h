@@ -0,0 +1,83 @@
+#ifndef TRUNCATE_H
+#define TRUNCATE_H
+
+#include "xtdlib.h"
+
+#include <SDL3/SDL.h>
+#include <SDL3_ttf/SDL_ttf.h>
+
+#include "clay.h"
+
+//=============================================================================
+// TEXT TRUNCATION
+//=============================================================================
+
+// Fits names and paths into a pixel width by cutting out their middle,
+// "very_long_na…ame.txt", so both the start and the extension stay visible.
+//
+// Nothing here calls TTF_GetStringSize. Glyph advances are looked up once per
+// font, size and codepoint and kept. The first time a string is fitted its
+// prefix-advance table is built from them: the width of every leading run of
+// codepoints, from which any head and tail width is a subtraction. The split
+// is then a binary search over how many codepoints to keep, half from either
+// end, for the most that fit beside the ellipsis.
+//
+// Strings are cached by font, size and contents, compared in full on a hash
+// hit. Each keeps the cut strings for the last few widths it was fitted to,
+// each in a buffer of its own, so a name fitted to the same width again costs
+// a hash and a lookup, and the same name shown at two widths does not refit
+// every frame. A new width, from the panel being resized or a row's labels
+// growing, reruns only the binary search. Kerning across the cut is not
+// accounted for.
+//
+// A cut string handed out in a frame is never overwritten or freed before
+// the next text_truncator_begin_frame, so it stays valid through layout and
+// rendering of the frame.
+
+#define TRUNCATE_CACHE_SLOTS    8192
+#define TRUNCATE_GLYPH_SLOTS    4096
+#define TRUNCATE_ELLIPSIS       "\xE2\x80\xA6"
+
+typedef struct TruncateEntry TruncateEntry;
+
+typedef struct TruncateGlyph {
+	u64 key;				// font, size and codepoint; 0 if empty
+	f32 advance;
+} TruncateGlyph;
+
+typedef struct TruncateStats {
+	u64 num_fitted;			// strings whose split was searched for
+	u64 num_tables_built;
+	u64 num_glyphs_measured;
+} TruncateStats;
+
+typedef struct TextTruncator {
+	TTF_Font **fonts;
+	TruncateEntry *entries;
+	u32 num_entries;
+	TruncateGlyph *glyphs;
+	u32 num_glyphs;
+	u64 frame;				// counts text_truncator_begin_frame calls
+
+	// cut strings no entry had room for, freed when the next frame begins
+	char **overflow;
+	u32 num_overflow;
+	u32 overflow_capacity;
+
+	TruncateStats stats;
+} TextTruncator;
+
+void text_truncator_init (TextTruncator *truncator, TTF_Font **fonts);
+void text_truncator_shutdown (TextTruncator *truncator);
+
+// empties a cache that filled up over past frames; call before laying out
+void text_truncator_begin_frame (TextTruncator *truncator);
+
+// width of text from cached advances
+f32 text_truncator_measure (TextTruncator *truncator, u16 font_id, u16 font_size, const char *text, u32 length);
+
+// text as is if it fits within width, else with its middle replaced by an
+// ellipsis. A cut string belongs to the cache and lasts until the next frame
+Clay_String text_truncator_fit (TextTruncator *truncator, u16 font_id, u16 font_size, const char *text, f32 width);
+
+#endif // TRUNCATE_H
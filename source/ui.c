@@ -3,6 +3,65 @@
 #include <SDL3/SDL.h>
 
 #include "app.h"
+#include "aggregate.h"
+#include "filetype.h"
+#include "git_status.h"
+
+UiElementIds ui_ids;
+
+//=============================================================================
+// ELEMENT IDS
+//=============================================================================
+
+void ui_init_element_ids (void) {
+	ui_ids.null = CLAY_ID("null");
+	ui_ids.top_level_container = CLAY_ID("TopLevelContainer");
+	ui_ids.application_header = CLAY_ID("ApplicationHeader");
+	ui_ids.application_minimize_button = CLAY_ID("ApplicationMinimizeButton");
+	ui_ids.application_minimize_button_icon = CLAY_ID("ApplicationMinimizeButtonIcon");
+	ui_ids.application_maximize_button = CLAY_ID("ApplicationMaximizeButton");
+	ui_ids.application_maximize_button_icon = CLAY_ID("ApplicationMaximizeButtonIcon");
+	ui_ids.application_close_button = CLAY_ID("ApplicationCloseButton");
+	ui_ids.application_close_button_icon = CLAY_ID("ApplicationCloseButtonIcon");
+	ui_ids.file_explorer = CLAY_ID("FileExplorer");
+	ui_ids.file_explorer_filter_area = CLAY_ID("FileExplorerFilterArea");
+	ui_ids.file_explorer_search_results_area = CLAY_ID("FileExplorerSearchResultsArea");
+	ui_ids.file_explorer_search_results_list = CLAY_ID("FileExplorerSearchResultsList");
+	ui_ids.file_explorer_rows_above = CLAY_ID("FileExplorerRowsAbove");
+	ui_ids.file_explorer_rows_below = CLAY_ID("FileExplorerRowsBelow");
+	ui_ids.file_explorer_search_result_scroll_bar = CLAY_ID("FileExplorerSearchResultScrollBar");
+	ui_ids.file_explorer_search_result_scroll_thumb = CLAY_ID("FileExplorerSearchResultScrollThumb");
+	ui_ids.application_body = CLAY_ID("ApplicationBody");
+	ui_ids.file_preview = CLAY_ID("FilePreview");
+	ui_ids.file_preview_header = CLAY_ID("FilePreviewHeader");
+	ui_ids.file_preview_lines = CLAY_ID("FilePreviewLines");
+	ui_ids.content_column = CLAY_ID("ContentColumn");
+	ui_ids.search_results = CLAY_ID("SearchResults");
+	ui_ids.search_results_header = CLAY_ID("SearchResultsHeader");
+	ui_ids.search_results_list = CLAY_ID("SearchResultsList");
+	ui_ids.duplicates = CLAY_ID("Duplicates");
+	ui_ids.duplicates_header = CLAY_ID("DuplicatesHeader");
+	ui_ids.duplicates_list = CLAY_ID("DuplicatesList");
+	ui_ids.file_operations = CLAY_ID("FileOperations");
+}
+
+// row ids use a per-node serial rather than the row index, so they survive
+// re-sorting and expansion and only ever get hashed once per node
+static void cache_directory_ids (ApplicationState *app, Directory *directory) {
+	if (directory->element_id.id != 0) {
+		return;
+	}
+	u32 serial = app->next_element_serial++;
+	directory->element_id = CLAY_IDI("Directory", serial);
+	directory->expand_icon_id = CLAY_IDI("DirectoryExpandIcon", serial);
+}
+
+static void cache_file_ids (ApplicationState *app, File *file) {
+	if (file->element_id.id != 0) {
+		return;
+	}
+	file->element_id = CLAY_IDI("File", app->next_element_serial++);
+}
 
 //=============================================================================
 // LAYOUTS
@@ -10,7 +69,7 @@
 
 void application_header_layout (ApplicationState *app) {
 	CLAY({
-		.id = CLAY_ID("ApplicationHeader"),
+		.id = ui_ids.application_header,
 		.layout = {
 			.layoutDirection = CLAY_LEFT_TO_RIGHT,
 			.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_FIXED(35) },
@@ -23,7 +82,7 @@ void application_header_layout (ApplicationState *app) {
 	}) {
 		// -- Minimize Button -----------------------------
 		CLAY({
-            .id = CLAY_ID("ApplicationMinimizeButton"),
+            .id = ui_ids.application_minimize_button,
             .layout = { 
 				.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_GROW(0) },
                 .childAlignment = { .x = CLAY_ALIGN_X_CENTER, .y = CLAY_ALIGN_Y_CENTER }
@@ -33,14 +92,14 @@ void application_header_layout (ApplicationState *app) {
         }) {
 			Clay_OnHover(handle_application_minimize_button, (intptr_t) app);
 			CLAY({ 
-				.id = CLAY_ID("ApplicationMinimizeButtonIcon"),	
+				.id = ui_ids.application_minimize_button_icon,	
 				.layout = { .sizing = {.width = CLAY_SIZING_FIXED(12), .height = CLAY_SIZING_FIXED(1)}},
 				.backgroundColor = COLOR_TEXT_LIGHT
 			}) {}
 		}
         // -- Maximize Button -----------------------------
         CLAY({
-            .id = CLAY_ID("ApplicationMaximizeButton"),
+            .id = ui_ids.application_maximize_button,
             .layout = { 
 				.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_GROW(0) },
                 .childAlignment = { .x = CLAY_ALIGN_X_CENTER, .y = CLAY_ALIGN_Y_CENTER }
@@ -50,7 +109,7 @@ void application_header_layout (ApplicationState *app) {
         }) {
 			Clay_OnHover(handle_application_maximize_button, (intptr_t) app);
 			CLAY({
-				.id = CLAY_ID("ApplicationMaximizeButtonIcon"),
+				.id = ui_ids.application_maximize_button_icon,
             	.layout = {
    	            	.sizing = { .width = CLAY_SIZING_FIXED(20), .height = CLAY_SIZING_GROW(0) }
             	},
@@ -63,7 +122,7 @@ void application_header_layout (ApplicationState *app) {
 		}
         // -- Close Button --------------------------------
         CLAY({
-            .id = CLAY_ID("ApplicationCloseButton"),
+            .id = ui_ids.application_close_button,
             .layout = { 
 				.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_GROW(0) },
                 .childAlignment = { .x = CLAY_ALIGN_X_CENTER, .y = CLAY_ALIGN_Y_CENTER } },
@@ -72,7 +131,7 @@ void application_header_layout (ApplicationState *app) {
         }) {
 			Clay_OnHover(handle_application_close_button, (intptr_t) app);
 			CLAY({
-				.id = CLAY_ID("ApplicationCloseButtonIcon"),
+				.id = ui_ids.application_close_button_icon,
             	.layout = {
                 	.sizing = { .width = CLAY_SIZING_FIXED(24), .height = CLAY_SIZING_FIXED(24) }
             	},
@@ -85,39 +144,195 @@ void application_header_layout (ApplicationState *app) {
 	} 
 }
 
-void directory_component (ApplicationState *app, Directory *directory, i32 id) {
+// git status shows as the name's color and a letter at the end of the row;
+// a directory takes the status of what changed below it
+static Clay_Color vcs_status_color (VcsStatus status) {
+	switch (status) {
+	case VCS_STATUS_MODIFIED:  return COLOR_VCS_MODIFIED;
+	case VCS_STATUS_UNTRACKED: return COLOR_VCS_UNTRACKED;
+	case VCS_STATUS_IGNORED:   return COLOR_VCS_IGNORED;
+	default:                   return COLOR_TEXT_LIGHT;
+	}
+}
+
+static VcsStatus directory_vcs_status (Directory *directory) {
+	if (directory->stats.num_modified) return VCS_STATUS_MODIFIED;
+	if (directory->stats.num_untracked) return VCS_STATUS_UNTRACKED;
+	return directory->git_ignored ? VCS_STATUS_IGNORED : VCS_STATUS_NONE;
+}
+
+static const char *vcs_status_letter (VcsStatus status) {
+	switch (status) {
+	case VCS_STATUS_MODIFIED:  return "M";
+	case VCS_STATUS_UNTRACKED: return "U";
+	default:                   return NULL;
+	}
+}
+
+static void vcs_status_marker (VcsStatus status) {
+	const char *letter = vcs_status_letter(status);
+	if (!letter) {
+		return;
+	}
+	Clay_String marker = {true, 1, letter};
+	CLAY({ .layout = { .padding = { 0, 6, 0, 0 } } }) {
+		CLAY_TEXT(marker, CLAY_TEXT_CONFIG({ .textColor = vcs_status_color(status), .fontId = FONT_ID_ROBOTO_REGULAR, .fontSize = 12 }));
+	}
+}
+
+// -- Names -------------------------------------------------------------------
+
+// a 12pt label at the end of a row, with the padding it is laid out with
+static f32 row_label_width (ApplicationState *app, const char *label, u16 padding) {
+	if (!label) {
+		return 0;
+	}
+	return text_truncator_measure(&app->truncator, FONT_ID_ROBOTO_REGULAR, 12, label, (u32) SDL_strlen(label)) + padding;
+}
+
+// names are cut in the middle to what is left of the row once its indent,
+// icon and trailing labels are placed
+static Clay_String explorer_row_name (ApplicationState *app, const char *name, u32 depth, f32 trailing_width) {
+	f32 width = app->explorer_row_width - (f32) (depth * EXPLORER_INDENT_WIDTH) - EXPLORER_ROW_HEIGHT - trailing_width;
+	return text_truncator_fit(&app->truncator, FONT_ID_ROBOTO_REGULAR, 16, name, xtd_max(width, 0.0f));
+}
+
+void directory_component (ApplicationState *app, Directory *directory, u32 depth, bool selected) {
+	cache_directory_ids(app, directory);
 	CLAY({
-		.id = CLAY_IDI("Directory", id),
+		.id = directory->element_id,
 		.layout = {
 			.layoutDirection = CLAY_LEFT_TO_RIGHT,
-			.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_FIXED(24) },
-			.padding = CLAY_PADDING_ALL(0),
+			.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_FIXED(EXPLORER_ROW_HEIGHT) },
+			.padding = { (u16) (depth * EXPLORER_INDENT_WIDTH), 0, 0, 0 },
 			.childGap = 0,
 			.childAlignment = { .x = CLAY_ALIGN_X_LEFT, .y = CLAY_ALIGN_Y_CENTER },
 		},
+		.backgroundColor = selected ? COLOR_SELECTION : COLOR_TRANSPARENT,
 		.border = { .width = {0, 0, 0, 0, 0}, .color = COLOR_BORDER },
 	}) {
 		CLAY({
-			.id = CLAY_IDI("DirectoryExpandIcon", id),
+			.id = directory->expand_icon_id,
 			.layout = {
 				.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_GROW(0) },
 				.padding = CLAY_PADDING_ALL(0),
 			},
 			.aspectRatio = { 1.0 / 1.0 },
-			.image = { .imageData = app->icons[ICON_ID_DIRECTORY_ARROW_RIGHT] },
+			.image = { .imageData = directory->expanded ? 
+				app->icons[ICON_ID_DIRECTORY_ARROW_DOWN] : app->icons[ICON_ID_DIRECTORY_ARROW_RIGHT] },
+		}) {}
+		VcsStatus vcs_status = directory_vcs_status(directory);
+
+		// roots also show what they cost and how far indexing has got
+		const char *root_label = directory->parent ? NULL :
+			workspace_root_label(&app->workspace, workspace_root_index(&app->workspace, directory));
+		const char *stats_label = aggregate_label(directory);
+		f32 trailing_width = row_label_width(app, root_label, 12) + row_label_width(app, stats_label, 6) +
+			row_label_width(app, vcs_status_letter(vcs_status), 6);
+
+		Clay_String directory_name = explorer_row_name(app, directory->name, depth, trailing_width);
+		CLAY_TEXT(directory_name, CLAY_TEXT_CONFIG({ .textColor = vcs_status_color(vcs_status), .fontId = FONT_ID_ROBOTO_REGULAR, .fontSize = 16 }));
+
+		CLAY({ .layout = { .sizing = { .width = CLAY_SIZING_GROW(0) } } }) {}
+
+		if (root_label) {
+			Clay_String root_stats = {false, (i32) SDL_strlen(root_label), root_label};
+			CLAY({ .layout = { .padding = { 0, 12, 0, 0 } } }) {
+				CLAY_TEXT(root_stats, CLAY_TEXT_CONFIG({ .textColor = COLOR_BORDER, .fontId = FONT_ID_ROBOTO_REGULAR, .fontSize = 12 }));
+			}
+		}
+
+		Clay_String directory_stats = {false, (i32) SDL_strlen(stats_label), stats_label};
+		CLAY({ .layout = { .padding = { 0, 6, 0, 0 } } }) {
+			CLAY_TEXT(directory_stats, CLAY_TEXT_CONFIG({ .textColor = COLOR_BORDER, .fontId = FONT_ID_ROBOTO_REGULAR, .fontSize = 12 }));
+		}
+		vcs_status_marker(vcs_status);
+	}
+}
+
+void file_component (ApplicationState *app, File *file, u32 depth, bool selected) {
+	cache_file_ids(app, file);
+	CLAY({
+		.id = file->element_id,
+		.layout = {
+			.layoutDirection = CLAY_LEFT_TO_RIGHT,
+			.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_FIXED(EXPLORER_ROW_HEIGHT) },
+			.padding = { (u16) (depth * EXPLORER_INDENT_WIDTH), 0, 0, 0 },
+			.childAlignment = { .x = CLAY_ALIGN_X_LEFT, .y = CLAY_ALIGN_Y_CENTER },
+		},
+		.backgroundColor = (app->preview.file == file) ? COLOR_HIGHLIGHT_BLUE : selected ? COLOR_SELECTION : COLOR_TRANSPARENT,
+	}) {
+		// thumbnails sit where a directory's expand arrow would be
+		CLAY({
+			.layout = {
+				.sizing = { .width = CLAY_SIZING_FIXED(EXPLORER_ROW_HEIGHT), .height = CLAY_SIZING_FIXED(EXPLORER_ROW_HEIGHT) },
+				.childAlignment = { .x = CLAY_ALIGN_X_CENTER, .y = CLAY_ALIGN_Y_CENTER },
+			},
 		}) {
+			if (file->thumbnail_state == THUMBNAIL_STATE_READY) {
+				CLAY({
+					.layout = { .sizing = { .width = CLAY_SIZING_FIXED(THUMBNAIL_SIZE), .height = CLAY_SIZING_FIXED(THUMBNAIL_SIZE) } },
+					.image = { .imageData = file->thumbnail },
+				}) {}
+			}
 		}
-		Clay_String directory_name = {false, 24, directory->name};
-		CLAY_TEXT(directory_name, CLAY_TEXT_CONFIG({ .textColor = COLOR_TEXT_LIGHT, .fontId = FONT_ID_ROBOTO_REGULAR, .fontSize = 16 }));
+		Clay_String file_name = explorer_row_name(app, file->name, depth, row_label_width(app, vcs_status_letter(file->vcs_status), 6));
+		CLAY_TEXT(file_name, CLAY_TEXT_CONFIG({ .textColor = vcs_status_color(file->vcs_status), .fontId = FONT_ID_ROBOTO_REGULAR, .fontSize = 16 }));
+
+		CLAY({ .layout = { .sizing = { .width = CLAY_SIZING_GROW(0) } } }) {}
+		vcs_status_marker(file->vcs_status);
+	}
+}
+
+static void push_explorer_row (ApplicationState *app, Directory *directory, File *file, u32 depth) {
+	if (app->num_explorer_rows == app->explorer_rows_capacity) {
+		app->explorer_rows_capacity = xtd_max(app->explorer_rows_capacity * 2, 256u);
+		app->explorer_rows = SDL_realloc(app->explorer_rows, app->explorer_rows_capacity * sizeof(ExplorerRow));
 	}
+	app->explorer_rows[app->num_explorer_rows++] = (ExplorerRow) { directory, file, depth };
 }
 
+static void push_directory_rows (ApplicationState *app, Directory *directory, u32 depth) {
+	push_explorer_row(app, directory, NULL, depth);
+	if (!directory->expanded) {
+		return;
+	}
+	for (u32 i = 0; i < directory->num_child_directories; i++) {
+		if (directory->child_directories[i]->removed) continue;
+		push_directory_rows(app, directory->child_directories[i], depth + 1);
+	}
+	for (u32 i = 0; i < directory->num_child_files; i++) {
+		if (directory->child_files[i]->removed) continue;
+		push_explorer_row(app, NULL, directory->child_files[i], depth + 1);
+	}
+}
+
+void rebuild_explorer_rows (ApplicationState *app) {
+	selection_begin_remap(&app->selection, app->explorer_rows, app->num_explorer_rows);
+	app->num_explorer_rows = 0;
+	for (u32 i = 0; i < app->workspace.num_roots; i++) {
+		push_directory_rows(app, &app->workspace.roots[i], 0);
+	}
+	selection_end_remap(&app->selection, app->explorer_rows, app->num_explorer_rows);
+	app->explorer_rows_dirty = false;
+}
+
+// the order the explorer is in, changed with Ctrl+1 to Ctrl+4
+static const char *sort_labels[NUM_SORT_COLUMNS][2] = {
+	[SORT_COLUMN_NAME]          = { "Name", "Name, reversed" },
+	[SORT_COLUMN_EXTENSION]     = { "Type", "Type, reversed" },
+	[SORT_COLUMN_SIZE]          = { "Size", "Size, largest first" },
+	[SORT_COLUMN_MODIFIED_TIME] = { "Modified", "Modified, newest first" },
+};
+
 void file_explorer_layout (ApplicationState *app) {
+	ScrollState *scroll = &app->explorer_scroll;
+
 	CLAY({
-		.id = CLAY_ID("FileExplorer"),
+		.id = ui_ids.file_explorer,
 		.layout = { 
 			.layoutDirection = CLAY_TOP_TO_BOTTOM, 
-			.sizing = { .width = CLAY_SIZING_FIXED(250), .height = CLAY_SIZING_GROW(0) },
+			.sizing = { .width = CLAY_SIZING_FIXED(EXPLORER_WIDTH), .height = CLAY_SIZING_GROW(0) },
 			.padding = {0, 0, 4, 0}, 
 			.childGap = 0 
 		},
@@ -125,15 +340,28 @@ void file_explorer_layout (ApplicationState *app) {
 		.border = { .width = {1, 1, 0, 1, 0}, .color = COLOR_BORDER } 	
 	}) {
 		CLAY({
-			.id = CLAY_ID("FileExplorerFilterArea"),
+			.id = ui_ids.file_explorer_filter_area,
 			.layout = {
-				.sizing = {.width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_FIXED(20) },\
+				.sizing = {.width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_FIXED(20) },
+				.padding = { 6, 6, 0, 0 },
+				.childAlignment = { .y = CLAY_ALIGN_Y_CENTER },
 			},
-			.backgroundColor = {255, 0, 255, 255},
-		}) {}
+			.backgroundColor = COLOR_BACKGROUND_HEIGHT_2,
+		}) {
+			if (app->search_query_length > 0) {
+				Clay_String query = {false, (i32) app->search_query_length, app->search_query};
+				CLAY_TEXT(query, CLAY_TEXT_CONFIG({ .textColor = COLOR_TEXT_LIGHT, .fontId = FONT_ID_ROBOTO_REGULAR, .fontSize = 14 }));
+			} else {
+				CLAY_TEXT(CLAY_STRING("Find in files (/regex)"), CLAY_TEXT_CONFIG({ .textColor = COLOR_BORDER, .fontId = FONT_ID_ROBOTO_REGULAR, .fontSize = 14 }));
+			}
+			CLAY({ .layout = { .sizing = { .width = CLAY_SIZING_GROW(0) } } }) {}
+			const char *sort_label = sort_labels[app->sort_column][app->sort_descending];
+			Clay_String sort = {true, (i32) SDL_strlen(sort_label), sort_label};
+			CLAY_TEXT(sort, CLAY_TEXT_CONFIG({ .textColor = COLOR_BORDER, .fontId = FONT_ID_ROBOTO_REGULAR, .fontSize = 12 }));
+		}
 		
 		CLAY({
-			.id = CLAY_ID("FileExplorerSearchResultsArea"),
+			.id = ui_ids.file_explorer_search_results_area,
 			.layout = { 
 				.layoutDirection = CLAY_LEFT_TO_RIGHT, 
 				.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_GROW(0) },
@@ -141,35 +369,316 @@ void file_explorer_layout (ApplicationState *app) {
 			},
 		}) {
 			
+			// only rows in the viewport, plus the ones the current fling is about to
+			// reveal, are laid out; spacers stand in for everything else
+			RowRange rows = scroll_prefetch_range(scroll, EXPLORER_ROW_HEIGHT, app->num_explorer_rows);
+			app->explorer_laid_out_rows = rows;
+
+			// names are fitted to the list as it was laid out last frame
+			Clay_ElementData list_data = Clay_GetElementData(ui_ids.file_explorer_search_results_list);
+			app->explorer_row_width = list_data.found ? list_data.boundingBox.width : EXPLORER_WIDTH - EXPLORER_SCROLL_BAR_WIDTH;
+
 			CLAY({
-				.id = CLAY_ID("FileExplorerSearchResultsList"),
+				.id = ui_ids.file_explorer_search_results_list,
 				.layout = { 
 					.layoutDirection = CLAY_TOP_TO_BOTTOM, 
 					.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_GROW(0) },
 					.childAlignment = { .x = CLAY_ALIGN_X_LEFT },
 				},
-				.clip = { .vertical = true, .childOffset = Clay_GetScrollOffset()},
+				.clip = { .vertical = true, .childOffset = { 0, -scroll->offset } },
 			}) {
-				for (u32 i = 0; i < app->num_directories; ++i) {
-					directory_component(app, &app->directories[i], i);
+				CLAY({
+					.id = ui_ids.file_explorer_rows_above,
+					.layout = { .sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_FIXED(rows.first * EXPLORER_ROW_HEIGHT) } },
+				}) {}
+
+				// the selected ranges are walked alongside the rows, one lookup per frame
+				Selection *selection = &app->selection;
+				u32 range = selection_find(selection, rows.first);
+				for (u32 i = rows.first; i < rows.end; ++i) {
+					while (range < selection->num_ranges && selection->ranges[range].end <= i) range++;
+					bool selected = range < selection->num_ranges && selection->ranges[range].first <= i;
+					ExplorerRow *row = &app->explorer_rows[i];
+					if (row->directory) {
+						directory_component(app, row->directory, row->depth, selected);
+					} else {
+						file_component(app, row->file, row->depth, selected);
+					}
 				}
+
+				CLAY({
+					.id = ui_ids.file_explorer_rows_below,
+					.layout = { .sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_FIXED((app->num_explorer_rows - rows.end) * EXPLORER_ROW_HEIGHT) } },
+				}) {}
 			}
 			
+			f32 track_height = scroll->viewport_height;
+			bool show_thumb = scroll_max_offset(scroll) > 0;
+
 			CLAY({
-				.id = CLAY_ID("FileExplorerSearchResultScrollBar"),
+				.id = ui_ids.file_explorer_search_result_scroll_bar,
 				.layout = {
-					.sizing = { .width = CLAY_SIZING_FIXED(6), .height = CLAY_SIZING_GROW(0) },
+					.layoutDirection = CLAY_TOP_TO_BOTTOM,
+					.sizing = { .width = CLAY_SIZING_FIXED(EXPLORER_SCROLL_BAR_WIDTH), .height = CLAY_SIZING_GROW(0) },
+					.padding = { 0, 0, (u16) scroll_thumb_position(scroll, track_height), 0 },
 				},
-				.backgroundColor = {0, 255, 0, 255}
+				.backgroundColor = COLOR_BACKGROUND_HEIGHT_1,
 			}) {
-
+				if (show_thumb) {
+					Clay_OnHover(handle_scroll_bar, (intptr_t) app);
+					CLAY({
+						.id = ui_ids.file_explorer_search_result_scroll_thumb,
+						.layout = {
+							.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_FIXED(scroll_thumb_height(scroll, track_height)) },
+						},
+						.backgroundColor = (Clay_Hovered() || scroll->dragging_thumb) ? COLOR_HIGHLIGHT_BLUE : COLOR_BORDER,
+					}) {}
+				}
 			}			
 		}	
 	}
 } 
 
+void file_preview_layout (ApplicationState *app) {
+	Preview *preview = &app->preview;
+
+	CLAY({
+		.id = ui_ids.file_preview,
+		.layout = {
+			.layoutDirection = CLAY_TOP_TO_BOTTOM,
+			.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_GROW(0) },
+			.childGap = 0,
+		},
+		.backgroundColor = COLOR_BACKGROUND_HEIGHT_0,
+	}) {
+		if (preview->is_open) {
+			CLAY({
+				.id = ui_ids.file_preview_header,
+				.layout = {
+					.layoutDirection = CLAY_LEFT_TO_RIGHT,
+					.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_FIXED(EXPLORER_ROW_HEIGHT) },
+					.padding = { 8, 8, 0, 0 },
+					.childAlignment = { .y = CLAY_ALIGN_Y_CENTER },
+				},
+				.backgroundColor = COLOR_BACKGROUND_HEIGHT_1,
+				.border = { .width = {0, 0, 0, 1, 0}, .color = COLOR_BORDER },
+			}) {
+				Clay_String file_name = {false, (i32) SDL_strlen(preview->file->name), preview->file->name};
+				CLAY_TEXT(file_name, CLAY_TEXT_CONFIG({ .textColor = COLOR_TEXT_LIGHT, .fontId = FONT_ID_ROBOTO_REGULAR, .fontSize = 16 }));
+
+				CLAY({ .layout = { .sizing = { .width = CLAY_SIZING_FIXED(12) } } }) {}
+
+				const char *type_name = file_type_of(preview->file)->name;
+				Clay_String type = {true, (i32) SDL_strlen(type_name), type_name};
+				CLAY_TEXT(type, CLAY_TEXT_CONFIG({ .textColor = COLOR_BORDER, .fontId = FONT_ID_ROBOTO_REGULAR, .fontSize = 12 }));
+
+				CLAY({ .layout = { .sizing = { .width = CLAY_SIZING_GROW(0) } } }) {}
+
+				Clay_String status = {false, (i32) SDL_strlen(preview->status), preview->status};
+				CLAY_TEXT(status, CLAY_TEXT_CONFIG({ .textColor = COLOR_BORDER, .fontId = FONT_ID_ROBOTO_REGULAR, .fontSize = 12 }));
+			}
+
+			// the lines point into the preview's mapped window, which stays put until the next preview_update
+			CLAY({
+				.id = ui_ids.file_preview_lines,
+				.layout = {
+					.layoutDirection = CLAY_TOP_TO_BOTTOM,
+					.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_GROW(0) },
+					.padding = { 8, 8, 4, 4 },
+				},
+				.clip = { .horizontal = true, .vertical = true },
+			}) {
+				for (u32 i = 0; i < preview->num_lines; i++) {
+					CLAY({ .layout = { .sizing = { .height = CLAY_SIZING_FIXED(PREVIEW_LINE_HEIGHT) } } }) {
+						CLAY_TEXT(preview->lines[i], CLAY_TEXT_CONFIG({ 
+							.textColor = COLOR_TEXT_LIGHT, 
+							.fontId = FONT_ID_ROBOTO_REGULAR, 
+							.fontSize = PREVIEW_FONT_SIZE,
+							.wrapMode = CLAY_TEXT_WRAP_NONE,
+						}));
+					}
+				}
+			}
+		}
+	}
+}
+
+void search_results_layout (ApplicationState *app) {
+	SearchEngine *engine = &app->search_engine;
+	if (!engine->runs) {
+		return;
+	}
+
+	CLAY({
+		.id = ui_ids.search_results,
+		.layout = {
+			.layoutDirection = CLAY_TOP_TO_BOTTOM,
+			.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_PERCENT(0.4f) },
+		},
+		.backgroundColor = COLOR_BACKGROUND_HEIGHT_1,
+		.border = { .width = {0, 0, 0, 1, 0}, .color = COLOR_BORDER },
+	}) {
+		CLAY({
+			.id = ui_ids.search_results_header,
+			.layout = {
+				.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_FIXED(EXPLORER_ROW_HEIGHT) },
+				.padding = { 8, 8, 0, 0 },
+				.childAlignment = { .y = CLAY_ALIGN_Y_CENTER },
+			},
+		}) {
+			Clay_String status = {false, (i32) SDL_strlen(app->search_status), app->search_status};
+			CLAY_TEXT(status, CLAY_TEXT_CONFIG({ .textColor = COLOR_TEXT_LIGHT, .fontId = FONT_ID_ROBOTO_REGULAR, .fontSize = 12 }));
+		}
+
+		// rows are addressed by hit index, so only the visible ones are laid out
+		CLAY({
+			.id = ui_ids.search_results_list,
+			.layout = {
+				.layoutDirection = CLAY_TOP_TO_BOTTOM,
+				.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_GROW(0) },
+				.padding = { 8, 8, 0, 4 },
+			},
+			.clip = { .horizontal = true, .vertical = true },
+		}) {
+			u32 end = xtd_min(engine->num_hits, app->search_first_hit + app->search_visible_rows);
+			for (u32 i = app->search_first_hit; i < end; i++) {
+				SearchHit *hit = &engine->hits[i];
+				const char *separator = SDL_strrchr(hit->path, PATH_SEPARATOR);
+				const char *name = separator ? separator + 1 : hit->path;
+
+				CLAY({
+					.layout = {
+						.layoutDirection = CLAY_LEFT_TO_RIGHT,
+						.sizing = { .height = CLAY_SIZING_FIXED(SEARCH_RESULT_ROW_HEIGHT) },
+						.childGap = 8,
+						.childAlignment = { .y = CLAY_ALIGN_Y_CENTER },
+					},
+				}) {
+					Clay_String file_name = {false, (i32) SDL_strlen(name), name};
+					Clay_String line_label = {false, (i32) SDL_strlen(hit->line_label), hit->line_label};
+					Clay_String text = {false, (i32) hit->text_length, hit->text};
+					CLAY_TEXT(file_name, CLAY_TEXT_CONFIG({ .textColor = COLOR_TEXT_LIGHT, .fontId = FONT_ID_ROBOTO_REGULAR, .fontSize = 14, .wrapMode = CLAY_TEXT_WRAP_NONE }));
+					CLAY_TEXT(line_label, CLAY_TEXT_CONFIG({ .textColor = COLOR_BORDER, .fontId = FONT_ID_ROBOTO_REGULAR, .fontSize = 14, .wrapMode = CLAY_TEXT_WRAP_NONE }));
+					CLAY_TEXT(text, CLAY_TEXT_CONFIG({ .textColor = COLOR_TEXT_LIGHT, .fontId = FONT_ID_ROBOTO_REGULAR, .fontSize = 14, .wrapMode = CLAY_TEXT_WRAP_NONE }));
+				}
+			}
+		}
+	}
+}
+
+void duplicates_layout (ApplicationState *app) {
+	DuplicateFinder *finder = &app->duplicates;
+	if (!app->duplicates_visible) {
+		return;
+	}
+
+	CLAY({
+		.id = ui_ids.duplicates,
+		.layout = {
+			.layoutDirection = CLAY_TOP_TO_BOTTOM,
+			.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_PERCENT(0.4f) },
+		},
+		.backgroundColor = COLOR_BACKGROUND_HEIGHT_1,
+		.border = { .width = {0, 0, 0, 1, 0}, .color = COLOR_BORDER },
+	}) {
+		CLAY({
+			.id = ui_ids.duplicates_header,
+			.layout = {
+				.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_FIXED(EXPLORER_ROW_HEIGHT) },
+				.padding = { 8, 8, 0, 0 },
+				.childAlignment = { .y = CLAY_ALIGN_Y_CENTER },
+			},
+		}) {
+			Clay_String status = {false, (i32) SDL_strlen(app->duplicates_status), app->duplicates_status};
+			CLAY_TEXT(status, CLAY_TEXT_CONFIG({ .textColor = COLOR_TEXT_LIGHT, .fontId = FONT_ID_ROBOTO_REGULAR, .fontSize = 12 }));
+		}
+
+		// each set is a header row followed by a row per file; only the visible rows are laid out
+		CLAY({
+			.id = ui_ids.duplicates_list,
+			.layout = {
+				.layoutDirection = CLAY_TOP_TO_BOTTOM,
+				.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_GROW(0) },
+				.padding = { 8, 8, 0, 4 },
+			},
+			.clip = { .horizontal = true, .vertical = true },
+		}) {
+			// paths are cut in the middle to the list's width, less its padding and their indent
+			Clay_ElementData list_data = Clay_GetElementData(ui_ids.duplicates_list);
+			f32 path_width = list_data.found ? xtd_max(list_data.boundingBox.width - 32, 0.0f) : 1e9f;
+
+			u32 end = xtd_min(finder->num_rows, app->duplicates_first_row + app->duplicates_visible_rows);
+			DuplicateSet *set = app->duplicates_first_row < end ? duplicate_finder_set_at_row(finder, app->duplicates_first_row) : NULL;
+			for (u32 row = app->duplicates_first_row; row < end; row++) {
+				if (row == set->first_row + 1 + set->num_files) {
+					set++;
+				}
+				u32 index = row - set->first_row;
+				Clay_String label = index == 0 ? (Clay_String) {false, (i32) SDL_strlen(set->label), set->label} :
+					text_truncator_fit(&app->truncator, FONT_ID_ROBOTO_REGULAR, 14, finder->paths[set->first_path + index - 1], path_width);
+
+				CLAY({
+					.layout = {
+						.sizing = { .height = CLAY_SIZING_FIXED(DUPLICATE_ROW_HEIGHT) },
+						.padding = { index == 0 ? 0 : 16, 0, 0, 0 },
+						.childAlignment = { .y = CLAY_ALIGN_Y_CENTER },
+					},
+				}) {
+					CLAY_TEXT(label, CLAY_TEXT_CONFIG({ .textColor = COLOR_TEXT_LIGHT, .fontId = FONT_ID_ROBOTO_REGULAR, .fontSize = 14, .wrapMode = CLAY_TEXT_WRAP_NONE }));
+				}
+			}
+		}
+	}
+}
+
+void file_operations_layout (ApplicationState *app) {
+	if (!app->file_ops.operations && !app->file_ops_status[0]) {
+		return;
+	}
+
+	CLAY({
+		.id = ui_ids.file_operations,
+		.layout = {
+			.layoutDirection = CLAY_TOP_TO_BOTTOM,
+			.sizing = { .width = CLAY_SIZING_GROW(0) },
+			.padding = { 8, 8, 4, 4 },
+		},
+		.backgroundColor = COLOR_BACKGROUND_HEIGHT_1,
+		.border = { .width = {0, 0, 1, 0, 0}, .color = COLOR_BORDER },
+	}) {
+		for (FileOperation *operation = app->file_ops.operations; operation; operation = operation->next) {
+			CLAY({
+				.layout = {
+					.layoutDirection = CLAY_LEFT_TO_RIGHT,
+					.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_FIXED(EXPLORER_ROW_HEIGHT) },
+					.childGap = 8,
+					.childAlignment = { .y = CLAY_ALIGN_Y_CENTER },
+				},
+			}) {
+				CLAY({
+					.layout = { .sizing = { .width = CLAY_SIZING_FIXED(FILE_OPERATION_BAR_WIDTH), .height = CLAY_SIZING_FIXED(6) } },
+					.backgroundColor = COLOR_BACKGROUND_HEIGHT_0,
+				}) {
+					CLAY({
+						.layout = { .sizing = { .width = CLAY_SIZING_FIXED(FILE_OPERATION_BAR_WIDTH * file_operation_fraction(operation)), .height = CLAY_SIZING_GROW(0) } },
+						.backgroundColor = COLOR_HIGHLIGHT_BLUE,
+					}) {}
+				}
+				Clay_String label = {false, (i32) SDL_strlen(operation->label), operation->label};
+				CLAY_TEXT(label, CLAY_TEXT_CONFIG({ .textColor = COLOR_TEXT_LIGHT, .fontId = FONT_ID_ROBOTO_REGULAR, .fontSize = 12, .wrapMode = CLAY_TEXT_WRAP_NONE }));
+			}
+		}
+		if (app->file_ops_status[0]) {
+			CLAY({ .layout = { .sizing = { .height = CLAY_SIZING_FIXED(EXPLORER_ROW_HEIGHT) }, .childAlignment = { .y = CLAY_ALIGN_Y_CENTER } } }) {
+				Clay_String status = {false, (i32) SDL_strlen(app->file_ops_status), app->file_ops_status};
+				CLAY_TEXT(status, CLAY_TEXT_CONFIG({ .textColor = COLOR_BORDER, .fontId = FONT_ID_ROBOTO_REGULAR, .fontSize = 12, .wrapMode = CLAY_TEXT_WRAP_NONE }));
+			}
+		}
+	}
+}
+
 Clay_RenderCommandArray application_layout (ApplicationState *app) {
-	Clay_BeginLayout(); CLAY({ 	.id = CLAY_ID("TopLevelContainer"), .layout = { 
+	Clay_BeginLayout(); CLAY({ 	.id = ui_ids.top_level_container, .layout = { 
 			.layoutDirection = CLAY_TOP_TO_BOTTOM,
 			.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_GROW(0) }, 
 			.padding = CLAY_PADDING_ALL(0), 
@@ -179,7 +688,27 @@ Clay_RenderCommandArray application_layout (ApplicationState *app) {
 		.border = { .width = {2, 2, 2, 2, 1}, .color = COLOR_BORDER },
 	}) {
 		application_header_layout(app);
-		file_explorer_layout(app);
+		CLAY({
+			.id = ui_ids.application_body,
+			.layout = {
+				.layoutDirection = CLAY_LEFT_TO_RIGHT,
+				.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_GROW(0) },
+			},
+		}) {
+			file_explorer_layout(app);
+			CLAY({
+				.id = ui_ids.content_column,
+				.layout = {
+					.layoutDirection = CLAY_TOP_TO_BOTTOM,
+					.sizing = { .width = CLAY_SIZING_GROW(0), .height = CLAY_SIZING_GROW(0) },
+				},
+			}) {
+				search_results_layout(app);
+				duplicates_layout(app);
+				file_preview_layout(app);
+				file_operations_layout(app);
+			}
+		}
 	}
 	
 	return Clay_EndLayout();
@@ -198,7 +727,7 @@ void handle_application_minimize_button (Clay_ElementId id, Clay_PointerData poi
 
 	if (app->last_element_clicked.id == id.id && pointer_data.state == CLAY_POINTER_DATA_RELEASED_THIS_FRAME) {
 		SDL_MinimizeWindow(app->window);
-		app->last_element_clicked = CLAY_ID("null");
+		app->last_element_clicked = ui_ids.null;
 	}
 
 }
@@ -215,11 +744,11 @@ void handle_application_maximize_button (Clay_ElementId id, Clay_PointerData poi
 	
 	if (button_triggered && !window_is_maximized) {
 		SDL_MaximizeWindow(app->window);
-		app->last_element_clicked = CLAY_ID("null");
+		app->last_element_clicked = ui_ids.null;
 	}
 	else if (button_triggered && window_is_maximized) {
 		SDL_RestoreWindow(app->window);
-		app->last_element_clicked = CLAY_ID("null");
+		app->last_element_clicked = ui_ids.null;
 	}
 
 }
@@ -237,7 +766,120 @@ void handle_application_close_button (Clay_ElementId id, Clay_PointerData pointe
     	quit_event.type = SDL_EVENT_QUIT;
     	quit_event.quit.timestamp = SDL_GetTicksNS(); 		
 		SDL_PushEvent(&quit_event);
-		app->last_element_clicked = CLAY_ID("null");
+		app->last_element_clicked = ui_ids.null;
+	}
+}
+
+//=============================================================================
+// File Explorer Handlers
+//=============================================================================
+
+// remembers the row last clicked as the one file operations act on
+static void set_current_path (ApplicationState *app, const char *path, bool is_directory) {
+	SDL_free(app->current_path);
+	app->current_path = SDL_strdup(path);
+	app->current_is_directory = is_directory;
+	app->delete_armed_ns = 0;
+}
+
+// Rows are too many to each register a hover callback; the hit index maps the
+// pointer straight to a row. A directory's expand arrow toggles it, the rest
+// of any row selects it. Returns the element the click is tracked by
+static ExplorerRow *pointer_explorer_row (ApplicationState *app, Clay_ElementId *target, u32 *index) {
+	if (!hit_index_pointer_row(&app->hit_index, index) || *index >= app->num_explorer_rows) {
+		return NULL;
+	}
+	ExplorerRow *row = &app->explorer_rows[*index];
+	if (row->directory) {
+		*target = hit_index_pointer_over(&app->hit_index, row->directory->expand_icon_id.id) ?
+			row->directory->expand_icon_id : row->directory->element_id;
+	} else {
+		*target = row->file->element_id;
+	}
+	return row;
+}
+
+// a plain click selects only the row, Ctrl toggles it and Shift selects
+// everything from the anchor, the last row clicked without Shift
+static void select_explorer_row (ApplicationState *app, u32 index) {
+	Selection *selection = &app->selection;
+	SDL_Keymod modifiers = SDL_GetModState();
+	bool command = (modifiers & (SDL_KMOD_CTRL | SDL_KMOD_GUI)) != 0;
+
+	if ((modifiers & SDL_KMOD_SHIFT) && selection->anchor != SELECTION_NO_ANCHOR) {
+		u32 anchor = selection->anchor;
+		if (!command) selection_clear(selection);
+		selection_add(selection, (RowRange) { xtd_min(anchor, index), xtd_max(anchor, index) + 1 });
+		selection->anchor = anchor;
+		return;
+	}
+	if (command) {
+		selection_toggle(selection, index);
+	} else {
+		selection_clear(selection);
+		selection_add(selection, (RowRange) { index, index + 1 });
+	}
+	selection->anchor = index;
+}
+
+void handle_explorer_row_press (ApplicationState *app) {
+	Clay_ElementId target;
+	u32 index;
+	if (pointer_explorer_row(app, &target, &index)) {
+		app->last_element_clicked = target;
+	}
+}
+
+void handle_explorer_row_release (ApplicationState *app) {
+	Clay_ElementId target;
+	u32 index;
+	ExplorerRow *row = pointer_explorer_row(app, &target, &index);
+	if (!row || app->last_element_clicked.id != target.id) {
+		return;
+	}
+	app->last_element_clicked = ui_ids.null;
+
+	if (row->directory && target.id == row->directory->expand_icon_id.id) {
+		Directory *directory = row->directory;
+		set_current_path(app, directory->path, true);
+		directory->expanded = !directory->expanded;
+		if (directory->expanded && !workspace_reload(&app->workspace, directory)) {
+			sort_directory_children(&app->sort_engine, directory, app->sort_column, app->sort_descending);
+		}
+		app->explorer_rows_dirty = true;
+		return;
+	}
+
+	select_explorer_row(app, index);
+	if (row->directory) {
+		set_current_path(app, row->directory->path, true);
+	} else {
+		set_current_path(app, row->file->path, false);
+		if (row->file != app->preview.file) {
+			preview_open(&app->preview, row->file);
+		}
+	}
+}
+
+void handle_scroll_bar (Clay_ElementId id, Clay_PointerData pointer_data, intptr_t user_data) {
+	ApplicationState *app = (ApplicationState *) user_data;
+	ScrollState *scroll = &app->explorer_scroll;
+
+	if (pointer_data.state != CLAY_POINTER_DATA_PRESSED_THIS_FRAME) {
+		return;
 	}
+
+	// clicking the track jumps the thumb under the pointer, then drags from there
+	if (!Clay_PointerOver(ui_ids.file_explorer_search_result_scroll_thumb)) {
+		Clay_BoundingBox track = Clay_GetElementData(id).boundingBox;
+		f32 thumb_height = scroll_thumb_height(scroll, track.height);
+		f32 travel = track.height - thumb_height;
+		if (travel > 0) {
+			f32 thumb_top = pointer_data.position.y - track.y - thumb_height / 2;
+			scroll_set_offset(scroll, (thumb_top / travel) * scroll_max_offset(scroll));
+		}
+	}
+
+	scroll_begin_thumb_drag(scroll, pointer_data.position.y);
 }
 
@@ -3,18 +3,51 @@
 
 #include "xtdlib.h"
 #include "clay.h"
+#include "scroll.h"
 
 typedef struct ApplicationState ApplicationState; // forward declaration
+typedef struct Directory Directory;
 
 typedef struct File {
 	char *path;
 	char *name;
 	char *extension;
+	Directory *parent;
+
+	u64 size;
+	i64 modified_time;
+
+	void *thumbnail;		// SDL_Texture, once thumbnail_state is THUMBNAIL_STATE_READY
+	u8 thumbnail_state;		// ThumbnailState, see thumbnail.h
+	u8 type;				// FileTypeId, see filetype.h
+	u8 type_source;			// FileTypeSource
+	u8 vcs_status;			// VcsStatus, see git_status.h
+	bool removed;			// gone from disk; freed by workspace_free_removed
+	bool is_link;			// a symbolic link, listed but never followed; size and time are its own
+
+	Clay_ElementId element_id;
 } File;
 
+// recursive totals for everything below a directory
+typedef struct DirectoryStats {
+	u64 total_size;
+	u64 num_files;
+	i64 newest_modified_time;
+	u64 num_modified;		// tracked files changed or deleted, see git_status.h
+	u64 num_untracked;
+} DirectoryStats;
+
 typedef struct Directory {
 	char *name;
 	char *path;
+	struct Directory *parent;
+
+	i64 modified_time;
+	u32 sort_generation;
+
+	DirectoryStats stats;
+	char stats_label[48];
+	bool stats_label_dirty;
 
 	struct Directory **child_directories;
 	u32 num_child_directories;
@@ -22,8 +55,38 @@ typedef struct Directory {
 	struct File **child_files;
 	u32 num_child_files;
 
+	bool expanded;
+	bool unloaded;			// children freed to fit the memory budget, see workspace.h
+	bool removed;			// gone from disk, like File::removed
+	u64 last_viewed;		// Workspace::view_clock when last laid out
+
+	// the git work tree the children are in, see git_status.h
+	struct GitRepo *git_repo;
+	struct GitIgnore *git_ignore;	// patterns applying to the children
+	u32 git_generation;			// of the index they were compared against, 0 until listed
+	u32 num_git_deleted;		// tracked files below that no loaded child accounts for
+	bool git_ignored;			// untracked children are ignored
+
+	Clay_ElementId element_id;
+	Clay_ElementId expand_icon_id;
+
 } Directory;
 
+// one line of the explorer list: the tree flattened in display order
+typedef struct ExplorerRow {
+	Directory *directory;
+	File *file;
+	u32 depth;
+} ExplorerRow;
+
+// whether file is on one of the rows in range; range is a screenful, so a scan is fine
+static inline bool explorer_rows_contain_file (ExplorerRow *rows, RowRange range, const File *file) {
+	for (u32 i = range.first; i < range.end; i++) {
+		if (rows[i].file == file) return true;
+	}
+	return false;
+}
+
 //=============================================================================
 // UI CONSTANTS
 //=============================================================================
@@ -51,6 +114,16 @@ ICON_ID_CLOSE,
 	NUM_ICON_IDS
 } IconId;
 
+#define EXPLORER_WIDTH 250
+#define EXPLORER_SCROLL_BAR_WIDTH 6
+#define EXPLORER_ROW_HEIGHT 24
+#define EXPLORER_INDENT_WIDTH 12
+#define SEARCH_RESULT_ROW_HEIGHT 20
+#define SEARCH_RESULT_MAX_ROWS 128
+#define DUPLICATE_ROW_HEIGHT 20
+#define DUPLICATE_MAX_ROWS 128
+#define FILE_OPERATION_BAR_WIDTH 160
+
 static const Clay_Color COLOR_TRANSPARENT = (Clay_Color) {0, 0, 0, 0};
 static const Clay_Color COLOR_MAGENTA = (Clay_Color) {255, 0, 255, 255};
 static const Clay_Color COLOR_BACKGROUND_HEIGHT_0 = (Clay_Color) {25, 27, 28, 255};
@@ -59,7 +132,54 @@ static const Clay_Color COLOR_BACKGROUND_HEIGHT_2 = (Clay_Color) {39, 42, 43, 25
 static const Clay_Color COLOR_TEXT_LIGHT = (Clay_Color) {170, 170, 170, 255};
 static const Clay_Color COLOR_HIGHLIGHT_BLUE = (Clay_Color) {25, 70, 86, 255};
 static const Clay_Color COLOR_HIGHLIGHT_RED  = (Clay_Color) {117, 64, 64, 255};
+static const Clay_Color COLOR_SELECTION = (Clay_Color) {36, 52, 58, 255};
 static const Clay_Color COLOR_BORDER = (Clay_Color) {52, 58, 59, 255};
+static const Clay_Color COLOR_VCS_MODIFIED = (Clay_Color) {204, 167, 96, 255};
+static const Clay_Color COLOR_VCS_UNTRACKED = (Clay_Color) {120, 176, 112, 255};
+static const Clay_Color COLOR_VCS_IGNORED = (Clay_Color) {104, 108, 109, 255};
+
+//=============================================================================
+// ELEMENT IDS
+//=============================================================================
+
+// Ids of the static elements, hashed once by ui_init_element_ids instead of
+// through CLAY_ID on every layout and hit test. Per-row ids are cached on the
+// Directory/File nodes the first time they are laid out.
+typedef struct UiElementIds {
+	Clay_ElementId null;
+	Clay_ElementId top_level_container;
+	Clay_ElementId application_header;
+	Clay_ElementId application_minimize_button;
+	Clay_ElementId application_minimize_button_icon;
+	Clay_ElementId application_maximize_button;
+	Clay_ElementId application_maximize_button_icon;
+	Clay_ElementId application_close_button;
+	Clay_ElementId application_close_button_icon;
+	Clay_ElementId file_explorer;
+	Clay_ElementId file_explorer_filter_area;
+	Clay_ElementId file_explorer_search_results_area;
+	Clay_ElementId file_explorer_search_results_list;
+	Clay_ElementId file_explorer_rows_above;
+	Clay_ElementId file_explorer_rows_below;
+	Clay_ElementId file_explorer_search_result_scroll_bar;
+	Clay_ElementId file_explorer_search_result_scroll_thumb;
+	Clay_ElementId application_body;
+	Clay_ElementId file_preview;
+	Clay_ElementId file_preview_header;
+	Clay_ElementId file_preview_lines;
+	Clay_ElementId content_column;
+	Clay_ElementId search_results;
+	Clay_ElementId search_results_header;
+	Clay_ElementId search_results_list;
+	Clay_ElementId duplicates;
+	Clay_ElementId duplicates_header;
+	Clay_ElementId duplicates_list;
+	Clay_ElementId file_operations;
+} UiElementIds;
+
+extern UiElementIds ui_ids;
+
+void ui_init_element_ids (void);
 
 //=============================================================================
 // LAYOUTS
@@ -71,6 +191,12 @@ void application_header_layout (ApplicationState *app);
 void file_explorer_layout (ApplicationState *app);
 void file_explorer_file_layout (ApplicationState *app, File *file, i32 id);
 void file_explorer_directory_layout (ApplicationState *app, Directory *directory, i32 id);
+void file_preview_layout (ApplicationState *app);
+void search_results_layout (ApplicationState *app);
+void duplicates_layout (ApplicationState *app);
+void file_operations_layout (ApplicationState *app);
+
+void rebuild_explorer_rows (ApplicationState *app);
 
 //=============================================================================
 // INTERACTIONS
@@ -82,6 +208,8 @@ void handle_application_maximize_button (Clay_ElementId id, Clay_PointerData poi
 void handle_application_close_button    (Clay_ElementId id, Clay_PointerData pointer_data, intptr_t user_data);
 
 // file explorerer interactions
-void handle_directory_expand_button (Clay_ElementId id, Clay_PointerData pointer_data, intptr_t user_data);
+void handle_scroll_bar (Clay_ElementId id, Clay_PointerData pointer_data, intptr_t user_data);
+void handle_explorer_row_press (ApplicationState *app);
+void handle_explorer_row_release (ApplicationState *app);
 
 #endif // UI_H
@@ -0,0 +1,425 @@
+#include "workspace.h"
+
+#include "aggregate.h"
+
+//=============================================================================
+// ACCOUNTING
+//=============================================================================
+
+// what the scanner allocated for one listing: the child nodes, their paths
+// (name and extension point into them) and the two child arrays
+static u64 listing_bytes (Directory *directory) {
+	u64 bytes = (u64) directory->num_child_directories * (sizeof(Directory) + sizeof(Directory *)) +
+		(u64) directory->num_child_files * (sizeof(File) + sizeof(File *));
+	for (u32 i = 0; i < directory->num_child_directories; i++) {
+		bytes += SDL_strlen(directory->child_directories[i]->path) + 1;
+	}
+	for (u32 i = 0; i < directory->num_child_files; i++) {
+		bytes += SDL_strlen(directory->child_files[i]->path) + 1;
+	}
+	return bytes;
+}
+
+u32 workspace_root_index (Workspace *workspace, Directory *directory) {
+	while (directory->parent) {
+		directory = directory->parent;
+	}
+	return (u32) (directory - workspace->roots);
+}
+
+void workspace_on_listed (Workspace *workspace, Directory *directory) {
+	u32 root_index = workspace_root_index(workspace, directory);
+	WorkspaceRootStats *stats = &workspace->root_stats[root_index];
+
+	u64 bytes = listing_bytes(directory);
+	stats->memory_bytes += bytes;
+	stats->num_directories_listed++;
+	stats->num_directories_found += directory->num_child_directories;
+	stats->label_dirty = true;
+	workspace->memory_used += bytes;
+}
+
+bool workspace_root_is_scanning (Workspace *workspace, u32 root_index) {
+	WorkspaceRootStats *stats = &workspace->root_stats[root_index];
+	return stats->num_directories_listed < stats->num_directories_found;
+}
+
+const char *workspace_root_label (Workspace *workspace, u32 root_index) {
+	WorkspaceRootStats *stats = &workspace->root_stats[root_index];
+	if (!stats->label_dirty) {
+		return stats->label;
+	}
+
+	f64 megabytes = (f64) stats->memory_bytes / (1 << 20);
+	if (workspace_root_is_scanning(workspace, root_index)) {
+		u32 percent = (u32) (stats->num_directories_listed * 100 / xtd_max(stats->num_directories_found, 1ull));
+		SDL_snprintf(stats->label, sizeof(stats->label), "%.1f MB mem, %u%%", megabytes, percent);
+	} else {
+		SDL_snprintf(stats->label, sizeof(stats->label), "%.1f MB mem", megabytes);
+	}
+	stats->label_dirty = false;
+	return stats->label;
+}
+
+//=============================================================================
+// TREES
+//=============================================================================
+
+void workspace_init (Workspace *workspace, Scanner *scanner, ThumbnailService *thumbnails, u64 memory_budget) {
+	SDL_memset(workspace, 0, sizeof(*workspace));
+	workspace->scanner = scanner;
+	workspace->thumbnails = thumbnails;
+	workspace->memory_budget = memory_budget;
+}
+
+bool workspace_add_root (Workspace *workspace, const char *path) {
+	if (workspace->num_roots == WORKSPACE_MAX_ROOTS) {
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Cannot open %s: at most %u roots", path, WORKSPACE_MAX_ROOTS);
+		return false;
+	}
+	for (u32 i = 0; i < workspace->num_roots; i++) {
+		if (SDL_strcmp(workspace->roots[i].path, path) == 0) {
+			return false;
+		}
+	}
+
+	u32 root_index = workspace->num_roots++;
+	Directory *root = &workspace->roots[root_index];
+	root->path = SDL_strdup(path);
+	root->name = root->path;
+	root->expanded = true;
+	root->stats_label_dirty = true;
+
+	WorkspaceRootStats *stats = &workspace->root_stats[root_index];
+	stats->num_directories_found = 1;
+	stats->label_dirty = true;
+
+	scanner_scan(workspace->scanner, root);
+	return true;
+}
+
+// frees everything below directory and returns the bytes it was accounted as
+static u64 free_children (ThumbnailService *thumbnails, WorkspaceRootStats *stats, Directory *directory) {
+	u64 bytes = listing_bytes(directory);
+
+	for (u32 i = 0; i < directory->num_child_directories; i++) {
+		Directory *child = directory->child_directories[i];
+		bytes += free_children(thumbnails, stats, child);
+		// an unloaded directory stopped counting when it was unloaded
+		if (!child->unloaded) {
+			stats->num_directories_found--;
+			stats->num_directories_listed--;
+		}
+		SDL_free(child->path);
+		SDL_free(child);
+	}
+	for (u32 i = 0; i < directory->num_child_files; i++) {
+		File *file = directory->child_files[i];
+		thumbnail_release(thumbnails, file);
+		SDL_free(file->path);
+		SDL_free(file);
+	}
+
+	SDL_free(directory->child_directories);
+	SDL_free(directory->child_files);
+	directory->child_directories = NULL;
+	directory->num_child_directories = 0;
+	directory->child_files = NULL;
+	directory->num_child_files = 0;
+	return bytes;
+}
+
+void workspace_shutdown (Workspace *workspace) {
+	for (u32 i = 0; i < workspace->num_roots; i++) {
+		free_children(NULL, &workspace->root_stats[i], &workspace->roots[i]);
+		SDL_free(workspace->roots[i].path);
+	}
+	SDL_free(workspace->removed);
+	SDL_memset(workspace, 0, sizeof(*workspace));
+}
+
+bool workspace_reload (Workspace *workspace, Directory *directory) {
+	if (!directory->unloaded) {
+		return false;
+	}
+	u32 root_index = workspace_root_index(workspace, directory);
+	WorkspaceRootStats *stats = &workspace->root_stats[root_index];
+	stats->num_directories_found++;
+	stats->label_dirty = true;
+
+	// the kept totals come back listing by listing, so they are taken out first
+	aggregate_subtract(directory, directory->stats);
+	directory->unloaded = false;
+	scanner_scan(workspace->scanner, directory);
+	return true;
+}
+
+//=============================================================================
+// BUDGET
+//=============================================================================
+
+void workspace_mark_viewed (Workspace *workspace, ExplorerRow *rows, RowRange visible) {
+	workspace->view_clock++;
+	for (u32 i = visible.first; i < visible.end; i++) {
+		Directory *directory = rows[i].directory ? rows[i].directory : rows[i].file->parent;
+		directory->last_viewed = workspace->view_clock;
+	}
+}
+
+static bool contains_file (Directory *directory, const File *file) {
+	for (Directory *ancestor = file ? file->parent : NULL; ancestor; ancestor = ancestor->parent) {
+		if (ancestor == directory) return true;
+	}
+	return false;
+}
+
+static void unload (Workspace *workspace, Directory *directory) {
+	u32 root_index = workspace_root_index(workspace, directory);
+	WorkspaceRootStats *stats = &workspace->root_stats[root_index];
+
+	u64 bytes = free_children(workspace->thumbnails, stats, directory);
+	stats->memory_bytes -= bytes;
+	workspace->memory_used -= bytes;
+
+	// the directory itself no longer counts as listed until it is reloaded
+	stats->num_directories_found--;
+	stats->num_directories_listed--;
+	stats->num_unloads++;
+	stats->label_dirty = true;
+	directory->unloaded = true;
+}
+
+u32 workspace_enforce_budget (Workspace *workspace, ExplorerRow *rows, u32 num_rows, const File *pinned) {
+	u32 num_unloaded = 0;
+
+	while (workspace->memory_used > workspace->memory_budget) {
+		// the collapsed directories in the list are exactly the subtrees nobody can see
+		Directory *oldest = NULL;
+		for (u32 i = 0; i < num_rows; i++) {
+			Directory *directory = rows[i].directory;
+			if (!directory || directory->expanded || directory->unloaded) continue;
+			if (directory->num_child_directories == 0 && directory->num_child_files == 0) continue;
+			if (oldest && directory->last_viewed >= oldest->last_viewed) continue;
+			if (workspace_root_is_scanning(workspace, workspace_root_index(workspace, directory))) continue;
+			if (contains_file(directory, pinned)) continue;
+			oldest = directory;
+		}
+		if (!oldest) {
+			break;
+		}
+		unload(workspace, oldest);
+		num_unloaded++;
+	}
+
+	return num_unloaded;
+}
+
+//=============================================================================
+// EDITS
+//=============================================================================
+
+static bool is_separator (char c) {
+	return c == '/' || c == '\\';
+}
+
+static Directory *find_root (Workspace *workspace, const char *path, const char **rest) {
+	for (u32 i = 0; i < workspace->num_roots; i++) {
+		const char *root_path = workspace->roots[i].path;
+		size_t length = SDL_strlen(root_path);
+		while (length > 0 && is_separator(root_path[length - 1])) length--;
+
+		if (SDL_strncmp(path, root_path, length) == 0 && (path[length] == '\0' || is_separator(path[length]))) {
+			*rest = path + length;
+			return &workspace->roots[i];
+		}
+	}
+	return NULL;
+}
+
+static bool name_equals (const char *name, const char *component, size_t length) {
+	return SDL_strncmp(name, component, length) == 0 && name[length] == '\0';
+}
+
+// follows path down from the root it starts with. With leave_last set, the
+// walk stops at the parent and the final component is left in name
+static Directory *walk_path (Workspace *workspace, const char *path, bool leave_last, const char **name, size_t *name_length) {
+	const char *rest;
+	Directory *directory = find_root(workspace, path, &rest);
+	while (directory) {
+		while (is_separator(*rest)) rest++;
+		if (*rest == '\0') {
+			return leave_last ? NULL : directory;
+		}
+
+		size_t length = 0;
+		while (rest[length] && !is_separator(rest[length])) length++;
+		const char *after = rest + length;
+		while (is_separator(*after)) after++;
+		if (leave_last && *after == '\0') {
+			*name = rest;
+			*name_length = length;
+			return directory;
+		}
+		if (directory->unloaded) {
+			return NULL;
+		}
+
+		Directory *parent = directory;
+		directory = NULL;
+		for (u32 i = 0; i < parent->num_child_directories; i++) {
+			Directory *child = parent->child_directories[i];
+			if (!child->removed && name_equals(child->name, rest, length)) {
+				directory = child;
+				break;
+			}
+		}
+		rest += length;
+	}
+	return NULL;
+}
+
+Directory *workspace_find_directory (Workspace *workspace, const char *path) {
+	return walk_path(workspace, path, false, NULL, NULL);
+}
+
+File *workspace_find_file (Workspace *workspace, const char *path) {
+	const char *name;
+	size_t length;
+	Directory *parent = walk_path(workspace, path, true, &name, &length);
+	if (!parent || parent->unloaded) {
+		return NULL;
+	}
+	for (u32 i = 0; i < parent->num_child_files; i++) {
+		File *file = parent->child_files[i];
+		if (!file->removed && name_equals(file->name, name, length)) {
+			return file;
+		}
+	}
+	return NULL;
+}
+
+// a parent still being listed gets its children replaced when the listing attaches
+static bool can_insert (Workspace *workspace, Directory *parent, const char *path) {
+	if (parent->unloaded || workspace_root_is_scanning(workspace, workspace_root_index(workspace, parent))) {
+		return false;
+	}
+	// the scanner may have picked it up already
+	return !workspace_find_file(workspace, path) && !workspace_find_directory(workspace, path);
+}
+
+static void account_node (Workspace *workspace, Directory *parent, u64 bytes) {
+	WorkspaceRootStats *stats = &workspace->root_stats[workspace_root_index(workspace, parent)];
+	stats->memory_bytes += bytes;
+	stats->label_dirty = true;
+	workspace->memory_used += bytes;
+}
+
+bool workspace_insert_file (Workspace *workspace, Directory *parent, const char *path, u64 size, i64 modified_time) {
+	if (!can_insert(workspace, parent, path)) {
+		return false;
+	}
+	File *file = file_create(parent, SDL_strdup(path), size, modified_time);
+	parent->child_files = SDL_realloc(parent->child_files, (parent->num_child_files + 1) * sizeof(File *));
+	parent->child_files[parent->num_child_files++] = file;
+
+	aggregate_add_file(parent, file);
+	account_node(workspace, parent, sizeof(File) + sizeof(File *) + SDL_strlen(path) + 1);
+	return true;
+}
+
+bool workspace_insert_directory (Workspace *workspace, Directory *parent, const char *path, i64 modified_time) {
+	if (!can_insert(workspace, parent, path)) {
+		return false;
+	}
+	Directory *directory = directory_create(parent, SDL_strdup(path), modified_time);
+	parent->child_directories = SDL_realloc(parent->child_directories, (parent->num_child_directories + 1) * sizeof(Directory *));
+	parent->child_directories[parent->num_child_directories++] = directory;
+
+	account_node(workspace, parent, sizeof(Directory) + sizeof(Directory *) + SDL_strlen(path) + 1);
+	workspace->root_stats[workspace_root_index(workspace, parent)].num_directories_found++;
+	scanner_scan(workspace->scanner, directory);
+	return true;
+}
+
+static void push_removed (Workspace *workspace, RemovedNode node) {
+	if (workspace->num_removed == workspace->removed_capacity) {
+		workspace->removed_capacity = xtd_max(workspace->removed_capacity * 2, 16u);
+		workspace->removed = SDL_realloc(workspace->removed, workspace->removed_capacity * sizeof(RemovedNode));
+	}
+	workspace->removed[workspace->num_removed++] = node;
+}
+
+void workspace_remove_file (Workspace *workspace, File *file) {
+	if (file->removed) {
+		return;
+	}
+	file->removed = true;
+	aggregate_remove_file(file->parent, file);
+	push_removed(workspace, (RemovedNode) { .file = file });
+}
+
+void workspace_remove_directory (Workspace *workspace, Directory *directory) {
+	if (directory->removed || !directory->parent) {
+		return;
+	}
+	directory->removed = true;
+	aggregate_subtract(directory->parent, directory->stats);
+	push_removed(workspace, (RemovedNode) { .directory = directory });
+}
+
+// takes item out of array, keeping the rest in their sorted order
+static void remove_child (void **array, u32 *count, void *item) {
+	for (u32 i = 0; i < *count; i++) {
+		if (array[i] == item) {
+			SDL_memmove(array + i, array + i + 1, (*count - i - 1) * sizeof(void *));
+			(*count)--;
+			return;
+		}
+	}
+}
+
+static void free_removed_node (Workspace *workspace, RemovedNode node) {
+	Directory *parent = node.file ? node.file->parent : node.directory->parent;
+	WorkspaceRootStats *stats = &workspace->root_stats[workspace_root_index(workspace, parent)];
+	u64 bytes;
+
+	if (node.file) {
+		File *file = node.file;
+		remove_child((void **) parent->child_files, &parent->num_child_files, file);
+		bytes = sizeof(File) + sizeof(File *) + SDL_strlen(file->path) + 1;
+		thumbnail_release(workspace->thumbnails, file);
+		SDL_free(file->path);
+		SDL_free(file);
+	} else {
+		Directory *directory = node.directory;
+		remove_child((void **) parent->child_directories, &parent->num_child_directories, directory);
+		bytes = free_children(workspace->thumbnails, stats, directory) +
+			sizeof(Directory) + sizeof(Directory *) + SDL_strlen(directory->path) + 1;
+		if (!directory->unloaded) {
+			stats->num_directories_found--;
+			stats->num_directories_listed--;
+		}
+		SDL_free(directory->path);
+		SDL_free(directory);
+	}
+
+	stats->memory_bytes -= bytes;
+	stats->label_dirty = true;
+	workspace->memory_used -= bytes;
+}
+
+void workspace_free_removed (Workspace *workspace) {
+	// in removal order: a node removed inside a directory removed later is
+	// freed before the directory frees its subtree
+	u32 kept = 0;
+	for (u32 i = 0; i < workspace->num_removed; i++) {
+		RemovedNode node = workspace->removed[i];
+		Directory *parent = node.file ? node.file->parent : node.directory->parent;
+		if (workspace_root_is_scanning(workspace, workspace_root_index(workspace, parent))) {
+			workspace->removed[kept++] = node;
+			continue;
+		}
+		free_removed_node(workspace, node);
+	}
+	workspace->num_removed = kept;
+}
@@ -0,0 +1,129 @@
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include "xtdlib.h"
+
+#include <SDL3/SDL.h>
+
+#include "scan.h"
+#include "scroll.h"
+#include "thumbnail.h"
+#include "ui.h"
+
+//=============================================================================
+// WORKSPACE
+//=============================================================================
+
+// The set of root directories shown in the explorer. Every root has its own
+// tree, but all of them are indexed by the one Scanner and its job queue.
+//
+// Node memory is accounted per root as listings are attached and checked
+// against one global budget. When the workspace is over budget,
+// workspace_enforce_budget unloads whole subtrees below collapsed directories,
+// least recently viewed first: the children are freed, the directory keeps
+// its recursive stats and is marked unloaded, and expanding it again rescans
+// it. Only the collapsed directories of the explorer list are candidates, so
+// an unloaded node is never on screen, and only roots the scanner is done
+// with are touched, so no job or pending listing can refer to a freed node.
+// Search only sees what is loaded.
+
+#define WORKSPACE_MAX_ROOTS             16
+#define WORKSPACE_DEFAULT_MEMORY_BUDGET (512ull << 20)
+
+typedef struct WorkspaceRootStats {
+	u64 memory_bytes;
+	u64 num_directories_found;		// listed or waiting to be
+	u64 num_directories_listed;
+	u64 num_unloads;
+
+	char label[48];
+	bool label_dirty;
+} WorkspaceRootStats;
+
+// a node flagged removed and not yet freed; one of the two is set
+typedef struct RemovedNode {
+	Directory *directory;
+	File *file;
+} RemovedNode;
+
+typedef struct Workspace {
+	Scanner *scanner;
+	ThumbnailService *thumbnails;	// optional; gets the textures of files being freed
+
+	// fixed storage: every node's parent chain ends at one of these
+	Directory roots[WORKSPACE_MAX_ROOTS];
+	WorkspaceRootStats root_stats[WORKSPACE_MAX_ROOTS];
+	u32 num_roots;
+
+	u64 memory_budget;
+	u64 memory_used;
+	u64 view_clock;		// advances once per workspace_mark_viewed
+
+	RemovedNode *removed;	// oldest first, see workspace_free_removed
+	u32 num_removed;
+	u32 removed_capacity;
+} Workspace;
+
+void workspace_init (Workspace *workspace, Scanner *scanner, ThumbnailService *thumbnails, u64 memory_budget);
+
+// frees every tree; call after the scanner's job queue is destroyed. Thumbnail
+// textures belong to the renderer and go with it
+void workspace_shutdown (Workspace *workspace);
+
+// adds a root and starts indexing it; returns false if the path is already open or there is no room
+bool workspace_add_root (Workspace *workspace, const char *path);
+
+// index into roots of the root the directory belongs to
+u32 workspace_root_index (Workspace *workspace, Directory *directory);
+
+// accounts a listing the scanner just attached; call from the scanner's attach callback
+void workspace_on_listed (Workspace *workspace, Directory *directory);
+
+// records the rows in [visible.first, visible.end) as viewed now
+void workspace_mark_viewed (Workspace *workspace, ExplorerRow *rows, RowRange visible);
+
+// rescans a directory whose children were unloaded; returns true if a scan started
+bool workspace_reload (Workspace *workspace, Directory *directory);
+
+// unloads collapsed subtrees among rows until the workspace fits its budget,
+// skipping the one holding pinned. Returns the number of subtrees unloaded
+u32 workspace_enforce_budget (Workspace *workspace, ExplorerRow *rows, u32 num_rows, const File *pinned);
+
+bool workspace_root_is_scanning (Workspace *workspace, u32 root_index);
+
+// -- Edits -------------------------------------------------------------------
+
+// Changes made by the app itself (see file_ops.h) are applied to loaded trees
+// in place rather than by rescanning. Removed nodes are only flagged, since
+// rows, previews and thumbnail tasks may still point at them, and freed later
+// by workspace_free_removed. Call only while the sort engine is idle.
+
+// the loaded node at path, or NULL if it is outside every root or not loaded
+Directory *workspace_find_directory (Workspace *workspace, const char *path);
+File *workspace_find_file (Workspace *workspace, const char *path);
+
+// adds a node for something just created on disk under a loaded parent; a
+// directory is then scanned. Returns false if the parent is not loaded
+bool workspace_insert_file (Workspace *workspace, Directory *parent, const char *path, u64 size, i64 modified_time);
+bool workspace_insert_directory (Workspace *workspace, Directory *parent, const char *path, i64 modified_time);
+
+void workspace_remove_file (Workspace *workspace, File *file);
+void workspace_remove_directory (Workspace *workspace, Directory *directory);
+
+// Frees the nodes removed so far, with everything below them, and takes them
+// out of their parents' child arrays. By then nothing may point at them: the
+// rows must have been rebuilt and the thumbnail and type sniffing updates run
+// on them, which drops tasks for files no longer listed, the preview must be
+// closed, and neither a sort nor a git status refresh may be in flight. Nodes
+// in a root the scanner is still working on are kept for a later call.
+//
+// Call right before workspace_enforce_budget, under the same conditions. An
+// unload frees subtrees whole, so a removed node still waiting here must not
+// be below it; the two skip the same scanning roots, so once this has run,
+// every node it kept is out of the unload's reach.
+void workspace_free_removed (Workspace *workspace);
+
+// memory and scan progress of one root, refreshed when they change
+const char *workspace_root_label (Workspace *workspace, u32 root_index);
+
+#endif // WORKSPACE_H
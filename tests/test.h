@@ -0,0 +1,29 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+
+//=============================================================================
+// TESTS
+//=============================================================================
+
+// Each test is a standalone program built against the sources it covers;
+// the command is at the top of its file. A failed check prints where it
+// failed and the program exits nonzero once every test has run.
+
+static int test_failures;
+
+#define CHECK(condition) do { \
+	if (!(condition)) { \
+		fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+		test_failures++; \
+	} \
+} while (0)
+
+#define RUN(test) do { \
+	int failures_before = test_failures; \
+	test(); \
+	printf("%s %s\n", failures_before == test_failures ? "ok  " : "FAIL", #test); \
+} while (0)
+
+#endif // TEST_H
@@ -0,0 +1,220 @@
+// cc -I source -I modules/xtdlib -I modules/clay tests/test_git_index.c source/aggregate.c source/bytes.c source/file_map.c source/filetype.c source/job.c source/scan.c source/scan_io.c $(pkg-config --cflags --libs sdl3)
+
+#include "test.h"
+
+// the index parser is internal to git_status.c
+#include "git_status.c"
+
+#define MODE_FILE       0100644
+#define MODE_SYMLINK    0120000
+#define MODE_GITLINK    0160000
+
+#define FLAG_EXTENDED       0x4000
+#define FLAG_STAGE_1        0x1000
+#define EXTENDED_SKIP_WORKTREE  0x4000
+#define EXTENDED_INTENT_TO_ADD  0x2000
+
+typedef struct IndexBuilder {
+	u8 data[4096];
+	u32 length;
+	u32 version;
+	const char *previous_path;	// for version 4's prefix compression
+} IndexBuilder;
+
+static void put_u32 (u8 *at, u32 value) {
+	at[0] = (u8) (value >> 24);
+	at[1] = (u8) (value >> 16);
+	at[2] = (u8) (value >> 8);
+	at[3] = (u8) value;
+}
+
+static void put_u16 (u8 *at, u16 value) {
+	at[0] = (u8) (value >> 8);
+	at[1] = (u8) value;
+}
+
+// git's encode_varint, the inverse of read_varint
+static u32 put_varint (u8 *at, u64 value) {
+	u8 bytes[16];
+	u32 position = sizeof(bytes) - 1;
+	bytes[position] = value & 127;
+	while (value >>= 7) {
+		bytes[--position] = 128 | (--value & 127);
+	}
+	u32 length = sizeof(bytes) - position;
+	SDL_memcpy(at, bytes + position, length);
+	return length;
+}
+
+static void begin_index (IndexBuilder *builder, u32 version, u32 num_entries) {
+	SDL_memset(builder, 0, sizeof(*builder));
+	builder->version = version;
+	SDL_memcpy(builder->data, "DIRC", 4);
+	put_u32(builder->data + 4, version);
+	put_u32(builder->data + 8, num_entries);
+	builder->length = GIT_INDEX_HEADER_SIZE;
+}
+
+static void add_entry (IndexBuilder *builder, const char *path, u32 mode, u32 modified_seconds, u32 size, u16 flags, u16 extended) {
+	u8 *entry = builder->data + builder->length;
+	u32 path_length = (u32) SDL_strlen(path);
+	put_u32(entry + 8, modified_seconds);
+	put_u32(entry + 24, mode);
+	put_u32(entry + 36, size);
+	put_u16(entry + 60, (u16) (flags | xtd_min(path_length, 0xFFFu)));
+
+	u8 *name = entry + GIT_ENTRY_FIXED_SIZE;
+	if (flags & FLAG_EXTENDED) {
+		put_u16(name, extended);
+		name += 2;
+	}
+	if (builder->version == 4) {
+		u32 common = 0;
+		const char *previous = builder->previous_path ? builder->previous_path : "";
+		while (previous[common] && previous[common] == path[common]) common++;
+		name += put_varint(name, SDL_strlen(previous) - common);
+		SDL_memcpy(name, path + common, path_length - common + 1);
+		builder->length = (u32) (name - builder->data) + path_length - common + 1;
+		builder->previous_path = path;
+	} else {
+		SDL_memcpy(name, path, path_length + 1);
+		u32 entry_size = ((u32) (name - entry) + path_length + 8) & ~7u;
+		builder->length += entry_size;
+	}
+}
+
+// parses as load_index does, but from a small paths buffer so it has to grow
+static bool parse_index (IndexBuilder *builder, u32 length, GitIndex *index) {
+	*index = (GitIndex) { .num_entries = read_u32_be(builder->data + 8) };
+	index->entries = SDL_calloc(xtd_max(index->num_entries, 1u), sizeof(GitIndexEntry));
+	index->paths = SDL_malloc(4);
+	return parse_entries(index, builder->data, builder->data + length, read_u32_be(builder->data + 4), 4);
+}
+
+static void free_parsed (GitIndex *index) {
+	SDL_free(index->entries);
+	SDL_free(index->paths);
+}
+
+static bool has_path (GitIndex *index, u32 i, const char *path) {
+	GitIndexEntry *entry = &index->entries[i];
+	return entry->path_length == SDL_strlen(path) && SDL_strcmp(index->paths + entry->path, path) == 0;
+}
+
+static void test_varint (void) {
+	u64 values[] = { 0, 1, 127, 128, 16511, 16512, 1ull << 32, (1ull << 56) - 1 };
+	for (u32 i = 0; i < SDL_arraysize(values); i++) {
+		u8 bytes[16];
+		u32 length = put_varint(bytes, values[i]);
+		u64 value = 0;
+		CHECK(read_varint(bytes, bytes + length, &value) == bytes + length);
+		CHECK(value == values[i]);
+		CHECK(!read_varint(bytes, bytes + length - 1, &value));
+	}
+}
+
+static void test_version_2 (void) {
+	IndexBuilder builder;
+	begin_index(&builder, 2, 5);
+	add_entry(&builder, "Makefile", MODE_FILE, 1700000000, 1234, 0, 0);
+	add_entry(&builder, "conflicted.c", MODE_FILE, 0, 0, FLAG_STAGE_1, 0);
+	add_entry(&builder, "link", MODE_SYMLINK, 0, 7, 0, 0);
+	add_entry(&builder, "modules/sub", MODE_GITLINK, 0, 0, 0, 0);
+	add_entry(&builder, "src/a_path_long_enough_to_need_growing.c", MODE_FILE, 0, 0, 0, 0);
+
+	GitIndex index;
+	CHECK(parse_index(&builder, builder.length, &index));
+	CHECK(has_path(&index, 0, "Makefile"));
+	CHECK(index.entries[0].modified_seconds == 1700000000);
+	CHECK(index.entries[0].size == 1234);
+	CHECK(index.entries[0].flags == 0);
+	CHECK(has_path(&index, 1, "conflicted.c"));
+	CHECK(index.entries[1].flags == GIT_ENTRY_CONFLICT);
+	CHECK(index.entries[2].flags == GIT_ENTRY_SYMLINK);
+	CHECK(index.entries[2].size == 7);
+	CHECK(index.entries[3].flags == GIT_ENTRY_GITLINK);
+	CHECK(has_path(&index, 4, "src/a_path_long_enough_to_need_growing.c"));
+	free_parsed(&index);
+}
+
+static void test_version_3 (void) {
+	IndexBuilder builder;
+	begin_index(&builder, 3, 3);
+	add_entry(&builder, "plain", MODE_FILE, 0, 1, 0, 0);
+	add_entry(&builder, "sparse/skipped", MODE_FILE, 0, 2, FLAG_EXTENDED, EXTENDED_SKIP_WORKTREE);
+	add_entry(&builder, "added", MODE_FILE, 0, 3, FLAG_EXTENDED, EXTENDED_INTENT_TO_ADD);
+
+	GitIndex index;
+	CHECK(parse_index(&builder, builder.length, &index));
+	CHECK(has_path(&index, 0, "plain"));
+	CHECK(index.entries[0].flags == 0);
+	CHECK(has_path(&index, 1, "sparse/skipped"));
+	CHECK(index.entries[1].flags == GIT_ENTRY_SKIP_WORKTREE);
+	CHECK(index.entries[1].size == 2);
+	CHECK(has_path(&index, 2, "added"));
+	CHECK(index.entries[2].flags == GIT_ENTRY_INTENT_TO_ADD);
+	CHECK(index.entries[2].size == 3);
+	free_parsed(&index);
+}
+
+static void test_version_4 (void) {
+	const char *paths[] = { "README", "src/app.c", "src/app.h", "src/deep/x.c", "src/z.c", "zz" };
+	IndexBuilder builder;
+	begin_index(&builder, 4, SDL_arraysize(paths));
+	for (u32 i = 0; i < SDL_arraysize(paths); i++) {
+		add_entry(&builder, paths[i], MODE_FILE, 0, i, i == 3 ? FLAG_EXTENDED : 0, EXTENDED_SKIP_WORKTREE);
+	}
+
+	GitIndex index;
+	CHECK(parse_index(&builder, builder.length, &index));
+	for (u32 i = 0; i < SDL_arraysize(paths); i++) {
+		CHECK(has_path(&index, i, paths[i]));
+		CHECK(index.entries[i].size == i);
+	}
+	CHECK(index.entries[3].flags == GIT_ENTRY_SKIP_WORKTREE);
+	free_parsed(&index);
+}
+
+static void test_damaged (void) {
+	GitIndex index;
+	IndexBuilder builder;
+
+	// cut short inside the last entry's fixed part, then inside its padding
+	begin_index(&builder, 2, 2);
+	add_entry(&builder, "first", MODE_FILE, 0, 0, 0, 0);
+	u32 first_end = builder.length;
+	add_entry(&builder, "second", MODE_FILE, 0, 0, 0, 0);
+	CHECK(!parse_index(&builder, first_end + 30, &index));
+	free_parsed(&index);
+	CHECK(!parse_index(&builder, builder.length - 1, &index));
+	free_parsed(&index);
+
+	// more entries claimed than there are
+	put_u32(builder.data + 8, 3);
+	CHECK(!parse_index(&builder, builder.length, &index));
+	free_parsed(&index);
+
+	// a path without its terminator
+	begin_index(&builder, 4, 1);
+	add_entry(&builder, "name", MODE_FILE, 0, 0, 0, 0);
+	CHECK(!parse_index(&builder, builder.length - 1, &index));
+	free_parsed(&index);
+
+	// stripping more of the previous path than it has
+	begin_index(&builder, 4, 2);
+	add_entry(&builder, "ab", MODE_FILE, 0, 0, 0, 0);
+	u32 second = builder.length;
+	add_entry(&builder, "ac", MODE_FILE, 0, 0, 0, 0);
+	builder.data[second + GIT_ENTRY_FIXED_SIZE] = 3;
+	CHECK(!parse_index(&builder, builder.length, &index));
+	free_parsed(&index);
+}
+
+int main (void) {
+	RUN(test_varint);
+	RUN(test_version_2);
+	RUN(test_version_3);
+	RUN(test_version_4);
+	RUN(test_damaged);
+	return test_failures != 0;
+}
@@ -0,0 +1,213 @@
+// cc -I source -I modules/xtdlib -I modules/clay tests/test_selection.c source/selection.c $(pkg-config --cflags --libs sdl3)
+
+#include "test.h"
+
+#include "selection.h"
+
+#define NUM_ROWS 300
+
+// the selection against a flag per row, and its ranges against their invariants
+static bool matches (Selection *selection, const bool *selected, u32 num_rows) {
+	for (u32 i = 0; i < selection->num_ranges; i++) {
+		RowRange range = selection->ranges[i];
+		if (range.first >= range.end) return false;
+		if (i > 0 && selection->ranges[i - 1].end >= range.first) return false;
+	}
+	u32 count = 0;
+	for (u32 row = 0; row < num_rows; row++) {
+		if (selection_contains(selection, row) != selected[row]) return false;
+		count += selected[row];
+	}
+	return count == selection->num_selected;
+}
+
+static void test_add_merges_ranges (void) {
+	Selection selection;
+	selection_init(&selection);
+
+	selection_add(&selection, (RowRange) { 10, 20 });
+	selection_add(&selection, (RowRange) { 30, 40 });
+	CHECK(selection.num_ranges == 2);
+	CHECK(selection.num_selected == 20);
+
+	// touching ranges join, so none is ever adjacent to the next
+	selection_add(&selection, (RowRange) { 20, 25 });
+	CHECK(selection.num_ranges == 2);
+	CHECK(selection.ranges[0].first == 10 && selection.ranges[0].end == 25);
+
+	// one range swallowing several
+	selection_add(&selection, (RowRange) { 5, 50 });
+	CHECK(selection.num_ranges == 1);
+	CHECK(selection.ranges[0].first == 5 && selection.ranges[0].end == 50);
+	CHECK(selection.num_selected == 45);
+
+	selection_add(&selection, (RowRange) { 60, 60 });
+	CHECK(selection.num_ranges == 1);
+	CHECK(!selection_contains(&selection, 4));
+	CHECK(selection_contains(&selection, 5));
+	CHECK(selection_contains(&selection, 49));
+	CHECK(!selection_contains(&selection, 50));
+
+	selection_free(&selection);
+}
+
+static void test_remove_splits_ranges (void) {
+	Selection selection;
+	selection_init(&selection);
+
+	selection_add(&selection, (RowRange) { 0, 100 });
+	selection_remove(&selection, (RowRange) { 40, 60 });
+	CHECK(selection.num_ranges == 2);
+	CHECK(selection.ranges[0].first == 0 && selection.ranges[0].end == 40);
+	CHECK(selection.ranges[1].first == 60 && selection.ranges[1].end == 100);
+	CHECK(selection.num_selected == 80);
+
+	// trimming the ends of two ranges and dropping one between them
+	selection_add(&selection, (RowRange) { 45, 50 });
+	selection_remove(&selection, (RowRange) { 30, 70 });
+	CHECK(selection.num_ranges == 2);
+	CHECK(selection.ranges[0].end == 30);
+	CHECK(selection.ranges[1].first == 70);
+	CHECK(selection.num_selected == 60);
+
+	selection_remove(&selection, (RowRange) { 0, 1000 });
+	CHECK(selection.num_ranges == 0);
+	CHECK(selection.num_selected == 0);
+
+	selection_free(&selection);
+}
+
+static void test_toggle_and_find (void) {
+	Selection selection;
+	selection_init(&selection);
+
+	selection_toggle(&selection, 7);
+	selection_toggle(&selection, 9);
+	CHECK(selection.num_ranges == 2);
+	selection_toggle(&selection, 8);
+	CHECK(selection.num_ranges == 1);
+	CHECK(selection.num_selected == 3);
+	selection_toggle(&selection, 8);
+	CHECK(selection.num_ranges == 2);
+	CHECK(!selection_contains(&selection, 8));
+
+	CHECK(selection_find(&selection, 0) == 0);
+	CHECK(selection_find(&selection, 7) == 0);
+	CHECK(selection_find(&selection, 8) == 1);
+	CHECK(selection_find(&selection, 10) == selection.num_ranges);
+
+	selection_free(&selection);
+}
+
+static void test_invert (void) {
+	Selection selection;
+	selection_init(&selection);
+
+	selection_invert(&selection, 50);
+	CHECK(selection.num_ranges == 1);
+	CHECK(selection.num_selected == 50);
+
+	selection_remove(&selection, (RowRange) { 0, 10 });
+	selection_remove(&selection, (RowRange) { 20, 30 });
+	selection_invert(&selection, 50);
+	CHECK(selection.num_ranges == 2);
+	CHECK(selection.ranges[0].first == 0 && selection.ranges[0].end == 10);
+	CHECK(selection.ranges[1].first == 20 && selection.ranges[1].end == 30);
+	CHECK(selection.num_selected == 20);
+
+	selection_invert(&selection, 50);
+	CHECK(selection.num_ranges == 2);
+	CHECK(selection.ranges[0].first == 10 && selection.ranges[1].end == 50);
+	CHECK(selection.num_selected == 30);
+
+	selection_free(&selection);
+}
+
+// random operations checked row by row against a flag per row
+static void test_random_operations (void) {
+	Selection selection;
+	selection_init(&selection);
+	bool selected[NUM_ROWS] = {0};
+	u32 seed = 1;
+	bool ok = true;
+
+	for (u32 step = 0; step < 100000 && ok; step++) {
+		seed = seed * 1664525 + 1013904223;
+		u32 op = (seed >> 8) % 7;
+		u32 first = (seed >> 12) % NUM_ROWS;
+		u32 end = xtd_min(first + (seed >> 20) % 20, (u32) NUM_ROWS);
+
+		if (op < 3) {
+			selection_add(&selection, (RowRange) { first, end });
+			for (u32 row = first; row < end; row++) selected[row] = true;
+		} else if (op < 5) {
+			selection_remove(&selection, (RowRange) { first, end });
+			for (u32 row = first; row < end; row++) selected[row] = false;
+		} else if (op == 5) {
+			selection_toggle(&selection, first);
+			selected[first] = !selected[first];
+		} else if (first % 50 == 0) {
+			selection_invert(&selection, NUM_ROWS);
+			for (u32 row = 0; row < NUM_ROWS; row++) selected[row] = !selected[row];
+		}
+		ok = matches(&selection, selected, NUM_ROWS);
+	}
+	CHECK(ok);
+
+	selection_free(&selection);
+}
+
+static void test_remap (void) {
+	static File files[NUM_ROWS];
+	static ExplorerRow rows[NUM_ROWS];
+	static ExplorerRow new_rows[NUM_ROWS];
+	for (u32 i = 0; i < NUM_ROWS; i++) {
+		rows[i] = (ExplorerRow) { .file = &files[i] };
+	}
+
+	Selection selection;
+	selection_init(&selection);
+	selection_add(&selection, (RowRange) { 10, 40 });
+	selection_add(&selection, (RowRange) { 100, 101 });
+	selection_add(&selection, (RowRange) { 250, 300 });
+	selection.anchor = 11;
+
+	// the rows reversed, as by flipping the sort, with every third one gone
+	u32 num_new_rows = 0;
+	for (u32 i = NUM_ROWS; i-- > 0;) {
+		if (i % 3 != 0) new_rows[num_new_rows++] = rows[i];
+	}
+	selection_begin_remap(&selection, rows, NUM_ROWS);
+	selection_end_remap(&selection, new_rows, num_new_rows);
+
+	bool ok = true;
+	u32 count = 0;
+	for (u32 row = 0; row < num_new_rows; row++) {
+		u32 i = (u32) (new_rows[row].file - files);
+		bool was_selected = (i >= 10 && i < 40) || i == 100 || i >= 250;
+		ok &= selection_contains(&selection, row) == was_selected;
+		count += was_selected;
+	}
+	CHECK(ok);
+	CHECK(selection.num_selected == count);
+	CHECK(selection.anchor < num_new_rows && new_rows[selection.anchor].file == &files[11]);
+
+	// an anchor whose row is gone is dropped
+	selection.anchor = 0;
+	ExplorerRow *anchor_row = &new_rows[0];
+	selection_begin_remap(&selection, new_rows, num_new_rows);
+	selection_end_remap(&selection, anchor_row + 1, num_new_rows - 1);
+	CHECK(selection.anchor == SELECTION_NO_ANCHOR);
+
+	selection_free(&selection);
+}
+
+int main (void) {
+	RUN(test_add_merges_ranges);
+	RUN(test_remove_splits_ranges);
+	RUN(test_toggle_and_find);
+	RUN(test_invert);
+	RUN(test_random_operations);
+	RUN(test_remap);
+	return test_failures != 0;
+}
@@ -0,0 +1,145 @@
+// cc -I source -I modules/xtdlib -I modules/clay tests/test_truncate.c source/truncate.c $(pkg-config --cflags sdl3-ttf) $(pkg-config --cflags --libs sdl3)
+
+#include "test.h"
+
+#include "truncate.h"
+
+// A fixed-pitch font in place of SDL_ttf, so widths are known: at size 16
+// every ASCII codepoint advances 8 pixels and any other 10, the ellipsis
+// included, scaling with the size
+static float font_size = 16;
+
+bool TTF_SetFontSize (TTF_Font *font, float size) {
+	font_size = size;
+	return true;
+}
+
+bool TTF_GetGlyphMetrics (TTF_Font *font, u32 codepoint, int *min_x, int *max_x, int *min_y, int *max_y, int *advance) {
+	*advance = (int) ((codepoint < 128 ? 8 : 10) * font_size / 16);
+	return true;
+}
+
+static TTF_Font *fonts[1];
+
+static bool equals (Clay_String string, const char *expected) {
+	return string.length == (i32) SDL_strlen(expected) && SDL_memcmp(string.chars, expected, (size_t) string.length) == 0;
+}
+
+static void test_fits_within_width (void) {
+	TextTruncator truncator;
+	text_truncator_init(&truncator, fonts);
+	text_truncator_begin_frame(&truncator);
+
+	const char *name = "short.txt";
+	CHECK(text_truncator_measure(&truncator, 0, 16, name, 9) == 72);
+	Clay_String fitted = text_truncator_fit(&truncator, 0, 16, name, 72);
+	CHECK(fitted.chars == name && fitted.length == 9);
+	CHECK(truncator.stats.num_fitted == 0);
+
+	text_truncator_shutdown(&truncator);
+}
+
+static void test_cuts_the_middle (void) {
+	TextTruncator truncator;
+	text_truncator_init(&truncator, fonts);
+	text_truncator_begin_frame(&truncator);
+
+	// 8 codepoints and the ellipsis fit in 80 pixels, the head taking the odd one
+	const char *name = "abcdefghij.txt";
+	CHECK(equals(text_truncator_fit(&truncator, 0, 16, name, 80), "abcd" TRUNCATE_ELLIPSIS ".txt"));
+	CHECK(equals(text_truncator_fit(&truncator, 0, 16, name, 88), "abcde" TRUNCATE_ELLIPSIS ".txt"));
+
+	// at size 32 everything is twice as wide
+	CHECK(equals(text_truncator_fit(&truncator, 0, 32, name, 160), "abcd" TRUNCATE_ELLIPSIS ".txt"));
+
+	// too narrow for any codepoint beside the ellipsis
+	CHECK(equals(text_truncator_fit(&truncator, 0, 16, name, 12), TRUNCATE_ELLIPSIS));
+	CHECK(equals(text_truncator_fit(&truncator, 0, 16, name, 0), TRUNCATE_ELLIPSIS));
+
+	text_truncator_shutdown(&truncator);
+}
+
+static void test_keeps_whole_codepoints (void) {
+	TextTruncator truncator;
+	text_truncator_init(&truncator, fonts);
+	text_truncator_begin_frame(&truncator);
+
+	// two-byte codepoints 10 pixels wide: the ellipsis and 6 of them in 70
+	const char *name = "\xC3\xA9\xC3\xA8\xC3\xAA\xC3\xAB\xC3\xA0\xC3\xA2\xC3\xA4\xC3\xA7";
+	Clay_String fitted = text_truncator_fit(&truncator, 0, 16, name, 70);
+	CHECK(equals(fitted, "\xC3\xA9\xC3\xA8\xC3\xAA" TRUNCATE_ELLIPSIS "\xC3\xA2\xC3\xA4\xC3\xA7"));
+	CHECK(text_truncator_measure(&truncator, 0, 16, fitted.chars, (u32) fitted.length) <= 70);
+
+	text_truncator_shutdown(&truncator);
+}
+
+static void test_cached_between_frames (void) {
+	TextTruncator truncator;
+	text_truncator_init(&truncator, fonts);
+	text_truncator_begin_frame(&truncator);
+
+	const char *name = "a_very_long_file_name.tar.gz";
+	Clay_String first = text_truncator_fit(&truncator, 0, 16, name, 100);
+	CHECK(truncator.stats.num_fitted == 1);
+	CHECK(truncator.stats.num_tables_built == 1);
+
+	text_truncator_begin_frame(&truncator);
+	Clay_String again = text_truncator_fit(&truncator, 0, 16, name, 100);
+	CHECK(again.chars == first.chars && again.length == first.length);
+	CHECK(truncator.stats.num_fitted == 1);
+
+	// a new width reruns the search but not the table
+	text_truncator_fit(&truncator, 0, 16, name, 120);
+	CHECK(truncator.stats.num_fitted == 2);
+	CHECK(truncator.stats.num_tables_built == 1);
+
+	// the caller's buffer may change after the call; the cache kept a copy
+	char buffer[] = "a_very_long_file_name.tar.gz";
+	Clay_String copied = text_truncator_fit(&truncator, 0, 16, buffer, 100);
+	buffer[0] = 'b';
+	Clay_String changed = text_truncator_fit(&truncator, 0, 16, buffer, 100);
+	CHECK(copied.chars[0] == 'a');
+	CHECK(changed.chars[0] == 'b');
+
+	text_truncator_shutdown(&truncator);
+}
+
+// the same string at several widths in one frame: every cut handed out stays
+// as it was until the next frame, including those past the ones an entry keeps
+static void test_widths_in_one_frame (void) {
+	TextTruncator truncator;
+	text_truncator_init(&truncator, fonts);
+
+	const char *name = "a_very_long_file_name_that_overflows.tar.gz";
+	f32 widths[6] = { 200, 120, 200, 90, 60, 40 };
+	for (u32 frame = 0; frame < 3; frame++) {
+		text_truncator_begin_frame(&truncator);
+		CHECK(truncator.num_overflow == 0);
+
+		Clay_String fitted[6];
+		char copies[6][64];
+		for (u32 i = 0; i < 6; i++) {
+			fitted[i] = text_truncator_fit(&truncator, 0, 16, name, widths[i]);
+			SDL_memcpy(copies[i], fitted[i].chars, (size_t) fitted[i].length);
+		}
+		for (u32 i = 0; i < 6; i++) {
+			CHECK(SDL_memcmp(copies[i], fitted[i].chars, (size_t) fitted[i].length) == 0);
+			CHECK(text_truncator_measure(&truncator, 0, 16, fitted[i].chars, (u32) fitted[i].length) <= widths[i]);
+		}
+		CHECK(fitted[0].chars == fitted[2].chars);
+
+		// five distinct widths against four kept: one went to the overflow list
+		CHECK(truncator.num_overflow == 1);
+	}
+
+	text_truncator_shutdown(&truncator);
+}
+
+int main (void) {
+	RUN(test_fits_within_width);
+	RUN(test_cuts_the_middle);
+	RUN(test_keeps_whole_codepoints);
+	RUN(test_cached_between_frames);
+	RUN(test_widths_in_one_frame);
+	return test_failures != 0;
+}